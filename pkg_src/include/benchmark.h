@@ -0,0 +1,35 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "wifi_scanner.h"
+
+#define BENCHMARK_DEFAULT_ITERATIONS 5
+#define BENCHMARK_JSON_DEFAULT_DOCUMENTS 2000
+#define BENCHMARK_JSON_DEFAULT_NETWORKS 200
+#define BENCHMARK_LINK_SSID "ur-wireless-tools-bench"
+
+typedef struct {
+    int samples;
+    long long total_ms;
+    long long min_ms;
+    long long max_ms;
+} benchmark_stats_t;
+
+void benchmark_stats_add(benchmark_stats_t *stats, long long sample_ms);
+void print_benchmark_stats_json(const char *name, const benchmark_stats_t *stats, int is_last);
+
+// Full open-network connection test (save, cleanup, link reset, restore) with the link
+// waits as fixed sleeps vs rtnetlink waits. Any interface works; a veth whose peer is
+// down behaves like an unassociated radio.
+int benchmark_link_waits(const char *interface_name, int iterations);
+
+// Every scan method of scan_alternatives on one interface: latency, CPU time, peak RSS and
+// failure rate each. The winner is stored for the interface and its driver, where
+// wifi_select_optimal_scan_method picks it up.
+int benchmark_scan_methods(const char *interface_name, int iterations);
+
+// Render a synthetic scan document with `networks` BSS entries through the per-field printf
+// formatter it replaced and through json_writer, both to /dev/null; needs no interface
+int benchmark_json_output(int documents, int networks);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,51 @@
+#ifndef COMMAND_RUNNER_H
+#define COMMAND_RUNNER_H
+
+#include "wifi_scanner.h"
+
+#define COMMAND_DEFAULT_TIMEOUT_MS 5000
+#define COMMAND_SCAN_TIMEOUT_MS 15000
+#define COMMAND_OUTPUT_INITIAL_CAPACITY 4096
+#define COMMAND_OUTPUT_MAX_CAPACITY (1024 * 1024)
+
+// Flags for command_run
+#define COMMAND_CAPTURE_STDERR 0x1      // merge stderr into the captured output (default: discard it)
+#define COMMAND_INHERIT_OUTPUT 0x2      // leave stdout/stderr on ours instead of capturing or discarding
+
+// Growable output buffer; reuse it across calls to avoid reallocating
+typedef struct {
+    char *data;                     // NUL-terminated
+    size_t length;
+    size_t capacity;
+} command_output_t;
+
+typedef struct {
+    int exit_code;                  // -1 when killed by a signal, 127 when the program was not found
+    int timed_out;                  // killed at the deadline
+    pid_t pid;
+    long long duration_ms;          // spawn to reap
+    long long first_output_ms;      // spawn to first captured byte, -1 when nothing came
+} command_status_t;
+
+// Spawn argv[0] (searched in PATH, no shell) with stdin on /dev/null and wait up to timeout_ms.
+// Output is captured into output when given, discarded otherwise (unless COMMAND_INHERIT_OUTPUT).
+// Returns the exit code, or -1 when the command could not be started, was killed, or timed out.
+int command_run(const char *const argv[], int flags, int timeout_ms,
+                command_output_t *output, command_status_t *status);
+
+// Run with output captured into this thread's shared buffer and return a read stream over it,
+// for parsers written against popen(). NULL when the command could not be started. The stream
+// is only valid until the next command_run_stream in the same thread; fclose it when done.
+FILE *command_run_stream(const char *const argv[], int flags, int timeout_ms, command_status_t *status);
+
+// Per-thread reusable output buffer, released when the thread exits
+command_output_t *command_shared_output(void);
+void command_output_free(command_output_t *output);
+
+// pidfd for a child (readable once it exits), -1 when the kernel has no pidfd_open
+int command_pidfd_open(pid_t pid);
+
+// Render argv for logs, quoting arguments that contain spaces
+void command_format(const char *const argv[], char *buffer, size_t size);
+
+#endif // COMMAND_RUNNER_H
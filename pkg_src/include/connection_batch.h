@@ -0,0 +1,47 @@
+#ifndef CONNECTION_BATCH_H
+#define CONNECTION_BATCH_H
+
+#include "wifi_scanner.h"
+
+#define MAX_BATCH_JOBS 64
+#define MAX_PSK_LEN 64
+
+// One line of the job file: interface<TAB>ssid[<TAB>psk]
+typedef struct {
+    char interface_name[MAX_INTERFACE_NAME];
+    char ssid[MAX_SSID_LEN];
+    char psk[MAX_PSK_LEN + 1];
+    int secured;
+} connection_job_t;
+
+// Per-interface session: state is saved and the link reset once for all its jobs
+typedef struct {
+    char interface_name[MAX_INTERFACE_NAME];
+    int job_indices[MAX_BATCH_JOBS];
+    int job_count;
+    int setup_duration_ms;
+    int teardown_duration_ms;
+    int restore_duration_ms;        // pinned reattach of the original network, -1 if not restored
+    int session_duration_ms;
+    int supplicant_persistent;      // tests shared one wpa_supplicant instance
+    int supplicant_start_ms;
+    int passed;
+    int failed;
+} connection_batch_session_t;
+
+typedef struct {
+    connection_job_t jobs[MAX_BATCH_JOBS];
+    connection_test_result_t results[MAX_BATCH_JOBS];
+    int job_count;
+    connection_batch_session_t sessions[MAX_INTERFACES];
+    int session_count;
+    time_t start_time;
+    int total_duration_ms;
+} connection_batch_t;
+
+// Parse a job file; returns the number of jobs or -1 on error (message in error)
+int connection_batch_load(const char *path, connection_batch_t *batch, char *error, size_t error_size);
+// Run all jobs, one thread per interface; returns the number of failed tests
+int connection_batch_run(connection_batch_t *batch);
+
+#endif // CONNECTION_BATCH_H
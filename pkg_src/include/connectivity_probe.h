@@ -0,0 +1,54 @@
+#ifndef CONNECTIVITY_PROBE_H
+#define CONNECTIVITY_PROBE_H
+
+#include "wifi_scanner.h"
+#include <netinet/in.h>
+
+#define CONNECTIVITY_PROBE_MAX_TARGETS 4
+#define CONNECTIVITY_PROBE_DEFAULT_TIMEOUT_MS 2000
+#define CONNECTIVITY_PROBE_NAME_LEN 128
+
+// Probe targets; empty lists fall back to the defaults, an empty gateway is
+// taken from the interface's default route
+typedef struct {
+    char gateway[INET_ADDRSTRLEN];
+    char dns_servers[CONNECTIVITY_PROBE_MAX_TARGETS][INET_ADDRSTRLEN];
+    int dns_server_count;
+    char dns_query_name[CONNECTIVITY_PROBE_NAME_LEN];
+    struct sockaddr_in tcp_targets[CONNECTIVITY_PROBE_MAX_TARGETS];
+    int tcp_target_count;
+} connectivity_probe_config_t;
+
+typedef enum {
+    PROBE_STATUS_SKIPPED = 0,       // no target for this layer
+    PROBE_STATUS_REACHABLE,
+    PROBE_STATUS_UNREACHABLE,       // every probe of the layer failed definitively
+    PROBE_STATUS_TIMEOUT
+} probe_status_t;
+
+typedef struct {
+    probe_status_t status;
+    double rtt_ms;                  // of the first definitive answer, -1 if none
+    char target[64];                // target that answered (or the last one tried)
+    char method[8];                 // arp, icmp, dns, tcp
+    int probes_sent;
+} probe_layer_result_t;
+
+typedef struct {
+    probe_layer_result_t layers[PROBE_LAYER_COUNT];
+    double total_ms;
+} connectivity_probe_result_t;
+
+void connectivity_probe_default_config(connectivity_probe_config_t *config);
+// Parse "gateway=IP,dns=IP,name=HOST,tcp=IP:PORT" (keys may repeat) over the defaults.
+// Returns 0, or -1 with a message in error.
+int connectivity_probe_parse_targets(const char *spec, connectivity_probe_config_t *config, char *error, size_t error_size);
+// Fire gateway ARP/ICMP, DNS and TCP-connect probes at once from the interface and
+// wait for the first definitive answer per layer. Returns the number of reachable layers,
+// or -1 when the interface does not exist.
+int connectivity_probe_run(const char *interface_name, const connectivity_probe_config_t *config,
+                           int timeout_ms, connectivity_probe_result_t *result);
+const char *probe_layer_name(probe_layer_t layer);
+const char *probe_status_name(probe_status_t status);
+
+#endif // CONNECTIVITY_PROBE_H
@@ -0,0 +1,50 @@
+#ifndef DHCP_PROBE_H
+#define DHCP_PROBE_H
+
+#include "wifi_scanner.h"
+#include <stdint.h>
+#include <netinet/in.h>
+
+#define DHCP_PROBE_DEFAULT_TIMEOUT_MS 4000
+#define DHCP_PROBE_RETRANSMIT_MS 1000
+// Below the host's own default routes; traffic bound to the interface still uses it
+#define DHCP_PROBE_ROUTE_METRIC 1024
+
+typedef enum {
+    DHCP_PROBE_OFFER_ONLY = 0,      // DISCOVER -> OFFER, nothing is leased
+    DHCP_PROBE_LEASE,               // DISCOVER -> OFFER -> REQUEST -> ACK, then RELEASE; no address installed
+    DHCP_PROBE_BIND                 // as LEASE, but the address and default route are installed instead of released
+} dhcp_probe_mode_t;
+
+typedef struct {
+    int outcome;                    // 0 answered, -1 error, -2 timed out, -3 NAK
+    dhcp_probe_mode_t mode;
+    int discover_count;
+    double offer_ms;                // first DISCOVER to OFFER, -1 if none
+    double ack_ms;                  // first DISCOVER to ACK, -1 if none
+    double total_ms;
+    int bound;                      // address installed on the interface
+    uint32_t lease_time_s;
+    char offered_ip[INET_ADDRSTRLEN];
+    char server_ip[INET_ADDRSTRLEN];
+    char subnet_mask[INET_ADDRSTRLEN];
+    char router[INET_ADDRSTRLEN];
+    char error[128];
+    // What a BIND installed, so dhcp_probe_release() can take it back out (network byte order)
+    uint32_t bound_address;
+    int bound_prefix_len;
+    uint32_t bound_router;
+    int route_installed;            // 0 when a default route at our metric already existed
+    uint32_t bound_server_id;
+    uint8_t bound_server_mac[6];
+} dhcp_probe_result_t;
+
+// In-process DHCP exchange over an AF_PACKET socket, so no DHCP client process is
+// spawned and the latency excludes process start-up. Returns result->outcome.
+int dhcp_probe_run(const char *interface_name, dhcp_probe_mode_t mode, int timeout_ms, dhcp_probe_result_t *result);
+// Undo a BIND: send DHCPRELEASE and remove the default route and address it installed.
+// Does nothing when result->bound is clear; clears it on return.
+int dhcp_probe_release(const char *interface_name, dhcp_probe_result_t *result);
+const char *dhcp_probe_mode_name(dhcp_probe_mode_t mode);
+
+#endif // DHCP_PROBE_H
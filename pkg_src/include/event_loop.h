@@ -0,0 +1,49 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "wifi_scanner.h"
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#define EVENT_LOOP_MAX_SOURCES 64
+#define EVENT_LOOP_MAX_EVENTS 16
+
+typedef struct event_loop event_loop_t;
+
+// Called with the epoll events of a ready fd. Return <0 to unregister the source (the handler
+// still owns the fd). Level-triggered: a handler that leaves data unread is called again.
+typedef int (*event_handler_t)(event_loop_t *loop, int fd, uint32_t events, void *data);
+
+typedef struct {
+    int fd;
+    event_handler_t handler;
+    void *data;
+    int in_use;
+    uint32_t generation;            // tells a reused slot from an event queued for its previous owner
+} event_source_t;
+
+// One epoll instance driving every fd of a monitor in a single thread. SIGINT and SIGTERM
+// are blocked while it runs and arrive through a signalfd, so shutdown is a normal event.
+struct event_loop {
+    int epoll_fd;
+    int signal_fd;
+    sigset_t saved_mask;
+    int mask_saved;
+    int running;
+    event_source_t sources[EVENT_LOOP_MAX_SOURCES];
+    uint64_t wakeups;               // epoll_wait returns with events
+    uint64_t dispatches;            // handler calls
+};
+
+int event_loop_init(event_loop_t *loop);
+int event_loop_add(event_loop_t *loop, int fd, uint32_t events, event_handler_t handler, void *data);
+// Change the events watched on a registered fd; 0 parks it without unregistering
+int event_loop_modify(event_loop_t *loop, int fd, uint32_t events);
+void event_loop_remove(event_loop_t *loop, int fd);
+// Dispatch until event_loop_stop, a shutdown signal, or an error (-1)
+int event_loop_run(event_loop_t *loop);
+void event_loop_stop(event_loop_t *loop);
+// Close the loop's own fds and restore the signal mask; registered fds belong to their owners
+void event_loop_close(event_loop_t *loop);
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,42 @@
+#ifndef INTERFACE_CACHE_H
+#define INTERFACE_CACHE_H
+
+#include "wifi_scanner.h"
+
+// Field groups of wifi_interface_t with independent lifetimes
+typedef enum {
+    IFACE_FIELDS_STATIC = 0,   // mac, type, mode: effectively never expire
+    IFACE_FIELDS_STATUS,       // admin UP/DOWN: refreshed every tick
+    IFACE_FIELDS_LINK,         // ssid, frequency, channel, tx_power: short-lived
+    IFACE_FIELDS_SIGNAL,       // signal_strength: refreshed every tick
+    IFACE_FIELD_GROUP_COUNT
+} interface_field_group_t;
+
+#define IFACE_FIELD_MASK(group) (1u << (group))
+#define IFACE_FIELD_MASK_ALL ((1u << IFACE_FIELD_GROUP_COUNT) - 1)
+
+// Link group TTL; extended only while both rtnetlink link events and nl80211 MLME events
+// (connect, roam, disconnect, channel switch) can invalidate entries
+#define IFACE_CACHE_LINK_TTL_MS 2000
+#define IFACE_CACHE_LINK_TTL_WITH_EVENTS_MS 10000
+
+typedef struct {
+    unsigned long hits[IFACE_FIELD_GROUP_COUNT];
+    unsigned long misses[IFACE_FIELD_GROUP_COUNT];
+    unsigned long invalidations;
+    unsigned long link_events;
+    unsigned long mlme_events;
+    int events_active;
+} interface_cache_stats_t;
+
+// Cached lookup; refreshes only the stale field groups
+int interface_cache_get(const char *interface_name, wifi_interface_t *interface);
+// Seed or overwrite an entry with a complete snapshot
+void interface_cache_store(const wifi_interface_t *interface);
+// Drop cached data for one interface (NULL drops everything)
+void interface_cache_invalidate(const char *interface_name);
+// Advance the tick; per-tick groups expire on the next lookup
+void interface_cache_tick(void);
+void interface_cache_get_stats(interface_cache_stats_t *stats);
+
+#endif // INTERFACE_CACHE_H
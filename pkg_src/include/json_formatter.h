@@ -2,13 +2,41 @@
 #define JSON_FORMATTER_H
 
 #include "wifi_scanner.h"
+#include "wiphy_capabilities.h"
+#include "connection_batch.h"
+#include "dhcp_probe.h"
+#include "connectivity_probe.h"
+#include "test_history.h"
+#include "tick_scheduler.h"
+#include "link_state.h"
+#include "json_writer.h"
 
 // JSON formatting functions
 void print_interface_json(const wifi_interface_t *interface);
 void print_scan_results_json(const scan_session_t *session);
 void print_scan_result_json(const scan_result_t *result, int is_last);
 void print_continuous_scan_json(const char *interface_name, const scan_session_t *session);
+void print_scan_timing_json(const scan_timing_t *timing);
+void print_tick_schedule_json(const tick_scheduler_t *sched);
+void print_link_state_json(const link_state_t *state);
+void print_test_phases_json(const connection_test_result_t *result);
+void print_test_connectivity_json(const connection_test_result_t *result);
 void print_connection_test_json(const connection_test_result_t *result);
+void print_connection_batch_json(const connection_batch_t *batch);
+void print_test_stats_json(const test_history_entry_t *entry);
+void print_dhcp_probe_json(const char *interface_name, const dhcp_probe_result_t *result);
+void print_connectivity_probe_json(const char *interface_name, const connectivity_probe_result_t *result);
+void print_interface_cache_stats_json(void);
+void print_wiphy_capabilities_json(const char *interface_name, const wiphy_capabilities_t *caps);
 char* escape_json_string(const char *str);
 
+// The same records appended to a writer, for callers assembling a document of their own
+void json_write_interface(json_writer_t *w, const wifi_interface_t *interface);
+void json_write_scan_result(json_writer_t *w, const scan_result_t *result, int is_last);
+void json_write_scan_results(json_writer_t *w, const scan_session_t *session);
+void json_write_scan_timing(json_writer_t *w, const scan_timing_t *timing);
+void json_write_tick_schedule(json_writer_t *w, const tick_scheduler_t *sched);
+void json_write_link_state(json_writer_t *w, const link_state_t *state);
+void json_write_interface_cache_stats(json_writer_t *w);
+
 #endif // JSON_FORMATTER_H
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Output document built in a growable buffer and written with one write(). The appenders
+// never fail individually; an allocation failure sets `failed` and the rest is dropped.
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} json_writer_t;
+
+void json_writer_init(json_writer_t *w);
+void json_writer_free(json_writer_t *w);
+// Empty the buffer, keeping its memory for the next document
+void json_writer_reset(json_writer_t *w);
+
+// Text copied as is: punctuation, keys and indentation
+void json_writer_raw(json_writer_t *w, const char *text);
+void json_writer_raw_n(json_writer_t *w, const char *text, size_t len);
+// Quoted and escaped string value; NULL is written as null
+void json_writer_string(json_writer_t *w, const char *value);
+void json_writer_int(json_writer_t *w, long long value);
+void json_writer_uint(json_writer_t *w, unsigned long long value);
+// Fixed number of decimals, as printf("%.Nf")
+void json_writer_double(json_writer_t *w, double value, int decimals);
+void json_writer_bool(json_writer_t *w, int value);
+void json_writer_null(json_writer_t *w);
+
+// Write the whole buffer to fd and reset it. For stdout, anything still in the stdio
+// buffer is flushed first so records stay in order. Returns 0, or -1 with errno.
+int json_writer_flush(json_writer_t *w, int fd);
+// Append the buffer to a stdio stream and reset it, for fragments inside printf output
+void json_writer_emit(json_writer_t *w, FILE *stream);
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,31 @@
+#ifndef LINK_STATE_H
+#define LINK_STATE_H
+
+#include "wifi_scanner.h"
+
+typedef enum {
+    LINK_STATE_SOURCE_NONE = 0,
+    LINK_STATE_SOURCE_NL80211,      // one NL80211_CMD_GET_SCAN dump
+    LINK_STATE_SOURCE_IW            // one "iw dev <if> link" when nl80211 is unavailable
+} link_state_source_t;
+
+// Everything the connection tests need to know about the station link, read in one go
+typedef struct {
+    int connected;                  // associated with a BSS
+    char bssid[MAX_MAC_LEN];
+    char ssid[MAX_SSID_LEN];
+    int frequency;                  // MHz, 0 when unknown
+    int signal_dbm;
+    int has_signal;
+    char supplicant_state[32];      // wpa_state from the control socket, empty when no supplicant answers
+    link_state_source_t source;
+} link_state_t;
+
+// Sample the link of an interface. Returns 0 (also when disconnected) or -1 when no source answered.
+int link_state_sample(const char *interface_name, link_state_t *state);
+// Connected to exactly this SSID
+int link_state_matches_ssid(const link_state_t *state, const char *ssid);
+// Print the sample the way "iw dev <if> link" summarises it
+void print_link_state(const char *interface_name, const link_state_t *state);
+
+#endif // LINK_STATE_H
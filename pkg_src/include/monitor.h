@@ -0,0 +1,34 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include "wifi_scanner.h"
+#include <stdint.h>
+
+#define MONITOR_MAX_INTERFACES 8
+#define MONITOR_MIN_SCAN_PERIOD 0.5f
+
+// What to report for each interface; a period of 0 turns that record stream off
+typedef struct {
+    const char *interfaces[MONITOR_MAX_INTERFACES];
+    int interface_count;
+    float scan_period;              // seconds between scan starts (at least MONITOR_MIN_SCAN_PERIOD)
+    float info_period;              // interface info records
+    float station_period;           // station link samples
+    int link_events;                // report up/running changes from rtnetlink as they happen
+} monitor_config_t;
+
+typedef struct {
+    uint64_t wakeups;               // event loop wake-ups over the whole run
+    uint64_t dispatches;
+    uint64_t scans;
+    uint64_t scan_timeouts;         // scans killed at FORKED_SCAN_TIMEOUT_MS
+    uint64_t link_events;
+} monitor_stats_t;
+
+// Run every record stream of every interface as handlers on one event loop in this thread,
+// until Ctrl-C/SIGTERM. Scans run in forked children watched through their eventfd and pidfd,
+// so a slow scan on one interface does not hold up the others. Records use the formats of
+// --continuous and --continuous-info. Returns 0, or -1 when the loop could not be set up.
+int monitor_run(const monitor_config_t *config, monitor_stats_t *stats);
+
+#endif // MONITOR_H
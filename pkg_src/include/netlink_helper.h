@@ -0,0 +1,91 @@
+#ifndef NETLINK_HELPER_H
+#define NETLINK_HELPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+
+#define NL_MSG_BUF_SIZE 4096
+#define NL_RECV_BUF_SIZE 32768
+#define NL_DEFAULT_TIMEOUT_MS 2000
+
+// Netlink socket wrapper
+typedef struct {
+    int fd;
+    uint32_t seq;
+    uint32_t port_id;
+} nl_socket_t;
+
+// Fixed-size outgoing message buffer
+typedef struct {
+    union {
+        struct nlmsghdr hdr;
+        char buf[NL_MSG_BUF_SIZE];
+    } u;
+} nl_msg_t;
+
+// Called for every message of a response; return <0 to abort, 0 to continue
+typedef int (*nl_msg_handler_t)(struct nlmsghdr *nlh, void *user_data);
+
+// Iterate over a stream of attributes
+#define nl_attr_for_each(pos, head, len, rem) \
+    for (pos = (struct nlattr *)(head), rem = (int)(len); \
+         rem >= (int)sizeof(struct nlattr) && pos->nla_len >= sizeof(struct nlattr) && pos->nla_len <= rem; \
+         rem -= NLA_ALIGN(pos->nla_len), pos = (struct nlattr *)((char *)pos + NLA_ALIGN(pos->nla_len)))
+
+#define nl_attr_for_each_nested(pos, nla, rem) \
+    nl_attr_for_each(pos, nl_attr_data(nla), nl_attr_len(nla), rem)
+
+// Socket management
+int nl_socket_open(nl_socket_t *sock, int protocol, uint32_t groups);
+void nl_socket_close(nl_socket_t *sock);
+int nl_socket_add_membership(nl_socket_t *sock, uint32_t group);
+
+// Message construction
+void nl_msg_init(nl_msg_t *msg, uint16_t type, uint16_t flags);
+void *nl_msg_append(nl_msg_t *msg, const void *data, size_t len);
+int nl_msg_put_attr(nl_msg_t *msg, uint16_t type, const void *data, size_t len);
+int nl_msg_put_u32(nl_msg_t *msg, uint16_t type, uint32_t value);
+int nl_msg_put_string(nl_msg_t *msg, uint16_t type, const char *value);
+int nl_msg_put_flag(nl_msg_t *msg, uint16_t type);
+void genl_msg_init(nl_msg_t *msg, uint16_t family_id, uint8_t cmd, uint16_t flags);
+
+// Request/response handling
+int nl_send(nl_socket_t *sock, nl_msg_t *msg);
+int nl_receive(nl_socket_t *sock, nl_msg_handler_t handler, void *user_data, int timeout_ms);
+int nl_transact(nl_socket_t *sock, nl_msg_t *msg, nl_msg_handler_t handler, void *user_data);
+
+// Attribute access
+void *nl_attr_data(const struct nlattr *nla);
+int nl_attr_len(const struct nlattr *nla);
+uint8_t nl_attr_get_u8(const struct nlattr *nla);
+uint16_t nl_attr_get_u16(const struct nlattr *nla);
+uint32_t nl_attr_get_u32(const struct nlattr *nla);
+int nl_parse_attrs(struct nlattr **tb, int max_type, void *head, int len);
+int nl_parse_nested(struct nlattr **tb, int max_type, const struct nlattr *nla);
+int genl_parse_attrs(struct nlattr **tb, int max_type, struct nlmsghdr *nlh);
+
+// Generic netlink family lookup
+int genl_resolve_family(nl_socket_t *sock, const char *family_name);
+// Multicast group id of a family's named group (e.g. nl80211 "mlme"), -1 if absent
+int genl_resolve_multicast_group(nl_socket_t *sock, const char *family_name, const char *group_name);
+
+// Block until a routable address is present on the interface (1), the deadline passes (0) or on error (-1)
+int rtnl_wait_for_address(const char *interface_name, int timeout_ms, char *address, size_t address_size);
+
+// Block until the link has every flag in flags_set and none in flags_clear (IFF_UP, IFF_RUNNING, ...).
+// Returns 1 when reached, 0 on timeout, -1 on error; final_flags receives the last seen flags.
+int rtnl_wait_for_link_flags(const char *interface_name, unsigned int flags_set, unsigned int flags_clear,
+                             int timeout_ms, unsigned int *final_flags);
+
+// Install an IPv4 address / default route on the interface (what a DHCP client does on bind).
+// An existing default route with the same metric is left in place: the route call then
+// returns 1 instead of 0, so the caller knows not to delete it later.
+int rtnl_add_ipv4_address(const char *interface_name, uint32_t address_be, int prefix_len);
+int rtnl_add_ipv4_default_route(const char *interface_name, uint32_t gateway_be, uint32_t metric);
+// Undo the above; an address or route that is already gone counts as removed
+int rtnl_del_ipv4_address(const char *interface_name, uint32_t address_be, int prefix_len);
+int rtnl_del_ipv4_default_route(const char *interface_name, uint32_t gateway_be, uint32_t metric);
+
+#endif // NETLINK_HELPER_H
@@ -2,9 +2,11 @@
 #define WIFI_SCAN_ALTERNATIVES_H
 
 #include "wifi_scanner.h"
+#include "tick_scheduler.h"
 #include <pthread.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <stdint.h>
 
 // Use the constants from wifi_scanner.h
 #define INTERFACE_NAME_LEN MAX_INTERFACE_NAME
@@ -19,25 +21,136 @@ typedef enum {
     WIFI_SCAN_METHOD_FORKED_SHM        // Legacy forked with shared memory (deprecated)
 } wifi_scan_method_t;
 
+#define WIFI_SCAN_METHOD_COUNT 6
+#define WIFI_SCAN_METHOD_CHOICE_MAGIC 0x5753434Du  // "WSCM"
+#define WIFI_SCAN_METHOD_CHOICE_VERSION 1
+#define WIFI_SCAN_METHOD_DRIVER_LEN 64
+
+// Benchmark winner for one interface on one driver, stored verbatim on disk
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    char interface[MAX_INTERFACE_NAME];
+    char driver[WIFI_SCAN_METHOD_DRIVER_LEN];
+    wifi_scan_method_t method;
+    time_t measured;
+    int samples;
+    double avg_ms;
+    double cpu_ms;                  // per scan, this process plus its scan children
+    long rss_kb;                    // peak resident size of the process running the method
+    double failure_rate;            // scans that returned no networks
+} wifi_scan_method_choice_t;
+
 // Scan result callback function type
 typedef void (*wifi_scan_callback_t)(const char* interface, scan_result_t* results, int count, void* user_data);
 
-// Thread-safe scan context structure
+// One scan's results as published by the worker
 typedef struct {
-    char interface[INTERFACE_NAME_LEN];
     scan_result_t results[MAX_SCAN_RESULTS];
     int result_count;
+    int scan_status;                // 0 when the scan found networks, -1 otherwise
+    time_t scan_time;
+    uint64_t sequence;              // publication number, starting at 1
+} wifi_scan_buffer_t;
+
+#define WIFI_SCAN_BUFFER_COUNT 3
+#define WIFI_SCAN_BUFFER_INDEX_MASK 0x3u
+#define WIFI_SCAN_BUFFER_FRESH 0x4u    // set in ready_index until a reader takes the buffer
+
+// Thread-safe scan context structure. Results are triple-buffered: the worker scans into its
+// back buffer and publishes it by atomically swapping it into ready_index; the reader swaps
+// ready and front the same way. Neither side takes a lock or waits for the other, so a reader
+// never blocks on a scan in flight and the callback runs outside any lock.
+typedef struct {
+    char interface[INTERFACE_NAME_LEN];
+    wifi_scan_buffer_t buffers[WIFI_SCAN_BUFFER_COUNT];
+    unsigned int back_index;        // worker thread only
+    unsigned int front_index;       // reader thread only
+    unsigned int ready_index;       // atomic: latest publication, | WIFI_SCAN_BUFFER_FRESH when unread
     wifi_scan_callback_t callback;
     void* user_data;
-    pthread_mutex_t mutex;
-    pthread_cond_t condition;
-    volatile int scan_complete;
+    pthread_mutex_t mutex;          // start/stop only, never held across a scan
+    volatile int scan_complete;     // atomic: at least one scan published
     volatile int scan_active;
     int scan_interval_ms;
+    tick_scheduler_t scheduler;     // continuous mode: fixed-rate ticks, stopped by async_stop
     pthread_t thread_id;
-    int scan_status;
 } wifi_scan_context_t;
 
+#define WIFI_SCAN_ASYNC_MAX_REQUESTS 16
+#define WIFI_SCAN_ASYNC_DEFAULT_DEADLINE_SECONDS 15
+
+// What to scan, for wifi_scan_async_submit
+typedef struct {
+    char interface[INTERFACE_NAME_LEN];
+    int frequencies[SCAN_MAX_FREQUENCIES]; // MHz
+    int frequency_count;            // 0 scans every channel of band_mask
+    uint32_t band_mask;             // WIPHY_BAND_* bits; 0 for every band
+    int deadline_ms;                // from submission; 0 for the wifi_scan_timeout_handler default
+} wifi_scan_request_t;
+
+typedef enum {
+    WIFI_SCAN_ASYNC_DONE = 0,       // the scan ran; result_count may still be 0
+    WIFI_SCAN_ASYNC_TIMED_OUT,      // the deadline passed before a scan returned networks
+    WIFI_SCAN_ASYNC_FAILED          // could not be run at all
+} wifi_scan_async_status_t;
+
+// A finished request taken from a queue; free it with wifi_scan_completion_release
+typedef struct {
+    int handle;
+    char interface[INTERFACE_NAME_LEN];
+    wifi_scan_async_status_t status;
+    scan_result_t* results;         // heap, MAX_SCAN_RESULTS entries
+    int result_count;
+    scan_timing_t timing;
+    long long queued_ms;            // submission until the scan started
+    long long duration_ms;          // submission until completion
+} wifi_scan_completion_t;
+
+struct wifi_scan_queue;
+
+typedef struct {
+    int in_use;                     // running, or finished and waiting to be reaped
+    uint64_t finished_order;        // completion sequence, 0 while running
+    struct wifi_scan_queue* queue;
+    wifi_scan_request_t request;
+    wifi_scan_callback_t callback;
+    void* user_data;
+    long long submitted_ms;
+    wifi_scan_completion_t completion;
+} wifi_scan_slot_t;
+
+// Scans in flight on any number of interfaces, each on its own thread. Completions without a
+// callback are queued in finishing order; completion_fd is an eventfd semaphore that stays
+// readable while any are queued, so the queue plugs into poll/epoll loops.
+typedef struct wifi_scan_queue {
+    int completion_fd;
+    pthread_mutex_t mutex;
+    pthread_cond_t idle;            // broadcast when the last running request finishes
+    wifi_scan_slot_t slots[WIFI_SCAN_ASYNC_MAX_REQUESTS];
+    int next_handle;
+    int running;
+    uint64_t finished;
+} wifi_scan_queue_t;
+
+// Pipe method wire format: a stream of frames, each a header followed by `length` payload
+// bytes. A scan is any number of RECORD frames (one network each) closed by an END frame
+// whose payload is the child's int32 scan status. Numbers are in host byte order; both ends
+// are the same binary.
+#define WIFI_PIPE_FRAME_MAGIC 0x5346u       // "FS"
+#define WIFI_PIPE_FRAME_VERSION 1
+#define WIFI_PIPE_FRAME_RECORD 1
+#define WIFI_PIPE_FRAME_END 2
+#define WIFI_PIPE_MAX_PAYLOAD 512
+#define WIFI_PIPE_RING_SIZE 16384
+
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint32_t length;
+} wifi_pipe_frame_header_t;
+
 // Pipe-based scan communication structure
 typedef struct {
     int pipe_fd[2];  // [0] = read, [1] = write
@@ -46,16 +159,49 @@ typedef struct {
     volatile int scan_running;
 } wifi_pipe_scan_context_t;
 
-// Signal-based scan context
+// Realtime, so completions queue instead of merging; blocked in every thread that executes
+// a signal-based scan
+#define WIFI_SCAN_COMPLETION_SIGNAL (SIGRTMIN + 4)
+
+// Signal-based scan context. The child reports completion with WIFI_SCAN_COMPLETION_SIGNAL
+// sent to the executing thread alone, carrying its result count. The parent reads it from
+// its own signalfd and matches it by the child's pid, so any number of contexts can run on
+// different threads and a late signal from an abandoned child is ignored.
 typedef struct {
     char interface[INTERFACE_NAME_LEN];
     scan_result_t* result_buffer;
-    int* result_count_buffer;
-    volatile sig_atomic_t scan_ready;
-    volatile sig_atomic_t scan_error;
+    int signal_fd;
     pid_t scanner_pid;
 } wifi_signal_scan_context_t;
 
+#define WIFI_SCAN_WORKER_OP_SCAN 1   // any other request ends the worker
+
+// Request (value: WIFI_SCAN_WORKER_OP_*) and reply (value: result count) on the worker socket
+typedef struct {
+    uint32_t sequence;
+    int32_t value;
+} wifi_scan_worker_msg_t;
+
+// Written by the worker, read by the parent after the matching reply
+typedef struct {
+    int result_count;
+    scan_result_t results[MAX_SCAN_RESULTS];
+} wifi_scan_worker_shared_t;
+
+// Long-lived scan process, forked once and driven over a SOCK_SEQPACKET socketpair. The
+// result mapping outlives the process, so restarting after a crash or stall costs a fork
+// and nothing else. The worker leads its own process group, so a stalled worker is killed
+// together with its iw.
+typedef struct {
+    char interface[INTERFACE_NAME_LEN];
+    pid_t pid;                      // 0 while no worker runs
+    int sock_fd;                    // parent end
+    wifi_scan_worker_shared_t* shared;
+    uint32_t sequence;              // of the last request
+    int timeout_ms;                 // per scan; a worker that misses it is treated as stalled
+    int starts;                     // worker processes started, the first one included
+} wifi_scan_worker_t;
+
 // Function prototypes for alternative scan methods
 
 // Direct synchronous scanning (no shared memory)
@@ -78,27 +224,73 @@ int wifi_scan_signal_based_init(wifi_signal_scan_context_t* ctx, const char* int
 int wifi_scan_signal_based_execute(wifi_signal_scan_context_t* ctx, scan_result_t* results, int max_results);
 int wifi_scan_signal_based_cleanup(wifi_signal_scan_context_t* ctx);
 
-// Callback-based asynchronous scanning
+// Persistent scan worker
+int wifi_scan_worker_init(wifi_scan_worker_t* worker, const char* interface);
+// One scan on the worker, restarting it first if it died since the last one. Returns the
+// result count, or -1 when the worker crashed, stalled or could not be started.
+int wifi_scan_worker_scan(wifi_scan_worker_t* worker, scan_result_t* results, int max_results);
+void wifi_scan_worker_destroy(wifi_scan_worker_t* worker);
+
+// Asynchronous scan requests with a completion queue
+int wifi_scan_queue_init(wifi_scan_queue_t* queue);
+// Start a request and return its handle (>0) without waiting, or -1 (errno EBUSY when all
+// WIFI_SCAN_ASYNC_MAX_REQUESTS slots are taken). With a callback the results are delivered on
+// the scan's thread instead of being queued.
+int wifi_scan_async_submit(wifi_scan_queue_t* queue, const wifi_scan_request_t* request,
+                           wifi_scan_callback_t callback, void* user_data);
+// Take the oldest queued completion without waiting: 1 when one was taken, 0 when none is ready
+int wifi_scan_async_reap(wifi_scan_queue_t* queue, wifi_scan_completion_t* completion);
+void wifi_scan_completion_release(wifi_scan_completion_t* completion);
+// Wait for the requests still running, then drop completions nobody reaped
+void wifi_scan_queue_destroy(wifi_scan_queue_t* queue);
+
+// Callback-based asynchronous scanning of all channels on a process-wide queue; returns the
+// handle, or -1. The callback runs on the scan's thread.
 int wifi_scan_async_callback_start(const char* interface, wifi_scan_callback_t callback, void* user_data);
 
 // Continuous scanning alternatives
+// Blocks until keep_running clears; the callback runs on the scan thread once per tick
 int wifi_continuous_scan_threaded(const char* interface, int interval_ms, 
                                   wifi_scan_callback_t callback, void* user_data);
+// Blocks until keep_running clears; the callback runs once per scheduler tick
 int wifi_continuous_scan_timer_based(const char* interface, int interval_ms, 
                                      wifi_scan_callback_t callback, void* user_data);
+// Schedule of the timer-based loop in this thread (tick, skipped ticks), NULL outside its callback
+const tick_scheduler_t* wifi_continuous_scan_current_schedule(void);
 
 // Enhanced continuous scanning with different methods
 void wifi_continuous_scan_loop_threaded(const char* interface_name, float delay_seconds);
 void wifi_continuous_scan_loop_pipe(const char* interface_name, float delay_seconds);
 void wifi_continuous_scan_loop_signal(const char* interface_name, float delay_seconds);
+void wifi_continuous_scan_loop_timer(const char* interface_name, float delay_seconds);
+// Submit one request per interface at once and print completions as they arrive
+void wifi_scan_async_loop(const char* const* interfaces, int interface_count,
+                          const int* frequencies, int frequency_count, uint32_t band_mask, int deadline_ms);
 
 // Utility functions
 void wifi_scan_context_init(wifi_scan_context_t* ctx);
 void wifi_scan_context_destroy(wifi_scan_context_t* ctx);
+// Latest published scan, without waiting. NULL before the first publication. The buffer
+// stays valid until this reader's next call; call from one reader thread only.
+const wifi_scan_buffer_t* wifi_scan_context_latest(wifi_scan_context_t* ctx);
+// Set the deadline of async requests that do not carry their own (0 or less only queries it).
+// Returns the previous value in seconds.
 int wifi_scan_timeout_handler(int timeout_seconds);
 
 // Method selection and configuration
+// Method forced with wifi_configure_scan_method, else the --bench-methods winner stored for
+// this interface and its driver, else WIFI_SCAN_METHOD_THREADED
 wifi_scan_method_t wifi_select_optimal_scan_method(const char* interface);
+// Force one method for this process; -1 clears the override
 int wifi_configure_scan_method(wifi_scan_method_t method);
+// One scan with the given method, the way its --scan-* command runs it
+int wifi_scan_with_method(wifi_scan_method_t method, const char* interface,
+                          scan_result_t* results, int max_results);
+const char* wifi_scan_method_name(wifi_scan_method_t method);
+// Method of a wifi_scan_method_name string, or -1
+int wifi_scan_method_from_name(const char* name);
+int wifi_scan_method_load_choice(const char* interface, wifi_scan_method_choice_t* choice);
+// Fills in magic, version and driver before writing
+int wifi_scan_method_store_choice(wifi_scan_method_choice_t* choice);
 
 #endif // WIFI_SCAN_ALTERNATIVES_H
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef SUPPLICANT_CTRL_H
+#define SUPPLICANT_CTRL_H
+
+#include "wifi_scanner.h"
+#include <sys/un.h>
+
+#define SUPPLICANT_CTRL_DIR "/var/run/wpa_supplicant"
+#define SUPPLICANT_CTRL_REPLY_LEN 4096
+#define SUPPLICANT_CTRL_EVENT_LEN 512
+#define SUPPLICANT_CTRL_PENDING_EVENTS 16
+#define SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS 2000
+
+// Client side of the wpa_supplicant control socket
+typedef struct {
+    int fd;
+    int attached;
+    char local_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    char interface_name[MAX_INTERFACE_NAME];
+    int target_network_id;          // network a wait must see connected, -1 for any
+    // Unsolicited events received while waiting for a command reply
+    int pending_count;
+    char pending[SUPPLICANT_CTRL_PENDING_EVENTS][SUPPLICANT_CTRL_EVENT_LEN];
+} supplicant_ctrl_t;
+
+typedef enum {
+    SUPPLICANT_EVENT_OTHER = 0,
+    SUPPLICANT_EVENT_CONNECTED,
+    SUPPLICANT_EVENT_DISCONNECTED,
+    SUPPLICANT_EVENT_SSID_TEMP_DISABLED,
+    SUPPLICANT_EVENT_ASSOC_REJECT,
+    SUPPLICANT_EVENT_AUTH_REJECT,
+    SUPPLICANT_EVENT_NETWORK_NOT_FOUND,
+    SUPPLICANT_EVENT_TERMINATING,
+    SUPPLICANT_EVENT_ASSOCIATING,
+    SUPPLICANT_EVENT_ASSOCIATED,
+    SUPPLICANT_EVENT_KEY_NEGOTIATED
+} supplicant_event_type_t;
+
+// Outcome of waiting for a connection attempt
+typedef struct {
+    int outcome;                    // 0 connected, -1 failed, -2 timed out
+    char reason[160];               // failure reason as reported by the supplicant
+    long long associating_ms;       // monotonic timestamps, 0 when not observed
+    long long associated_ms;
+    long long key_negotiated_ms;
+    long long connected_ms;
+} supplicant_wait_result_t;
+
+// Connection management
+int supplicant_ctrl_open(supplicant_ctrl_t *ctrl, const char *ctrl_dir, const char *interface_name);
+int supplicant_ctrl_open_wait(supplicant_ctrl_t *ctrl, const char *ctrl_dir, const char *interface_name, int timeout_ms);
+void supplicant_ctrl_close(supplicant_ctrl_t *ctrl);
+
+// Commands and events
+int supplicant_ctrl_request(supplicant_ctrl_t *ctrl, const char *command, char *reply, size_t reply_size, int timeout_ms);
+int supplicant_ctrl_attach(supplicant_ctrl_t *ctrl);
+int supplicant_ctrl_receive_event(supplicant_ctrl_t *ctrl, char *event, size_t event_size, int timeout_ms);
+supplicant_event_type_t supplicant_classify_event(const char *event);
+int supplicant_ctrl_get_status_field(supplicant_ctrl_t *ctrl, const char *field, char *value, size_t value_size);
+int supplicant_reply_get_field(const char *reply, const char *field, char *value, size_t value_size);
+
+// Runtime network provisioning (no config file); psk_hex NULL adds an open network
+int supplicant_ctrl_add_network(supplicant_ctrl_t *ctrl, const char *ssid, const char *psk_hex);
+int supplicant_ctrl_select_network(supplicant_ctrl_t *ctrl, int network_id);
+// Reattach to a known network on one BSSID and channel (falls back to an unpinned select
+// when the supplicant does not accept freq=); frequency 0 leaves the channel open
+int supplicant_ctrl_select_network_pinned(supplicant_ctrl_t *ctrl, int network_id, const char *bssid, int frequency);
+int supplicant_ctrl_remove_network(supplicant_ctrl_t *ctrl, int network_id);
+// Ids of the configured networks not marked [DISABLED], so a caller can hand back exactly
+// what SELECT_NETWORK disables. Returns the number of ids stored, or -1.
+int supplicant_ctrl_list_enabled_networks(supplicant_ctrl_t *ctrl, int *network_ids, int max_ids);
+// ENABLE_NETWORK for each id; 0 when every one was accepted
+int supplicant_ctrl_enable_networks(supplicant_ctrl_t *ctrl, const int *network_ids, int count);
+
+// Block until CONNECTED, a terminal failure event, or the deadline
+int supplicant_wait_for_connection(supplicant_ctrl_t *ctrl, int timeout_ms, supplicant_wait_result_t *result);
+
+#endif // SUPPLICANT_CTRL_H
@@ -0,0 +1,35 @@
+#ifndef SUPPLICANT_SESSION_H
+#define SUPPLICANT_SESSION_H
+
+#include "wifi_scanner.h"
+
+#define SUPPLICANT_SESSION_START_TIMEOUT_MS 3000
+#define SUPPLICANT_SESSION_MAX_NETWORKS 64
+
+// A wpa_supplicant instance kept alive across connection tests on one interface.
+// Tests provision networks over its control socket instead of restarting it.
+typedef struct {
+    int in_use;
+    int owned;                      // started by us (stopped by supplicant_session_stop)
+    pid_t daemon_pid;
+    char interface_name[MAX_INTERFACE_NAME];
+    char config_path[256];
+    char pidfile_path[256];
+    long long started_ms;
+    int start_duration_ms;
+    // Networks an adopted supplicant had enabled before tests selected theirs; handed back
+    // once by supplicant_session_stop
+    int enabled_network_count;
+    int enabled_networks[SUPPLICANT_SESSION_MAX_NETWORKS];
+} supplicant_session_t;
+
+// Start a control-interface-only supplicant on the interface, or adopt one that
+// already answers there. Returns 0 when a supplicant is ready, -1 otherwise.
+int supplicant_session_start(const char *interface_name);
+// Terminate the supplicant if this process started it; adopted ones are left running with
+// the networks they had enabled at start enabled again
+void supplicant_session_stop(const char *interface_name);
+int supplicant_session_active(const char *interface_name);
+int supplicant_session_get(const char *interface_name, supplicant_session_t *session);
+
+#endif // SUPPLICANT_SESSION_H
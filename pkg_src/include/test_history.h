@@ -0,0 +1,66 @@
+#ifndef TEST_HISTORY_H
+#define TEST_HISTORY_H
+
+#include "wifi_scanner.h"
+#include <stdint.h>
+
+#ifndef TEST_HISTORY_DIR
+#define TEST_HISTORY_DIR PERSISTENT_STATE_DIR
+#endif
+#define TEST_HISTORY_LOG TEST_HISTORY_DIR "/test_history.log"
+#define TEST_HISTORY_INDEX TEST_HISTORY_DIR "/test_history.idx"
+
+#define TEST_HISTORY_MAGIC 0x54485354u  // "THST"
+#define TEST_HISTORY_VERSION 1
+#define TEST_HISTORY_MAX_SSIDS 128
+
+// Log-bucketed quantile sketch: every estimate is within 2% of a true sample value.
+// Bucket i > 0 holds values in [gamma^(i-1), gamma^i) ms; bucket 0 holds values below 1 ms.
+#define SKETCH_RELATIVE_ACCURACY 0.02
+#define SKETCH_BUCKETS 352              // covers up to ~20 minutes
+
+// Metrics tracked per SSID: one per test phase plus the whole test
+#define TEST_HISTORY_METRIC_TOTAL TEST_PHASE_COUNT
+#define TEST_HISTORY_METRIC_COUNT (TEST_PHASE_COUNT + 1)
+
+typedef struct {
+    uint32_t count;
+    uint32_t buckets[SKETCH_BUCKETS];
+} quantile_sketch_t;
+
+// One fixed-size record of the append-only log
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    connection_test_result_t result;
+} test_history_record_t;
+
+// One slot of the index file: running counters and sketches for an SSID
+typedef struct {
+    char ssid[MAX_SSID_LEN];
+    uint32_t tests;
+    uint32_t successes;
+    time_t first_test;
+    time_t last_test;
+    quantile_sketch_t metrics[TEST_HISTORY_METRIC_COUNT];
+} test_history_entry_t;
+
+// Index header; slots follow it in insertion order
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t record_count;          // log records folded into the index
+} test_history_index_header_t;
+
+void sketch_add(quantile_sketch_t *sketch, double value_ms);
+double sketch_quantile(const quantile_sketch_t *sketch, double quantile);
+
+// Append a result to the log and fold it into the SSID's index slot
+int test_history_append(const connection_test_result_t *result);
+// Look an SSID up in the index; records the index has not seen yet (or all of them when the
+// index is missing or corrupt) are folded in from the log first. 0 found, 1 unknown SSID, -1 error.
+int test_history_lookup(const char *ssid, test_history_entry_t *entry);
+const char *test_history_metric_name(int metric);
+
+#endif // TEST_HISTORY_H
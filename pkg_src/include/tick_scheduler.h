@@ -0,0 +1,37 @@
+#ifndef TICK_SCHEDULER_H
+#define TICK_SCHEDULER_H
+
+#include "wifi_scanner.h"
+#include <stdint.h>
+
+// Fixed-rate ticks for the continuous loops. Deadlines are absolute CLOCK_MONOTONIC times
+// (first + n * period) kept by a timerfd, so the period does not stretch by the work done
+// in each tick; a tick that finds whole periods already gone counts them as skipped.
+typedef struct {
+    int timer_fd;
+    int stop_fd;                    // eventfd: tick_scheduler_stop wakes a blocked wait
+    long long period_ns;
+    long long first_deadline_ns;    // CLOCK_MONOTONIC
+    double align_seconds;           // wall-clock boundary of the first tick, 0 for "now"
+    uint64_t expirations;           // periods elapsed so far, delivered or skipped
+    uint64_t ticks;                 // ticks delivered to the loop
+    uint64_t skipped_ticks;         // periods lost because the previous tick's work overran them
+    long long lateness_us;          // last wake-up behind its deadline
+} tick_scheduler_t;
+
+// Process-wide phase alignment from --align: the first tick of every scheduler falls on a
+// multiple of this many seconds of wall-clock time. 0 (the default) starts immediately.
+void tick_scheduler_set_alignment(double align_seconds);
+double tick_scheduler_get_alignment(void);
+
+int tick_scheduler_init(tick_scheduler_t *sched, double period_seconds);
+// Take the expirations pending on timer_fd without blocking, for callers that watch the fd
+// themselves (the event loop). 1 on a tick, 0 when none is due yet, -1 on error.
+int tick_scheduler_consume(tick_scheduler_t *sched);
+// Block until the next tick. 1 on a tick, 0 when stopped or interrupted for shutdown, -1 on error.
+int tick_scheduler_wait(tick_scheduler_t *sched);
+// Wake a wait in another thread and make every later wait return 0
+void tick_scheduler_stop(tick_scheduler_t *sched);
+void tick_scheduler_close(tick_scheduler_t *sched);
+
+#endif // TICK_SCHEDULER_H
@@ -23,6 +23,21 @@
 #define MAX_MAC_LEN 18
 #define CONNECTION_TIMEOUT_SECONDS 5
 #define SECURED_CONNECTION_TIMEOUT_SECONDS 10
+#define RESTORE_TIMEOUT_MS 5000
+#define MAX_PMKSA_LEN 512
+#define RUNTIME_STATE_DIR "/run/ur-wireless-tools"
+#define PERSISTENT_STATE_DIR "/var/lib/ur-wireless-tools"
+#define SCAN_MAX_FREQUENCIES 32
+
+// Network the interface was on before a test, so restore can reattach without a full scan
+typedef struct {
+    int supplicant_managed;         // selected and completed in a running wpa_supplicant
+    int network_id;
+    char bssid[MAX_MAC_LEN];
+    int frequency;
+    char configured_bssid[MAX_MAC_LEN]; // the network's own bssid setting ("any" when unpinned)
+    char pmksa[MAX_PMKSA_LEN];      // PMKSA_GET entries, empty when the supplicant does not export them
+} network_profile_t;
 
 // Structure to hold interface information
 typedef struct {
@@ -37,6 +52,7 @@ typedef struct {
     int tx_power;
     char mode[32];
     int was_connected;
+    network_profile_t profile;      // filled by save_interface_state only
 } wifi_interface_t;
 
 // Structure to hold scan result
@@ -52,6 +68,29 @@ typedef struct {
     char timestamp[32];
 } scan_result_t;
 
+// Wall-clock breakdown of one scan (CLOCK_MONOTONIC, milliseconds)
+typedef struct {
+    int interface_info_ms;          // interface query before the scan
+    int scan_command_ms;            // scan command until its output starts (kernel scan)
+    int parse_ms;                   // reading and parsing the scan output
+    int retry_wait_ms;              // settle delays between empty attempts
+    int process_overhead_ms;        // fork, shared memory and reaping around the scan
+    int attempts;
+    int handoff_us;                 // forked scan: child's completion signal until the parent woke, -1 otherwise
+} scan_timing_t;
+
+// A forked scan in flight. The child scans into an anonymous shared mapping and writes
+// done_fd once the results are published; pidfd becomes readable when it exits.
+typedef struct {
+    pid_t pid;
+    int done_fd;
+    int pidfd;                      // -1 when the kernel has no pidfd_open
+    void *shared;
+    long long started_ms;
+} forked_scan_t;
+
+#define FORKED_SCAN_TIMEOUT_MS 12000
+
 // Structure to hold scan session data
 typedef struct {
     wifi_interface_t interface;
@@ -59,8 +98,31 @@ typedef struct {
     int result_count;
     time_t scan_time;
     int scan_duration_ms;
+    scan_timing_t timing;
 } scan_session_t;
 
+// Phases of a connection test in execution order
+typedef enum {
+    TEST_PHASE_STATE_SAVE = 0,
+    TEST_PHASE_CONFIG_WRITE,
+    TEST_PHASE_LINK_RESET,
+    TEST_PHASE_SUPPLICANT_START,    // daemon start or runtime provisioning, until events are attached
+    TEST_PHASE_AUTH_ASSOC,
+    TEST_PHASE_HANDSHAKE,           // association to key negotiation (secured networks)
+    TEST_PHASE_DHCP,
+    TEST_PHASE_CONNECTIVITY_PROBE,
+    TEST_PHASE_RESTORE,             // cleanup and state restore
+    TEST_PHASE_COUNT
+} test_phase_t;
+
+// Layers checked by the connectivity probe after DHCP
+typedef enum {
+    PROBE_LAYER_GATEWAY = 0,
+    PROBE_LAYER_DNS,
+    PROBE_LAYER_INTERNET,
+    PROBE_LAYER_COUNT
+} probe_layer_t;
+
 // Structure to hold connection test result
 typedef struct {
     char ssid[MAX_SSID_LEN];
@@ -70,9 +132,13 @@ typedef struct {
     char connection_type[32];
     time_t test_time;
     int test_duration_ms;
+    int dhcp_duration_ms;           // DHCP client start to address assignment, 0 if none
+    int phase_ms[TEST_PHASE_COUNT]; // wall-clock time per phase, -1 when the phase did not run
+    double layer_rtt_ms[PROBE_LAYER_COUNT]; // connectivity probe RTT per layer, -1 when unreachable or not probed
     char original_ssid[MAX_SSID_LEN];
     char original_bssid[MAX_MAC_LEN];
     int was_connected;
+    int restore_duration_ms;        // restore start until the original link was back, -1 if not restored
 } connection_test_result_t;
 
 // Global variables
@@ -82,22 +148,60 @@ extern float scan_delay;
 // Function declarations
 int detect_wifi_interfaces(wifi_interface_t *interfaces, int max_interfaces);
 int get_interface_info(const char *interface_name, wifi_interface_t *interface);
+int fetch_interface_fields(const char *interface_name, wifi_interface_t *interface, unsigned int field_mask);
 int perform_scan(const char *interface_name, scan_result_t *results, int max_results);
+// Scan only the given channels (MHz; none for all) and give up at timeout_ms overall
+// (0: each attempt gets the usual scan timeout)
+int perform_scan_frequencies(const char *interface_name, const int *frequencies, int frequency_count,
+                             int timeout_ms, scan_result_t *results, int max_results);
 int perform_forked_scan(const char *interface_name, scan_result_t *results, int max_results);
+// perform_forked_scan in two halves for callers with their own event loop: start returns -1
+// when no child could be forked; finish (after done_fd or pidfd fired, or the deadline passed)
+// reaps the child, killing it if it has not signalled, and returns the result count.
+int forked_scan_start(const char *interface_name, forked_scan_t *scan);
+int forked_scan_finish(forked_scan_t *scan, scan_result_t *results, int max_results);
+void get_last_scan_timing(scan_timing_t *timing);
+int run_timed_scan(const char *interface_name, scan_session_t *session);
+// Fill the session's timing from the last scan; info_start_ms and scan_start_ms bracket the
+// interface query, and the scan is taken to have ended now
+void complete_timed_scan(scan_session_t *session, long long info_start_ms, long long scan_start_ms);
 void continuous_scan_loop(const char *interface_name, float delay_seconds);
 void continuous_info_loop(const char *interface_name, float delay_seconds);
 int test_open_ap_connection(const char *interface_name, const char *ssid, connection_test_result_t *result);
 int test_secured_ap_connection(const char *interface_name, const char *ssid, const char *password, connection_test_result_t *result);
+// Variants for batch sessions: the caller saves, resets and restores the interface once
+int test_open_ap_connection_in_session(const char *interface_name, const char *ssid, connection_test_result_t *result);
+int test_secured_ap_connection_in_session(const char *interface_name, const char *ssid, const char *password, connection_test_result_t *result);
 int start_wpa_supplicant_with_timeout(const char *interface_name, const char *config_file, int timeout_seconds, pid_t *wpa_pid);
 int start_wpa_supplicant_secured_with_timeout(const char *interface_name, const char *config_file, const char *ssid, int timeout_seconds, pid_t *wpa_pid);
+const char* get_wpa_failure_reason(void);
+const char* test_phase_name(test_phase_t phase);
+int cleanup_interface_connections(const char *interface_name);
+void terminate_interface_processes(const char *interface_name);
+// Kill "<program> -i <interface>" processes of this interface only
+void kill_interface_process(const char *program, const char *interface_name);
+void flush_interface_addresses(const char *interface_name);
 int save_interface_state(const char *interface_name, wifi_interface_t *saved_state);
 int restore_interface_state(const char *interface_name, const wifi_interface_t *saved_state);
+// Duration of the last restore in this thread, -1 when there was nothing to reattach
+int get_last_restore_duration_ms(void);
 char* generate_random_filename(void);
 void log_command_execution(const char *command, const char *description);
-int execute_command_with_logging(const char *command, const char *description);
-FILE* execute_command_with_output_logging(const char *command, const char *description);
+// Run an argv (no shell) through the command runner, logging the command and its exit code;
+// the output variant also prints what it wrote. Both return the exit code or -1.
+int execute_command_with_logging(const char *const argv[], const char *description);
+int execute_command_with_output_logging(const char *const argv[], const char *description);
 void signal_handler(int sig);
 void print_usage(const char *program_name);
 void precise_sleep(float seconds);
+int wait_for_link_state(const char *interface_name, unsigned int flags_set, unsigned int flags_clear, int timeout_ms);
+// Make wait_for_link_state sleep its full bound, as the fixed delays it replaced did (benchmarks only)
+void set_fixed_link_waits(int fixed);
+int wait_for_process_exit(pid_t pid, int timeout_ms);
+int reset_interface_link(const char *interface_name);
+long long monotonic_time_ms(void);
+int ensure_runtime_state_dir(void);
+int ensure_persistent_state_dir(void);
+int create_state_file(const char *path, mode_t mode);
 
 #endif // WIFI_SCANNER_H
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef WIPHY_CAPABILITIES_H
+#define WIPHY_CAPABILITIES_H
+
+#include "wifi_scanner.h"
+#include <stdint.h>
+
+#define WIPHY_CACHE_MAGIC 0x57495048u  // "WIPH"
+#define WIPHY_CACHE_VERSION 2
+#define WIPHY_MAX_CHANNELS 128
+#define WIPHY_MAX_COMBINATIONS 8
+#define WIPHY_MAX_COMB_LIMITS 4
+#define WIPHY_MAX_DRIVER_LEN 64
+#define WIPHY_REG_ALPHA2_LEN 4
+
+// Band bits for wiphy_capabilities_t.band_mask
+#define WIPHY_BAND_2GHZ  (1u << 0)
+#define WIPHY_BAND_5GHZ  (1u << 1)
+#define WIPHY_BAND_60GHZ (1u << 2)
+#define WIPHY_BAND_6GHZ  (1u << 3)
+
+// Single channel supported by the radio
+typedef struct {
+    int frequency;
+    int channel;
+    unsigned char band;       // WIPHY_BAND_* bit index
+    unsigned char disabled;
+    unsigned char no_ir;      // passive scan only
+    unsigned char radar;
+} wiphy_channel_t;
+
+// One limit inside an interface combination (e.g. "#{ AP } <= 4")
+typedef struct {
+    int max_interfaces;
+    uint32_t iftype_mask;     // bit per NL80211_IFTYPE_*
+} wiphy_comb_limit_t;
+
+typedef struct {
+    int limit_count;
+    wiphy_comb_limit_t limits[WIPHY_MAX_COMB_LIMITS];
+    int max_interfaces;
+    int num_channels;
+} wiphy_combination_t;
+
+// Capability model of one wiphy, stored verbatim in the on-disk cache
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    char phy_name[MAX_INTERFACE_NAME];
+    char driver[WIPHY_MAX_DRIVER_LEN];
+    char reg_alpha2[WIPHY_REG_ALPHA2_LEN]; // regulatory domain the channel flags were read under
+    int phy_index;
+    time_t created;
+    uint32_t band_mask;
+    uint32_t iftype_mask;
+    int max_scan_ssids;
+    int max_sched_scan_ssids;
+    int max_match_sets;
+    int sched_scan_supported;
+    int supports_ap;
+    int supports_monitor;
+    int supports_station;
+    int channel_count;
+    wiphy_channel_t channels[WIPHY_MAX_CHANNELS];
+    int combination_count;
+    wiphy_combination_t combinations[WIPHY_MAX_COMBINATIONS];
+} wiphy_capabilities_t;
+
+// Capability lookup (memory cache -> disk cache -> nl80211 GET_WIPHY). Cache entries are
+// keyed by the current regulatory domain, so a country change never serves stale
+// disabled/no_ir/radar flags.
+int wiphy_get_capabilities(const char *interface_name, wiphy_capabilities_t *caps);
+int wiphy_refresh_capabilities(const char *interface_name, wiphy_capabilities_t *caps);
+int wiphy_query_nl80211(int phy_index, wiphy_capabilities_t *caps);
+// Regulatory alpha2 in force for the wiphy ("00" world, "99" intersected); -1 if unknown
+int wiphy_query_reg_alpha2(int phy_index, char *alpha2, size_t alpha2_size);
+
+// Helpers for interface selection and scan planning
+int wiphy_get_phy_identity(const char *interface_name, char *phy_name, size_t phy_size,
+                           int *phy_index, char *driver, size_t driver_size);
+// Kernel driver bound to the interface's device, "unknown" for virtual links
+void wiphy_get_driver_name(const char *interface_name, char *driver, size_t driver_size);
+int wiphy_can_scan(const wiphy_capabilities_t *caps);
+int wiphy_supports_frequency(const wiphy_capabilities_t *caps, int frequency);
+int wiphy_get_scan_frequencies(const wiphy_capabilities_t *caps, uint32_t band_mask, int *frequencies, int max_frequencies);
+// Channel list for a scan on the interface: the requested frequencies the radio can use
+// (limited to band_mask when set), or every enabled channel of band_mask when none are
+// requested. Returns the count, 0 for a full sweep, or -1 when nothing asked for is usable.
+// Without a capability model the request is passed through unchanged.
+int wiphy_plan_scan_frequencies(const char *interface_name, const int *requested, int requested_count,
+                                uint32_t band_mask, int *planned, int max_planned);
+
+#endif // WIPHY_CAPABILITIES_H
@@ -0,0 +1,26 @@
+#ifndef WPA_CONFIG_H
+#define WPA_CONFIG_H
+
+#include "wifi_scanner.h"
+
+#define WPA_PSK_LEN 32
+#define WPA_PSK_HEX_LEN (WPA_PSK_LEN * 2)
+#define WPA_PSK_CACHE_SIZE 16
+#define WPA_PBKDF2_ITERATIONS 4096
+#define WPA_CONFIG_MAX_LEN 1024
+
+// Derive the 256-bit PSK (PBKDF2-HMAC-SHA1, 4096 rounds) as 64 hex digits.
+// A 64-hex-digit passphrase is taken as the PSK itself. Results are cached per
+// SSID/passphrase pair. Returns 0, or -1 for an invalid passphrase.
+int wpa_config_derive_psk(const char *ssid, const char *passphrase, char *psk_hex, size_t psk_hex_size);
+
+// Hex-encode an SSID the way wpa_supplicant accepts it unquoted
+void wpa_config_hex_ssid(const char *ssid, char *hex, size_t hex_size);
+
+// Render a single-network config; psk_hex NULL means an open network
+int wpa_config_build(char *buffer, size_t buffer_size, const char *ctrl_dir, const char *ssid, const char *psk_hex);
+
+// Create a new 0600 file and write the config with a single write()
+int wpa_config_write(const char *path, const char *ssid, const char *psk_hex);
+
+#endif // WPA_CONFIG_H
@@ -0,0 +1,418 @@
+#include "benchmark.h"
+#include "command_runner.h"
+#include "scan_alternatives.h"
+#include "wiphy_capabilities.h"
+#include "json_formatter.h"
+#include <net/if.h>
+#include <sys/resource.h>
+
+void benchmark_stats_add(benchmark_stats_t *stats, long long sample_ms) {
+    if (stats->samples == 0 || sample_ms < stats->min_ms) stats->min_ms = sample_ms;
+    if (stats->samples == 0 || sample_ms > stats->max_ms) stats->max_ms = sample_ms;
+    stats->total_ms += sample_ms;
+    stats->samples++;
+}
+
+void print_benchmark_stats_json(const char *name, const benchmark_stats_t *stats, int is_last) {
+    printf("    \"%s\": {\"samples\": %d, \"avg_ms\": %.1f, \"min_ms\": %lld, \"max_ms\": %lld}%s\n",
+           name, stats->samples, stats->samples ? (double)stats->total_ms / stats->samples : 0.0,
+           stats->min_ms, stats->max_ms, is_last ? "" : ",");
+}
+
+// One complete open-network test, from the state save to the restore, with its step log
+// sent to /dev/null. Nothing answers BENCHMARK_LINK_SSID, so the test ends in its failure
+// path; the save, cleanup, link reset and restore it goes through are the real ones.
+static long long run_link_sequence(const char *interface_name, int state_driven) {
+    connection_test_result_t result;
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+    fflush(stdout);
+    if (saved_stdout >= 0 && null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+
+    set_fixed_link_waits(!state_driven);
+    long long start_ms = monotonic_time_ms();
+    test_open_ap_connection(interface_name, BENCHMARK_LINK_SSID, &result);
+    long long duration_ms = monotonic_time_ms() - start_ms;
+    set_fixed_link_waits(0);
+
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+    if (null_fd >= 0) close(null_fd);
+    return duration_ms;
+}
+
+int benchmark_link_waits(const char *interface_name, int iterations) {
+    benchmark_stats_t legacy;
+    benchmark_stats_t state_driven;
+
+    if (if_nametoindex(interface_name) == 0) {
+        printf("{\"error\": \"Interface not found\", \"interface\": \"%s\"}\n", interface_name);
+        return -1;
+    }
+
+    memset(&legacy, 0, sizeof(legacy));
+    memset(&state_driven, 0, sizeof(state_driven));
+
+    // Alternate the modes so drift in system load affects both equally
+    for (int i = 0; i < iterations && keep_running; i++) {
+        benchmark_stats_add(&legacy, run_link_sequence(interface_name, 0));
+        benchmark_stats_add(&state_driven, run_link_sequence(interface_name, 1));
+    }
+
+    double legacy_avg = legacy.samples ? (double)legacy.total_ms / legacy.samples : 0.0;
+    double state_avg = state_driven.samples ? (double)state_driven.total_ms / state_driven.samples : 0.0;
+
+    printf("{\n");
+    printf("  \"benchmark\": \"link_waits\",\n");
+    printf("  \"interface\": \"%s\",\n", interface_name);
+    printf("  \"iterations\": %d,\n", legacy.samples);
+    printf("  \"results\": {\n");
+    print_benchmark_stats_json("fixed_sleeps", &legacy, 0);
+    print_benchmark_stats_json("state_driven_waits", &state_driven, 1);
+    printf("  },\n");
+    printf("  \"saved_ms_per_test\": %.1f,\n", legacy_avg - state_avg);
+    printf("  \"speedup\": %.2f\n", state_avg > 0 ? legacy_avg / state_avg : 0.0);
+    printf("}\n");
+    return 0;
+}
+
+// What a method's measuring child sends back
+typedef struct {
+    benchmark_stats_t latency;
+    int failures;
+    int networks;
+    long long cpu_us;               // own and reaped children's user + system time
+    long rss_kb;
+} scan_method_sample_t;
+
+static long long rusage_cpu_us(const struct rusage *usage) {
+    return (long long)(usage->ru_utime.tv_sec + usage->ru_stime.tv_sec) * 1000000LL +
+           usage->ru_utime.tv_usec + usage->ru_stime.tv_usec;
+}
+
+static void measure_scan_method(const char *interface_name, wifi_scan_method_t method, int iterations,
+                                scan_method_sample_t *sample) {
+    scan_result_t *results = malloc(MAX_SCAN_RESULTS * sizeof(scan_result_t));
+    struct rusage self_usage;
+    struct rusage child_usage;
+
+    if (!results) exit(1);
+    for (int i = 0; i < iterations && keep_running; i++) {
+        long long start_ms = monotonic_time_ms();
+        int count = wifi_scan_with_method(method, interface_name, results, MAX_SCAN_RESULTS);
+
+        benchmark_stats_add(&sample->latency, monotonic_time_ms() - start_ms);
+        if (count > 0) {
+            sample->networks += count;
+        } else {
+            sample->failures++;
+        }
+    }
+    free(results);
+
+    getrusage(RUSAGE_SELF, &self_usage);
+    getrusage(RUSAGE_CHILDREN, &child_usage);
+    sample->cpu_us = rusage_cpu_us(&self_usage) + rusage_cpu_us(&child_usage);
+    sample->rss_kb = self_usage.ru_maxrss;
+}
+
+// Each method runs in a child of its own so its CPU time and memory high-water mark are not
+// mixed with the other methods' (and leftover threads or handlers die with it)
+static int run_scan_method(const char *interface_name, wifi_scan_method_t method, int iterations,
+                           scan_method_sample_t *sample) {
+    int pipe_fd[2];
+    int status;
+
+    memset(sample, 0, sizeof(scan_method_sample_t));
+    if (pipe2(pipe_fd, O_CLOEXEC) != 0) return -1;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(pipe_fd[0]);
+        measure_scan_method(interface_name, method, iterations, sample);
+        _exit(write(pipe_fd[1], sample, sizeof(scan_method_sample_t)) == (ssize_t)sizeof(scan_method_sample_t) ? 0 : 1);
+    }
+
+    close(pipe_fd[1]);
+    ssize_t len;
+    do {
+        len = read(pipe_fd[0], sample, sizeof(scan_method_sample_t));
+    } while (len < 0 && errno == EINTR);
+    close(pipe_fd[0]);
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+
+    return (len == (ssize_t)sizeof(scan_method_sample_t) && sample->latency.samples > 0) ? 0 : -1;
+}
+
+static double sample_avg_ms(const scan_method_sample_t *sample) {
+    return sample->latency.samples ? (double)sample->latency.total_ms / sample->latency.samples : 0.0;
+}
+
+// Fewest failures first: a fast method that misses networks is no use. Then latency.
+static int sample_better(const scan_method_sample_t *a, const scan_method_sample_t *b) {
+    double a_rate = (double)a->failures / a->latency.samples;
+    double b_rate = (double)b->failures / b->latency.samples;
+
+    if (a_rate != b_rate) return a_rate < b_rate;
+    return sample_avg_ms(a) < sample_avg_ms(b);
+}
+
+int benchmark_scan_methods(const char *interface_name, int iterations) {
+    scan_method_sample_t samples[WIFI_SCAN_METHOD_COUNT];
+    int measured[WIFI_SCAN_METHOD_COUNT];
+    int best = -1;
+
+    if (if_nametoindex(interface_name) == 0) {
+        printf("{\"error\": \"Interface not found\", \"interface\": \"%s\"}\n", interface_name);
+        return -1;
+    }
+
+    for (int m = 0; m < WIFI_SCAN_METHOD_COUNT && keep_running; m++) {
+        measured[m] = run_scan_method(interface_name, (wifi_scan_method_t)m, iterations, &samples[m]) == 0;
+        if (!measured[m]) continue;
+        if (samples[m].failures < samples[m].latency.samples && (best < 0 || sample_better(&samples[m], &samples[best]))) {
+            best = m;
+        }
+    }
+    if (!keep_running) return -1;
+
+    wifi_scan_method_choice_t choice;
+    int stored = 0;
+    memset(&choice, 0, sizeof(choice));
+    strncpy(choice.interface, interface_name, sizeof(choice.interface) - 1);
+    if (best >= 0) {
+        choice.method = (wifi_scan_method_t)best;
+        choice.measured = time(NULL);
+        choice.samples = samples[best].latency.samples;
+        choice.avg_ms = sample_avg_ms(&samples[best]);
+        choice.cpu_ms = samples[best].cpu_us / 1000.0 / samples[best].latency.samples;
+        choice.rss_kb = samples[best].rss_kb;
+        choice.failure_rate = (double)samples[best].failures / samples[best].latency.samples;
+        stored = wifi_scan_method_store_choice(&choice) == 0;
+    } else {
+        wiphy_get_driver_name(interface_name, choice.driver, sizeof(choice.driver));
+    }
+
+    printf("{\n");
+    printf("  \"benchmark\": \"scan_methods\",\n");
+    printf("  \"interface\": \"%s\",\n", interface_name);
+    printf("  \"driver\": \"%s\",\n", choice.driver);
+    printf("  \"iterations\": %d,\n", iterations);
+    printf("  \"results\": {\n");
+    for (int m = 0, printed = 0; m < WIFI_SCAN_METHOD_COUNT; m++) {
+        const scan_method_sample_t *sample = &samples[m];
+        printf("    \"%s\": ", wifi_scan_method_name((wifi_scan_method_t)m));
+        if (!measured[m]) {
+            printf("{\"error\": \"Could not run method\"}");
+        } else {
+            printf("{\"samples\": %d, \"avg_ms\": %.1f, \"min_ms\": %lld, \"max_ms\": %lld, "
+                   "\"cpu_ms_per_scan\": %.1f, \"peak_rss_kb\": %ld, \"failure_rate\": %.2f, \"avg_networks\": %.1f}",
+                   sample->latency.samples, sample_avg_ms(sample), sample->latency.min_ms, sample->latency.max_ms,
+                   sample->cpu_us / 1000.0 / sample->latency.samples, sample->rss_kb,
+                   (double)sample->failures / sample->latency.samples,
+                   (double)sample->networks / sample->latency.samples);
+        }
+        printf("%s\n", ++printed < WIFI_SCAN_METHOD_COUNT ? "," : "");
+    }
+    printf("  },\n");
+    if (best >= 0) {
+        printf("  \"selected\": \"%s\",\n", wifi_scan_method_name(choice.method));
+    } else {
+        printf("  \"selected\": null,\n");
+    }
+    printf("  \"stored\": %s\n", stored ? "true" : "false");
+    printf("}\n");
+    return best >= 0 ? 0 : -1;
+}
+
+// The scan document as printed before json_writer, one printf per field; kept as the
+// baseline and to check that the writer's output is byte for byte the same
+static void legacy_print_scan_timing(FILE *out, const scan_timing_t *timing) {
+    fprintf(out, "{\"interface_info_ms\": %d, \"scan_command_ms\": %d, \"parse_ms\": %d, "
+            "\"retry_wait_ms\": %d, \"process_overhead_ms\": %d, \"attempts\": %d, \"handoff_us\": ",
+            timing->interface_info_ms, timing->scan_command_ms, timing->parse_ms,
+            timing->retry_wait_ms, timing->process_overhead_ms, timing->attempts);
+    if (timing->handoff_us >= 0) {
+        fprintf(out, "%d}", timing->handoff_us);
+    } else {
+        fprintf(out, "null}");
+    }
+}
+
+static void legacy_print_scan_result(FILE *out, const scan_result_t *result, int is_last) {
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"bssid\": \"%s\",\n", escape_json_string(result->bssid));
+    fprintf(out, "      \"ssid\": \"%s\",\n", escape_json_string(result->ssid));
+    fprintf(out, "      \"frequency\": %d,\n", result->frequency);
+    fprintf(out, "      \"channel\": %d,\n", result->channel);
+    fprintf(out, "      \"signal_strength\": %d,\n", result->signal_strength);
+    fprintf(out, "      \"quality\": %d,\n", result->quality);
+    fprintf(out, "      \"security\": \"%s\",\n", escape_json_string(result->security));
+    fprintf(out, "      \"capabilities\": \"%s\",\n", escape_json_string(result->capabilities));
+    fprintf(out, "      \"timestamp\": \"%s\"\n", escape_json_string(result->timestamp));
+    fprintf(out, "    }");
+    if (!is_last) {
+        fprintf(out, ",");
+    }
+    fprintf(out, "\n");
+}
+
+static void legacy_print_scan_results(FILE *out, const scan_session_t *session) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"interface\": {\n");
+    fprintf(out, "    \"name\": \"%s\",\n", escape_json_string(session->interface.name));
+    fprintf(out, "    \"type\": \"%s\",\n", escape_json_string(session->interface.type));
+    fprintf(out, "    \"status\": \"%s\",\n", escape_json_string(session->interface.status));
+    fprintf(out, "    \"mac_address\": \"%s\",\n", escape_json_string(session->interface.mac));
+    fprintf(out, "    \"frequency\": %d,\n", session->interface.frequency);
+    fprintf(out, "    \"channel\": %d,\n", session->interface.channel);
+    fprintf(out, "    \"ssid\": \"%s\",\n", escape_json_string(session->interface.ssid));
+    fprintf(out, "    \"signal_strength\": %d,\n", session->interface.signal_strength);
+    fprintf(out, "    \"tx_power\": %d,\n", session->interface.tx_power);
+    fprintf(out, "    \"mode\": \"%s\"\n", escape_json_string(session->interface.mode));
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"scan_info\": {\n");
+    fprintf(out, "    \"scan_time\": %ld,\n", session->scan_time);
+    fprintf(out, "    \"scan_duration_ms\": %d,\n", session->scan_duration_ms);
+    fprintf(out, "    \"phases\": ");
+    legacy_print_scan_timing(out, &session->timing);
+    fprintf(out, ",\n");
+    fprintf(out, "    \"results_count\": %d\n", session->result_count);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"scan_results\": [\n");
+    
+    for (int i = 0; i < session->result_count; i++) {
+        legacy_print_scan_result(out, &session->results[i], (i == session->result_count - 1));
+    }
+    
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
+
+static void fill_synthetic_session(scan_session_t *session, int networks) {
+    static const char *securities[] = {"Open", "WPA2", "WPA3", "WPA2/WPA3"};
+    
+    memset(session, 0, sizeof(scan_session_t));
+    strcpy(session->interface.name, "wlan0");
+    strcpy(session->interface.type, "managed");
+    strcpy(session->interface.status, "up");
+    strcpy(session->interface.mac, "02:00:00:00:01:00");
+    strcpy(session->interface.ssid, "office \"main\"");
+    strcpy(session->interface.mode, "station");
+    session->interface.frequency = 5180;
+    session->interface.channel = 36;
+    session->interface.signal_strength = -52;
+    session->interface.tx_power = 20;
+    session->scan_time = time(NULL);
+    session->scan_duration_ms = 3120;
+    session->timing.scan_command_ms = 3050;
+    session->timing.parse_ms = 4;
+    session->timing.attempts = 1;
+    session->timing.handoff_us = 85;
+    session->result_count = networks;
+    
+    for (int i = 0; i < networks; i++) {
+        scan_result_t *result = &session->results[i];
+        snprintf(result->bssid, sizeof(result->bssid), "02:1a:%02x:%02x:%02x:%02x", i & 0xff, (i * 7) & 0xff, (i * 13) & 0xff, (i * 31) & 0xff);
+        snprintf(result->ssid, sizeof(result->ssid), "network-%03d%s", i, (i % 17 == 0) ? " \\guest\\" : "");
+        result->frequency = (i % 3 == 0) ? 2412 + 5 * (i % 13) : 5180 + 20 * (i % 8);
+        result->channel = (i % 3 == 0) ? 1 + i % 13 : 36 + 4 * (i % 8);
+        result->signal_strength = -30 - i % 60;
+        result->quality = 100 - 2 * (i % 50);
+        strcpy(result->security, securities[i % 4]);
+        strcpy(result->capabilities, "ESS Privacy ShortSlotTime RadioMeasure");
+        snprintf(result->timestamp, sizeof(result->timestamp), "%ld", (long)session->scan_time);
+    }
+}
+
+static long long monotonic_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void print_json_rate(const char *name, int documents, size_t document_bytes, long long elapsed_us, int is_last) {
+    double seconds = elapsed_us > 0 ? elapsed_us / 1e6 : 1e-6;
+    
+    printf("    \"%s\": {\"documents\": %d, \"elapsed_ms\": %.1f, \"documents_per_s\": %.0f, \"mb_per_s\": %.1f}%s\n",
+           name, documents, elapsed_us / 1000.0, documents / seconds,
+           (double)document_bytes * documents / seconds / (1024.0 * 1024.0), is_last ? "" : ",");
+}
+
+int benchmark_json_output(int documents, int networks) {
+    scan_session_t *session = malloc(sizeof(scan_session_t));
+    json_writer_t writer;
+    char *legacy_text = NULL;
+    size_t legacy_len = 0;
+    
+    if (!session) return -1;
+    if (networks > MAX_SCAN_RESULTS) networks = MAX_SCAN_RESULTS;
+    fill_synthetic_session(session, networks);
+    json_writer_init(&writer);
+    
+    // Same bytes from both, or the comparison is meaningless
+    FILE *memory = open_memstream(&legacy_text, &legacy_len);
+    FILE *null_stream = fopen("/dev/null", "w");
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (!memory || !null_stream || null_fd < 0) {
+        printf("{\"error\": \"Cannot open output sinks\", \"reason\": \"%s\"}\n", strerror(errno));
+        if (memory) fclose(memory);
+        if (null_stream) fclose(null_stream);
+        if (null_fd >= 0) close(null_fd);
+        free(legacy_text);
+        free(session);
+        return -1;
+    }
+    legacy_print_scan_results(memory, session);
+    fclose(memory);
+    json_write_scan_results(&writer, session);
+    int identical = writer.len == legacy_len && memcmp(writer.data, legacy_text, legacy_len) == 0;
+    size_t document_bytes = writer.len;
+    json_writer_reset(&writer);
+    
+    // The printf baseline gets a fully buffered stream, its best case; a terminal is line-buffered
+    long long start_us = monotonic_time_us();
+    for (int i = 0; i < documents && keep_running; i++) {
+        legacy_print_scan_results(null_stream, session);
+        fflush(null_stream);
+    }
+    long long legacy_us = monotonic_time_us() - start_us;
+    
+    start_us = monotonic_time_us();
+    for (int i = 0; i < documents && keep_running; i++) {
+        json_write_scan_results(&writer, session);
+        json_writer_flush(&writer, null_fd);
+    }
+    long long writer_us = monotonic_time_us() - start_us;
+    
+    fclose(null_stream);
+    close(null_fd);
+    json_writer_free(&writer);
+    free(legacy_text);
+    free(session);
+    if (!keep_running) return -1;
+    
+    printf("{\n");
+    printf("  \"benchmark\": \"json_output\",\n");
+    printf("  \"networks\": %d,\n", networks);
+    printf("  \"document_bytes\": %zu,\n", document_bytes);
+    printf("  \"identical_output\": %s,\n", identical ? "true" : "false");
+    printf("  \"results\": {\n");
+    print_json_rate("printf_per_field", documents, document_bytes, legacy_us, 0);
+    print_json_rate("json_writer", documents, document_bytes, writer_us, 1);
+    printf("  },\n");
+    printf("  \"speedup\": %.2f\n", writer_us > 0 ? (double)legacy_us / writer_us : 0.0);
+    printf("}\n");
+    return identical ? 0 : -1;
+}
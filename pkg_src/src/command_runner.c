@@ -0,0 +1,247 @@
+#include "command_runner.h"
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+
+extern char **environ;
+
+static pthread_key_t shared_output_key;
+static pthread_once_t shared_output_once = PTHREAD_ONCE_INIT;
+
+void command_output_free(command_output_t *output) {
+    if (!output) return;
+    free(output->data);
+    memset(output, 0, sizeof(command_output_t));
+}
+
+static void release_shared_output(void *value) {
+    command_output_free((command_output_t *)value);
+    free(value);
+}
+
+static void create_shared_output_key(void) {
+    pthread_key_create(&shared_output_key, release_shared_output);
+}
+
+command_output_t *command_shared_output(void) {
+    pthread_once(&shared_output_once, create_shared_output_key);
+
+    command_output_t *output = (command_output_t *)pthread_getspecific(shared_output_key);
+    if (!output) {
+        output = (command_output_t *)calloc(1, sizeof(command_output_t));
+        if (output && pthread_setspecific(shared_output_key, output) != 0) {
+            free(output);
+            output = NULL;
+        }
+    }
+    return output;
+}
+
+void command_format(const char *const argv[], char *buffer, size_t size) {
+    size_t used = 0;
+
+    if (size == 0) return;
+    buffer[0] = '\0';
+    for (int i = 0; argv[i] && used < size; i++) {
+        int quote = (argv[i][0] == '\0' || strpbrk(argv[i], " \t'\"") != NULL);
+        int written = snprintf(buffer + used, size - used, "%s%s%s%s",
+                               i > 0 ? " " : "", quote ? "'" : "", argv[i], quote ? "'" : "");
+        if (written < 0) break;
+        used += (size_t)written;
+    }
+}
+
+// Append what the pipe has right now; 0 on EOF, 1 when more may come
+static int read_available(int fd, command_output_t *output, long long spawn_ms, command_status_t *status) {
+    char scratch[4096];
+
+    for (;;) {
+        char *target = scratch;
+        size_t room = sizeof(scratch);
+
+        if (output) {
+            if (output->capacity - output->length < 2 && output->capacity < COMMAND_OUTPUT_MAX_CAPACITY) {
+                size_t capacity = output->capacity ? output->capacity * 2 : COMMAND_OUTPUT_INITIAL_CAPACITY;
+                char *data = (char *)realloc(output->data, capacity);
+                if (data) {
+                    output->data = data;
+                    output->capacity = capacity;
+                }
+            }
+            // Past the cap (or out of memory) keep draining so the child never blocks on a full pipe
+            if (output->capacity - output->length >= 2) {
+                target = output->data + output->length;
+                room = output->capacity - output->length - 1;
+            }
+        }
+
+        ssize_t bytes = read(fd, target, room);
+        if (bytes > 0) {
+            if (status->first_output_ms < 0) status->first_output_ms = monotonic_time_ms() - spawn_ms;
+            if (output && target != scratch) {
+                output->length += (size_t)bytes;
+                output->data[output->length] = '\0';
+            }
+            continue;
+        }
+        if (bytes == 0) return 0;
+        if (errno == EINTR) continue;
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : 0;
+    }
+}
+
+int command_pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int decode_wait_status(int wait_status) {
+    if (WIFEXITED(wait_status)) return WEXITSTATUS(wait_status);
+    return -1;
+}
+
+int command_run(const char *const argv[], int flags, int timeout_ms,
+                command_output_t *output, command_status_t *status) {
+    command_status_t local_status;
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t signals;
+    int pipe_fds[2] = {-1, -1};
+    int capture = !(flags & COMMAND_INHERIT_OUTPUT) && output != NULL;
+    pid_t pid;
+
+    if (!status) status = &local_status;
+    memset(status, 0, sizeof(command_status_t));
+    status->exit_code = -1;
+    status->first_output_ms = -1;
+    if (!argv || !argv[0]) return -1;
+
+    if (output) {
+        output->length = 0;
+        if (output->data) output->data[0] = '\0';
+    }
+    // Only the read end is non-blocking; the child's end keeps normal write semantics
+    if (capture) {
+        if (pipe2(pipe_fds, O_CLOEXEC) != 0) return -1;
+        fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    if (capture) {
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+        if (flags & COMMAND_CAPTURE_STDERR) {
+            posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDERR_FILENO);
+        } else {
+            posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+        }
+    } else if (!(flags & COMMAND_INHERIT_OUTPUT)) {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+
+    // The child starts with an empty mask and default SIGPIPE whatever this thread has set
+    posix_spawnattr_init(&attr);
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    // Flush our buffered stdout so inherited output does not interleave out of order
+    if (flags & COMMAND_INHERIT_OUTPUT) fflush(stdout);
+
+    long long spawn_ms = monotonic_time_ms();
+    int spawn_error = posix_spawnp(&pid, argv[0], &actions, &attr, (char *const *)argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (capture) close(pipe_fds[1]);
+
+    if (spawn_error != 0) {
+        if (capture) close(pipe_fds[0]);
+        status->exit_code = (spawn_error == ENOENT) ? 127 : -1;
+        return -1;
+    }
+    status->pid = pid;
+
+    int read_fd = capture ? pipe_fds[0] : -1;
+    int pidfd = command_pidfd_open(pid);
+    long long deadline = spawn_ms + timeout_ms;
+    int wait_status = 0;
+    int reaped = 0;
+
+    while (!reaped) {
+        struct pollfd fds[2];
+        int nfds = 0;
+        long long remaining = deadline - monotonic_time_ms();
+
+        if (remaining <= 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &wait_status, 0);
+            status->timed_out = 1;
+            break;
+        }
+
+        if (read_fd >= 0) {
+            fds[nfds].fd = read_fd;
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+        if (pidfd >= 0) {
+            fds[nfds].fd = pidfd;
+            fds[nfds].events = POLLIN;
+            nfds++;
+        } else if (remaining > 10) {
+            remaining = 10; // no pidfd: fall back to polling waitpid
+        }
+
+        if (poll(fds, (nfds_t)nfds, (int)remaining) < 0 && errno != EINTR) break;
+
+        if (read_fd >= 0 && read_available(read_fd, output, spawn_ms, status) == 0) {
+            close(read_fd);
+            read_fd = -1;
+        }
+        if (waitpid(pid, &wait_status, WNOHANG) == pid) reaped = 1;
+    }
+
+    // Take what is already buffered but do not wait for EOF: a daemonized grandchild may hold the pipe
+    if (read_fd >= 0) {
+        read_available(read_fd, output, spawn_ms, status);
+        close(read_fd);
+    }
+    if (pidfd >= 0) close(pidfd);
+
+    status->duration_ms = monotonic_time_ms() - spawn_ms;
+    if (status->timed_out) return -1;
+    if (!reaped) {
+        // poll failed: do not leave a zombie behind
+        waitpid(pid, &wait_status, 0);
+    }
+    status->exit_code = decode_wait_status(wait_status);
+    return status->exit_code;
+}
+
+FILE *command_run_stream(const char *const argv[], int flags, int timeout_ms, command_status_t *status) {
+    command_status_t local_status;
+    command_output_t *output = command_shared_output();
+
+    if (!status) status = &local_status;
+    if (!output) return NULL;
+    command_run(argv, flags & ~COMMAND_INHERIT_OUTPUT, timeout_ms, output, status);
+    if (status->pid == 0) return NULL;
+
+    // fmemopen wants a buffer even for empty output
+    if (!output->data) {
+        output->data = (char *)malloc(COMMAND_OUTPUT_INITIAL_CAPACITY);
+        if (!output->data) return NULL;
+        output->capacity = COMMAND_OUTPUT_INITIAL_CAPACITY;
+        output->data[0] = '\0';
+    }
+    return fmemopen(output->data, output->length, "r");
+}
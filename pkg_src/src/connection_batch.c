@@ -0,0 +1,216 @@
+#include "connection_batch.h"
+#include "supplicant_session.h"
+#include <pthread.h>
+#include <ctype.h>
+
+static char *trim_field(char *field) {
+    while (*field && isspace((unsigned char)*field)) field++;
+    char *end = field + strlen(field);
+    while (end > field && isspace((unsigned char)end[-1])) *--end = '\0';
+    return field;
+}
+
+static connection_batch_session_t *find_session(connection_batch_t *batch, const char *interface_name) {
+    for (int i = 0; i < batch->session_count; i++) {
+        if (strcmp(batch->sessions[i].interface_name, interface_name) == 0) {
+            return &batch->sessions[i];
+        }
+    }
+    if (batch->session_count >= MAX_INTERFACES) return NULL;
+
+    connection_batch_session_t *session = &batch->sessions[batch->session_count++];
+    memset(session, 0, sizeof(connection_batch_session_t));
+    strncpy(session->interface_name, interface_name, MAX_INTERFACE_NAME - 1);
+    return session;
+}
+
+int connection_batch_load(const char *path, connection_batch_t *batch, char *error, size_t error_size) {
+    char line[MAX_LINE_LEN];
+    int line_number = 0;
+
+    memset(batch, 0, sizeof(connection_batch_t));
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        snprintf(error, error_size, "Cannot open job file: %s", strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_number++;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char *content = trim_field(line);
+        if (*content == '\0' || *content == '#') continue;
+
+        // Tab separated so SSIDs and passphrases may contain spaces
+        char *interface_name = strtok(content, "\t");
+        char *ssid = strtok(NULL, "\t");
+        char *psk = strtok(NULL, "\t");
+
+        if (!interface_name || !ssid) {
+            snprintf(error, error_size, "Line %d: expected <interface>\\t<ssid>[\\t<psk>]", line_number);
+            fclose(fp);
+            return -1;
+        }
+        interface_name = trim_field(interface_name);
+        if (psk) psk = trim_field(psk);
+
+        if (strlen(interface_name) >= MAX_INTERFACE_NAME || strlen(ssid) >= MAX_SSID_LEN ||
+            (psk && strlen(psk) > MAX_PSK_LEN)) {
+            snprintf(error, error_size, "Line %d: field too long", line_number);
+            fclose(fp);
+            return -1;
+        }
+        if (batch->job_count >= MAX_BATCH_JOBS) {
+            snprintf(error, error_size, "Too many jobs (maximum %d)", MAX_BATCH_JOBS);
+            fclose(fp);
+            return -1;
+        }
+
+        connection_batch_session_t *session = find_session(batch, interface_name);
+        if (!session) {
+            snprintf(error, error_size, "Line %d: too many interfaces (maximum %d)", line_number, MAX_INTERFACES);
+            fclose(fp);
+            return -1;
+        }
+
+        connection_job_t *job = &batch->jobs[batch->job_count];
+        strncpy(job->interface_name, interface_name, MAX_INTERFACE_NAME - 1);
+        strncpy(job->ssid, ssid, MAX_SSID_LEN - 1);
+        if (psk && *psk) {
+            strncpy(job->psk, psk, MAX_PSK_LEN);
+            job->secured = 1;
+        }
+        session->job_indices[session->job_count++] = batch->job_count;
+        batch->job_count++;
+    }
+
+    fclose(fp);
+    if (batch->job_count == 0) {
+        snprintf(error, error_size, "Job file contains no jobs");
+        return -1;
+    }
+    return batch->job_count;
+}
+
+typedef struct {
+    connection_batch_t *batch;
+    connection_batch_session_t *session;
+} session_thread_arg_t;
+
+static void *session_thread(void *arg) {
+    session_thread_arg_t *thread_arg = (session_thread_arg_t *)arg;
+    connection_batch_t *batch = thread_arg->batch;
+    connection_batch_session_t *session = thread_arg->session;
+    const char *interface_name = session->interface_name;
+    wifi_interface_t saved_state;
+    int state_saved;
+    long long session_start = monotonic_time_ms();
+
+    // Setup: save state and reset the link once for every job on this interface
+    printf("[BATCH] %s: saving interface state and resetting link for %d test(s)\n",
+           interface_name, session->job_count);
+    fflush(stdout);
+    memset(&saved_state, 0, sizeof(saved_state));
+    state_saved = (save_interface_state(interface_name, &saved_state) == 0);
+
+    kill_interface_process("udhcpc", interface_name);
+    flush_interface_addresses(interface_name);
+    reset_interface_link(interface_name);
+    
+    // One supplicant serves every job; tests add and remove networks over its control socket
+    long long supplicant_start = monotonic_time_ms();
+    session->supplicant_persistent = (supplicant_session_start(interface_name) == 0);
+    session->supplicant_start_ms = (int)(monotonic_time_ms() - supplicant_start);
+    if (!session->supplicant_persistent) {
+        printf("[BATCH] %s: no persistent wpa_supplicant, tests will start their own\n", interface_name);
+        cleanup_interface_connections(interface_name);
+    }
+    session->setup_duration_ms = (int)(monotonic_time_ms() - session_start);
+
+    for (int i = 0; i < session->job_count; i++) {
+        int index = session->job_indices[i];
+        connection_job_t *job = &batch->jobs[index];
+        connection_test_result_t *result = &batch->results[index];
+
+        if (!keep_running) {
+            memset(result, 0, sizeof(connection_test_result_t));
+            strncpy(result->ssid, job->ssid, MAX_SSID_LEN - 1);
+            strncpy(result->interface_name, interface_name, MAX_INTERFACE_NAME - 1);
+            strncpy(result->connection_type, job->secured ? "secured" : "open", sizeof(result->connection_type) - 1);
+            strncpy(result->error_message, "Skipped - batch interrupted", sizeof(result->error_message) - 1);
+            session->failed++;
+            continue;
+        }
+
+        if (job->secured) {
+            test_secured_ap_connection_in_session(interface_name, job->ssid, job->psk, result);
+        } else {
+            test_open_ap_connection_in_session(interface_name, job->ssid, result);
+        }
+
+        if (state_saved) {
+            strncpy(result->original_ssid, saved_state.ssid, MAX_SSID_LEN - 1);
+            strncpy(result->original_bssid, saved_state.profile.bssid, MAX_MAC_LEN - 1);
+            result->was_connected = saved_state.was_connected;
+        }
+        if (result->success) {
+            session->passed++;
+        } else {
+            session->failed++;
+        }
+    }
+
+    // Teardown: one restore for the whole session
+    long long teardown_start = monotonic_time_ms();
+    if (session->supplicant_persistent) {
+        supplicant_session_stop(interface_name);
+        kill_interface_process("udhcpc", interface_name);
+    } else {
+        terminate_interface_processes(interface_name);
+    }
+    flush_interface_addresses(interface_name);
+    session->restore_duration_ms = -1;
+    if (state_saved) {
+        restore_interface_state(interface_name, &saved_state);
+        session->restore_duration_ms = get_last_restore_duration_ms();
+    }
+    session->teardown_duration_ms = (int)(monotonic_time_ms() - teardown_start);
+    session->session_duration_ms = (int)(monotonic_time_ms() - session_start);
+
+    printf("[BATCH] %s: session completed (%d passed, %d failed, %d ms)\n",
+           interface_name, session->passed, session->failed, session->session_duration_ms);
+    fflush(stdout);
+    return NULL;
+}
+
+int connection_batch_run(connection_batch_t *batch) {
+    pthread_t threads[MAX_INTERFACES];
+    session_thread_arg_t args[MAX_INTERFACES];
+    int started[MAX_INTERFACES];
+    int failed = 0;
+    long long start_ms = monotonic_time_ms();
+
+    batch->start_time = time(NULL);
+
+    // Independent interfaces run in parallel; jobs on one interface run in file order
+    for (int i = 0; i < batch->session_count; i++) {
+        args[i].batch = batch;
+        args[i].session = &batch->sessions[i];
+        started[i] = (pthread_create(&threads[i], NULL, session_thread, &args[i]) == 0);
+        if (!started[i]) {
+            session_thread(&args[i]);
+        }
+    }
+
+    for (int i = 0; i < batch->session_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        failed += batch->sessions[i].failed;
+    }
+
+    batch->total_duration_ms = (int)(monotonic_time_ms() - start_ms);
+    return failed;
+}
@@ -0,0 +1,468 @@
+#include "connectivity_probe.h"
+#include <poll.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/if_ether.h>
+#include <netpacket/packet.h>
+#include <net/ethernet.h>
+
+#define PROBE_MAX_SOCKETS (2 + 2 * CONNECTIVITY_PROBE_MAX_TARGETS)
+#define PROBE_DNS_PORT 53
+#define PROBE_ICMP_PAYLOAD "ur-wireless-tools"
+
+typedef enum {
+    PROBE_METHOD_ARP = 0,
+    PROBE_METHOD_ICMP,
+    PROBE_METHOD_DNS,
+    PROBE_METHOD_TCP
+} probe_method_t;
+
+// One outstanding probe; every probe owns a non-blocking socket bound to the interface
+typedef struct {
+    int fd;
+    probe_layer_t layer;
+    probe_method_t method;
+    int done;
+    int raw;                        // ICMP over a raw socket (replies carry the IP header)
+    uint16_t id;
+    struct in_addr target;
+    char target_text[64];
+    long long sent_us;
+} probe_t;
+
+typedef struct {
+    probe_t probes[PROBE_MAX_SOCKETS];
+    int count;
+    int ifindex;
+    uint8_t mac[ETH_ALEN];
+    struct in_addr local_address;
+} probe_set_t;
+
+static const char *method_names[] = {"arp", "icmp", "dns", "tcp"};
+
+const char *probe_layer_name(probe_layer_t layer) {
+    switch (layer) {
+        case PROBE_LAYER_GATEWAY: return "gateway";
+        case PROBE_LAYER_DNS: return "dns";
+        case PROBE_LAYER_INTERNET: return "internet";
+        default: return "unknown";
+    }
+}
+
+const char *probe_status_name(probe_status_t status) {
+    switch (status) {
+        case PROBE_STATUS_SKIPPED: return "skipped";
+        case PROBE_STATUS_REACHABLE: return "reachable";
+        case PROBE_STATUS_UNREACHABLE: return "unreachable";
+        case PROBE_STATUS_TIMEOUT: return "timeout";
+    }
+    return "unknown";
+}
+
+static long long monotonic_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int add_tcp_target(connectivity_probe_config_t *config, const char *address, int port) {
+    if (config->tcp_target_count >= CONNECTIVITY_PROBE_MAX_TARGETS || port <= 0 || port > 65535) return -1;
+
+    struct sockaddr_in *target = &config->tcp_targets[config->tcp_target_count];
+    memset(target, 0, sizeof(*target));
+    target->sin_family = AF_INET;
+    target->sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address, &target->sin_addr) != 1) return -1;
+    config->tcp_target_count++;
+    return 0;
+}
+
+void connectivity_probe_default_config(connectivity_probe_config_t *config) {
+    memset(config, 0, sizeof(connectivity_probe_config_t));
+    strcpy(config->dns_servers[0], "8.8.8.8");
+    strcpy(config->dns_servers[1], "1.1.1.1");
+    config->dns_server_count = 2;
+    strcpy(config->dns_query_name, "example.com");
+    add_tcp_target(config, "8.8.8.8", 443);
+    add_tcp_target(config, "1.1.1.1", 443);
+}
+
+int connectivity_probe_parse_targets(const char *spec, connectivity_probe_config_t *config, char *error, size_t error_size) {
+    char buffer[512];
+    char *saveptr = NULL;
+    int dns_given = 0;
+    int tcp_given = 0;
+
+    if (strlen(spec) >= sizeof(buffer)) {
+        snprintf(error, error_size, "Target list too long");
+        return -1;
+    }
+    strcpy(buffer, spec);
+
+    for (char *item = strtok_r(buffer, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        char *value = strchr(item, '=');
+        struct in_addr address;
+        if (!value) {
+            snprintf(error, error_size, "Expected key=value, got '%.64s'", item);
+            return -1;
+        }
+        *value++ = '\0';
+
+        if (strcmp(item, "gateway") == 0 && inet_pton(AF_INET, value, &address) == 1) {
+            strncpy(config->gateway, value, sizeof(config->gateway) - 1);
+        } else if (strcmp(item, "dns") == 0 && inet_pton(AF_INET, value, &address) == 1) {
+            // Listing servers replaces the defaults rather than adding to them
+            if (!dns_given++) config->dns_server_count = 0;
+            if (config->dns_server_count >= CONNECTIVITY_PROBE_MAX_TARGETS) {
+                snprintf(error, error_size, "At most %d DNS servers", CONNECTIVITY_PROBE_MAX_TARGETS);
+                return -1;
+            }
+            strncpy(config->dns_servers[config->dns_server_count++], value, INET_ADDRSTRLEN - 1);
+        } else if (strcmp(item, "name") == 0 && strlen(value) > 0 && strlen(value) < sizeof(config->dns_query_name)) {
+            strcpy(config->dns_query_name, value);
+        } else if (strcmp(item, "tcp") == 0 && strchr(value, ':')) {
+            char *port = strchr(value, ':');
+            *port++ = '\0';
+            if (!tcp_given++) config->tcp_target_count = 0;
+            if (add_tcp_target(config, value, atoi(port)) != 0) {
+                snprintf(error, error_size, "Invalid TCP target '%.32s:%.8s'", value, port);
+                return -1;
+            }
+        } else {
+            snprintf(error, error_size, "Invalid target '%.32s=%.64s'", item, value);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Default gateway of the interface from the kernel routing table
+static int read_default_gateway(const char *interface_name, struct in_addr *gateway) {
+    char line[256];
+    char name[IFNAMSIZ];
+    unsigned long destination, gateway_hex, flags;
+
+    FILE *fp = fopen("/proc/net/route", "r");
+    if (!fp) return -1;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%15s %lx %lx %lx", name, &destination, &gateway_hex, &flags) == 4 &&
+            strcmp(name, interface_name) == 0 && destination == 0 && (flags & 0x2) /* RTF_GATEWAY */) {
+            gateway->s_addr = (in_addr_t)gateway_hex;
+            fclose(fp);
+            return 0;
+        }
+    }
+    fclose(fp);
+    return -1;
+}
+
+static int read_interface_addresses(const char *interface_name, probe_set_t *set) {
+    struct ifreq ifr;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface_name, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) == 0) {
+        memcpy(set->mac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface_name, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFADDR, &ifr) == 0) {
+        set->local_address = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr;
+    }
+    close(fd);
+    return 0;
+}
+
+static probe_t *new_probe(probe_set_t *set, probe_layer_t layer, probe_method_t method, struct in_addr target) {
+    if (set->count >= PROBE_MAX_SOCKETS) return NULL;
+
+    probe_t *probe = &set->probes[set->count];
+    memset(probe, 0, sizeof(probe_t));
+    probe->fd = -1;
+    probe->layer = layer;
+    probe->method = method;
+    probe->target = target;
+    inet_ntop(AF_INET, &target, probe->target_text, sizeof(probe->target_text));
+    return probe;
+}
+
+// Keep the probe only when its first packet actually left
+static void commit_probe(probe_set_t *set, probe_t *probe, int sent) {
+    if (sent) {
+        probe->sent_us = monotonic_time_us();
+        set->count++;
+    } else if (probe->fd >= 0) {
+        close(probe->fd);
+    }
+}
+
+static int bind_to_interface(int fd, const char *interface_name) {
+    return setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, interface_name, strlen(interface_name) + 1);
+}
+
+static void start_arp_probe(probe_set_t *set, struct in_addr gateway) {
+    struct sockaddr_ll addr;
+    struct ether_arp request;
+    probe_t *probe = new_probe(set, PROBE_LAYER_GATEWAY, PROBE_METHOD_ARP, gateway);
+    if (!probe || set->local_address.s_addr == 0) return;
+
+    probe->fd = socket(AF_PACKET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_ARP));
+    if (probe->fd < 0) return;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ARP);
+    addr.sll_ifindex = set->ifindex;
+    if (bind(probe->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        commit_probe(set, probe, 0);
+        return;
+    }
+
+    memset(&request, 0, sizeof(request));
+    request.arp_hrd = htons(ARPHRD_ETHER);
+    request.arp_pro = htons(ETH_P_IP);
+    request.arp_hln = ETH_ALEN;
+    request.arp_pln = 4;
+    request.arp_op = htons(ARPOP_REQUEST);
+    memcpy(request.arp_sha, set->mac, ETH_ALEN);
+    memcpy(request.arp_spa, &set->local_address, 4);
+    memcpy(request.arp_tpa, &gateway, 4);
+
+    addr.sll_halen = ETH_ALEN;
+    memset(addr.sll_addr, 0xff, ETH_ALEN);
+    commit_probe(set, probe, sendto(probe->fd, &request, sizeof(request), 0, (struct sockaddr *)&addr, sizeof(addr)) > 0);
+}
+
+static void start_icmp_probe(probe_set_t *set, const char *interface_name, struct in_addr gateway) {
+    struct sockaddr_in dest;
+    unsigned char packet[sizeof(struct icmphdr) + sizeof(PROBE_ICMP_PAYLOAD)];
+    probe_t *probe = new_probe(set, PROBE_LAYER_GATEWAY, PROBE_METHOD_ICMP, gateway);
+    if (!probe) return;
+
+    // Unprivileged ping sockets first; raw sockets need CAP_NET_RAW
+    probe->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_ICMP);
+    if (probe->fd < 0) {
+        probe->fd = socket(AF_INET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_ICMP);
+        probe->raw = 1;
+    }
+    if (probe->fd < 0 || bind_to_interface(probe->fd, interface_name) != 0) {
+        commit_probe(set, probe, 0);
+        return;
+    }
+
+    struct icmphdr *icmp = (struct icmphdr *)packet;
+    memset(packet, 0, sizeof(packet));
+    memcpy(packet + sizeof(struct icmphdr), PROBE_ICMP_PAYLOAD, sizeof(PROBE_ICMP_PAYLOAD));
+    probe->id = (uint16_t)(getpid() ^ set->count);
+    icmp->type = ICMP_ECHO;
+    icmp->un.echo.id = htons(probe->id);
+    icmp->un.echo.sequence = htons(1);
+
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < sizeof(packet); i += 2) sum += (uint32_t)((packet[i] << 8) | packet[i + 1]);
+    if (sizeof(packet) & 1) sum += (uint32_t)(packet[sizeof(packet) - 1] << 8);
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    icmp->checksum = htons((uint16_t)~sum);
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_addr = gateway;
+    commit_probe(set, probe, sendto(probe->fd, packet, sizeof(packet), 0, (struct sockaddr *)&dest, sizeof(dest)) > 0);
+}
+
+static size_t build_dns_query(unsigned char *buffer, size_t size, uint16_t id, const char *name) {
+    size_t pos = 12;
+
+    memset(buffer, 0, 12);
+    buffer[0] = (unsigned char)(id >> 8);
+    buffer[1] = (unsigned char)id;
+    buffer[2] = 0x01;               // recursion desired
+    buffer[5] = 1;                  // one question
+
+    while (*name && pos < size - 6) {
+        const char *dot = strchr(name, '.');
+        size_t label_len = dot ? (size_t)(dot - name) : strlen(name);
+        if (label_len == 0 || label_len > 63 || pos + label_len + 1 >= size - 6) return 0;
+        buffer[pos++] = (unsigned char)label_len;
+        memcpy(buffer + pos, name, label_len);
+        pos += label_len;
+        name += label_len + (dot ? 1 : 0);
+    }
+    buffer[pos++] = 0;
+    buffer[pos++] = 0; buffer[pos++] = 1;   // type A
+    buffer[pos++] = 0; buffer[pos++] = 1;   // class IN
+    return pos;
+}
+
+static void start_dns_probe(probe_set_t *set, const char *interface_name, struct in_addr server, const char *name) {
+    struct sockaddr_in dest;
+    unsigned char query[512];
+    probe_t *probe = new_probe(set, PROBE_LAYER_DNS, PROBE_METHOD_DNS, server);
+    if (!probe) return;
+
+    probe->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe->fd < 0 || bind_to_interface(probe->fd, interface_name) != 0) {
+        commit_probe(set, probe, 0);
+        return;
+    }
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(PROBE_DNS_PORT);
+    dest.sin_addr = server;
+    probe->id = (uint16_t)(monotonic_time_us() ^ (set->count << 8));
+    size_t len = build_dns_query(query, sizeof(query), probe->id, name);
+
+    // Connected, so ICMP port-unreachable surfaces as ECONNREFUSED
+    commit_probe(set, probe, len > 0 && connect(probe->fd, (struct sockaddr *)&dest, sizeof(dest)) == 0 &&
+                             send(probe->fd, query, len, 0) == (ssize_t)len);
+}
+
+static void start_tcp_probe(probe_set_t *set, const char *interface_name, const struct sockaddr_in *target) {
+    probe_t *probe = new_probe(set, PROBE_LAYER_INTERNET, PROBE_METHOD_TCP, target->sin_addr);
+    if (!probe) return;
+    snprintf(probe->target_text + strlen(probe->target_text), sizeof(probe->target_text) - strlen(probe->target_text),
+             ":%u", ntohs(target->sin_port));
+
+    probe->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe->fd < 0 || bind_to_interface(probe->fd, interface_name) != 0) {
+        commit_probe(set, probe, 0);
+        return;
+    }
+    int rc = connect(probe->fd, (const struct sockaddr *)target, sizeof(*target));
+    commit_probe(set, probe, rc == 0 || errno == EINPROGRESS);
+}
+
+// Returns 1 reachable, -1 definitive failure, 0 not an answer for this probe (keep waiting)
+static int handle_probe_event(probe_t *probe, short revents) {
+    unsigned char buffer[1500];
+
+    if (probe->method == PROBE_METHOD_TCP) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(probe->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        // A RST still proves the host answered end to end
+        return (error == 0 || error == ECONNREFUSED) ? 1 : -1;
+    }
+
+    ssize_t len = recv(probe->fd, buffer, sizeof(buffer), 0);
+    if (len < 0) {
+        if (errno == EAGAIN || errno == EINTR) return 0;
+        return (revents & POLLERR) ? -1 : 0;
+    }
+
+    if (probe->method == PROBE_METHOD_ARP) {
+        const struct ether_arp *reply = (const struct ether_arp *)buffer;
+        return (len >= (ssize_t)sizeof(*reply) && ntohs(reply->arp_op) == ARPOP_REPLY &&
+                memcmp(reply->arp_spa, &probe->target, 4) == 0) ? 1 : 0;
+    }
+    if (probe->method == PROBE_METHOD_ICMP) {
+        size_t offset = probe->raw ? (size_t)((buffer[0] & 0x0f) * 4) : 0;
+        if ((size_t)len < offset + sizeof(struct icmphdr)) return 0;
+        const struct icmphdr *icmp = (const struct icmphdr *)(buffer + offset);
+        if (icmp->type != ICMP_ECHOREPLY) return 0;
+        // Ping sockets rewrite the identifier; the kernel already demultiplexed the reply
+        return (!probe->raw || ntohs(icmp->un.echo.id) == probe->id) ? 1 : 0;
+    }
+    // DNS: any response to our query id shows the resolver is reachable, whatever the rcode
+    return (len >= 12 && ((buffer[0] << 8) | buffer[1]) == probe->id && (buffer[2] & 0x80)) ? 1 : 0;
+}
+
+int connectivity_probe_run(const char *interface_name, const connectivity_probe_config_t *config,
+                           int timeout_ms, connectivity_probe_result_t *result) {
+    probe_set_t set;
+    struct pollfd pfds[PROBE_MAX_SOCKETS];
+    struct in_addr address;
+    int pending[PROBE_LAYER_COUNT] = {0};
+    long long start_us = monotonic_time_us();
+
+    memset(result, 0, sizeof(connectivity_probe_result_t));
+    memset(&set, 0, sizeof(set));
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) result->layers[layer].rtt_ms = -1;
+
+    set.ifindex = (int)if_nametoindex(interface_name);
+    if (set.ifindex == 0) return -1;
+    read_interface_addresses(interface_name, &set);
+
+    // Everything is sent up front, so the probe costs about as much as its slowest layer
+    if ((config->gateway[0] && inet_pton(AF_INET, config->gateway, &address) == 1) ||
+        (!config->gateway[0] && read_default_gateway(interface_name, &address) == 0)) {
+        start_arp_probe(&set, address);
+        start_icmp_probe(&set, interface_name, address);
+    }
+    for (int i = 0; i < config->dns_server_count; i++) {
+        if (inet_pton(AF_INET, config->dns_servers[i], &address) == 1) {
+            start_dns_probe(&set, interface_name, address, config->dns_query_name);
+        }
+    }
+    for (int i = 0; i < config->tcp_target_count; i++) {
+        start_tcp_probe(&set, interface_name, &config->tcp_targets[i]);
+    }
+
+    for (int i = 0; i < set.count; i++) {
+        probe_layer_result_t *layer = &result->layers[set.probes[i].layer];
+        pending[set.probes[i].layer]++;
+        layer->probes_sent++;
+        layer->status = PROBE_STATUS_TIMEOUT;
+        if (!layer->target[0]) {
+            strncpy(layer->target, set.probes[i].target_text, sizeof(layer->target) - 1);
+            strcpy(layer->method, method_names[set.probes[i].method]);
+        }
+    }
+
+    long long deadline_us = start_us + (long long)timeout_ms * 1000;
+    while (keep_running) {
+        int nfds = 0;
+        int index[PROBE_MAX_SOCKETS];
+        for (int i = 0; i < set.count; i++) {
+            probe_t *probe = &set.probes[i];
+            if (probe->done || result->layers[probe->layer].status == PROBE_STATUS_REACHABLE) continue;
+            pfds[nfds].fd = probe->fd;
+            pfds[nfds].events = (probe->method == PROBE_METHOD_TCP) ? POLLOUT : POLLIN;
+            pfds[nfds].revents = 0;
+            index[nfds++] = i;
+        }
+
+        long long remaining_us = deadline_us - monotonic_time_us();
+        if (nfds == 0 || remaining_us <= 0) break;
+
+        int ready = poll(pfds, nfds, (int)((remaining_us + 999) / 1000));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) break;
+
+        for (int n = 0; n < nfds; n++) {
+            if (!pfds[n].revents) continue;
+            probe_t *probe = &set.probes[index[n]];
+            probe_layer_result_t *layer = &result->layers[probe->layer];
+
+            int outcome = handle_probe_event(probe, pfds[n].revents);
+            if (outcome == 0) continue;
+            probe->done = 1;
+            pending[probe->layer]--;
+
+            if (outcome > 0 && layer->status != PROBE_STATUS_REACHABLE) {
+                layer->status = PROBE_STATUS_REACHABLE;
+                layer->rtt_ms = (monotonic_time_us() - probe->sent_us) / 1000.0;
+                strncpy(layer->target, probe->target_text, sizeof(layer->target) - 1);
+                strcpy(layer->method, method_names[probe->method]);
+            } else if (outcome < 0 && pending[probe->layer] == 0 && layer->status != PROBE_STATUS_REACHABLE) {
+                layer->status = PROBE_STATUS_UNREACHABLE;
+            }
+        }
+    }
+
+    int reachable = 0;
+    for (int i = 0; i < set.count; i++) close(set.probes[i].fd);
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) {
+        if (result->layers[layer].status == PROBE_STATUS_REACHABLE) reachable++;
+    }
+    result->total_ms = (monotonic_time_us() - start_us) / 1000.0;
+    return reachable;
+}
@@ -0,0 +1,474 @@
+#include "dhcp_probe.h"
+#include "netlink_helper.h"
+#include <poll.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <netpacket/packet.h>
+#include <net/ethernet.h>
+#include <linux/filter.h>
+
+#define DHCP_SERVER_PORT 67
+#define DHCP_CLIENT_PORT 68
+#define DHCP_MAGIC_COOKIE 0x63825363
+#define DHCP_OPTIONS_LEN 312
+
+#define DHCP_DISCOVER 1
+#define DHCP_OFFER 2
+#define DHCP_REQUEST 3
+#define DHCP_ACK 5
+#define DHCP_NAK 6
+#define DHCP_RELEASE 7
+
+#define DHCP_OPT_PAD 0
+#define DHCP_OPT_SUBNET_MASK 1
+#define DHCP_OPT_ROUTER 3
+#define DHCP_OPT_REQUESTED_IP 50
+#define DHCP_OPT_LEASE_TIME 51
+#define DHCP_OPT_MESSAGE_TYPE 53
+#define DHCP_OPT_SERVER_ID 54
+#define DHCP_OPT_PARAM_LIST 55
+#define DHCP_OPT_END 255
+
+// BOOTP header as on the wire (RFC 2131)
+typedef struct __attribute__((packed)) {
+    uint8_t op;
+    uint8_t htype;
+    uint8_t hlen;
+    uint8_t hops;
+    uint32_t xid;
+    uint16_t secs;
+    uint16_t flags;
+    uint32_t ciaddr;
+    uint32_t yiaddr;
+    uint32_t siaddr;
+    uint32_t giaddr;
+    uint8_t chaddr[16];
+    uint8_t sname[64];
+    uint8_t file[128];
+    uint32_t cookie;
+    uint8_t options[DHCP_OPTIONS_LEN];
+} dhcp_message_t;
+
+typedef struct __attribute__((packed)) {
+    struct iphdr ip;
+    struct udphdr udp;
+    dhcp_message_t dhcp;
+} dhcp_packet_t;
+
+// Fields of a server reply that the probe acts on
+typedef struct {
+    int type;
+    uint32_t yiaddr;
+    uint32_t server_id;
+    uint32_t subnet_mask;
+    uint32_t router;
+    uint32_t lease_time;
+    uint8_t server_mac[ETH_ALEN];
+} dhcp_reply_t;
+
+typedef struct {
+    int fd;
+    int ifindex;
+    uint8_t mac[ETH_ALEN];
+    uint32_t xid;
+} dhcp_probe_socket_t;
+
+const char *dhcp_probe_mode_name(dhcp_probe_mode_t mode) {
+    switch (mode) {
+        case DHCP_PROBE_OFFER_ONLY: return "offer";
+        case DHCP_PROBE_LEASE: return "lease";
+        case DHCP_PROBE_BIND: return "bind";
+    }
+    return "unknown";
+}
+
+// Sub-millisecond resolution: a local server answers well inside one millisecond
+static long long monotonic_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint16_t ip_checksum(const void *data, size_t len) {
+    const uint16_t *words = (const uint16_t *)data;
+    uint32_t sum = 0;
+
+    for (; len > 1; len -= 2) sum += *words++;
+    if (len) sum += *(const uint8_t *)words;
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+// Only UDP datagrams to the client port reach the socket (offset 0 is the IP header)
+static int attach_client_port_filter(int fd) {
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                          // ip protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                          // fragment offset
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                         // x = ip header length
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),                          // udp destination port
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DHCP_CLIENT_PORT, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xffff),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog program = { sizeof(code) / sizeof(code[0]), code };
+
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program));
+}
+
+static int open_probe_socket(const char *interface_name, dhcp_probe_socket_t *sock, char *error, size_t error_size) {
+    struct sockaddr_ll addr;
+    struct ifreq ifr;
+
+    memset(sock, 0, sizeof(dhcp_probe_socket_t));
+    sock->ifindex = (int)if_nametoindex(interface_name);
+    if (sock->ifindex == 0) {
+        snprintf(error, error_size, "Interface not found");
+        return -1;
+    }
+
+    int ioctl_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (ioctl_fd < 0) {
+        snprintf(error, error_size, "socket: %s", strerror(errno));
+        return -1;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface_name, IFNAMSIZ - 1);
+    int ioctl_result = ioctl(ioctl_fd, SIOCGIFHWADDR, &ifr);
+    close(ioctl_fd);
+    if (ioctl_result < 0) {
+        snprintf(error, error_size, "Cannot read hardware address: %s", strerror(errno));
+        return -1;
+    }
+    memcpy(sock->mac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+
+    // SOCK_DGRAM: the kernel adds and strips the link-layer header
+    sock->fd = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons(ETH_P_IP));
+    if (sock->fd < 0) {
+        snprintf(error, error_size, "Packet socket unavailable: %s", strerror(errno));
+        return -1;
+    }
+    attach_client_port_filter(sock->fd);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    addr.sll_ifindex = sock->ifindex;
+    if (bind(sock->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        snprintf(error, error_size, "Cannot bind packet socket: %s", strerror(errno));
+        close(sock->fd);
+        sock->fd = -1;
+        return -1;
+    }
+
+    sock->xid = (uint32_t)(monotonic_time_ms() * 2654435761u) ^ ((uint32_t)getpid() << 16) ^ sock->mac[5];
+    return 0;
+}
+
+static uint8_t *put_option(uint8_t *pos, uint8_t code, const void *data, uint8_t len) {
+    *pos++ = code;
+    *pos++ = len;
+    memcpy(pos, data, len);
+    return pos + len;
+}
+
+// Build and send one client message. Replies are requested as broadcast because
+// the interface has no address yet; a RELEASE is unicast to the leasing server.
+static int send_client_message(dhcp_probe_socket_t *sock, int type, const dhcp_reply_t *offer, uint16_t secs) {
+    static const uint8_t broadcast_mac[ETH_ALEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    static const uint8_t param_list[] = {DHCP_OPT_SUBNET_MASK, DHCP_OPT_ROUTER, DHCP_OPT_LEASE_TIME, DHCP_OPT_SERVER_ID};
+    dhcp_packet_t packet;
+    struct sockaddr_ll dest;
+    uint8_t message_type = (uint8_t)type;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.dhcp.op = 1;
+    packet.dhcp.htype = 1;
+    packet.dhcp.hlen = ETH_ALEN;
+    packet.dhcp.xid = htonl(sock->xid);
+    packet.dhcp.secs = htons(secs);
+    packet.dhcp.cookie = htonl(DHCP_MAGIC_COOKIE);
+    memcpy(packet.dhcp.chaddr, sock->mac, ETH_ALEN);
+
+    uint8_t *pos = put_option(packet.dhcp.options, DHCP_OPT_MESSAGE_TYPE, &message_type, 1);
+    if (type == DHCP_RELEASE) {
+        packet.dhcp.ciaddr = offer->yiaddr;
+        pos = put_option(pos, DHCP_OPT_SERVER_ID, &offer->server_id, 4);
+    } else {
+        packet.dhcp.flags = htons(0x8000);
+        if (type == DHCP_REQUEST) {
+            pos = put_option(pos, DHCP_OPT_REQUESTED_IP, &offer->yiaddr, 4);
+            pos = put_option(pos, DHCP_OPT_SERVER_ID, &offer->server_id, 4);
+        }
+        pos = put_option(pos, DHCP_OPT_PARAM_LIST, param_list, sizeof(param_list));
+    }
+    *pos++ = DHCP_OPT_END;
+
+    // Options are padded to their full size so old BOOTP relays accept the message
+    size_t udp_len = sizeof(struct udphdr) + sizeof(dhcp_message_t);
+    packet.udp.source = htons(DHCP_CLIENT_PORT);
+    packet.udp.dest = htons(DHCP_SERVER_PORT);
+    packet.udp.len = htons((uint16_t)udp_len);
+    packet.udp.check = 0;           // optional over IPv4
+
+    packet.ip.version = 4;
+    packet.ip.ihl = sizeof(struct iphdr) / 4;
+    packet.ip.tot_len = htons((uint16_t)(sizeof(struct iphdr) + udp_len));
+    packet.ip.ttl = 64;
+    packet.ip.protocol = IPPROTO_UDP;
+    packet.ip.saddr = (type == DHCP_RELEASE) ? offer->yiaddr : INADDR_ANY;
+    packet.ip.daddr = (type == DHCP_RELEASE) ? offer->server_id : INADDR_BROADCAST;
+    packet.ip.check = ip_checksum(&packet.ip, sizeof(struct iphdr));
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sll_family = AF_PACKET;
+    dest.sll_protocol = htons(ETH_P_IP);
+    dest.sll_ifindex = sock->ifindex;
+    dest.sll_halen = ETH_ALEN;
+    memcpy(dest.sll_addr, (type == DHCP_RELEASE) ? offer->server_mac : broadcast_mac, ETH_ALEN);
+
+    ssize_t sent = sendto(sock->fd, &packet, sizeof(packet), 0, (struct sockaddr *)&dest, sizeof(dest));
+    return (sent == (ssize_t)sizeof(packet)) ? 0 : -1;
+}
+
+// Validate a received datagram as a reply to our transaction and extract its options
+static int parse_server_reply(const dhcp_probe_socket_t *sock, const uint8_t *data, size_t len, dhcp_reply_t *reply) {
+    const struct iphdr *ip = (const struct iphdr *)data;
+
+    if (len < sizeof(struct iphdr) || ip->version != 4 || ip->protocol != IPPROTO_UDP) return -1;
+    size_t ip_len = ip->ihl * 4u;
+    if (ip_len < sizeof(struct iphdr) || len < ip_len + sizeof(struct udphdr)) return -1;
+
+    const struct udphdr *udp = (const struct udphdr *)(data + ip_len);
+    if (ntohs(udp->dest) != DHCP_CLIENT_PORT) return -1;
+
+    const dhcp_message_t *dhcp = (const dhcp_message_t *)(data + ip_len + sizeof(struct udphdr));
+    size_t dhcp_len = len - ip_len - sizeof(struct udphdr);
+    if (dhcp_len < offsetof(dhcp_message_t, options)) return -1;
+    if (dhcp->op != 2 || ntohl(dhcp->xid) != sock->xid || ntohl(dhcp->cookie) != DHCP_MAGIC_COOKIE ||
+        memcmp(dhcp->chaddr, sock->mac, ETH_ALEN) != 0) {
+        return -1;
+    }
+
+    memset(reply, 0, sizeof(dhcp_reply_t));
+    reply->yiaddr = dhcp->yiaddr;
+
+    const uint8_t *pos = dhcp->options;
+    const uint8_t *end = (const uint8_t *)dhcp + dhcp_len;
+    while (pos < end && *pos != DHCP_OPT_END) {
+        if (*pos == DHCP_OPT_PAD) {
+            pos++;
+            continue;
+        }
+        if (pos + 2 > end || pos + 2 + pos[1] > end) break;
+        uint8_t code = pos[0];
+        uint8_t opt_len = pos[1];
+        const uint8_t *value = pos + 2;
+
+        if (code == DHCP_OPT_MESSAGE_TYPE && opt_len >= 1) reply->type = value[0];
+        else if (code == DHCP_OPT_SERVER_ID && opt_len >= 4) memcpy(&reply->server_id, value, 4);
+        else if (code == DHCP_OPT_SUBNET_MASK && opt_len >= 4) memcpy(&reply->subnet_mask, value, 4);
+        else if (code == DHCP_OPT_ROUTER && opt_len >= 4) memcpy(&reply->router, value, 4);
+        else if (code == DHCP_OPT_LEASE_TIME && opt_len >= 4) {
+            memcpy(&reply->lease_time, value, 4);
+            reply->lease_time = ntohl(reply->lease_time);
+        }
+        pos += 2 + opt_len;
+    }
+    return reply->type ? 0 : -1;
+}
+
+// Wait for a reply of one of the wanted types until deadline_ms, resending the current
+// message every DHCP_PROBE_RETRANSMIT_MS. Returns the reply type, or 0 on timeout.
+static int wait_for_reply(dhcp_probe_socket_t *sock, int request_type, const dhcp_reply_t *offer,
+                          long long start_ms, long long deadline_ms, dhcp_reply_t *reply, int *sent_count) {
+    uint8_t buffer[1500];
+    struct sockaddr_ll from;
+    socklen_t from_len;
+    long long next_send_ms = monotonic_time_ms() + DHCP_PROBE_RETRANSMIT_MS;
+
+    while (keep_running) {
+        long long now = monotonic_time_ms();
+        if (now >= deadline_ms) return 0;
+        if (now >= next_send_ms) {
+            send_client_message(sock, request_type, offer, (uint16_t)((now - start_ms) / 1000));
+            if (sent_count) (*sent_count)++;
+            next_send_ms = now + DHCP_PROBE_RETRANSMIT_MS;
+        }
+
+        long long wake_ms = (next_send_ms < deadline_ms) ? next_send_ms : deadline_ms;
+        struct pollfd pfd = { sock->fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, (int)(wake_ms - now));
+        if (ready < 0 && errno != EINTR) return -1;
+        if (ready <= 0) continue;
+
+        from_len = sizeof(from);
+        ssize_t len = recvfrom(sock->fd, buffer, sizeof(buffer), 0, (struct sockaddr *)&from, &from_len);
+        if (len <= 0) continue;
+        if (parse_server_reply(sock, buffer, (size_t)len, reply) != 0) continue;
+
+        if (request_type == DHCP_DISCOVER && reply->type == DHCP_OFFER) {
+            memcpy(reply->server_mac, from.sll_addr, ETH_ALEN);
+            return DHCP_OFFER;
+        }
+        if (request_type == DHCP_REQUEST && (reply->type == DHCP_ACK || reply->type == DHCP_NAK)) {
+            // A NAK or ACK from a server we did not select is not ours
+            if (reply->server_id && reply->server_id != offer->server_id) continue;
+            memcpy(reply->server_mac, from.sll_addr, ETH_ALEN);
+            return reply->type;
+        }
+    }
+    return 0;
+}
+
+static void format_address(uint32_t address, char *buffer) {
+    if (address) {
+        inet_ntop(AF_INET, &address, buffer, INET_ADDRSTRLEN);
+    } else {
+        buffer[0] = '\0';
+    }
+}
+
+static int prefix_length(uint32_t mask_be) {
+    uint32_t mask = ntohl(mask_be);
+    int length = 0;
+    while (mask & 0x80000000u) {
+        length++;
+        mask <<= 1;
+    }
+    return length;
+}
+
+int dhcp_probe_run(const char *interface_name, dhcp_probe_mode_t mode, int timeout_ms, dhcp_probe_result_t *result) {
+    dhcp_probe_socket_t sock;
+    dhcp_reply_t no_offer;
+    dhcp_reply_t offer;
+    dhcp_reply_t ack;
+
+    memset(result, 0, sizeof(dhcp_probe_result_t));
+    result->mode = mode;
+    result->offer_ms = -1;
+    result->ack_ms = -1;
+    result->outcome = -1;
+
+    if (open_probe_socket(interface_name, &sock, result->error, sizeof(result->error)) != 0) {
+        return result->outcome;
+    }
+
+    long long start_us = monotonic_time_us();
+    long long start_ms = monotonic_time_ms();
+    long long deadline_ms = start_ms + timeout_ms;
+    memset(&no_offer, 0, sizeof(no_offer));
+
+    send_client_message(&sock, DHCP_DISCOVER, &no_offer, 0);
+    result->discover_count = 1;
+    int reply_type = wait_for_reply(&sock, DHCP_DISCOVER, &no_offer, start_ms, deadline_ms, &offer, &result->discover_count);
+    if (reply_type != DHCP_OFFER) {
+        result->outcome = (reply_type < 0) ? -1 : -2;
+        snprintf(result->error, sizeof(result->error), reply_type < 0 ? "Receive failed" : "No DHCPOFFER before timeout");
+        goto done;
+    }
+
+    result->offer_ms = (monotonic_time_us() - start_us) / 1000.0;
+    format_address(offer.yiaddr, result->offered_ip);
+    format_address(offer.server_id, result->server_ip);
+    format_address(offer.subnet_mask, result->subnet_mask);
+    format_address(offer.router, result->router);
+    result->lease_time_s = offer.lease_time;
+
+    if (mode == DHCP_PROBE_OFFER_ONLY) {
+        result->outcome = 0;
+        goto done;
+    }
+
+    // Without a server identifier the REQUEST cannot select this offer
+    if (!offer.server_id) {
+        snprintf(result->error, sizeof(result->error), "DHCPOFFER without server identifier");
+        goto done;
+    }
+
+    send_client_message(&sock, DHCP_REQUEST, &offer, (uint16_t)(result->offer_ms / 1000.0));
+    reply_type = wait_for_reply(&sock, DHCP_REQUEST, &offer, start_ms, deadline_ms, &ack, NULL);
+    if (reply_type == DHCP_NAK) {
+        result->outcome = -3;
+        snprintf(result->error, sizeof(result->error), "Server answered DHCPNAK");
+        goto done;
+    }
+    if (reply_type != DHCP_ACK) {
+        result->outcome = (reply_type < 0) ? -1 : -2;
+        snprintf(result->error, sizeof(result->error), reply_type < 0 ? "Receive failed" : "No DHCPACK before timeout");
+        goto done;
+    }
+
+    result->ack_ms = (monotonic_time_us() - start_us) / 1000.0;
+    if (ack.lease_time) result->lease_time_s = ack.lease_time;
+    if (ack.subnet_mask) format_address(ack.subnet_mask, result->subnet_mask);
+    if (ack.router) format_address(ack.router, result->router);
+    result->outcome = 0;
+
+    if (mode == DHCP_PROBE_BIND) {
+        uint32_t mask = ack.subnet_mask ? ack.subnet_mask : offer.subnet_mask;
+        uint32_t router = ack.router ? ack.router : offer.router;
+        if (rtnl_add_ipv4_address(interface_name, offer.yiaddr, mask ? prefix_length(mask) : 24) != 0) {
+            result->outcome = -1;
+            snprintf(result->error, sizeof(result->error), "Lease acknowledged but the address could not be installed");
+        } else {
+            result->bound = 1;
+            result->bound_address = offer.yiaddr;
+            result->bound_prefix_len = mask ? prefix_length(mask) : 24;
+            result->bound_server_id = offer.server_id;
+            memcpy(result->bound_server_mac, ack.server_mac, ETH_ALEN);
+            if (router && rtnl_add_ipv4_default_route(interface_name, router, DHCP_PROBE_ROUTE_METRIC) == 0) {
+                result->bound_router = router;
+                result->route_installed = 1;
+            }
+        }
+    } else {
+        // Hand the lease straight back so probing does not use up the server's pool
+        memcpy(offer.server_mac, ack.server_mac, ETH_ALEN);
+        send_client_message(&sock, DHCP_RELEASE, &offer, 0);
+    }
+
+done:
+    result->total_ms = (monotonic_time_us() - start_us) / 1000.0;
+    close(sock.fd);
+    return result->outcome;
+}
+
+int dhcp_probe_release(const char *interface_name, dhcp_probe_result_t *result) {
+    dhcp_probe_socket_t sock;
+    dhcp_reply_t lease;
+    char error[128];
+    int status = 0;
+
+    if (!result->bound) return 0;
+
+    // The lease goes back to the server first, while the link to it is still up
+    if (open_probe_socket(interface_name, &sock, error, sizeof(error)) == 0) {
+        memset(&lease, 0, sizeof(lease));
+        lease.yiaddr = result->bound_address;
+        lease.server_id = result->bound_server_id;
+        memcpy(lease.server_mac, result->bound_server_mac, ETH_ALEN);
+        if (send_client_message(&sock, DHCP_RELEASE, &lease, 0) != 0) status = -1;
+        close(sock.fd);
+    } else {
+        status = -1;
+    }
+
+    if (result->route_installed &&
+        rtnl_del_ipv4_default_route(interface_name, result->bound_router, DHCP_PROBE_ROUTE_METRIC) != 0) {
+        status = -1;
+    }
+    if (rtnl_del_ipv4_address(interface_name, result->bound_address, result->bound_prefix_len) != 0) {
+        status = -1;
+    }
+
+    result->bound = 0;
+    result->route_installed = 0;
+    return status;
+}
@@ -0,0 +1,138 @@
+#include "event_loop.h"
+#include <pthread.h>
+#include <sys/signalfd.h>
+
+static event_source_t *find_source(event_loop_t *loop, int fd) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (loop->sources[i].in_use && loop->sources[i].fd == fd) return &loop->sources[i];
+    }
+    return NULL;
+}
+
+// Shutdown signals are read here instead of interrupting whatever the loop was doing
+static int handle_signal(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    struct signalfd_siginfo info;
+
+    while (read(fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        signal_handler((int)info.ssi_signo);
+        event_loop_stop(loop);
+    }
+    return 0;
+}
+
+int event_loop_init(event_loop_t *loop) {
+    sigset_t signals;
+
+    memset(loop, 0, sizeof(event_loop_t));
+    loop->signal_fd = -1;
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0) return -1;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &loop->saved_mask);
+    loop->mask_saved = 1;
+    loop->signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (loop->signal_fd < 0 || event_loop_add(loop, loop->signal_fd, EPOLLIN, handle_signal, NULL) != 0) {
+        event_loop_close(loop);
+        return -1;
+    }
+    loop->running = 1;
+    return 0;
+}
+
+int event_loop_add(event_loop_t *loop, int fd, uint32_t events, event_handler_t handler, void *data) {
+    struct epoll_event event;
+    event_source_t *source = NULL;
+    int index;
+
+    for (index = 0; index < EVENT_LOOP_MAX_SOURCES; index++) {
+        if (!loop->sources[index].in_use) {
+            source = &loop->sources[index];
+            break;
+        }
+    }
+    if (!source) {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    source->generation++;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = ((uint64_t)source->generation << 32) | (uint32_t)index;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) return -1;
+
+    source->fd = fd;
+    source->handler = handler;
+    source->data = data;
+    source->in_use = 1;
+    return 0;
+}
+
+int event_loop_modify(event_loop_t *loop, int fd, uint32_t events) {
+    struct epoll_event event;
+    event_source_t *source = find_source(loop, fd);
+
+    if (!source) {
+        errno = ENOENT;
+        return -1;
+    }
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = ((uint64_t)source->generation << 32) | (uint32_t)(source - loop->sources);
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void event_loop_remove(event_loop_t *loop, int fd) {
+    event_source_t *source = find_source(loop, fd);
+
+    if (!source) return;
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    source->in_use = 0;
+    source->fd = -1;
+}
+
+int event_loop_run(event_loop_t *loop) {
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+
+    while (loop->running && keep_running) {
+        int ready = epoll_wait(loop->epoll_fd, events, EVENT_LOOP_MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        loop->wakeups++;
+
+        for (int i = 0; i < ready && loop->running; i++) {
+            uint32_t index = (uint32_t)events[i].data.u64;
+            uint32_t generation = (uint32_t)(events[i].data.u64 >> 32);
+            event_source_t *source = &loop->sources[index];
+
+            // An earlier handler in this batch may have removed (or replaced) the source
+            if (!source->in_use || source->generation != generation) continue;
+
+            loop->dispatches++;
+            if (source->handler(loop, source->fd, events[i].events, source->data) < 0 &&
+                source->in_use && source->generation == generation) {
+                event_loop_remove(loop, source->fd);
+            }
+        }
+    }
+    return 0;
+}
+
+void event_loop_stop(event_loop_t *loop) {
+    loop->running = 0;
+}
+
+void event_loop_close(event_loop_t *loop) {
+    if (loop->signal_fd >= 0) close(loop->signal_fd);
+    if (loop->mask_saved) pthread_sigmask(SIG_SETMASK, &loop->saved_mask, NULL);
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    loop->signal_fd = -1;
+    loop->epoll_fd = -1;
+    loop->mask_saved = 0;
+    loop->running = 0;
+}
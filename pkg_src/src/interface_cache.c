@@ -0,0 +1,332 @@
+#include "interface_cache.h"
+#include "netlink_helper.h"
+#include <pthread.h>
+#include <linux/rtnetlink.h>
+#include <linux/nl80211.h>
+#include <net/if.h>
+#include <sys/socket.h>
+
+typedef struct {
+    int in_use;
+    wifi_interface_t data;
+    unsigned int valid_mask;
+    long long fetched_ms[IFACE_FIELD_GROUP_COUNT];
+    unsigned long fetched_tick[IFACE_FIELD_GROUP_COUNT];
+    unsigned long generation;   // changes on every invalidation and when the slot is reused
+} interface_cache_entry_t;
+
+static interface_cache_entry_t cache_entries[MAX_INTERFACES];
+static interface_cache_stats_t cache_stats;
+static unsigned long cache_tick = 0;
+static unsigned long cache_generation = 0;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Non-blocking RTMGRP_LINK listener used to invalidate entries on link changes
+static nl_socket_t link_events = { -1, 0, 0 };
+static int link_events_state = 0; // 0 = not tried, 1 = active, -1 = unavailable
+
+// nl80211 "mlme" listener: a roam or reassociation changes SSID and frequency without
+// any RTM_NEWLINK, so the long link TTL is only safe while these arrive too
+static nl_socket_t mlme_events = { -1, 0, 0 };
+static int mlme_events_state = 0;
+
+static interface_cache_entry_t *find_entry(const char *interface_name, int create) {
+    interface_cache_entry_t *free_slot = NULL;
+
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (cache_entries[i].in_use) {
+            if (strcmp(cache_entries[i].data.name, interface_name) == 0) {
+                return &cache_entries[i];
+            }
+        } else if (!free_slot) {
+            free_slot = &cache_entries[i];
+        }
+    }
+
+    if (!create) return NULL;
+
+    // Table full: recycle the first slot rather than failing the lookup
+    if (!free_slot) free_slot = &cache_entries[0];
+
+    memset(free_slot, 0, sizeof(interface_cache_entry_t));
+    free_slot->in_use = 1;
+    free_slot->generation = ++cache_generation;
+    strncpy(free_slot->data.name, interface_name, MAX_INTERFACE_NAME - 1);
+    return free_slot;
+}
+
+static void invalidate_entry(interface_cache_entry_t *entry, unsigned int mask) {
+    // Bumped even when nothing was valid: a fetch in flight for these groups is now stale
+    entry->generation = ++cache_generation;
+    if (entry->valid_mask & mask) {
+        entry->valid_mask &= ~mask;
+        cache_stats.invalidations++;
+    }
+}
+
+static void open_mlme_events(void) {
+    if (mlme_events_state != 0) return;
+
+    mlme_events_state = -1;
+    if (nl_socket_open(&mlme_events, NETLINK_GENERIC, 0) != 0) return;
+
+    int group = genl_resolve_multicast_group(&mlme_events, "nl80211", "mlme");
+    if (group < 0 || nl_socket_add_membership(&mlme_events, (uint32_t)group) != 0) {
+        nl_socket_close(&mlme_events);
+        mlme_events.fd = -1;
+        return;
+    }
+    fcntl(mlme_events.fd, F_SETFL, O_NONBLOCK);
+    mlme_events_state = 1;
+}
+
+static void open_link_events(void) {
+    if (link_events_state != 0) return;
+
+    if (nl_socket_open(&link_events, NETLINK_ROUTE, RTMGRP_LINK) == 0) {
+        fcntl(link_events.fd, F_SETFL, O_NONBLOCK);
+        link_events_state = 1;
+    } else {
+        link_events_state = -1;
+    }
+    open_mlme_events();
+}
+
+static int events_active(void) {
+    return link_events_state == 1 && mlme_events_state == 1;
+}
+
+static void invalidate_all_entries(unsigned int mask) {
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (cache_entries[i].in_use) invalidate_entry(&cache_entries[i], mask);
+    }
+}
+
+// Apply pending RTM_NEWLINK/RTM_DELLINK notifications without blocking
+static void drain_link_events(void) {
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    if (link_events_state != 1) return;
+
+    while (1) {
+        ssize_t len = recv(link_events.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == ENOBUFS) {
+                // Events were dropped; nothing cached can be trusted
+                invalidate_all_entries(IFACE_FIELD_MASK_ALL);
+                continue;
+            }
+            break;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type != RTM_NEWLINK && nlh->nlmsg_type != RTM_DELLINK) continue;
+
+            struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA(nlh);
+            struct nlattr *tb[IFLA_MAX + 1];
+            nl_parse_attrs(tb, IFLA_MAX, (char *)ifi + NLMSG_ALIGN(sizeof(*ifi)),
+                           nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi)));
+            // Wireless extension events (scan done, etc.) also arrive as RTM_NEWLINK
+            if (!tb[IFLA_IFNAME] || tb[IFLA_WIRELESS]) continue;
+
+            cache_stats.link_events++;
+            interface_cache_entry_t *entry = find_entry((const char *)nl_attr_data(tb[IFLA_IFNAME]), 0);
+            if (!entry) continue;
+
+            if (nlh->nlmsg_type == RTM_DELLINK) {
+                invalidate_entry(entry, IFACE_FIELD_MASK_ALL);
+            } else {
+                invalidate_entry(entry, IFACE_FIELD_MASK(IFACE_FIELDS_STATUS) |
+                                        IFACE_FIELD_MASK(IFACE_FIELDS_LINK) |
+                                        IFACE_FIELD_MASK(IFACE_FIELDS_SIGNAL));
+            }
+        }
+    }
+}
+
+// Association changes: the SSID, frequency and signal of that interface are stale
+static void drain_mlme_events(void) {
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    char interface_name[IF_NAMESIZE];
+
+    if (mlme_events_state != 1) return;
+
+    while (1) {
+        ssize_t len = recv(mlme_events.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == ENOBUFS) {
+                invalidate_all_entries(IFACE_FIELD_MASK(IFACE_FIELDS_LINK) | IFACE_FIELD_MASK(IFACE_FIELDS_SIGNAL));
+                continue;
+            }
+            break;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) continue;
+            const struct genlmsghdr *genl = (const struct genlmsghdr *)NLMSG_DATA(nlh);
+            switch (genl->cmd) {
+                case NL80211_CMD_CONNECT:
+                case NL80211_CMD_ROAM:
+                case NL80211_CMD_DISCONNECT:
+                case NL80211_CMD_ASSOCIATE:
+                case NL80211_CMD_DISASSOCIATE:
+                case NL80211_CMD_DEAUTHENTICATE:
+                case NL80211_CMD_CH_SWITCH_NOTIFY:
+                    break;
+                default:
+                    continue;
+            }
+
+            struct nlattr *tb[NL80211_ATTR_MAX + 1];
+            genl_parse_attrs(tb, NL80211_ATTR_MAX, nlh);
+            if (!tb[NL80211_ATTR_IFINDEX] ||
+                !if_indextoname(nl_attr_get_u32(tb[NL80211_ATTR_IFINDEX]), interface_name)) {
+                continue;
+            }
+
+            cache_stats.mlme_events++;
+            interface_cache_entry_t *entry = find_entry(interface_name, 0);
+            if (entry) {
+                invalidate_entry(entry, IFACE_FIELD_MASK(IFACE_FIELDS_LINK) | IFACE_FIELD_MASK(IFACE_FIELDS_SIGNAL));
+            }
+        }
+    }
+}
+
+static int group_is_fresh(const interface_cache_entry_t *entry, int group, long long now_ms) {
+    if (!(entry->valid_mask & IFACE_FIELD_MASK(group))) return 0;
+
+    switch (group) {
+        case IFACE_FIELDS_STATIC:
+            return 1;
+        case IFACE_FIELDS_LINK: {
+            long long ttl = events_active() ? IFACE_CACHE_LINK_TTL_WITH_EVENTS_MS : IFACE_CACHE_LINK_TTL_MS;
+            return (now_ms - entry->fetched_ms[group]) < ttl;
+        }
+        default:
+            return entry->fetched_tick[group] == cache_tick;
+    }
+}
+
+static void copy_group_fields(wifi_interface_t *dst, const wifi_interface_t *src, unsigned int mask) {
+    if (mask & IFACE_FIELD_MASK(IFACE_FIELDS_STATIC)) {
+        memcpy(dst->mac, src->mac, sizeof(dst->mac));
+        memcpy(dst->type, src->type, sizeof(dst->type));
+        memcpy(dst->mode, src->mode, sizeof(dst->mode));
+    }
+    if (mask & IFACE_FIELD_MASK(IFACE_FIELDS_STATUS)) {
+        memcpy(dst->status, src->status, sizeof(dst->status));
+    }
+    if (mask & IFACE_FIELD_MASK(IFACE_FIELDS_LINK)) {
+        memcpy(dst->ssid, src->ssid, sizeof(dst->ssid));
+        dst->frequency = src->frequency;
+        dst->channel = src->channel;
+        dst->tx_power = src->tx_power;
+    }
+    if (mask & IFACE_FIELD_MASK(IFACE_FIELDS_SIGNAL)) {
+        dst->signal_strength = src->signal_strength;
+    }
+}
+
+static void mark_fetched(interface_cache_entry_t *entry, unsigned int mask) {
+    long long now_ms = monotonic_time_ms();
+
+    for (int group = 0; group < IFACE_FIELD_GROUP_COUNT; group++) {
+        if (mask & IFACE_FIELD_MASK(group)) {
+            entry->fetched_ms[group] = now_ms;
+            entry->fetched_tick[group] = cache_tick;
+        }
+    }
+    entry->valid_mask |= mask;
+}
+
+int interface_cache_get(const char *interface_name, wifi_interface_t *interface) {
+    wifi_interface_t snapshot;
+    unsigned int stale_mask = 0;
+
+    if (!interface_name || !interface) return -1;
+
+    pthread_mutex_lock(&cache_mutex);
+    open_link_events();
+    drain_link_events();
+    drain_mlme_events();
+
+    interface_cache_entry_t *entry = find_entry(interface_name, 1);
+    long long now_ms = monotonic_time_ms();
+
+    for (int group = 0; group < IFACE_FIELD_GROUP_COUNT; group++) {
+        if (group_is_fresh(entry, group, now_ms)) {
+            cache_stats.hits[group]++;
+        } else {
+            cache_stats.misses[group]++;
+            stale_mask |= IFACE_FIELD_MASK(group);
+        }
+    }
+
+    memcpy(&snapshot, &entry->data, sizeof(snapshot));
+    unsigned long generation = entry->generation;
+    pthread_mutex_unlock(&cache_mutex);
+
+    // External commands run without the lock so other interfaces are not serialized
+    int result = 0;
+    if (stale_mask) {
+        result = fetch_interface_fields(interface_name, &snapshot, stale_mask);
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    // Events queued while the lock was dropped may describe a change the fetch raced with
+    drain_link_events();
+    drain_mlme_events();
+    entry = find_entry(interface_name, 1);
+    memcpy(interface, &entry->data, sizeof(wifi_interface_t));
+    if (stale_mask && result == 0) {
+        if (entry->generation == generation) {
+            copy_group_fields(&entry->data, &snapshot, stale_mask);
+            mark_fetched(entry, stale_mask);
+        }
+        // The caller still gets what was just read; only the cache declines to keep it
+        copy_group_fields(interface, &snapshot, stale_mask);
+    }
+    interface->was_connected = 0;
+    memset(&interface->profile, 0, sizeof(interface->profile));
+    pthread_mutex_unlock(&cache_mutex);
+
+    return result;
+}
+
+void interface_cache_store(const wifi_interface_t *interface) {
+    if (!interface) return;
+
+    pthread_mutex_lock(&cache_mutex);
+    open_link_events();
+    interface_cache_entry_t *entry = find_entry(interface->name, 1);
+    copy_group_fields(&entry->data, interface, IFACE_FIELD_MASK_ALL);
+    mark_fetched(entry, IFACE_FIELD_MASK_ALL);
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void interface_cache_invalidate(const char *interface_name) {
+    pthread_mutex_lock(&cache_mutex);
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (!cache_entries[i].in_use) continue;
+        if (!interface_name || strcmp(cache_entries[i].data.name, interface_name) == 0) {
+            invalidate_entry(&cache_entries[i], IFACE_FIELD_MASK_ALL);
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void interface_cache_tick(void) {
+    pthread_mutex_lock(&cache_mutex);
+    cache_tick++;
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void interface_cache_get_stats(interface_cache_stats_t *stats) {
+    pthread_mutex_lock(&cache_mutex);
+    memcpy(stats, &cache_stats, sizeof(interface_cache_stats_t));
+    stats->events_active = events_active();
+    pthread_mutex_unlock(&cache_mutex);
+}
@@ -1,56 +1,60 @@
 #include "interface_detector.h"
+#include "wiphy_capabilities.h"
+#include "command_runner.h"
+#include <net/if.h>
 
 int detect_wifi_interfaces(wifi_interface_t *interfaces, int max_interfaces) {
     return scan_network_interfaces(interfaces, max_interfaces);
 }
 
+// Offer one interface name to the detector; returns 1 when it was added
+static int add_if_wireless(const char *name, wifi_interface_t *interfaces, int count) {
+    if (strlen(name) == 0 || strlen(name) >= MAX_INTERFACE_NAME || !is_wireless_interface(name)) {
+        return 0;
+    }
+    strncpy(interfaces[count].name, name, MAX_INTERFACE_NAME - 1);
+    interfaces[count].name[MAX_INTERFACE_NAME - 1] = '\0';
+    
+    // Get detailed information for this interface
+    return get_interface_details(name, &interfaces[count]) == 0;
+}
+
 int scan_network_interfaces(wifi_interface_t *interfaces, int max_interfaces) {
-    FILE *fp;
     char line[MAX_LINE_LEN];
     int count = 0;
     
-    // Try ip command first
-    fp = popen("ip link show 2>/dev/null | grep -E '^[0-9]+:' | awk '{print $2}' | sed 's/:$//'", "r");
-    
-    if (!fp) {
-        // Fallback: try reading from /proc/net/dev
-        fp = popen("cat /proc/net/dev 2>/dev/null | tail -n +3 | awk -F: '{print $1}' | tr -d ' '", "r");
-    }
-    
-    if (!fp) {
-        // Fallback: try ls /sys/class/net/
-        fp = popen("ls /sys/class/net/ 2>/dev/null", "r");
+    // Enumerate interfaces in-process, in ifindex order like "ip link show"
+    struct if_nameindex *names = if_nameindex();
+    if (names) {
+        for (struct if_nameindex *name = names; name->if_index != 0 && count < max_interfaces; name++) {
+            count += add_if_wireless(name->if_name, interfaces, count);
+        }
+        if_freenameindex(names);
+        return count;
     }
     
-    if (!fp) {
-        // Last resort: try ifconfig
-        fp = popen("ifconfig -a 2>/dev/null | grep -E '^[a-zA-Z0-9]+' | awk '{print $1}' | sed 's/:$//'", "r");
-    }
+    // Fallback: /proc/net/dev
     
+    FILE *fp = fopen("/proc/net/dev", "r");
     if (!fp) {
         return 0;
     }
     
-    while (fgets(line, sizeof(line), fp) && count < max_interfaces) {
-        line[strcspn(line, "\n")] = 0; // Remove newline
+    // Two header lines, then "  name: counters..."
+    for (int line_number = 0; fgets(line, sizeof(line), fp) && count < max_interfaces; line_number++) {
+        char *colon = strchr(line, ':');
+        if (line_number < 2 || !colon) continue;
+        *colon = '\0';
         
-        if (strlen(line) > 0 && is_wireless_interface(line)) {
-            strncpy(interfaces[count].name, line, MAX_INTERFACE_NAME - 1);
-            interfaces[count].name[MAX_INTERFACE_NAME - 1] = '\0';
-            
-            // Get detailed information for this interface
-            if (get_interface_details(line, &interfaces[count]) == 0) {
-                count++;
-            }
-        }
+        char *name = line + strspn(line, " \t");
+        count += add_if_wireless(name, interfaces, count);
     }
     
-    pclose(fp);
+    fclose(fp);
     return count;
 }
 
 int is_wireless_interface(const char *interface_name) {
-    char command[MAX_COMMAND_LEN];
     char path[256];
     
     // Check if wireless directory exists in sysfs
@@ -60,14 +64,14 @@ int is_wireless_interface(const char *interface_name) {
     }
     
     // Alternative: check using iw command
-    snprintf(command, sizeof(command), "iw dev %s info >/dev/null 2>&1", interface_name);
-    if (system(command) == 0) {
+    const char *const iw_info[] = {"iw", "dev", interface_name, "info", NULL};
+    if (command_run(iw_info, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL) == 0) {
         return 1;
     }
     
     // Alternative: check using iwconfig
-    snprintf(command, sizeof(command), "iwconfig %s >/dev/null 2>&1", interface_name);
-    if (system(command) == 0) {
+    const char *const iwconfig[] = {"iwconfig", interface_name, NULL};
+    if (command_run(iwconfig, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL) == 0) {
         return 1;
     }
     
@@ -75,104 +79,19 @@ int is_wireless_interface(const char *interface_name) {
 }
 
 int get_interface_details(const char *interface_name, wifi_interface_t *interface) {
-    FILE *fp;
-    char command[MAX_COMMAND_LEN];
-    char line[MAX_LINE_LEN];
-    
-    // Initialize interface structure
+    // Goes through the snapshot cache so later lookups in this process are hits
     memset(interface, 0, sizeof(wifi_interface_t));
-    strncpy(interface->name, interface_name, MAX_INTERFACE_NAME - 1);
-    
-    // Get interface status using ip command
-    snprintf(command, sizeof(command), "ip link show %s | grep -oE '(UP|DOWN)'", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        if (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            strncpy(interface->status, line, sizeof(interface->status) - 1);
-        } else {
-            strcpy(interface->status, "DOWN");
-        }
-        pclose(fp);
-    }
-    
-    // Get MAC address
-    snprintf(command, sizeof(command), "cat /sys/class/net/%s/address 2>/dev/null", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        if (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            strncpy(interface->mac, line, MAX_MAC_LEN - 1);
-        }
-        pclose(fp);
-    }
-    
-    // Get wireless information using iw
-    snprintf(command, sizeof(command), "iw dev %s info 2>/dev/null", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        while (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            
-            if (strstr(line, "type ")) {
-                char *type_start = strstr(line, "type ") + 5;
-                strncpy(interface->type, type_start, sizeof(interface->type) - 1);
-            }
-            else if (strstr(line, "channel ")) {
-                sscanf(line, "%*s channel %d (%d MHz)", &interface->channel, &interface->frequency);
-            }
-            else if (strstr(line, "txpower ")) {
-                float power;
-                if (sscanf(line, "%*s txpower %f dBm", &power) == 1) {
-                    interface->tx_power = (int)power;
-                }
-            }
-        }
-        pclose(fp);
-    }
-    
-    // Get SSID if connected
-    snprintf(command, sizeof(command), "iw dev %s link 2>/dev/null | grep SSID", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        if (fgets(line, sizeof(line), fp)) {
-            char *ssid_start = strstr(line, "SSID: ");
-            if (ssid_start) {
-                ssid_start += 6;
-                strncpy(interface->ssid, ssid_start, MAX_SSID_LEN - 1);
-                interface->ssid[strcspn(interface->ssid, "\n")] = 0;
-            }
-        }
-        pclose(fp);
-    }
-    
-    // Get signal strength if connected
-    snprintf(command, sizeof(command), "iw dev %s link 2>/dev/null | grep signal", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        if (fgets(line, sizeof(line), fp)) {
-            int signal;
-            if (sscanf(line, "%*s signal: %d dBm", &signal) == 1) {
-                interface->signal_strength = signal;
-            }
-        }
-        pclose(fp);
-    }
-    
-    // Set default type if not detected
-    if (strlen(interface->type) == 0) {
-        strcpy(interface->type, "managed");
-    }
-    
-    return 0;
+    return get_interface_info(interface_name, interface);
 }
 
 int check_interface_capabilities(const char *interface_name) {
-    char command[MAX_COMMAND_LEN];
+    wiphy_capabilities_t caps;
     
-    // Check if interface can scan
-    snprintf(command, sizeof(command), "iw dev %s scan trigger test >/dev/null 2>&1", interface_name);
-    return (system(command) == 0) ? 1 : 0;
+    // Read scan support from the cached wiphy model instead of triggering a scan
+    if (wiphy_get_capabilities(interface_name, &caps) != 0) {
+        return 0;
+    }
+    return wiphy_can_scan(&caps);
 }
 
 char* get_best_wifi_interface(wifi_interface_t *interfaces, int interface_count) {
@@ -202,6 +121,20 @@ char* get_best_wifi_interface(wifi_interface_t *interfaces, int interface_count)
             score += 1;
         }
         
+        // Use the cached wiphy model: skip radios that cannot scan, prefer dual-band ones
+        wiphy_capabilities_t caps;
+        if (wiphy_get_capabilities(interfaces[i].name, &caps) == 0) {
+            if (!wiphy_can_scan(&caps)) {
+                continue;
+            }
+            if (caps.band_mask & (WIPHY_BAND_5GHZ | WIPHY_BAND_6GHZ)) {
+                score += 2;
+            }
+            if (caps.sched_scan_supported) {
+                score += 1;
+            }
+        }
+        
         if (score > best_score) {
             best_score = score;
             strncpy(best_interface, interfaces[i].name, MAX_INTERFACE_NAME - 1);
@@ -1,4 +1,5 @@
 #include "json_formatter.h"
+#include "interface_cache.h"
 
 char* escape_json_string(const char *str) {
     static char escaped[512];
@@ -35,107 +36,572 @@ char* escape_json_string(const char *str) {
     return escaped;
 }
 
+// Each formatter appends to a json_writer_t. The print_*_json wrappers write whole documents
+// to stdout with one write(); fragments meant to sit inside a caller's printf output go
+// through stdio instead, so they stay in order with it.
+
+static void print_document(json_writer_t *w) {
+    json_writer_flush(w, STDOUT_FILENO);
+    json_writer_free(w);
+}
+
+static void print_fragment(json_writer_t *w) {
+    json_writer_emit(w, stdout);
+    json_writer_free(w);
+}
+
+// "key": "value" with the line's indentation and trailing separator
+static void write_string_field(json_writer_t *w, const char *prefix, const char *value, const char *suffix) {
+    json_writer_raw(w, prefix);
+    json_writer_string(w, value);
+    json_writer_raw(w, suffix);
+}
+
+static void write_int_field(json_writer_t *w, const char *prefix, long long value, const char *suffix) {
+    json_writer_raw(w, prefix);
+    json_writer_int(w, value);
+    json_writer_raw(w, suffix);
+}
+
+static void write_bool_field(json_writer_t *w, const char *prefix, int value, const char *suffix) {
+    json_writer_raw(w, prefix);
+    json_writer_bool(w, value);
+    json_writer_raw(w, suffix);
+}
+
+// Interface fields at the given indentation ("      " inside a list, "    " as a member)
+static void write_interface_fields(json_writer_t *w, const wifi_interface_t *interface, const char *indent) {
+    json_writer_raw(w, indent);
+    write_string_field(w, "\"name\": ", interface->name, ",\n");
+    json_writer_raw(w, indent);
+    write_string_field(w, "\"type\": ", interface->type, ",\n");
+    json_writer_raw(w, indent);
+    write_string_field(w, "\"status\": ", interface->status, ",\n");
+    json_writer_raw(w, indent);
+    write_string_field(w, "\"mac_address\": ", interface->mac, ",\n");
+    json_writer_raw(w, indent);
+    write_int_field(w, "\"frequency\": ", interface->frequency, ",\n");
+    json_writer_raw(w, indent);
+    write_int_field(w, "\"channel\": ", interface->channel, ",\n");
+    json_writer_raw(w, indent);
+    write_string_field(w, "\"ssid\": ", interface->ssid, ",\n");
+    json_writer_raw(w, indent);
+    write_int_field(w, "\"signal_strength\": ", interface->signal_strength, ",\n");
+    json_writer_raw(w, indent);
+    write_int_field(w, "\"tx_power\": ", interface->tx_power, ",\n");
+    json_writer_raw(w, indent);
+    write_string_field(w, "\"mode\": ", interface->mode, "\n");
+}
+
+void json_write_interface(json_writer_t *w, const wifi_interface_t *interface) {
+    json_writer_raw(w, "    {\n");
+    write_interface_fields(w, interface, "      ");
+    json_writer_raw(w, "    }");
+}
+
 void print_interface_json(const wifi_interface_t *interface) {
-    printf("    {\n");
-    printf("      \"name\": \"%s\",\n", escape_json_string(interface->name));
-    printf("      \"type\": \"%s\",\n", escape_json_string(interface->type));
-    printf("      \"status\": \"%s\",\n", escape_json_string(interface->status));
-    printf("      \"mac_address\": \"%s\",\n", escape_json_string(interface->mac));
-    printf("      \"frequency\": %d,\n", interface->frequency);
-    printf("      \"channel\": %d,\n", interface->channel);
-    printf("      \"ssid\": \"%s\",\n", escape_json_string(interface->ssid));
-    printf("      \"signal_strength\": %d,\n", interface->signal_strength);
-    printf("      \"tx_power\": %d,\n", interface->tx_power);
-    printf("      \"mode\": \"%s\"\n", escape_json_string(interface->mode));
-    printf("    }");
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_interface(&w, interface);
+    print_fragment(&w);
+}
+
+void json_write_scan_result(json_writer_t *w, const scan_result_t *result, int is_last) {
+    json_writer_raw(w, "    {\n");
+    write_string_field(w, "      \"bssid\": ", result->bssid, ",\n");
+    write_string_field(w, "      \"ssid\": ", result->ssid, ",\n");
+    write_int_field(w, "      \"frequency\": ", result->frequency, ",\n");
+    write_int_field(w, "      \"channel\": ", result->channel, ",\n");
+    write_int_field(w, "      \"signal_strength\": ", result->signal_strength, ",\n");
+    write_int_field(w, "      \"quality\": ", result->quality, ",\n");
+    write_string_field(w, "      \"security\": ", result->security, ",\n");
+    write_string_field(w, "      \"capabilities\": ", result->capabilities, ",\n");
+    write_string_field(w, "      \"timestamp\": ", result->timestamp, "\n");
+    json_writer_raw(w, is_last ? "    }\n" : "    },\n");
 }
 
 void print_scan_result_json(const scan_result_t *result, int is_last) {
-    printf("    {\n");
-    printf("      \"bssid\": \"%s\",\n", escape_json_string(result->bssid));
-    printf("      \"ssid\": \"%s\",\n", escape_json_string(result->ssid));
-    printf("      \"frequency\": %d,\n", result->frequency);
-    printf("      \"channel\": %d,\n", result->channel);
-    printf("      \"signal_strength\": %d,\n", result->signal_strength);
-    printf("      \"quality\": %d,\n", result->quality);
-    printf("      \"security\": \"%s\",\n", escape_json_string(result->security));
-    printf("      \"capabilities\": \"%s\",\n", escape_json_string(result->capabilities));
-    printf("      \"timestamp\": \"%s\"\n", escape_json_string(result->timestamp));
-    printf("    }");
-    if (!is_last) {
-        printf(",");
-    }
-    printf("\n");
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_scan_result(&w, result, is_last);
+    print_fragment(&w);
 }
 
-void print_scan_results_json(const scan_session_t *session) {
-    printf("{\n");
-    printf("  \"interface\": {\n");
-    printf("    \"name\": \"%s\",\n", escape_json_string(session->interface.name));
-    printf("    \"type\": \"%s\",\n", escape_json_string(session->interface.type));
-    printf("    \"status\": \"%s\",\n", escape_json_string(session->interface.status));
-    printf("    \"mac_address\": \"%s\",\n", escape_json_string(session->interface.mac));
-    printf("    \"frequency\": %d,\n", session->interface.frequency);
-    printf("    \"channel\": %d,\n", session->interface.channel);
-    printf("    \"ssid\": \"%s\",\n", escape_json_string(session->interface.ssid));
-    printf("    \"signal_strength\": %d,\n", session->interface.signal_strength);
-    printf("    \"tx_power\": %d,\n", session->interface.tx_power);
-    printf("    \"mode\": \"%s\"\n", escape_json_string(session->interface.mode));
-    printf("  },\n");
-    printf("  \"scan_info\": {\n");
-    printf("    \"scan_time\": %ld,\n", session->scan_time);
-    printf("    \"scan_duration_ms\": %d,\n", session->scan_duration_ms);
-    printf("    \"results_count\": %d\n", session->result_count);
-    printf("  },\n");
-    printf("  \"scan_results\": [\n");
+void json_write_scan_results(json_writer_t *w, const scan_session_t *session) {
+    json_writer_raw(w, "{\n");
+    json_writer_raw(w, "  \"interface\": {\n");
+    write_interface_fields(w, &session->interface, "    ");
+    json_writer_raw(w, "  },\n");
+    json_writer_raw(w, "  \"scan_info\": {\n");
+    write_int_field(w, "    \"scan_time\": ", session->scan_time, ",\n");
+    write_int_field(w, "    \"scan_duration_ms\": ", session->scan_duration_ms, ",\n");
+    json_writer_raw(w, "    \"phases\": ");
+    json_write_scan_timing(w, &session->timing);
+    json_writer_raw(w, ",\n");
+    write_int_field(w, "    \"results_count\": ", session->result_count, "\n");
+    json_writer_raw(w, "  },\n");
+    json_writer_raw(w, "  \"scan_results\": [\n");
     
     for (int i = 0; i < session->result_count; i++) {
-        print_scan_result_json(&session->results[i], (i == session->result_count - 1));
+        json_write_scan_result(w, &session->results[i], (i == session->result_count - 1));
     }
     
-    printf("  ]\n");
-    printf("}\n");
+    json_writer_raw(w, "  ]\n");
+    json_writer_raw(w, "}\n");
+}
+
+void print_scan_results_json(const scan_session_t *session) {
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_scan_results(&w, session);
+    print_document(&w);
 }
 
 void print_continuous_scan_json(const char *interface_name, const scan_session_t *session) {
-    printf("{\n");
-    printf("  \"interface\": \"%s\",\n", escape_json_string(interface_name));
-    printf("  \"scan_time\": %ld,\n", session->scan_time);
-    printf("  \"scan_duration_ms\": %d,\n", session->scan_duration_ms);
-    printf("  \"results_count\": %d,\n", session->result_count);
-    printf("  \"interface_info\": ");
-    print_interface_json(&session->interface);
-    printf(",\n");
-    printf("  \"scan_results\": [\n");
+    json_writer_t w;
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    write_string_field(&w, "  \"interface\": ", interface_name, ",\n");
+    write_int_field(&w, "  \"scan_time\": ", session->scan_time, ",\n");
+    write_int_field(&w, "  \"scan_duration_ms\": ", session->scan_duration_ms, ",\n");
+    json_writer_raw(&w, "  \"phases\": ");
+    json_write_scan_timing(&w, &session->timing);
+    json_writer_raw(&w, ",\n");
+    write_int_field(&w, "  \"results_count\": ", session->result_count, ",\n");
+    json_writer_raw(&w, "  \"interface_info\": ");
+    json_write_interface(&w, &session->interface);
+    json_writer_raw(&w, ",\n");
+    json_writer_raw(&w, "  \"scan_results\": [\n");
     
     for (int i = 0; i < session->result_count; i++) {
-        print_scan_result_json(&session->results[i], (i == session->result_count - 1));
+        json_write_scan_result(&w, &session->results[i], (i == session->result_count - 1));
     }
     
-    printf("  ]\n");
-    printf("}\n");
+    json_writer_raw(&w, "  ]\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
+}
+
+void json_write_scan_timing(json_writer_t *w, const scan_timing_t *timing) {
+    write_int_field(w, "{\"interface_info_ms\": ", timing->interface_info_ms, ", ");
+    write_int_field(w, "\"scan_command_ms\": ", timing->scan_command_ms, ", ");
+    write_int_field(w, "\"parse_ms\": ", timing->parse_ms, ", ");
+    write_int_field(w, "\"retry_wait_ms\": ", timing->retry_wait_ms, ", ");
+    write_int_field(w, "\"process_overhead_ms\": ", timing->process_overhead_ms, ", ");
+    write_int_field(w, "\"attempts\": ", timing->attempts, ", ");
+    json_writer_raw(w, "\"handoff_us\": ");
+    if (timing->handoff_us >= 0) {
+        json_writer_int(w, timing->handoff_us);
+    } else {
+        json_writer_null(w);
+    }
+    json_writer_raw(w, "}");
+}
+
+void print_scan_timing_json(const scan_timing_t *timing) {
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_scan_timing(&w, timing);
+    print_fragment(&w);
+}
+
+void json_write_tick_schedule(json_writer_t *w, const tick_scheduler_t *sched) {
+    json_writer_raw(w, "{\"tick\": ");
+    json_writer_uint(w, sched->ticks);
+    json_writer_raw(w, ", \"skipped_ticks\": ");
+    json_writer_uint(w, sched->skipped_ticks);
+    json_writer_raw(w, ", \"lateness_us\": ");
+    json_writer_int(w, sched->lateness_us);
+    json_writer_raw(w, ", \"align_s\": ");
+    json_writer_double(w, sched->align_seconds, 3);
+    json_writer_raw(w, "}");
+}
+
+void print_tick_schedule_json(const tick_scheduler_t *sched) {
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_tick_schedule(&w, sched);
+    print_fragment(&w);
+}
+
+// Single-line station sample; fields the source could not provide are null
+void json_write_link_state(json_writer_t *w, const link_state_t *state) {
+    static const char *source_names[] = {"none", "nl80211", "iw"};
+
+    write_bool_field(w, "{\"connected\": ", state->connected, ", ");
+    write_string_field(w, "\"ssid\": ", state->ssid, ", ");
+    write_string_field(w, "\"bssid\": ", state->bssid, ", ");
+    write_int_field(w, "\"frequency\": ", state->frequency, ", ");
+    json_writer_raw(w, "\"signal_dbm\": ");
+    if (state->has_signal) {
+        json_writer_int(w, state->signal_dbm);
+    } else {
+        json_writer_null(w);
+    }
+    json_writer_raw(w, ", \"supplicant_state\": ");
+    json_writer_string(w, state->supplicant_state[0] ? state->supplicant_state : NULL);
+    write_string_field(w, ", \"source\": ", source_names[state->source], "}");
+}
+
+void print_link_state_json(const link_state_t *state) {
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_link_state(&w, state);
+    print_fragment(&w);
+}
+
+// Phases that did not run are reported as null
+static void write_test_phases(json_writer_t *w, const connection_test_result_t *result) {
+    json_writer_raw(w, "{");
+    for (int phase = 0; phase < TEST_PHASE_COUNT; phase++) {
+        json_writer_raw(w, "\"");
+        json_writer_raw(w, test_phase_name(phase));
+        json_writer_raw(w, "_ms\": ");
+        if (result->phase_ms[phase] >= 0) {
+            json_writer_int(w, result->phase_ms[phase]);
+        } else {
+            json_writer_null(w);
+        }
+        json_writer_raw(w, (phase == TEST_PHASE_COUNT - 1) ? "" : ", ");
+    }
+    json_writer_raw(w, "}");
+}
+
+void print_test_phases_json(const connection_test_result_t *result) {
+    json_writer_t w;
+    json_writer_init(&w);
+    write_test_phases(&w, result);
+    print_fragment(&w);
+}
+
+static void write_test_connectivity(json_writer_t *w, const connection_test_result_t *result) {
+    json_writer_raw(w, "{");
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) {
+        json_writer_raw(w, "\"");
+        json_writer_raw(w, probe_layer_name(layer));
+        json_writer_raw(w, "_rtt_ms\": ");
+        if (result->layer_rtt_ms[layer] >= 0) {
+            json_writer_double(w, result->layer_rtt_ms[layer], 3);
+        } else {
+            json_writer_null(w);
+        }
+        json_writer_raw(w, (layer == PROBE_LAYER_COUNT - 1) ? "" : ", ");
+    }
+    json_writer_raw(w, "}");
+}
+
+void print_test_connectivity_json(const connection_test_result_t *result) {
+    json_writer_t w;
+    json_writer_init(&w);
+    write_test_connectivity(&w, result);
+    print_fragment(&w);
+}
+
+void print_connectivity_probe_json(const char *interface_name, const connectivity_probe_result_t *result) {
+    json_writer_t w;
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    json_writer_raw(&w, "  \"connectivity_probe\": {\n");
+    write_string_field(&w, "    \"interface\": ", interface_name, ",\n");
+    json_writer_raw(&w, "    \"total_ms\": ");
+    json_writer_double(&w, result->total_ms, 3);
+    json_writer_raw(&w, ",\n");
+    json_writer_raw(&w, "    \"layers\": {\n");
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) {
+        const probe_layer_result_t *layer_result = &result->layers[layer];
+        json_writer_raw(&w, "      \"");
+        json_writer_raw(&w, probe_layer_name(layer));
+        json_writer_raw(&w, "\": {\"status\": \"");
+        json_writer_raw(&w, probe_status_name(layer_result->status));
+        json_writer_raw(&w, "\", \"rtt_ms\": ");
+        if (layer_result->rtt_ms >= 0) json_writer_double(&w, layer_result->rtt_ms, 3);
+        else json_writer_null(&w);
+        json_writer_raw(&w, ", \"method\": \"");
+        json_writer_raw(&w, layer_result->method);
+        write_string_field(&w, "\", \"target\": ", layer_result->target, ", ");
+        write_int_field(&w, "\"probes_sent\": ", layer_result->probes_sent, "}");
+        json_writer_raw(&w, (layer == PROBE_LAYER_COUNT - 1) ? "\n" : ",\n");
+    }
+    json_writer_raw(&w, "    }\n");
+    json_writer_raw(&w, "  },\n");
+    json_writer_raw(&w, result->layers[PROBE_LAYER_INTERNET].status == PROBE_STATUS_REACHABLE ?
+                    "  \"status\": \"success\"\n" : "  \"status\": \"failed\"\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
 }
 
 void print_connection_test_json(const connection_test_result_t *result) {
-    printf("{\n");
-    printf("  \"connection_test\": {\n");
-    printf("    \"ssid\": \"%s\",\n", escape_json_string(result->ssid));
-    printf("    \"interface\": \"%s\",\n", escape_json_string(result->interface_name));
-    printf("    \"connection_type\": \"%s\",\n", escape_json_string(result->connection_type));
-    printf("    \"success\": %s,\n", result->success ? "true" : "false");
-    printf("    \"test_time\": %ld,\n", result->test_time);
-    printf("    \"test_duration_ms\": %d,\n", result->test_duration_ms);
-    printf("    \"was_previously_connected\": %s,\n", result->was_connected ? "true" : "false");
-    printf("    \"original_ssid\": \"%s\"\n", escape_json_string(result->original_ssid));
+    json_writer_t w;
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    json_writer_raw(&w, "  \"connection_test\": {\n");
+    write_string_field(&w, "    \"ssid\": ", result->ssid, ",\n");
+    write_string_field(&w, "    \"interface\": ", result->interface_name, ",\n");
+    write_string_field(&w, "    \"connection_type\": ", result->connection_type, ",\n");
+    write_bool_field(&w, "    \"success\": ", result->success, ",\n");
+    write_int_field(&w, "    \"test_time\": ", result->test_time, ",\n");
+    write_int_field(&w, "    \"test_duration_ms\": ", result->test_duration_ms, ",\n");
+    write_int_field(&w, "    \"dhcp_duration_ms\": ", result->dhcp_duration_ms, ",\n");
+    json_writer_raw(&w, "    \"phases\": ");
+    write_test_phases(&w, result);
+    json_writer_raw(&w, ",\n");
+    json_writer_raw(&w, "    \"connectivity\": ");
+    write_test_connectivity(&w, result);
+    json_writer_raw(&w, ",\n");
+    write_bool_field(&w, "    \"was_previously_connected\": ", result->was_connected, ",\n");
+    write_string_field(&w, "    \"original_ssid\": ", result->original_ssid, ",\n");
+    write_string_field(&w, "    \"original_bssid\": ", result->original_bssid, ",\n");
+    json_writer_raw(&w, "    \"restore_duration_ms\": ");
+    if (result->restore_duration_ms >= 0) {
+        json_writer_int(&w, result->restore_duration_ms);
+    } else {
+        json_writer_null(&w);
+    }
+    json_writer_raw(&w, "\n");
     
     if (!result->success && strlen(result->error_message) > 0) {
-        printf(",\n    \"error_message\": \"%s\"\n", escape_json_string(result->error_message));
+        write_string_field(&w, ",\n    \"error_message\": ", result->error_message, "\n");
+    }
+    
+    json_writer_raw(&w, "  },\n");
+    json_writer_raw(&w, result->success ? "  \"status\": \"success\",\n" : "  \"status\": \"failed\",\n");
+    json_writer_raw(&w, result->success ?
+                    "  \"message\": \"Connection test completed successfully - interface restored to original state\"\n" :
+                    "  \"message\": \"Connection test failed - interface restored to original state\"\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
+}
+
+void print_connection_batch_json(const connection_batch_t *batch) {
+    json_writer_t w;
+    int passed = 0;
+    
+    for (int i = 0; i < batch->job_count; i++) {
+        if (batch->results[i].success) passed++;
+    }
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    json_writer_raw(&w, "  \"connection_batch\": {\n");
+    write_int_field(&w, "    \"start_time\": ", batch->start_time, ",\n");
+    write_int_field(&w, "    \"total_duration_ms\": ", batch->total_duration_ms, ",\n");
+    write_int_field(&w, "    \"tests_total\": ", batch->job_count, ",\n");
+    write_int_field(&w, "    \"tests_passed\": ", passed, ",\n");
+    write_int_field(&w, "    \"tests_failed\": ", batch->job_count - passed, ",\n");
+    json_writer_raw(&w, "    \"interfaces\": [\n");
+    for (int i = 0; i < batch->session_count; i++) {
+        const connection_batch_session_t *session = &batch->sessions[i];
+        write_string_field(&w, "      {\"interface\": ", session->interface_name, ", ");
+        write_int_field(&w, "\"tests\": ", session->job_count, ", ");
+        write_int_field(&w, "\"passed\": ", session->passed, ", ");
+        write_int_field(&w, "\"failed\": ", session->failed, ", ");
+        write_bool_field(&w, "\"supplicant_persistent\": ", session->supplicant_persistent, ", ");
+        write_int_field(&w, "\"supplicant_start_ms\": ", session->supplicant_start_ms, ", ");
+        write_int_field(&w, "\"setup_duration_ms\": ", session->setup_duration_ms, ", ");
+        write_int_field(&w, "\"teardown_duration_ms\": ", session->teardown_duration_ms, ", ");
+        json_writer_raw(&w, "\"restore_duration_ms\": ");
+        if (session->restore_duration_ms >= 0) {
+            json_writer_int(&w, session->restore_duration_ms);
+        } else {
+            json_writer_null(&w);
+        }
+        write_int_field(&w, ", \"session_duration_ms\": ", session->session_duration_ms, "}");
+        json_writer_raw(&w, (i == batch->session_count - 1) ? "\n" : ",\n");
+    }
+    json_writer_raw(&w, "    ],\n");
+    json_writer_raw(&w, "    \"tests\": [\n");
+    for (int i = 0; i < batch->job_count; i++) {
+        const connection_test_result_t *result = &batch->results[i];
+        json_writer_raw(&w, "      {\n");
+        write_string_field(&w, "        \"ssid\": ", batch->jobs[i].ssid, ",\n");
+        write_string_field(&w, "        \"interface\": ", batch->jobs[i].interface_name, ",\n");
+        write_string_field(&w, "        \"connection_type\": ", batch->jobs[i].secured ? "secured" : "open", ",\n");
+        write_bool_field(&w, "        \"success\": ", result->success, ",\n");
+        write_int_field(&w, "        \"test_time\": ", result->test_time, ",\n");
+        write_int_field(&w, "        \"test_duration_ms\": ", result->test_duration_ms, ",\n");
+        write_int_field(&w, "        \"dhcp_duration_ms\": ", result->dhcp_duration_ms, ",\n");
+        json_writer_raw(&w, "        \"phases\": ");
+        write_test_phases(&w, result);
+        json_writer_raw(&w, ",\n");
+        json_writer_raw(&w, "        \"connectivity\": ");
+        write_test_connectivity(&w, result);
+        json_writer_raw(&w, ",\n");
+        write_string_field(&w, "        \"error_message\": ", result->error_message, "\n");
+        json_writer_raw(&w, (i == batch->job_count - 1) ? "      }\n" : "      },\n");
     }
+    json_writer_raw(&w, "    ]\n");
+    json_writer_raw(&w, "  },\n");
+    json_writer_raw(&w, (passed == batch->job_count) ? "  \"status\": \"success\",\n" : "  \"status\": \"failed\",\n");
+    json_writer_raw(&w, "  \"message\": \"Batch connection test completed - interfaces restored to original state\"\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
+}
+
+void print_test_stats_json(const test_history_entry_t *entry) {
+    json_writer_t w;
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    json_writer_raw(&w, "  \"test_stats\": {\n");
+    write_string_field(&w, "    \"ssid\": ", entry->ssid, ",\n");
+    json_writer_raw(&w, "    \"tests\": ");
+    json_writer_uint(&w, entry->tests);
+    json_writer_raw(&w, ",\n    \"successes\": ");
+    json_writer_uint(&w, entry->successes);
+    json_writer_raw(&w, ",\n    \"success_rate\": ");
+    json_writer_double(&w, entry->tests ? (double)entry->successes / entry->tests : 0.0, 3);
+    json_writer_raw(&w, ",\n");
+    write_int_field(&w, "    \"first_test\": ", (long)entry->first_test, ",\n");
+    write_int_field(&w, "    \"last_test\": ", (long)entry->last_test, ",\n");
+    json_writer_raw(&w, "    \"relative_accuracy\": ");
+    json_writer_double(&w, SKETCH_RELATIVE_ACCURACY, 2);
+    json_writer_raw(&w, ",\n");
+    json_writer_raw(&w, "    \"phases\": {\n");
+    for (int metric = 0; metric < TEST_HISTORY_METRIC_COUNT; metric++) {
+        const quantile_sketch_t *sketch = &entry->metrics[metric];
+        json_writer_raw(&w, "      \"");
+        json_writer_raw(&w, test_history_metric_name(metric));
+        json_writer_raw(&w, "\": {\"samples\": ");
+        json_writer_uint(&w, sketch->count);
+        if (sketch->count > 0) {
+            json_writer_raw(&w, ", \"p50_ms\": ");
+            json_writer_double(&w, sketch_quantile(sketch, 0.50), 1);
+            json_writer_raw(&w, ", \"p95_ms\": ");
+            json_writer_double(&w, sketch_quantile(sketch, 0.95), 1);
+            json_writer_raw(&w, ", \"p99_ms\": ");
+            json_writer_double(&w, sketch_quantile(sketch, 0.99), 1);
+            json_writer_raw(&w, "}");
+        } else {
+            json_writer_raw(&w, ", \"p50_ms\": null, \"p95_ms\": null, \"p99_ms\": null}");
+        }
+        json_writer_raw(&w, (metric == TEST_HISTORY_METRIC_COUNT - 1) ? "\n" : ",\n");
+    }
+    json_writer_raw(&w, "    }\n");
+    json_writer_raw(&w, "  },\n");
+    json_writer_raw(&w, "  \"status\": \"success\"\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
+}
+
+void print_dhcp_probe_json(const char *interface_name, const dhcp_probe_result_t *result) {
+    static const char *outcomes[] = {"answered", "error", "timeout", "nak"};
+    int outcome_index = (result->outcome == 0) ? 0 : -result->outcome;
+    json_writer_t w;
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    json_writer_raw(&w, "  \"dhcp_probe\": {\n");
+    write_string_field(&w, "    \"interface\": ", interface_name, ",\n");
+    write_string_field(&w, "    \"mode\": ", dhcp_probe_mode_name(result->mode), ",\n");
+    write_string_field(&w, "    \"outcome\": ",
+                       (outcome_index >= 0 && outcome_index <= 3) ? outcomes[outcome_index] : "error", ",\n");
+    write_int_field(&w, "    \"discover_count\": ", result->discover_count, ",\n");
+    json_writer_raw(&w, "    \"offer_ms\": ");
+    if (result->offer_ms >= 0) json_writer_double(&w, result->offer_ms, 3);
+    else json_writer_null(&w);
+    json_writer_raw(&w, ",\n    \"ack_ms\": ");
+    if (result->ack_ms >= 0) json_writer_double(&w, result->ack_ms, 3);
+    else json_writer_null(&w);
+    json_writer_raw(&w, ",\n    \"total_ms\": ");
+    json_writer_double(&w, result->total_ms, 3);
+    json_writer_raw(&w, ",\n");
+    write_string_field(&w, "    \"offered_ip\": ", result->offered_ip, ",\n");
+    write_string_field(&w, "    \"server_ip\": ", result->server_ip, ",\n");
+    write_string_field(&w, "    \"subnet_mask\": ", result->subnet_mask, ",\n");
+    write_string_field(&w, "    \"router\": ", result->router, ",\n");
+    json_writer_raw(&w, "    \"lease_time_s\": ");
+    json_writer_uint(&w, result->lease_time_s);
+    json_writer_raw(&w, ",\n");
+    write_bool_field(&w, "    \"address_installed\": ", result->bound, "");
+    if (strlen(result->error) > 0) {
+        write_string_field(&w, ",\n    \"error_message\": ", result->error, "");
+    }
+    json_writer_raw(&w, "\n  },\n");
+    json_writer_raw(&w, result->outcome == 0 ? "  \"status\": \"success\"\n" : "  \"status\": \"failed\"\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
+}
+
+void json_write_interface_cache_stats(json_writer_t *w) {
+    static const char *group_names[IFACE_FIELD_GROUP_COUNT] = {"static", "status", "link", "signal"};
+    interface_cache_stats_t stats;
     
-    printf("  },\n");
-    printf("  \"status\": \"%s\",\n", result->success ? "success" : "failed");
-    printf("  \"message\": \"%s\"\n", result->success ? 
-           "Connection test completed successfully - interface restored to original state" :
-           "Connection test failed - interface restored to original state");
-    printf("}\n");
-}
\ No newline at end of file
+    interface_cache_get_stats(&stats);
+    json_writer_raw(w, "{");
+    for (int group = 0; group < IFACE_FIELD_GROUP_COUNT; group++) {
+        json_writer_raw(w, "\"");
+        json_writer_raw(w, group_names[group]);
+        json_writer_raw(w, "\": {\"hits\": ");
+        json_writer_uint(w, stats.hits[group]);
+        json_writer_raw(w, ", \"misses\": ");
+        json_writer_uint(w, stats.misses[group]);
+        json_writer_raw(w, "}, ");
+    }
+    json_writer_raw(w, "\"invalidations\": ");
+    json_writer_uint(w, stats.invalidations);
+    json_writer_raw(w, ", \"link_events\": ");
+    json_writer_uint(w, stats.link_events);
+    json_writer_raw(w, ", \"mlme_events\": ");
+    json_writer_uint(w, stats.mlme_events);
+    write_bool_field(w, ", \"events_active\": ", stats.events_active, "}");
+}
+
+void print_interface_cache_stats_json(void) {
+    json_writer_t w;
+    json_writer_init(&w);
+    json_write_interface_cache_stats(&w);
+    print_fragment(&w);
+}
+
+void print_wiphy_capabilities_json(const char *interface_name, const wiphy_capabilities_t *caps) {
+    json_writer_t w;
+    
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n");
+    json_writer_raw(&w, "  \"wiphy_capabilities\": {\n");
+    write_string_field(&w, "    \"interface\": ", interface_name, ",\n");
+    write_string_field(&w, "    \"phy\": ", caps->phy_name, ",\n");
+    write_string_field(&w, "    \"driver\": ", caps->driver, ",\n");
+    write_int_field(&w, "    \"cached_at\": ", caps->created, ",\n");
+    write_bool_field(&w, "    \"bands\": {\"2ghz\": ", caps->band_mask & WIPHY_BAND_2GHZ, ", ");
+    write_bool_field(&w, "\"5ghz\": ", caps->band_mask & WIPHY_BAND_5GHZ, ", ");
+    write_bool_field(&w, "\"6ghz\": ", caps->band_mask & WIPHY_BAND_6GHZ, ", ");
+    write_bool_field(&w, "\"60ghz\": ", caps->band_mask & WIPHY_BAND_60GHZ, "},\n");
+    write_int_field(&w, "    \"max_scan_ssids\": ", caps->max_scan_ssids, ",\n");
+    write_bool_field(&w, "    \"sched_scan_supported\": ", caps->sched_scan_supported, ",\n");
+    write_int_field(&w, "    \"max_sched_scan_ssids\": ", caps->max_sched_scan_ssids, ",\n");
+    write_int_field(&w, "    \"max_match_sets\": ", caps->max_match_sets, ",\n");
+    write_bool_field(&w, "    \"supports_station\": ", caps->supports_station, ",\n");
+    write_bool_field(&w, "    \"supports_ap\": ", caps->supports_ap, ",\n");
+    write_bool_field(&w, "    \"supports_monitor\": ", caps->supports_monitor, ",\n");
+    json_writer_raw(&w, "    \"channels\": [\n");
+    for (int i = 0; i < caps->channel_count; i++) {
+        const wiphy_channel_t *channel = &caps->channels[i];
+        write_int_field(&w, "      {\"frequency\": ", channel->frequency, ", ");
+        write_int_field(&w, "\"channel\": ", channel->channel, ", ");
+        write_bool_field(&w, "\"disabled\": ", channel->disabled, ", ");
+        write_bool_field(&w, "\"no_ir\": ", channel->no_ir, ", ");
+        write_bool_field(&w, "\"radar\": ", channel->radar, "}");
+        json_writer_raw(&w, (i < caps->channel_count - 1) ? ",\n" : "\n");
+    }
+    json_writer_raw(&w, "    ],\n");
+    json_writer_raw(&w, "    \"interface_combinations\": [\n");
+    for (int i = 0; i < caps->combination_count; i++) {
+        const wiphy_combination_t *comb = &caps->combinations[i];
+        write_int_field(&w, "      {\"max_interfaces\": ", comb->max_interfaces, ", ");
+        write_int_field(&w, "\"num_channels\": ", comb->num_channels, ", \"limits\": [");
+        for (int j = 0; j < comb->limit_count; j++) {
+            write_int_field(&w, "{\"max\": ", comb->limits[j].max_interfaces, ", \"iftype_mask\": ");
+            json_writer_uint(&w, comb->limits[j].iftype_mask);
+            json_writer_raw(&w, (j < comb->limit_count - 1) ? "}, " : "}");
+        }
+        json_writer_raw(&w, (i < caps->combination_count - 1) ? "]},\n" : "]}\n");
+    }
+    json_writer_raw(&w, "    ]\n");
+    json_writer_raw(&w, "  }\n");
+    json_writer_raw(&w, "}\n");
+    print_document(&w);
+}
@@ -0,0 +1,157 @@
+#include "json_writer.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JSON_WRITER_INITIAL_CAPACITY 4096
+
+void json_writer_init(json_writer_t *w) {
+    memset(w, 0, sizeof(json_writer_t));
+}
+
+void json_writer_free(json_writer_t *w) {
+    free(w->data);
+    memset(w, 0, sizeof(json_writer_t));
+}
+
+void json_writer_reset(json_writer_t *w) {
+    w->len = 0;
+    w->failed = 0;
+}
+
+// Make room for `extra` more bytes; capacity doubles so a document costs a few reallocs
+static int reserve(json_writer_t *w, size_t extra) {
+    if (w->failed) return -1;
+    if (w->len + extra <= w->cap) return 0;
+
+    size_t cap = w->cap ? w->cap : JSON_WRITER_INITIAL_CAPACITY;
+    while (cap < w->len + extra) cap *= 2;
+
+    char *data = realloc(w->data, cap);
+    if (!data) {
+        w->failed = 1;
+        return -1;
+    }
+    w->data = data;
+    w->cap = cap;
+    return 0;
+}
+
+void json_writer_raw_n(json_writer_t *w, const char *text, size_t len) {
+    if (reserve(w, len) != 0) return;
+    memcpy(w->data + w->len, text, len);
+    w->len += len;
+}
+
+void json_writer_raw(json_writer_t *w, const char *text) {
+    json_writer_raw_n(w, text, strlen(text));
+}
+
+void json_writer_string(json_writer_t *w, const char *value) {
+    static const char hex[] = "0123456789abcdef";
+
+    if (!value) {
+        json_writer_null(w);
+        return;
+    }
+
+    // Worst case every byte becomes \u00XX
+    size_t len = strlen(value);
+    if (reserve(w, len * 6 + 2) != 0) return;
+
+    char *out = w->data + w->len;
+    *out++ = '"';
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)value[i];
+        switch (c) {
+            case '"':  *out++ = '\\'; *out++ = '"'; break;
+            case '\\': *out++ = '\\'; *out++ = '\\'; break;
+            case '\n': *out++ = '\\'; *out++ = 'n'; break;
+            case '\r': *out++ = '\\'; *out++ = 'r'; break;
+            case '\t': *out++ = '\\'; *out++ = 't'; break;
+            default:
+                if (c < 0x20) {
+                    memcpy(out, "\\u00", 4);
+                    out[4] = hex[c >> 4];
+                    out[5] = hex[c & 0xf];
+                    out += 6;
+                } else {
+                    *out++ = (char)c;
+                }
+                break;
+        }
+    }
+    *out++ = '"';
+    w->len = out - w->data;
+}
+
+void json_writer_uint(json_writer_t *w, unsigned long long value) {
+    char digits[20];
+    int count = 0;
+
+    // Digits come out least significant first
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    if (reserve(w, count) != 0) return;
+    while (count > 0) w->data[w->len++] = digits[--count];
+}
+
+void json_writer_int(json_writer_t *w, long long value) {
+    if (value < 0) {
+        json_writer_raw_n(w, "-", 1);
+        // Negate in unsigned arithmetic so LLONG_MIN does not overflow
+        json_writer_uint(w, 0ULL - (unsigned long long)value);
+    } else {
+        json_writer_uint(w, (unsigned long long)value);
+    }
+}
+
+// Floats are rare in the output (timings, ratios); printf keeps their rounding identical
+void json_writer_double(json_writer_t *w, double value, int decimals) {
+    char text[64];
+    int len = snprintf(text, sizeof(text), "%.*f", decimals, value);
+
+    if (len > 0) json_writer_raw_n(w, text, (size_t)len < sizeof(text) ? (size_t)len : sizeof(text) - 1);
+}
+
+void json_writer_bool(json_writer_t *w, int value) {
+    if (value) json_writer_raw_n(w, "true", 4);
+    else json_writer_raw_n(w, "false", 5);
+}
+
+void json_writer_null(json_writer_t *w) {
+    json_writer_raw_n(w, "null", 4);
+}
+
+int json_writer_flush(json_writer_t *w, int fd) {
+    size_t offset = 0;
+
+    if (fd == STDOUT_FILENO) fflush(stdout);
+    // Never write a truncated document
+    if (w->failed) {
+        json_writer_reset(w);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    while (offset < w->len) {
+        ssize_t written = write(fd, w->data + offset, w->len - offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            json_writer_reset(w);
+            return -1;
+        }
+        offset += (size_t)written;
+    }
+    json_writer_reset(w);
+    return 0;
+}
+
+void json_writer_emit(json_writer_t *w, FILE *stream) {
+    if (w->len > 0 && !w->failed) fwrite(w->data, 1, w->len, stream);
+    json_writer_reset(w);
+}
@@ -0,0 +1,164 @@
+#include "link_state.h"
+#include "netlink_helper.h"
+#include "supplicant_ctrl.h"
+#include "command_runner.h"
+#include <net/if.h>
+#include <linux/nl80211.h>
+
+#define WLAN_EID_SSID 0
+
+// Family ids do not change while the module is loaded; resolve once per thread
+static __thread int nl80211_family_id = -1;
+
+static void format_mac(const unsigned char *mac, char *buffer) {
+    snprintf(buffer, MAX_MAC_LEN, "%02x:%02x:%02x:%02x:%02x:%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+// SSID element out of the BSS information elements
+static void parse_ssid_element(const unsigned char *ies, int len, char *ssid) {
+    while (len >= 2 && ies[1] + 2 <= len) {
+        if (ies[0] == WLAN_EID_SSID) {
+            int ssid_len = ies[1] < MAX_SSID_LEN - 1 ? ies[1] : MAX_SSID_LEN - 1;
+            memcpy(ssid, ies + 2, ssid_len);
+            ssid[ssid_len] = '\0';
+            return;
+        }
+        len -= ies[1] + 2;
+        ies += ies[1] + 2;
+    }
+}
+
+// Scan dump handler: only the BSS we are associated with is of interest
+static int scan_dump_handler(struct nlmsghdr *nlh, void *user_data) {
+    link_state_t *state = (link_state_t *)user_data;
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+    struct nlattr *bss[NL80211_BSS_MAX + 1];
+
+    genl_parse_attrs(tb, NL80211_ATTR_MAX, nlh);
+    if (!tb[NL80211_ATTR_BSS]) return 0;
+    nl_parse_nested(bss, NL80211_BSS_MAX, tb[NL80211_ATTR_BSS]);
+
+    if (!bss[NL80211_BSS_STATUS] || nl_attr_get_u32(bss[NL80211_BSS_STATUS]) != NL80211_BSS_STATUS_ASSOCIATED) {
+        return 0;
+    }
+
+    state->connected = 1;
+    if (bss[NL80211_BSS_BSSID] && nl_attr_len(bss[NL80211_BSS_BSSID]) >= 6) {
+        format_mac((const unsigned char *)nl_attr_data(bss[NL80211_BSS_BSSID]), state->bssid);
+    }
+    if (bss[NL80211_BSS_FREQUENCY]) {
+        state->frequency = (int)nl_attr_get_u32(bss[NL80211_BSS_FREQUENCY]);
+    }
+    if (bss[NL80211_BSS_SIGNAL_MBM]) {
+        state->signal_dbm = (int)(int32_t)nl_attr_get_u32(bss[NL80211_BSS_SIGNAL_MBM]) / 100;
+        state->has_signal = 1;
+    }
+    if (bss[NL80211_BSS_INFORMATION_ELEMENTS]) {
+        parse_ssid_element((const unsigned char *)nl_attr_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]),
+                           nl_attr_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]), state->ssid);
+    }
+    return 0;
+}
+
+// 0 sampled, -1 nl80211 unavailable (fall back to iw)
+static int sample_nl80211(const char *interface_name, link_state_t *state) {
+    nl_socket_t sock;
+    nl_msg_t msg;
+    unsigned int ifindex = if_nametoindex(interface_name);
+
+    if (ifindex == 0 || nl_socket_open(&sock, NETLINK_GENERIC, 0) != 0) {
+        return -1;
+    }
+    if (nl80211_family_id < 0) {
+        nl80211_family_id = genl_resolve_family(&sock, "nl80211");
+    }
+    if (nl80211_family_id < 0) {
+        nl_socket_close(&sock);
+        return -1;
+    }
+
+    genl_msg_init(&msg, (uint16_t)nl80211_family_id, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
+    nl_msg_put_u32(&msg, NL80211_ATTR_IFINDEX, ifindex);
+    int result = nl_transact(&sock, &msg, scan_dump_handler, state);
+    nl_socket_close(&sock);
+
+    // A non-wireless interface answers with an error: that is "not connected", not a reason to fork iw
+    if (result != 0 && result != -EOPNOTSUPP && result != -ENODEV && result != -EINVAL) {
+        return -1;
+    }
+    state->source = LINK_STATE_SOURCE_NL80211;
+    return 0;
+}
+
+static int sample_iw(const char *interface_name, link_state_t *state) {
+    const char *const argv[] = {"iw", "dev", interface_name, "link", NULL};
+    command_status_t status;
+    char line[MAX_LINE_LEN];
+
+    FILE *fp = command_run_stream(argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, &status);
+    if (!fp) return -1;
+
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = 0;
+
+        if (strncmp(line, "Connected to ", 13) == 0) {
+            state->connected = (sscanf(line + 13, "%17s", state->bssid) == 1);
+        } else if (strncmp(line, "\tSSID: ", 7) == 0) {
+            strncpy(state->ssid, line + 7, MAX_SSID_LEN - 1);
+        } else if (strncmp(line, "\tfreq: ", 7) == 0) {
+            state->frequency = atoi(line + 7);
+        } else if (strncmp(line, "\tsignal: ", 9) == 0) {
+            state->signal_dbm = atoi(line + 9);
+            state->has_signal = 1;
+        }
+    }
+    fclose(fp);
+    if (status.timed_out) return -1;
+    state->source = LINK_STATE_SOURCE_IW;
+    return 0;
+}
+
+int link_state_sample(const char *interface_name, link_state_t *state) {
+    supplicant_ctrl_t ctrl;
+
+    memset(state, 0, sizeof(link_state_t));
+
+    if (sample_nl80211(interface_name, state) != 0) {
+        memset(state, 0, sizeof(link_state_t));
+        if (sample_iw(interface_name, state) != 0) {
+            return -1;
+        }
+    }
+
+    // The control socket doubles as the "is a supplicant running for this interface" check
+    if (supplicant_ctrl_open(&ctrl, SUPPLICANT_CTRL_DIR, interface_name) == 0) {
+        if (supplicant_ctrl_get_status_field(&ctrl, "wpa_state", state->supplicant_state,
+                                             sizeof(state->supplicant_state)) != 0) {
+            state->supplicant_state[0] = '\0';
+        }
+        supplicant_ctrl_close(&ctrl);
+    }
+    return 0;
+}
+
+int link_state_matches_ssid(const link_state_t *state, const char *ssid) {
+    return state->connected && strcmp(state->ssid, ssid) == 0;
+}
+
+void print_link_state(const char *interface_name, const link_state_t *state) {
+    if (!state->connected) {
+        printf("[LINK] %s: not connected", interface_name);
+    } else {
+        printf("[LINK] %s: connected to %s (SSID: %s, freq: %d MHz", interface_name,
+               state->bssid[0] ? state->bssid : "unknown", state->ssid, state->frequency);
+        if (state->has_signal) {
+            printf(", signal: %d dBm", state->signal_dbm);
+        }
+        printf(")");
+    }
+    if (state->supplicant_state[0]) {
+        printf(", wpa_state: %s", state->supplicant_state);
+    }
+    printf("\n");
+}
@@ -2,15 +2,24 @@
 #include "interface_detector.h"
 #include "json_formatter.h"
 #include "scan_alternatives.h"
+#include "wiphy_capabilities.h"
+#include "supplicant_session.h"
+#include "benchmark.h"
+#include "command_runner.h"
+#include "tick_scheduler.h"
+#include "monitor.h"
 
 // Global variables
 volatile int keep_running = 1;
 float scan_delay = 5.0; // Default 5 seconds
 
+// Runs in signal context (or from the event loop's signalfd): only async-signal-safe calls,
+// so the message goes out with write() rather than through stdio
 void signal_handler(int sig) {
+    static const char message[] = "\n{\"status\": \"stopped\", \"message\": \"Scan interrupted by user\"}\n";
     (void)sig; // Suppress unused parameter warning
     keep_running = 0;
-    printf("\n{\"status\": \"stopped\", \"message\": \"Scan interrupted by user\"}\n");
+    write(STDOUT_FILENO, message, sizeof(message) - 1);
 }
 
 void print_usage(const char *program_name) {
@@ -27,8 +36,8 @@ void print_usage(const char *program_name) {
     printf("        \"description\": \"Perform single scan on specified interface (auto-detect if not specified)\"\n");
     printf("      },\n");
     printf("      {\n");
-    printf("        \"command\": \"--continuous [interface] [delay]\",\n");
-    printf("        \"description\": \"Continuous scan with specified delay in seconds (default: 5.0, minimum: 0.1)\"\n");
+    printf("        \"command\": \"--continuous [interface] [delay] [--align seconds]\",\n");
+    printf("        \"description\": \"Continuous scan every delay seconds on a fixed-rate schedule (default: 5.0, minimum: 0.1); --align starts ticks on wall-clock multiples of seconds, for all continuous modes\"\n");
     printf("      },\n");
     printf("      {\n");
     printf("        \"command\": \"--info [interface]\",\n");
@@ -39,12 +48,32 @@ void print_usage(const char *program_name) {
     printf("        \"description\": \"Continuous interface monitoring with specified delay in seconds (default: 5.0, minimum: 0.1)\"\n");
     printf("      },\n");
     printf("      {\n");
-    printf("        \"command\": \"--open-ap-connect-verification <interface> <ssid>\",\n");
-    printf("        \"description\": \"Test connection to open AP without persistent connection\"\n");
+    printf("        \"command\": \"--monitor [interface[,interface...]] [scan_period] [station_period]\",\n");
+    printf("        \"description\": \"Monitor several interfaces from one event loop: scans every scan_period seconds (default: 5.0), station link samples every station_period seconds (default: 1.0) and link up/down events as they happen; a period of 0 turns that stream off\"\n");
     printf("      },\n");
     printf("      {\n");
-    printf("        \"command\": \"--secured-ap-connect-verification <interface> <ssid> <password>\",\n");
-    printf("        \"description\": \"Test connection to secured AP with credentials without persistent connection\"\n");
+    printf("        \"command\": \"--scan-async <interface[,interface...]> [freq|band[,freq|band...]] [deadline_ms]\",\n");
+    printf("        \"description\": \"Submit one non-blocking scan per interface, optionally limited to channels (MHz) or bands (2.4ghz, 5ghz, 6ghz) the radio supports and a deadline, and print completions in the order they finish\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--scan-auto [interface] [direct|threaded|pipe|signal|async|forked]\",\n");
+    printf("        \"description\": \"Scan with the method stored by --bench-methods for this interface and driver (threaded if none), or the one named\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--continuous-timer [interface] [delay]\",\n");
+    printf("        \"description\": \"Continuous scan driven by timer ticks in one thread, reporting skipped ticks when a scan overruns its period\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--open-ap-connect-verification <interface> <ssid> [--persistent]\",\n");
+    printf("        \"description\": \"Test connection to open AP without persistent connection (--persistent keeps wpa_supplicant running for later tests)\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--secured-ap-connect-verification <interface> <ssid> <password> [--persistent]\",\n");
+    printf("        \"description\": \"Test connection to secured AP with credentials without persistent connection (--persistent keeps wpa_supplicant running for later tests)\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--batch-connect-verification <jobfile>\",\n");
+    printf("        \"description\": \"Run connection tests from a job file of tab-separated '<interface> <ssid> [psk]' lines, one session per interface, interfaces in parallel\"\n");
     printf("      },\n");
     printf("      {\n");
     printf("        \"command\": \"--interface-down <interface>\",\n");
@@ -55,6 +84,34 @@ void print_usage(const char *program_name) {
     printf("        \"description\": \"Set the specified interface up using 'ip link set <interface> up'\"\n");
     printf("      },\n");
     printf("      {\n");
+    printf("        \"command\": \"--capabilities [interface] [--refresh]\",\n");
+    printf("        \"description\": \"Show the cached nl80211 wiphy capability model (bands, channels, scan limits, combinations)\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--dhcp-probe <interface> [offer|lease|bind] [timeout_ms]\",\n");
+    printf("        \"description\": \"Measure DHCP OFFER/ACK latency in-process; lease releases the address again, bind installs it\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--test-stats <ssid>\",\n");
+    printf("        \"description\": \"Show recorded connection tests for an SSID: count, success rate and p50/p95/p99 per phase\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--connectivity-probe <interface> [gateway=IP,dns=IP,name=HOST,tcp=IP:PORT] [timeout_ms]\",\n");
+    printf("        \"description\": \"Probe gateway (ARP/ICMP), DNS and internet (TCP connect) reachability concurrently\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--bench-link-waits <interface> [iterations]\",\n");
+    printf("        \"description\": \"Time the full open-network connection test with fixed link sleeps against rtnetlink state waits\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--bench-methods <interface> [iterations]\",\n");
+    printf("        \"description\": \"Measure latency, CPU time, peak RSS and failure rate of every scan method and store the winner for this interface and driver\"\n");
+    printf("      },\n");
+    printf("      {\n");
+    printf("        \"command\": \"--bench-json [documents] [networks]\",\n");
+    printf("        \"description\": \"Render a synthetic scan document through the old per-field printf formatter and the buffered JSON writer; reports documents and bytes per second and checks the output is identical\"\n");
+    printf("      },\n");
+    printf("      {\n");
     printf("        \"command\": \"--help\",\n");
     printf("        \"description\": \"Show this help message\"\n");
     printf("      }\n");
@@ -63,6 +120,28 @@ void print_usage(const char *program_name) {
     printf("}\n");
 }
 
+// One-shot scan document for --scan-threaded, --scan-pipe and --scan-signal
+static void print_method_scan_json(const char *method, const char *interface_name,
+                                   const scan_result_t *results, int result_count) {
+    json_writer_t w;
+    json_writer_init(&w);
+    json_writer_raw(&w, "{\n  \"scan_method\": ");
+    json_writer_string(&w, method);
+    json_writer_raw(&w, ",\n  \"interface\": ");
+    json_writer_string(&w, interface_name);
+    json_writer_raw(&w, ",\n  \"scan_time\": ");
+    json_writer_int(&w, time(NULL));
+    json_writer_raw(&w, ",\n  \"results_count\": ");
+    json_writer_int(&w, result_count);
+    json_writer_raw(&w, ",\n  \"scan_results\": [\n");
+    for (int i = 0; i < result_count; i++) {
+        json_write_scan_result(&w, &results[i], (i == result_count - 1));
+    }
+    json_writer_raw(&w, "  ]\n}\n");
+    json_writer_flush(&w, STDOUT_FILENO);
+    json_writer_free(&w);
+}
+
 int main(int argc, char *argv[]) {
     wifi_interface_t interfaces[MAX_INTERFACES];
     int interface_count;
@@ -72,11 +151,128 @@ int main(int argc, char *argv[]) {
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
+    // --align <seconds> may appear anywhere after the command; take it out so the
+    // positional arguments keep their places
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--align") != 0) continue;
+        if (i + 1 >= argc || atof(argv[i + 1]) <= 0) {
+            printf("{\"error\": \"Invalid alignment\", \"usage\": \"--align <seconds>\"}\n");
+            return 1;
+        }
+        tick_scheduler_set_alignment(atof(argv[i + 1]));
+        for (int j = i; j + 2 <= argc; j++) {
+            argv[j] = argv[j + 2];
+        }
+        argc -= 2;
+        break;
+    }
+    
     if (argc < 2) {
         print_usage(argv[0]);
         return 1;
     }
     
+    // Benchmarks accept any interface, including stand-in fixtures without a radio
+    if (strcmp(argv[1], "--bench-link-waits") == 0) {
+        if (argc < 3) {
+            printf("{\"error\": \"Missing interface argument\", \"usage\": \"--bench-link-waits <interface> [iterations]\"}\n");
+            return 1;
+        }
+        int iterations = (argc >= 4) ? atoi(argv[3]) : BENCHMARK_DEFAULT_ITERATIONS;
+        return benchmark_link_waits(argv[2], iterations > 0 ? iterations : BENCHMARK_DEFAULT_ITERATIONS) == 0 ? 0 : 1;
+    }
+    
+    if (strcmp(argv[1], "--bench-json") == 0) {
+        int documents = (argc >= 3 && atoi(argv[2]) > 0) ? atoi(argv[2]) : BENCHMARK_JSON_DEFAULT_DOCUMENTS;
+        int networks = (argc >= 4 && atoi(argv[3]) >= 0) ? atoi(argv[3]) : BENCHMARK_JSON_DEFAULT_NETWORKS;
+        return benchmark_json_output(documents, networks) == 0 ? 0 : 1;
+    }
+    
+    if (strcmp(argv[1], "--bench-methods") == 0) {
+        if (argc < 3) {
+            printf("{\"error\": \"Missing interface argument\", \"usage\": \"--bench-methods <interface> [iterations]\"}\n");
+            return 1;
+        }
+        int iterations = (argc >= 4) ? atoi(argv[3]) : BENCHMARK_DEFAULT_ITERATIONS;
+        return benchmark_scan_methods(argv[2], iterations > 0 ? iterations : BENCHMARK_DEFAULT_ITERATIONS) == 0 ? 0 : 1;
+    }
+    
+    // Works on any Ethernet-like link, e.g. a veth pair with a DHCP server on the peer
+    if (strcmp(argv[1], "--dhcp-probe") == 0) {
+        dhcp_probe_result_t probe;
+        dhcp_probe_mode_t mode = DHCP_PROBE_LEASE;
+        int timeout_ms = DHCP_PROBE_DEFAULT_TIMEOUT_MS;
+        
+        if (argc < 3) {
+            printf("{\"error\": \"Missing interface argument\", \"usage\": \"--dhcp-probe <interface> [offer|lease|bind] [timeout_ms]\"}\n");
+            return 1;
+        }
+        if (argc >= 4) {
+            if (strcmp(argv[3], "offer") == 0) mode = DHCP_PROBE_OFFER_ONLY;
+            else if (strcmp(argv[3], "bind") == 0) mode = DHCP_PROBE_BIND;
+            else if (strcmp(argv[3], "lease") != 0) {
+                printf("{\"error\": \"Unknown probe mode\", \"usage\": \"--dhcp-probe <interface> [offer|lease|bind] [timeout_ms]\"}\n");
+                return 1;
+            }
+        }
+        if (argc >= 5 && atoi(argv[4]) > 0) timeout_ms = atoi(argv[4]);
+        
+        dhcp_probe_run(argv[2], mode, timeout_ms, &probe);
+        print_dhcp_probe_json(argv[2], &probe);
+        return probe.outcome == 0 ? 0 : 1;
+    }
+    
+    if (strcmp(argv[1], "--connectivity-probe") == 0) {
+        connectivity_probe_config_t config;
+        connectivity_probe_result_t probe;
+        char error[128];
+        int timeout_ms = CONNECTIVITY_PROBE_DEFAULT_TIMEOUT_MS;
+        
+        if (argc < 3) {
+            printf("{\"error\": \"Missing interface argument\", \"usage\": \"--connectivity-probe <interface> [targets] [timeout_ms]\"}\n");
+            return 1;
+        }
+        connectivity_probe_default_config(&config);
+        if (argc >= 4 && connectivity_probe_parse_targets(argv[3], &config, error, sizeof(error)) != 0) {
+            printf("{\"error\": \"%s\", \"usage\": \"targets: gateway=IP,dns=IP,name=HOST,tcp=IP:PORT\"}\n", escape_json_string(error));
+            return 1;
+        }
+        if (argc >= 5 && atoi(argv[4]) > 0) timeout_ms = atoi(argv[4]);
+        
+        if (connectivity_probe_run(argv[2], &config, timeout_ms, &probe) < 0) {
+            printf("{\"error\": \"Interface not found\", \"interface\": \"%s\"}\n", escape_json_string(argv[2]));
+            return 1;
+        }
+        print_connectivity_probe_json(argv[2], &probe);
+        return probe.layers[PROBE_LAYER_INTERNET].status == PROBE_STATUS_REACHABLE ? 0 : 1;
+    }
+    
+    // Reads only the history index, no interface needed
+    if (strcmp(argv[1], "--test-stats") == 0) {
+        test_history_entry_t *entry;
+        
+        if (argc < 3) {
+            printf("{\"error\": \"Missing SSID argument\", \"usage\": \"--test-stats <ssid>\"}\n");
+            return 1;
+        }
+        entry = malloc(sizeof(test_history_entry_t));
+        if (!entry) {
+            printf("{\"error\": \"Out of memory\"}\n");
+            return 1;
+        }
+        
+        int found = test_history_lookup(argv[2], entry);
+        if (found == 0) {
+            print_test_stats_json(entry);
+        } else if (found == 1) {
+            printf("{\"error\": \"No test history for SSID\", \"ssid\": \"%s\"}\n", escape_json_string(argv[2]));
+        } else {
+            printf("{\"error\": \"Cannot read test history\", \"index\": \"%s\"}\n", TEST_HISTORY_INDEX);
+        }
+        free(entry);
+        return found == 0 ? 0 : 1;
+    }
+    
     // Detect available WiFi interfaces
     interface_count = detect_wifi_interfaces(interfaces, MAX_INTERFACES);
     
@@ -117,16 +313,8 @@ int main(int argc, char *argv[]) {
         scan_session_t session;
         memset(&session, 0, sizeof(session));
         
-        // Get interface info
-        get_interface_info(selected_interface, &session.interface);
-        
-        // Perform scan using forked approach
-        clock_t start_time = clock();
-        session.result_count = perform_forked_scan(selected_interface, session.results, MAX_SCAN_RESULTS);
-        clock_t end_time = clock();
-        
-        session.scan_time = time(NULL);
-        session.scan_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
+        // Get interface info and perform scan using forked approach
+        run_timed_scan(selected_interface, &session);
         
         print_scan_results_json(&session);
         return 0;
@@ -208,9 +396,65 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    else if (strcmp(argv[1], "--monitor") == 0) {
+        monitor_config_t config;
+        monitor_stats_t stats;
+        
+        memset(&config, 0, sizeof(config));
+        config.scan_period = 5.0;
+        config.station_period = 1.0;
+        config.link_events = 1;
+        
+        if (argc >= 3) {
+            for (char *name = strtok(argv[2], ","); name && config.interface_count < MONITOR_MAX_INTERFACES;
+                 name = strtok(NULL, ",")) {
+                config.interfaces[config.interface_count++] = name;
+            }
+        } else {
+            selected_interface = get_best_wifi_interface(interfaces, interface_count);
+            if (selected_interface) config.interfaces[config.interface_count++] = selected_interface;
+        }
+        if (argc >= 4) {
+            config.scan_period = atof(argv[3]);
+            if (config.scan_period < 0) config.scan_period = 5.0;
+        }
+        if (argc >= 5) {
+            config.station_period = atof(argv[4]);
+            if (config.station_period < 0) config.station_period = 1.0;
+        }
+        
+        if (config.interface_count == 0) {
+            printf("{\"error\": \"No suitable WiFi interface found\"}\n");
+            return 1;
+        }
+        
+        json_writer_t w;
+        json_writer_init(&w);
+        json_writer_raw(&w, "{\"status\": \"starting\", \"interfaces\": [");
+        for (int i = 0; i < config.interface_count; i++) {
+            if (i > 0) json_writer_raw(&w, ", ");
+            json_writer_string(&w, config.interfaces[i]);
+        }
+        json_writer_raw(&w, "], \"scan_period\": ");
+        json_writer_double(&w, config.scan_period, 3);
+        json_writer_raw(&w, ", \"station_period\": ");
+        json_writer_double(&w, config.station_period, 3);
+        json_writer_raw(&w, "}\n");
+        json_writer_flush(&w, STDOUT_FILENO);
+        json_writer_free(&w);
+        
+        if (monitor_run(&config, &stats) != 0) return 1;
+        printf("{\"status\": \"monitor_finished\", \"wakeups\": %llu, \"dispatches\": %llu, \"scans\": %llu, "
+               "\"scan_timeouts\": %llu, \"link_events\": %llu}\n",
+               (unsigned long long)stats.wakeups, (unsigned long long)stats.dispatches,
+               (unsigned long long)stats.scans, (unsigned long long)stats.scan_timeouts,
+               (unsigned long long)stats.link_events);
+        return 0;
+    }
+    
     else if (strcmp(argv[1], "--open-ap-connect-verification") == 0) {
         if (argc < 4) {
-            printf("{\"error\": \"Missing required arguments\", \"usage\": \"--open-ap-connect-verification <interface> <ssid>\"}\n");
+            printf("{\"error\": \"Missing required arguments\", \"usage\": \"--open-ap-connect-verification <interface> <ssid> [--persistent]\"}\n");
             return 1;
         }
         
@@ -218,8 +462,14 @@ int main(int argc, char *argv[]) {
         const char *ssid = argv[3];
         connection_test_result_t result;
         
+        // Keep (or reuse) one wpa_supplicant on the interface instead of restarting it per test
+        if (argc > 4 && strcmp(argv[4], "--persistent") == 0) {
+            supplicant_session_start(interface);
+        }
+        
         // Test open AP connection
         test_open_ap_connection(interface, ssid, &result);
+        test_history_append(&result);
         print_connection_test_json(&result);
         
         return result.success ? 0 : 1;
@@ -227,7 +477,7 @@ int main(int argc, char *argv[]) {
     
     else if (strcmp(argv[1], "--secured-ap-connect-verification") == 0) {
         if (argc < 5) {
-            printf("{\"error\": \"Missing required arguments\", \"usage\": \"--secured-ap-connect-verification <interface> <ssid> <password>\"}\n");
+            printf("{\"error\": \"Missing required arguments\", \"usage\": \"--secured-ap-connect-verification <interface> <ssid> <password> [--persistent]\"}\n");
             return 1;
         }
         
@@ -236,13 +486,48 @@ int main(int argc, char *argv[]) {
         const char *password = argv[4];
         connection_test_result_t result;
         
+        // Keep (or reuse) one wpa_supplicant on the interface instead of restarting it per test
+        if (argc > 5 && strcmp(argv[5], "--persistent") == 0) {
+            supplicant_session_start(interface);
+        }
+        
         // Test secured AP connection
         test_secured_ap_connection(interface, ssid, password, &result);
+        test_history_append(&result);
         print_connection_test_json(&result);
         
         return result.success ? 0 : 1;
     }
     
+    else if (strcmp(argv[1], "--batch-connect-verification") == 0) {
+        if (argc < 3) {
+            printf("{\"error\": \"Missing job file argument\", \"usage\": \"--batch-connect-verification <jobfile>\"}\n");
+            return 1;
+        }
+        
+        connection_batch_t *batch = malloc(sizeof(connection_batch_t));
+        char error[256];
+        if (!batch) {
+            printf("{\"error\": \"Out of memory\"}\n");
+            return 1;
+        }
+        
+        if (connection_batch_load(argv[2], batch, error, sizeof(error)) < 0) {
+            printf("{\"error\": \"%s\", \"job_file\": \"%s\"}\n", escape_json_string(error), argv[2]);
+            free(batch);
+            return 1;
+        }
+        
+        int failed = connection_batch_run(batch);
+        for (int i = 0; i < batch->job_count; i++) {
+            test_history_append(&batch->results[i]);
+        }
+        print_connection_batch_json(batch);
+        free(batch);
+        
+        return failed == 0 ? 0 : 1;
+    }
+    
     else if (strcmp(argv[1], "--interface-down") == 0) {
         if (argc < 3) {
             printf("{\"error\": \"Missing interface argument\", \"usage\": \"--interface-down <interface>\"}\n");
@@ -250,7 +535,6 @@ int main(int argc, char *argv[]) {
         }
         
         const char *interface = argv[2];
-        char command[MAX_COMMAND_LEN];
         
         // Validate interface exists
         int interface_exists = 0;
@@ -274,8 +558,8 @@ int main(int argc, char *argv[]) {
         printf("{\"status\": \"setting_interface_down\", \"interface\": \"%s\"}\n", interface);
         fflush(stdout);
         
-        snprintf(command, sizeof(command), "ip link set %s down", interface);
-        int result = system(command);
+        const char *const link_down[] = {"ip", "link", "set", interface, "down", NULL};
+        int result = command_run(link_down, COMMAND_INHERIT_OUTPUT, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL);
         
         if (result == 0) {
             printf("{\"status\": \"success\", \"action\": \"interface_down\", \"interface\": \"%s\", \"message\": \"Interface set down successfully\"}\n", interface);
@@ -293,7 +577,6 @@ int main(int argc, char *argv[]) {
         }
         
         const char *interface = argv[2];
-        char command[MAX_COMMAND_LEN];
         
         // Validate interface exists
         int interface_exists = 0;
@@ -317,8 +600,8 @@ int main(int argc, char *argv[]) {
         printf("{\"status\": \"setting_interface_up\", \"interface\": \"%s\"}\n", interface);
         fflush(stdout);
         
-        snprintf(command, sizeof(command), "ip link set %s up", interface);
-        int result = system(command);
+        const char *const link_up[] = {"ip", "link", "set", interface, "up", NULL};
+        int result = command_run(link_up, COMMAND_INHERIT_OUTPUT, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL);
         
         if (result == 0) {
             printf("{\"status\": \"success\", \"action\": \"interface_up\", \"interface\": \"%s\", \"message\": \"Interface set up successfully\"}\n", interface);
@@ -329,6 +612,63 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    // Scan with the method --bench-methods measured best here, or the one named
+    else if (strcmp(argv[1], "--scan-auto") == 0) {
+        if (argc >= 3) {
+            selected_interface = argv[2];
+        } else {
+            selected_interface = get_best_wifi_interface(interfaces, interface_count);
+        }
+        
+        if (!selected_interface) {
+            printf("{\"error\": \"No suitable WiFi interface found\"}\n");
+            return 1;
+        }
+        if (argc >= 4) {
+            int forced = wifi_scan_method_from_name(argv[3]);
+            if (forced < 0) {
+                json_writer_t w;
+                json_writer_init(&w);
+                json_writer_raw(&w, "{\"error\": \"Unknown scan method\", \"method\": ");
+                json_writer_string(&w, argv[3]);
+                json_writer_raw(&w, "}\n");
+                json_writer_flush(&w, STDOUT_FILENO);
+                json_writer_free(&w);
+                return 1;
+            }
+            wifi_configure_scan_method((wifi_scan_method_t)forced);
+        }
+        
+        wifi_scan_method_t method = wifi_select_optimal_scan_method(selected_interface);
+        scan_result_t results[MAX_SCAN_RESULTS];
+        long long start_ms = monotonic_time_ms();
+        int result_count = wifi_scan_with_method(method, selected_interface, results, MAX_SCAN_RESULTS);
+        long long duration_ms = monotonic_time_ms() - start_ms;
+        if (result_count < 0) result_count = 0;
+        
+        // SSIDs are untrusted input: every string goes through the escaping writer
+        json_writer_t w;
+        json_writer_init(&w);
+        json_writer_raw(&w, "{\n  \"scan_method\": ");
+        json_writer_string(&w, wifi_scan_method_name(method));
+        json_writer_raw(&w, ",\n  \"interface\": ");
+        json_writer_string(&w, selected_interface);
+        json_writer_raw(&w, ",\n  \"scan_time\": ");
+        json_writer_int(&w, time(NULL));
+        json_writer_raw(&w, ",\n  \"scan_duration_ms\": ");
+        json_writer_int(&w, duration_ms);
+        json_writer_raw(&w, ",\n  \"results_count\": ");
+        json_writer_int(&w, result_count);
+        json_writer_raw(&w, ",\n  \"scan_results\": [\n");
+        for (int i = 0; i < result_count; i++) {
+            json_write_scan_result(&w, &results[i], i == result_count - 1);
+        }
+        json_writer_raw(&w, "  ]\n}\n");
+        json_writer_flush(&w, STDOUT_FILENO);
+        json_writer_free(&w);
+        return 0;
+    }
+    
     // New scan alternatives that replace shared memory files
     else if (strcmp(argv[1], "--scan-threaded") == 0) {
         if (argc >= 3) {
@@ -345,25 +685,7 @@ int main(int argc, char *argv[]) {
         scan_result_t results[MAX_SCAN_RESULTS];
         int result_count = wifi_scan_direct_sync(selected_interface, results, MAX_SCAN_RESULTS);
         
-        printf("{\n");
-        printf("  \"scan_method\": \"threaded\",\n");
-        printf("  \"interface\": \"%s\",\n", selected_interface);
-        printf("  \"scan_time\": %ld,\n", time(NULL));
-        printf("  \"results_count\": %d,\n", result_count);
-        printf("  \"scan_results\": [\n");
-        
-        for (int i = 0; i < result_count; i++) {
-            printf("    {\n");
-            printf("      \"ssid\": \"%s\",\n", results[i].ssid);
-            printf("      \"bssid\": \"%s\",\n", results[i].bssid);
-            printf("      \"frequency\": %d,\n", results[i].frequency);
-            printf("      \"signal_strength\": %d,\n", results[i].signal_strength);
-            printf("      \"quality\": %d,\n", results[i].quality);
-            printf("      \"encryption\": \"%s\"\n", results[i].security);
-            printf("    }%s\n", (i < result_count - 1) ? "," : "");
-        }
-        printf("  ]\n");
-        printf("}\n");
+        print_method_scan_json("threaded", selected_interface, results, result_count);
         return 0;
     }
     
@@ -385,25 +707,7 @@ int main(int argc, char *argv[]) {
         if (wifi_scan_pipe_based_init(&ctx, selected_interface) == 0) {
             int result_count = wifi_scan_pipe_based_execute(&ctx, results, MAX_SCAN_RESULTS);
             
-            printf("{\n");
-            printf("  \"scan_method\": \"pipe-based\",\n");
-            printf("  \"interface\": \"%s\",\n", selected_interface);
-            printf("  \"scan_time\": %ld,\n", time(NULL));
-            printf("  \"results_count\": %d,\n", result_count);
-            printf("  \"scan_results\": [\n");
-            
-            for (int i = 0; i < result_count; i++) {
-                printf("    {\n");
-                printf("      \"ssid\": \"%s\",\n", results[i].ssid);
-                printf("      \"bssid\": \"%s\",\n", results[i].bssid);
-                printf("      \"frequency\": %d,\n", results[i].frequency);
-                printf("      \"signal_strength\": %d,\n", results[i].signal_strength);
-                printf("      \"quality\": %d,\n", results[i].quality);
-                printf("      \"encryption\": \"%s\"\n", results[i].security);
-                printf("    }%s\n", (i < result_count - 1) ? "," : "");
-            }
-            printf("  ]\n");
-            printf("}\n");
+            print_method_scan_json("pipe-based", selected_interface, results, result_count);
             
             wifi_scan_pipe_based_cleanup(&ctx);
         } else {
@@ -431,25 +735,7 @@ int main(int argc, char *argv[]) {
         if (wifi_scan_signal_based_init(&ctx, selected_interface) == 0) {
             int result_count = wifi_scan_signal_based_execute(&ctx, results, MAX_SCAN_RESULTS);
             
-            printf("{\n");
-            printf("  \"scan_method\": \"signal-based\",\n");
-            printf("  \"interface\": \"%s\",\n", selected_interface);
-            printf("  \"scan_time\": %ld,\n", time(NULL));
-            printf("  \"results_count\": %d,\n", result_count);
-            printf("  \"scan_results\": [\n");
-            
-            for (int i = 0; i < result_count; i++) {
-                printf("    {\n");
-                printf("      \"ssid\": \"%s\",\n", results[i].ssid);
-                printf("      \"bssid\": \"%s\",\n", results[i].bssid);
-                printf("      \"frequency\": %d,\n", results[i].frequency);
-                printf("      \"signal_strength\": %d,\n", results[i].signal_strength);
-                printf("      \"quality\": %d,\n", results[i].quality);
-                printf("      \"encryption\": \"%s\"\n", results[i].security);
-                printf("    }%s\n", (i < result_count - 1) ? "," : "");
-            }
-            printf("  ]\n");
-            printf("}\n");
+            print_method_scan_json("signal-based", selected_interface, results, result_count);
             
             wifi_scan_signal_based_cleanup(&ctx);
         } else {
@@ -459,6 +745,36 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    else if (strcmp(argv[1], "--scan-async") == 0) {
+        const char *async_interfaces[WIFI_SCAN_ASYNC_MAX_REQUESTS];
+        int async_interface_count = 0;
+        int frequencies[SCAN_MAX_FREQUENCIES];
+        int frequency_count = 0;
+        uint32_t band_mask = 0;
+        
+        if (argc < 3) {
+            printf("{\"error\": \"Missing interface argument\", \"usage\": \"--scan-async <interface[,interface...]> [freq|band[,freq|band...]] [deadline_ms]\"}\n");
+            return 1;
+        }
+        for (char *name = strtok(argv[2], ","); name && async_interface_count < WIFI_SCAN_ASYNC_MAX_REQUESTS;
+             name = strtok(NULL, ",")) {
+            async_interfaces[async_interface_count++] = name;
+        }
+        if (argc >= 4) {
+            for (char *freq = strtok(argv[3], ","); freq && frequency_count < SCAN_MAX_FREQUENCIES;
+                 freq = strtok(NULL, ",")) {
+                if (strcasecmp(freq, "2.4ghz") == 0 || strcasecmp(freq, "2ghz") == 0) band_mask |= WIPHY_BAND_2GHZ;
+                else if (strcasecmp(freq, "5ghz") == 0) band_mask |= WIPHY_BAND_5GHZ;
+                else if (strcasecmp(freq, "6ghz") == 0) band_mask |= WIPHY_BAND_6GHZ;
+                else if (atoi(freq) > 0) frequencies[frequency_count++] = atoi(freq);
+            }
+        }
+        int deadline_ms = (argc >= 5) ? atoi(argv[4]) : 0;
+        
+        wifi_scan_async_loop(async_interfaces, async_interface_count, frequencies, frequency_count, band_mask, deadline_ms);
+        return 0;
+    }
+    
     else if (strcmp(argv[1], "--continuous-threaded") == 0) {
         if (argc >= 3) {
             selected_interface = argv[2];
@@ -534,6 +850,64 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    else if (strcmp(argv[1], "--continuous-timer") == 0) {
+        if (argc >= 3) {
+            selected_interface = argv[2];
+        } else {
+            selected_interface = get_best_wifi_interface(interfaces, interface_count);
+        }
+        
+        if (argc >= 4) {
+            scan_delay = atof(argv[3]);
+            if (scan_delay < 0.1) scan_delay = 5.0;
+        }
+        
+        if (!selected_interface) {
+            printf("{\"error\": \"No suitable WiFi interface found\"}\n");
+            return 1;
+        }
+        
+        printf("{\"status\": \"starting\", \"method\": \"timer\", \"interface\": \"%s\", \"scan_delay\": %.3f}\n", 
+               selected_interface, scan_delay);
+        fflush(stdout);
+        
+        wifi_continuous_scan_loop_timer(selected_interface, scan_delay);
+        return 0;
+    }
+    
+    else if (strcmp(argv[1], "--capabilities") == 0) {
+        int force_refresh = 0;
+        
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--refresh") == 0) {
+                force_refresh = 1;
+            } else if (!selected_interface) {
+                selected_interface = argv[i];
+            }
+        }
+        
+        if (!selected_interface) {
+            selected_interface = get_best_wifi_interface(interfaces, interface_count);
+        }
+        
+        if (!selected_interface) {
+            printf("{\"error\": \"No suitable WiFi interface found\"}\n");
+            return 1;
+        }
+        
+        wiphy_capabilities_t caps;
+        int caps_result = force_refresh ? wiphy_refresh_capabilities(selected_interface, &caps)
+                                        : wiphy_get_capabilities(selected_interface, &caps);
+        if (caps_result != 0) {
+            printf("{\"error\": \"Failed to query wiphy capabilities\", \"interface\": \"%s\"}\n", 
+                   selected_interface);
+            return 1;
+        }
+        
+        print_wiphy_capabilities_json(selected_interface, &caps);
+        return 0;
+    }
+    
     else if (strcmp(argv[1], "--help") == 0) {
         print_usage(argv[0]);
         return 0;
@@ -0,0 +1,413 @@
+#include "monitor.h"
+#include "event_loop.h"
+#include "tick_scheduler.h"
+#include "json_formatter.h"
+#include "interface_cache.h"
+#include "link_state.h"
+#include "netlink_helper.h"
+#include <net/if.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#define MONITOR_LINK_FLAGS (IFF_UP | IFF_RUNNING)
+
+typedef struct monitor monitor_t;
+
+typedef struct {
+    monitor_t *monitor;
+    const char *name;
+    tick_scheduler_t scan_timer;
+    tick_scheduler_t info_timer;
+    tick_scheduler_t station_timer;
+    int scan_number;
+    int info_number;
+    int station_number;
+    forked_scan_t scan;
+    int scan_in_flight;
+    int scan_deadline_fd;           // one-shot timerfd bounding the scan in flight
+    long long info_start_ms;
+    long long scan_start_ms;
+    scan_session_t session;
+    unsigned int link_flags;        // MONITOR_LINK_FLAGS as last reported
+} monitor_interface_t;
+
+struct monitor {
+    const monitor_config_t *config;
+    float scan_period;
+    event_loop_t loop;
+    nl_socket_t link_events;
+    monitor_stats_t stats;
+    monitor_interface_t interfaces[MONITOR_MAX_INTERFACES];
+    json_writer_t output;           // record being built; its buffer is kept between records
+};
+
+static unsigned int read_link_flags(const char *interface_name) {
+    char path[128];
+    unsigned int flags = 0;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/flags", interface_name);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    if (fscanf(fp, "%x", &flags) != 1) flags = 0;
+    fclose(fp);
+    return flags & MONITOR_LINK_FLAGS;
+}
+
+static void print_link_record(monitor_interface_t *mi, int removed) {
+    json_writer_t *w = &mi->monitor->output;
+
+    json_writer_raw(w, "{\"event\": \"link\", \"interface\": ");
+    json_writer_string(w, mi->name);
+    json_writer_raw(w, ", \"event_time\": ");
+    json_writer_int(w, time(NULL));
+    json_writer_raw(w, ", \"up\": ");
+    json_writer_bool(w, (mi->link_flags & IFF_UP) != 0);
+    json_writer_raw(w, ", \"running\": ");
+    json_writer_bool(w, (mi->link_flags & IFF_RUNNING) != 0);
+    json_writer_raw(w, ", \"removed\": ");
+    json_writer_bool(w, removed);
+    json_writer_raw(w, "}\n");
+    json_writer_flush(w, STDOUT_FILENO);
+}
+
+static void print_scan_record(monitor_interface_t *mi) {
+    scan_session_t *session = &mi->session;
+    json_writer_t *w = &mi->monitor->output;
+
+    json_writer_raw(w, "{\n  \"scan_number\": ");
+    json_writer_int(w, mi->scan_number);
+    json_writer_raw(w, ",\n  \"interface\": ");
+    json_writer_string(w, mi->name);
+    json_writer_raw(w, ",\n  \"scan_time\": ");
+    json_writer_int(w, session->scan_time);
+    json_writer_raw(w, ",\n  \"scan_duration_ms\": ");
+    json_writer_int(w, session->scan_duration_ms);
+    json_writer_raw(w, ",\n  \"phases\": ");
+    json_write_scan_timing(w, &session->timing);
+    json_writer_raw(w, ",\n  \"scan_delay\": ");
+    json_writer_double(w, mi->monitor->scan_period, 3);
+    json_writer_raw(w, ",\n  \"schedule\": ");
+    json_write_tick_schedule(w, &mi->scan_timer);
+    json_writer_raw(w, ",\n  \"results_count\": ");
+    json_writer_int(w, session->result_count);
+    json_writer_raw(w, ",\n  \"interface_info\": ");
+    json_write_interface(w, &session->interface);
+    json_writer_raw(w, ",\n  \"interface_cache\": ");
+    json_write_interface_cache_stats(w);
+    json_writer_raw(w, ",\n  \"scan_results\": [\n");
+
+    for (int i = 0; i < session->result_count; i++) {
+        json_write_scan_result(w, &session->results[i], (i == session->result_count - 1));
+    }
+
+    json_writer_raw(w, "  ]\n}\n");
+    json_writer_flush(w, STDOUT_FILENO);
+
+    mi->scan_number++;
+}
+
+// Collect the scan in flight; report is 0 when shutting down and the results are unwanted
+static void finish_scan(monitor_interface_t *mi, int report) {
+    event_loop_t *loop = &mi->monitor->loop;
+    struct itimerspec disarm;
+
+    event_loop_remove(loop, mi->scan.done_fd);
+    if (mi->scan.pidfd >= 0) event_loop_remove(loop, mi->scan.pidfd);
+    memset(&disarm, 0, sizeof(disarm));
+    timerfd_settime(mi->scan_deadline_fd, 0, &disarm, NULL);
+    mi->scan_in_flight = 0;
+
+    mi->session.result_count = forked_scan_finish(&mi->scan, mi->session.results, MAX_SCAN_RESULTS);
+    if (!report) return;
+
+    complete_timed_scan(&mi->session, mi->info_start_ms, mi->scan_start_ms);
+    mi->monitor->stats.scans++;
+    print_scan_record(mi);
+
+    // Periods that went by during the scan are waiting in the timerfd and count as skipped
+    event_loop_modify(loop, mi->scan_timer.timer_fd, EPOLLIN);
+}
+
+// The child's eventfd, its pidfd (died without signalling) or the scan deadline
+static int on_scan_event(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    monitor_interface_t *mi = (monitor_interface_t *)data;
+
+    if (fd == mi->scan_deadline_fd) {
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations)) return 0;
+        if (mi->scan_in_flight) mi->monitor->stats.scan_timeouts++;
+    }
+    if (mi->scan_in_flight) finish_scan(mi, 1);
+    return 0;
+}
+
+static int on_scan_tick(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    monitor_interface_t *mi = (monitor_interface_t *)data;
+    struct itimerspec deadline;
+
+    int tick = tick_scheduler_consume(&mi->scan_timer);
+    if (tick <= 0) return tick;
+
+    memset(&mi->session, 0, sizeof(mi->session));
+    interface_cache_tick();
+    mi->info_start_ms = monotonic_time_ms();
+    get_interface_info(mi->name, &mi->session.interface);
+    mi->scan_start_ms = monotonic_time_ms();
+
+    if (forked_scan_start(mi->name, &mi->scan) != 0) {
+        // No child: scan inline, as perform_forked_scan falls back to
+        mi->session.result_count = perform_scan(mi->name, mi->session.results, MAX_SCAN_RESULTS);
+        complete_timed_scan(&mi->session, mi->info_start_ms, mi->scan_start_ms);
+        mi->monitor->stats.scans++;
+        print_scan_record(mi);
+        return 0;
+    }
+
+    // Without a pidfd a child that dies before signalling is only noticed at the deadline
+    memset(&deadline, 0, sizeof(deadline));
+    deadline.it_value.tv_sec = FORKED_SCAN_TIMEOUT_MS / 1000;
+    deadline.it_value.tv_nsec = (long)(FORKED_SCAN_TIMEOUT_MS % 1000) * 1000000L;
+    timerfd_settime(mi->scan_deadline_fd, 0, &deadline, NULL);
+    event_loop_add(loop, mi->scan.done_fd, EPOLLIN, on_scan_event, mi);
+    if (mi->scan.pidfd >= 0) event_loop_add(loop, mi->scan.pidfd, EPOLLIN, on_scan_event, mi);
+    mi->scan_in_flight = 1;
+
+    // One scan per interface at a time: park the period timer until this one is collected
+    event_loop_modify(loop, mi->scan_timer.timer_fd, 0);
+    return 0;
+}
+
+static int on_info_tick(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    monitor_interface_t *mi = (monitor_interface_t *)data;
+    wifi_interface_t interface_info;
+
+    int tick = tick_scheduler_consume(&mi->info_timer);
+    if (tick <= 0) return tick;
+
+    memset(&interface_info, 0, sizeof(interface_info));
+    interface_cache_tick();
+
+    // Get current interface info with timing
+    long long start_time = monotonic_time_ms();
+    int result = get_interface_info(mi->name, &interface_info);
+    long long end_time = monotonic_time_ms();
+
+    time_t current_time = time(NULL);
+    int info_duration_ms = (int)(end_time - start_time);
+
+    json_writer_t *w = &mi->monitor->output;
+    json_writer_raw(w, "{\n  \"info_number\": ");
+    json_writer_int(w, mi->info_number);
+    json_writer_raw(w, ",\n  \"interface\": ");
+    json_writer_string(w, mi->name);
+    json_writer_raw(w, ",\n  \"info_time\": ");
+    json_writer_int(w, current_time);
+    json_writer_raw(w, ",\n  \"info_duration_ms\": ");
+    json_writer_int(w, info_duration_ms);
+    json_writer_raw(w, ",\n  \"info_delay\": ");
+    json_writer_double(w, mi->monitor->config->info_period, 3);
+    json_writer_raw(w, ",\n  \"schedule\": ");
+    json_write_tick_schedule(w, &mi->info_timer);
+    json_writer_raw(w, (result == 0) ? ",\n  \"status\": \"success\"" : ",\n  \"status\": \"error\"");
+    json_writer_raw(w, ",\n  \"interface_info\": ");
+    json_write_interface(w, &interface_info);
+    json_writer_raw(w, ",\n  \"interface_cache\": ");
+    json_write_interface_cache_stats(w);
+    json_writer_raw(w, "\n}\n");
+    json_writer_flush(w, STDOUT_FILENO);
+
+    mi->info_number++;
+    return 0;
+}
+
+static int on_station_tick(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    monitor_interface_t *mi = (monitor_interface_t *)data;
+    link_state_t state;
+
+    int tick = tick_scheduler_consume(&mi->station_timer);
+    if (tick <= 0) return tick;
+
+    memset(&state, 0, sizeof(state));
+    long long start_time = monotonic_time_ms();
+    int result = link_state_sample(mi->name, &state);
+    int sample_duration_ms = (int)(monotonic_time_ms() - start_time);
+
+    json_writer_t *w = &mi->monitor->output;
+    json_writer_raw(w, "{\"event\": \"station\", \"interface\": ");
+    json_writer_string(w, mi->name);
+    json_writer_raw(w, ", \"station_number\": ");
+    json_writer_int(w, mi->station_number);
+    json_writer_raw(w, ", \"sample_time\": ");
+    json_writer_int(w, time(NULL));
+    json_writer_raw(w, ", \"sample_duration_ms\": ");
+    json_writer_int(w, sample_duration_ms);
+    json_writer_raw(w, (result == 0) ? ", \"status\": \"success\"" : ", \"status\": \"error\"");
+    json_writer_raw(w, ", \"schedule\": ");
+    json_write_tick_schedule(w, &mi->station_timer);
+    json_writer_raw(w, ", \"link\": ");
+    json_write_link_state(w, &state);
+    json_writer_raw(w, "}\n");
+    json_writer_flush(w, STDOUT_FILENO);
+
+    mi->station_number++;
+    return 0;
+}
+
+static monitor_interface_t *find_interface(monitor_t *monitor, const char *interface_name) {
+    for (int i = 0; i < monitor->config->interface_count; i++) {
+        if (strcmp(monitor->interfaces[i].name, interface_name) == 0) return &monitor->interfaces[i];
+    }
+    return NULL;
+}
+
+// Report interfaces whose flags moved while notifications were being dropped
+static void resync_link_flags(monitor_t *monitor) {
+    for (int i = 0; i < monitor->config->interface_count; i++) {
+        monitor_interface_t *mi = &monitor->interfaces[i];
+        unsigned int flags = read_link_flags(mi->name);
+        if (flags != mi->link_flags) {
+            mi->link_flags = flags;
+            print_link_record(mi, 0);
+        }
+    }
+}
+
+static int on_link_events(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    monitor_t *monitor = (monitor_t *)data;
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    while (1) {
+        ssize_t len = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                resync_link_flags(monitor);
+                continue;
+            }
+            break;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type != RTM_NEWLINK && nlh->nlmsg_type != RTM_DELLINK) continue;
+
+            struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA(nlh);
+            struct nlattr *tb[IFLA_MAX + 1];
+            nl_parse_attrs(tb, IFLA_MAX, (char *)ifi + NLMSG_ALIGN(sizeof(*ifi)),
+                           nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi)));
+            // Wireless extension events (scan done, etc.) also arrive as RTM_NEWLINK
+            if (!tb[IFLA_IFNAME] || tb[IFLA_WIRELESS]) continue;
+
+            monitor_interface_t *mi = find_interface(monitor, (const char *)nl_attr_data(tb[IFLA_IFNAME]));
+            if (!mi) continue;
+            monitor->stats.link_events++;
+
+            int removed = (nlh->nlmsg_type == RTM_DELLINK);
+            unsigned int flags = removed ? 0 : (ifi->ifi_flags & MONITOR_LINK_FLAGS);
+            if (removed || flags != mi->link_flags) {
+                mi->link_flags = flags;
+                print_link_record(mi, removed);
+            }
+        }
+    }
+    return 0;
+}
+
+// A period of 0 leaves the timer closed (fd -1) and unregistered
+static int start_timer(monitor_t *monitor, tick_scheduler_t *timer, float period,
+                       event_handler_t handler, void *data) {
+    if (period <= 0) return 0;
+    if (tick_scheduler_init(timer, period) != 0) return -1;
+    return event_loop_add(&monitor->loop, timer->timer_fd, EPOLLIN, handler, data);
+}
+
+int monitor_run(const monitor_config_t *config, monitor_stats_t *stats) {
+    int result = 0;
+
+    monitor_t *monitor = (monitor_t *)calloc(1, sizeof(monitor_t));
+    if (!monitor) return -1;
+    monitor->config = config;
+    monitor->scan_period = config->scan_period;
+    monitor->link_events.fd = -1;
+    json_writer_init(&monitor->output);
+
+    // Enforce minimum scan interval for stability
+    if (monitor->scan_period > 0 && monitor->scan_period < MONITOR_MIN_SCAN_PERIOD) {
+        printf("{\"warning\": \"Scan interval too low, increasing to %.1f seconds for hardware stability\"}\n",
+               MONITOR_MIN_SCAN_PERIOD);
+        monitor->scan_period = MONITOR_MIN_SCAN_PERIOD;
+    }
+
+    for (int i = 0; i < config->interface_count; i++) {
+        monitor_interface_t *mi = &monitor->interfaces[i];
+        mi->monitor = monitor;
+        mi->name = config->interfaces[i];
+        mi->scan_timer.timer_fd = mi->scan_timer.stop_fd = -1;
+        mi->info_timer.timer_fd = mi->info_timer.stop_fd = -1;
+        mi->station_timer.timer_fd = mi->station_timer.stop_fd = -1;
+        mi->scan_deadline_fd = -1;
+        mi->scan_number = mi->info_number = mi->station_number = 1;
+        mi->link_flags = read_link_flags(mi->name);
+    }
+
+    if (event_loop_init(&monitor->loop) != 0) {
+        printf("{\"error\": \"Cannot create event loop\", \"reason\": \"%s\"}\n", strerror(errno));
+        free(monitor);
+        return -1;
+    }
+
+    for (int i = 0; i < config->interface_count && result == 0; i++) {
+        monitor_interface_t *mi = &monitor->interfaces[i];
+
+        if (monitor->scan_period > 0) {
+            mi->scan_deadline_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+            if (mi->scan_deadline_fd < 0 ||
+                event_loop_add(&monitor->loop, mi->scan_deadline_fd, EPOLLIN, on_scan_event, mi) != 0 ||
+                start_timer(monitor, &mi->scan_timer, monitor->scan_period, on_scan_tick, mi) != 0) {
+                printf("{\"error\": \"Cannot create scan timer\", \"reason\": \"%s\"}\n", strerror(errno));
+                result = -1;
+            }
+        }
+        if (result == 0 && start_timer(monitor, &mi->info_timer, config->info_period, on_info_tick, mi) != 0) {
+            printf("{\"error\": \"Cannot create info timer\", \"reason\": \"%s\"}\n", strerror(errno));
+            result = -1;
+        }
+        if (result == 0 && start_timer(monitor, &mi->station_timer, config->station_period, on_station_tick, mi) != 0) {
+            printf("{\"error\": \"Cannot create station timer\", \"reason\": \"%s\"}\n", strerror(errno));
+            result = -1;
+        }
+    }
+
+    if (result == 0 && config->link_events) {
+        if (nl_socket_open(&monitor->link_events, NETLINK_ROUTE, RTMGRP_LINK) != 0 ||
+            event_loop_add(&monitor->loop, monitor->link_events.fd, EPOLLIN, on_link_events, monitor) != 0) {
+            // Scans and samples still work without the event stream
+            printf("{\"warning\": \"Link events unavailable\", \"reason\": \"%s\"}\n", strerror(errno));
+        }
+    }
+    fflush(stdout);
+
+    if (result == 0 && event_loop_run(&monitor->loop) != 0) {
+        printf("{\"error\": \"Event loop failed\", \"reason\": \"%s\"}\n", strerror(errno));
+        result = -1;
+    }
+
+    for (int i = 0; i < config->interface_count; i++) {
+        monitor_interface_t *mi = &monitor->interfaces[i];
+        if (mi->scan_in_flight) finish_scan(mi, 0);
+        tick_scheduler_close(&mi->scan_timer);
+        tick_scheduler_close(&mi->info_timer);
+        tick_scheduler_close(&mi->station_timer);
+        if (mi->scan_deadline_fd >= 0) close(mi->scan_deadline_fd);
+    }
+    if (monitor->link_events.fd >= 0) nl_socket_close(&monitor->link_events);
+
+    monitor->stats.wakeups = monitor->loop.wakeups;
+    monitor->stats.dispatches = monitor->loop.dispatches;
+    event_loop_close(&monitor->loop);
+    if (stats) memcpy(stats, &monitor->stats, sizeof(monitor_stats_t));
+    json_writer_free(&monitor->output);
+    free(monitor);
+    return result;
+}
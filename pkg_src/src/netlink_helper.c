@@ -0,0 +1,555 @@
+#include "netlink_helper.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+
+// Open a netlink socket of the given protocol and join the multicast groups bitmask
+int nl_socket_open(nl_socket_t *sock, int protocol, uint32_t groups) {
+    struct sockaddr_nl addr;
+    socklen_t addr_len = sizeof(addr);
+
+    if (!sock) return -1;
+
+    memset(sock, 0, sizeof(nl_socket_t));
+    sock->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, protocol);
+    if (sock->fd < 0) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = groups;
+
+    if (bind(sock->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        getsockname(sock->fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        close(sock->fd);
+        sock->fd = -1;
+        return -1;
+    }
+
+    sock->port_id = addr.nl_pid;
+    sock->seq = (uint32_t)time(NULL);
+    return 0;
+}
+
+void nl_socket_close(nl_socket_t *sock) {
+    if (sock && sock->fd >= 0) {
+        close(sock->fd);
+        sock->fd = -1;
+    }
+}
+
+// Join a multicast group by number (needed for genl groups above 32)
+int nl_socket_add_membership(nl_socket_t *sock, uint32_t group) {
+    return setsockopt(sock->fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group));
+}
+
+void nl_msg_init(nl_msg_t *msg, uint16_t type, uint16_t flags) {
+    memset(msg, 0, sizeof(nl_msg_t));
+    msg->u.hdr.nlmsg_len = NLMSG_LENGTH(0);
+    msg->u.hdr.nlmsg_type = type;
+    msg->u.hdr.nlmsg_flags = NLM_F_REQUEST | flags;
+}
+
+// Append a fixed family header (genlmsghdr, ifinfomsg, ...) to the message
+void *nl_msg_append(nl_msg_t *msg, const void *data, size_t len) {
+    size_t offset = NLMSG_ALIGN(msg->u.hdr.nlmsg_len);
+
+    if (offset + NLMSG_ALIGN(len) > sizeof(msg->u.buf)) {
+        return NULL;
+    }
+
+    void *dest = msg->u.buf + offset;
+    if (data) {
+        memcpy(dest, data, len);
+    } else {
+        memset(dest, 0, len);
+    }
+    msg->u.hdr.nlmsg_len = offset + NLMSG_ALIGN(len);
+    return dest;
+}
+
+int nl_msg_put_attr(nl_msg_t *msg, uint16_t type, const void *data, size_t len) {
+    size_t offset = NLMSG_ALIGN(msg->u.hdr.nlmsg_len);
+    size_t attr_len = NLA_HDRLEN + len;
+
+    if (offset + NLA_ALIGN(attr_len) > sizeof(msg->u.buf)) {
+        return -1;
+    }
+
+    struct nlattr *nla = (struct nlattr *)(msg->u.buf + offset);
+    nla->nla_type = type;
+    nla->nla_len = (uint16_t)attr_len;
+    if (len > 0) {
+        memcpy((char *)nla + NLA_HDRLEN, data, len);
+    }
+    msg->u.hdr.nlmsg_len = offset + NLA_ALIGN(attr_len);
+    return 0;
+}
+
+int nl_msg_put_u32(nl_msg_t *msg, uint16_t type, uint32_t value) {
+    return nl_msg_put_attr(msg, type, &value, sizeof(value));
+}
+
+int nl_msg_put_string(nl_msg_t *msg, uint16_t type, const char *value) {
+    return nl_msg_put_attr(msg, type, value, strlen(value) + 1);
+}
+
+int nl_msg_put_flag(nl_msg_t *msg, uint16_t type) {
+    return nl_msg_put_attr(msg, type, NULL, 0);
+}
+
+void genl_msg_init(nl_msg_t *msg, uint16_t family_id, uint8_t cmd, uint16_t flags) {
+    struct genlmsghdr genl;
+
+    nl_msg_init(msg, family_id, flags);
+    memset(&genl, 0, sizeof(genl));
+    genl.cmd = cmd;
+    genl.version = 1;
+    nl_msg_append(msg, &genl, sizeof(genl));
+}
+
+int nl_send(nl_socket_t *sock, nl_msg_t *msg) {
+    struct sockaddr_nl kernel;
+
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    msg->u.hdr.nlmsg_seq = ++sock->seq;
+    msg->u.hdr.nlmsg_pid = sock->port_id;
+
+    ssize_t sent;
+    do {
+        sent = sendto(sock->fd, msg->u.buf, msg->u.hdr.nlmsg_len, 0,
+                      (struct sockaddr *)&kernel, sizeof(kernel));
+    } while (sent < 0 && errno == EINTR);
+
+    return (sent == (ssize_t)msg->u.hdr.nlmsg_len) ? 0 : -1;
+}
+
+// Receive messages for the last request until NLMSG_DONE/ACK, error or timeout.
+// Returns 0 on success, the negative errno reported by the kernel, or -ETIMEDOUT.
+int nl_receive(nl_socket_t *sock, nl_msg_handler_t handler, void *user_data, int timeout_ms) {
+    static __thread char buffer[NL_RECV_BUF_SIZE] __attribute__((aligned(NLMSG_ALIGNTO)));
+    struct pollfd pfd;
+
+    pfd.fd = sock->fd;
+    pfd.events = POLLIN;
+
+    while (1) {
+        int poll_result = poll(&pfd, 1, timeout_ms);
+        if (poll_result < 0 && errno == EINTR) continue;
+        if (poll_result <= 0) return -ETIMEDOUT;
+
+        ssize_t len = recv(sock->fd, buffer, sizeof(buffer), 0);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -errno;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            // Skip multicast notifications and replies to older requests
+            if (nlh->nlmsg_pid != sock->port_id || nlh->nlmsg_seq != sock->seq) {
+                continue;
+            }
+
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                return 0;
+            }
+
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+                return err->error; // 0 is a plain ACK
+            }
+
+            if (handler && handler(nlh, user_data) < 0) {
+                return -ECANCELED;
+            }
+
+            if (!(nlh->nlmsg_flags & NLM_F_MULTI)) {
+                return 0;
+            }
+        }
+    }
+}
+
+int nl_transact(nl_socket_t *sock, nl_msg_t *msg, nl_msg_handler_t handler, void *user_data) {
+    if (nl_send(sock, msg) != 0) {
+        return -EIO;
+    }
+    return nl_receive(sock, handler, user_data, NL_DEFAULT_TIMEOUT_MS);
+}
+
+void *nl_attr_data(const struct nlattr *nla) {
+    return (char *)nla + NLA_HDRLEN;
+}
+
+int nl_attr_len(const struct nlattr *nla) {
+    return nla->nla_len - NLA_HDRLEN;
+}
+
+uint8_t nl_attr_get_u8(const struct nlattr *nla) {
+    return *(const uint8_t *)nl_attr_data(nla);
+}
+
+uint16_t nl_attr_get_u16(const struct nlattr *nla) {
+    uint16_t value;
+    memcpy(&value, nl_attr_data(nla), sizeof(value));
+    return value;
+}
+
+uint32_t nl_attr_get_u32(const struct nlattr *nla) {
+    uint32_t value = 0;
+    int len = nl_attr_len(nla);
+    memcpy(&value, nl_attr_data(nla), len < (int)sizeof(value) ? (size_t)len : sizeof(value));
+    return value;
+}
+
+// Index attributes by type into tb[0..max_type]; unknown types are ignored
+int nl_parse_attrs(struct nlattr **tb, int max_type, void *head, int len) {
+    struct nlattr *nla;
+    int rem;
+
+    memset(tb, 0, sizeof(struct nlattr *) * (max_type + 1));
+    nl_attr_for_each(nla, head, len, rem) {
+        int type = nla->nla_type & NLA_TYPE_MASK;
+        if (type <= max_type) {
+            tb[type] = nla;
+        }
+    }
+    return 0;
+}
+
+int nl_parse_nested(struct nlattr **tb, int max_type, const struct nlattr *nla) {
+    return nl_parse_attrs(tb, max_type, nl_attr_data(nla), nl_attr_len(nla));
+}
+
+int genl_parse_attrs(struct nlattr **tb, int max_type, struct nlmsghdr *nlh) {
+    return nl_parse_attrs(tb, max_type,
+                          (char *)NLMSG_DATA(nlh) + GENL_HDRLEN,
+                          nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+}
+
+static int genl_family_handler(struct nlmsghdr *nlh, void *user_data) {
+    struct nlattr *tb[CTRL_ATTR_MAX + 1];
+    int *family_id = (int *)user_data;
+
+    genl_parse_attrs(tb, CTRL_ATTR_MAX, nlh);
+    if (tb[CTRL_ATTR_FAMILY_ID]) {
+        *family_id = nl_attr_get_u16(tb[CTRL_ATTR_FAMILY_ID]);
+    }
+    return 0;
+}
+
+// Resolve a generic netlink family name (e.g. "nl80211") to its id
+int genl_resolve_family(nl_socket_t *sock, const char *family_name) {
+    nl_msg_t msg;
+    int family_id = -1;
+
+    genl_msg_init(&msg, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 0);
+    nl_msg_put_string(&msg, CTRL_ATTR_FAMILY_NAME, family_name);
+
+    if (nl_transact(sock, &msg, genl_family_handler, &family_id) != 0) {
+        return -1;
+    }
+    return family_id;
+}
+
+typedef struct {
+    const char *group_name;
+    int group_id;
+} genl_group_lookup_t;
+
+static int genl_group_handler(struct nlmsghdr *nlh, void *user_data) {
+    genl_group_lookup_t *lookup = (genl_group_lookup_t *)user_data;
+    struct nlattr *tb[CTRL_ATTR_MAX + 1];
+    struct nlattr *group;
+    int rem;
+
+    genl_parse_attrs(tb, CTRL_ATTR_MAX, nlh);
+    if (!tb[CTRL_ATTR_MCAST_GROUPS]) return 0;
+
+    nl_attr_for_each_nested(group, tb[CTRL_ATTR_MCAST_GROUPS], rem) {
+        struct nlattr *gtb[CTRL_ATTR_MCAST_GRP_MAX + 1];
+        nl_parse_nested(gtb, CTRL_ATTR_MCAST_GRP_MAX, group);
+        if (gtb[CTRL_ATTR_MCAST_GRP_NAME] && gtb[CTRL_ATTR_MCAST_GRP_ID] &&
+            strcmp((const char *)nl_attr_data(gtb[CTRL_ATTR_MCAST_GRP_NAME]), lookup->group_name) == 0) {
+            lookup->group_id = (int)nl_attr_get_u32(gtb[CTRL_ATTR_MCAST_GRP_ID]);
+        }
+    }
+    return 0;
+}
+
+int genl_resolve_multicast_group(nl_socket_t *sock, const char *family_name, const char *group_name) {
+    nl_msg_t msg;
+    genl_group_lookup_t lookup = { group_name, -1 };
+
+    genl_msg_init(&msg, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 0);
+    nl_msg_put_string(&msg, CTRL_ATTR_FAMILY_NAME, family_name);
+
+    if (nl_transact(sock, &msg, genl_group_handler, &lookup) != 0) {
+        return -1;
+    }
+    return lookup.group_id;
+}
+
+// Accept IPv4 addresses other than loopback and IPv6 addresses that are neither
+// link-local nor still undergoing duplicate address detection
+static int address_is_usable(const struct ifaddrmsg *ifa, struct nlattr **tb) {
+    const struct nlattr *nla = tb[IFA_LOCAL] ? tb[IFA_LOCAL] : tb[IFA_ADDRESS];
+    if (!nla) return 0;
+
+    if (ifa->ifa_family == AF_INET) {
+        const unsigned char *bytes = (const unsigned char *)nl_attr_data(nla);
+        return nl_attr_len(nla) >= 4 && bytes[0] != 127;
+    }
+    if (ifa->ifa_family == AF_INET6) {
+        uint32_t flags = tb[IFA_FLAGS] ? nl_attr_get_u32(tb[IFA_FLAGS]) : ifa->ifa_flags;
+        return ifa->ifa_scope == RT_SCOPE_UNIVERSE && !(flags & (IFA_F_TENTATIVE | IFA_F_DADFAILED));
+    }
+    return 0;
+}
+
+int rtnl_wait_for_address(const char *interface_name, int timeout_ms, char *address, size_t address_size) {
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    nl_socket_t sock;
+    nl_msg_t msg;
+    struct ifaddrmsg request;
+    unsigned int ifindex = if_nametoindex(interface_name);
+    long long deadline;
+    struct timespec ts;
+
+    if (ifindex == 0) return -1;
+
+    // Subscribe before dumping so an address added in between is not missed
+    if (nl_socket_open(&sock, NETLINK_ROUTE, RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR) != 0) {
+        return -1;
+    }
+
+    nl_msg_init(&msg, RTM_GETADDR, NLM_F_DUMP);
+    memset(&request, 0, sizeof(request));
+    request.ifa_family = AF_UNSPEC;
+    nl_msg_append(&msg, &request, sizeof(request));
+    if (nl_send(&sock, &msg) != 0) {
+        nl_socket_close(&sock);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    deadline = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + timeout_ms;
+
+    // Dump replies and RTM_NEWADDR notifications are handled by the same loop
+    while (1) {
+        struct pollfd pfd = { sock.fd, POLLIN, 0 };
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        long long remaining = deadline - ((long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+        if (remaining <= 0) break;
+
+        int poll_result = poll(&pfd, 1, (int)remaining);
+        if (poll_result < 0 && errno == EINTR) continue;
+        if (poll_result <= 0) break;
+
+        ssize_t len = recv(sock.fd, buffer, sizeof(buffer), 0);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) continue;
+            nl_socket_close(&sock);
+            return -1;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type != RTM_NEWADDR) continue;
+
+            struct ifaddrmsg *ifa = (struct ifaddrmsg *)NLMSG_DATA(nlh);
+            if (ifa->ifa_index != ifindex) continue;
+
+            struct nlattr *tb[IFA_MAX + 1];
+            nl_parse_attrs(tb, IFA_MAX, (char *)ifa + NLMSG_ALIGN(sizeof(*ifa)),
+                           nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifa)));
+            if (!address_is_usable(ifa, tb)) continue;
+
+            if (address && address_size > 0) {
+                const struct nlattr *nla = tb[IFA_LOCAL] ? tb[IFA_LOCAL] : tb[IFA_ADDRESS];
+                char text[INET6_ADDRSTRLEN] = "";
+                inet_ntop(ifa->ifa_family, nl_attr_data(nla), text, sizeof(text));
+                snprintf(address, address_size, "%s/%d", text, ifa->ifa_prefixlen);
+            }
+            nl_socket_close(&sock);
+            return 1;
+        }
+    }
+
+    nl_socket_close(&sock);
+    return 0;
+}
+
+// Extract the flags of the interface from an RTM_NEWLINK message; -1 when it is another link
+static int link_message_flags(struct nlmsghdr *nlh, unsigned int ifindex, unsigned int *flags) {
+    if (nlh->nlmsg_type != RTM_NEWLINK) return -1;
+
+    struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA(nlh);
+    if ((unsigned int)ifi->ifi_index != ifindex) return -1;
+
+    *flags = ifi->ifi_flags;
+    return 0;
+}
+
+int rtnl_wait_for_link_flags(const char *interface_name, unsigned int flags_set, unsigned int flags_clear,
+                             int timeout_ms, unsigned int *final_flags) {
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    nl_socket_t sock;
+    nl_msg_t msg;
+    struct ifinfomsg request;
+    unsigned int ifindex = if_nametoindex(interface_name);
+    unsigned int flags = 0;
+    long long deadline;
+    struct timespec ts;
+
+    if (ifindex == 0) return -1;
+
+    // Subscribe before querying so a transition in between is not missed
+    if (nl_socket_open(&sock, NETLINK_ROUTE, RTMGRP_LINK) != 0) {
+        return -1;
+    }
+
+    nl_msg_init(&msg, RTM_GETLINK, 0);
+    memset(&request, 0, sizeof(request));
+    request.ifi_family = AF_UNSPEC;
+    request.ifi_index = (int)ifindex;
+    nl_msg_append(&msg, &request, sizeof(request));
+    if (nl_send(&sock, &msg) != 0) {
+        nl_socket_close(&sock);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    deadline = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + timeout_ms;
+
+    while (1) {
+        struct pollfd pfd = { sock.fd, POLLIN, 0 };
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        long long remaining = deadline - ((long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+        if (remaining <= 0) break;
+
+        int poll_result = poll(&pfd, 1, (int)remaining);
+        if (poll_result < 0 && errno == EINTR) continue;
+        if (poll_result <= 0) break;
+
+        ssize_t len = recv(sock.fd, buffer, sizeof(buffer), 0);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) continue;
+            nl_socket_close(&sock);
+            return -1;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+                if (err->error != 0) {
+                    nl_socket_close(&sock);
+                    return -1;
+                }
+                continue;
+            }
+            if (link_message_flags(nlh, ifindex, &flags) != 0) continue;
+
+            if ((flags & flags_set) == flags_set && (flags & flags_clear) == 0) {
+                if (final_flags) *final_flags = flags;
+                nl_socket_close(&sock);
+                return 1;
+            }
+        }
+    }
+
+    if (final_flags) *final_flags = flags;
+    nl_socket_close(&sock);
+    return 0;
+}
+
+static int ipv4_address_transact(const char *interface_name, uint32_t address_be, int prefix_len,
+                                 uint16_t type, uint16_t flags) {
+    nl_socket_t sock;
+    nl_msg_t msg;
+    struct ifaddrmsg request;
+    unsigned int ifindex = if_nametoindex(interface_name);
+
+    if (ifindex == 0 || nl_socket_open(&sock, NETLINK_ROUTE, 0) != 0) return -1;
+
+    nl_msg_init(&msg, type, flags);
+    memset(&request, 0, sizeof(request));
+    request.ifa_family = AF_INET;
+    request.ifa_prefixlen = (unsigned char)prefix_len;
+    request.ifa_scope = RT_SCOPE_UNIVERSE;
+    request.ifa_index = ifindex;
+    nl_msg_append(&msg, &request, sizeof(request));
+    nl_msg_put_attr(&msg, IFA_LOCAL, &address_be, sizeof(address_be));
+    nl_msg_put_attr(&msg, IFA_ADDRESS, &address_be, sizeof(address_be));
+    if (prefix_len < 31) {
+        uint32_t broadcast = address_be | htonl(0xffffffffu >> prefix_len);
+        nl_msg_put_attr(&msg, IFA_BROADCAST, &broadcast, sizeof(broadcast));
+    }
+
+    int result = nl_transact(&sock, &msg, NULL, NULL);
+    nl_socket_close(&sock);
+    return result;
+}
+
+int rtnl_add_ipv4_address(const char *interface_name, uint32_t address_be, int prefix_len) {
+    int result = ipv4_address_transact(interface_name, address_be, prefix_len, RTM_NEWADDR,
+                                       NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE);
+    return result == 0 ? 0 : -1;
+}
+
+int rtnl_del_ipv4_address(const char *interface_name, uint32_t address_be, int prefix_len) {
+    int result = ipv4_address_transact(interface_name, address_be, prefix_len, RTM_DELADDR, NLM_F_ACK);
+    return (result == 0 || result == -EADDRNOTAVAIL || result == -ENODEV) ? 0 : -1;
+}
+
+static int ipv4_default_route_transact(const char *interface_name, uint32_t gateway_be, uint32_t metric,
+                                       uint16_t type, uint16_t flags) {
+    nl_socket_t sock;
+    nl_msg_t msg;
+    struct rtmsg request;
+    unsigned int ifindex = if_nametoindex(interface_name);
+
+    if (ifindex == 0 || nl_socket_open(&sock, NETLINK_ROUTE, 0) != 0) return -1;
+
+    nl_msg_init(&msg, type, flags);
+    memset(&request, 0, sizeof(request));
+    request.rtm_family = AF_INET;
+    request.rtm_table = RT_TABLE_MAIN;
+    request.rtm_protocol = RTPROT_DHCP;
+    request.rtm_scope = RT_SCOPE_UNIVERSE;
+    request.rtm_type = RTN_UNICAST;
+    nl_msg_append(&msg, &request, sizeof(request));
+    nl_msg_put_attr(&msg, RTA_GATEWAY, &gateway_be, sizeof(gateway_be));
+    nl_msg_put_u32(&msg, RTA_OIF, ifindex);
+    nl_msg_put_u32(&msg, RTA_PRIORITY, metric);
+
+    int result = nl_transact(&sock, &msg, NULL, NULL);
+    nl_socket_close(&sock);
+    return result;
+}
+
+int rtnl_add_ipv4_default_route(const char *interface_name, uint32_t gateway_be, uint32_t metric) {
+    // EXCL: never replace a default route someone else installed at this metric
+    int result = ipv4_default_route_transact(interface_name, gateway_be, metric, RTM_NEWROUTE,
+                                             NLM_F_ACK | NLM_F_CREATE | NLM_F_EXCL);
+    if (result == -EEXIST) return 1;
+    return result == 0 ? 0 : -1;
+}
+
+int rtnl_del_ipv4_default_route(const char *interface_name, uint32_t gateway_be, uint32_t metric) {
+    int result = ipv4_default_route_transact(interface_name, gateway_be, metric, RTM_DELROUTE, NLM_F_ACK);
+    return (result == 0 || result == -ESRCH || result == -ENODEV) ? 0 : -1;
+}
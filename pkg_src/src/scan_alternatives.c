@@ -1,21 +1,18 @@
 #include "scan_alternatives.h"
+#include "json_formatter.h"
+#include "wiphy_capabilities.h"
+#include "command_runner.h"
 #include <errno.h>
 #include <sys/wait.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <sys/mman.h>
-
-// Global variables for signal handling
-static wifi_signal_scan_context_t* g_signal_ctx = NULL;
-
-// Signal handler for scan completion
-static void wifi_scan_signal_handler(int sig) {
-    if (g_signal_ctx && sig == SIGUSR1) {
-        g_signal_ctx->scan_ready = 1;
-    } else if (g_signal_ctx && sig == SIGUSR2) {
-        g_signal_ctx->scan_error = 1;
-    }
-}
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 
 // Direct synchronous scanning without shared memory
 int wifi_scan_direct_sync(const char* interface, scan_result_t* results, int max_results) {
@@ -31,10 +28,12 @@ void wifi_scan_context_init(wifi_scan_context_t* ctx) {
     
     memset(ctx, 0, sizeof(wifi_scan_context_t));
     pthread_mutex_init(&ctx->mutex, NULL);
-    pthread_cond_init(&ctx->condition, NULL);
     ctx->scan_complete = 0;
     ctx->scan_active = 0;
-    ctx->scan_status = 0;
+    // Three distinct buffers: the worker's, the reader's and the one in between
+    ctx->back_index = 0;
+    ctx->ready_index = 1;
+    ctx->front_index = 2;
 }
 
 // Destroy scan context
@@ -46,37 +45,54 @@ void wifi_scan_context_destroy(wifi_scan_context_t* ctx) {
     }
     
     pthread_mutex_destroy(&ctx->mutex);
-    pthread_cond_destroy(&ctx->condition);
     memset(ctx, 0, sizeof(wifi_scan_context_t));
 }
 
+// Hand the filled back buffer to readers and take the previous ready buffer as the next back
+static wifi_scan_buffer_t* wifi_scan_publish(wifi_scan_context_t* ctx) {
+    unsigned int published = ctx->back_index;
+    unsigned int previous = __atomic_exchange_n(&ctx->ready_index, published | WIFI_SCAN_BUFFER_FRESH,
+                                                __ATOMIC_ACQ_REL);
+    ctx->back_index = previous & WIFI_SCAN_BUFFER_INDEX_MASK;
+    __atomic_store_n(&ctx->scan_complete, 1, __ATOMIC_RELEASE);
+    return &ctx->buffers[published];
+}
+
+const wifi_scan_buffer_t* wifi_scan_context_latest(wifi_scan_context_t* ctx) {
+    if (!ctx || !__atomic_load_n(&ctx->scan_complete, __ATOMIC_ACQUIRE)) return NULL;
+    
+    if (__atomic_load_n(&ctx->ready_index, __ATOMIC_ACQUIRE) & WIFI_SCAN_BUFFER_FRESH) {
+        unsigned int taken = __atomic_exchange_n(&ctx->ready_index, ctx->front_index, __ATOMIC_ACQ_REL);
+        ctx->front_index = taken & WIFI_SCAN_BUFFER_INDEX_MASK;
+    }
+    return &ctx->buffers[ctx->front_index];
+}
+
 // Thread function for asynchronous scanning
 static void* wifi_scan_thread_worker(void* arg) {
     wifi_scan_context_t* ctx = (wifi_scan_context_t*)arg;
+    int continuous = ctx->scan_interval_ms > 0;
+    uint64_t sequence = 0;
     
     while (ctx->scan_active) {
-        pthread_mutex_lock(&ctx->mutex);
+        // Continuous mode scans on each tick; async_stop wakes the wait
+        if (continuous && tick_scheduler_wait(&ctx->scheduler) <= 0) break;
         
-        // Perform the scan
-        ctx->result_count = perform_scan(ctx->interface, ctx->results, MAX_SCAN_RESULTS);
-        ctx->scan_status = (ctx->result_count > 0) ? 0 : -1;
+        // Scan into the back buffer, which only this thread touches
+        wifi_scan_buffer_t* back = &ctx->buffers[ctx->back_index];
+        back->result_count = perform_scan(ctx->interface, back->results, MAX_SCAN_RESULTS);
+        back->scan_status = (back->result_count > 0) ? 0 : -1;
+        back->scan_time = time(NULL);
+        back->sequence = ++sequence;
         
-        // Call callback if provided
+        // Readers may take the published buffer but never write it, and this thread gets it
+        // back only at its next publication, so the callback can read it without a lock
+        wifi_scan_buffer_t* published = wifi_scan_publish(ctx);
         if (ctx->callback) {
-            ctx->callback(ctx->interface, ctx->results, ctx->result_count, ctx->user_data);
+            ctx->callback(ctx->interface, published->results, published->result_count, ctx->user_data);
         }
         
-        ctx->scan_complete = 1;
-        pthread_cond_signal(&ctx->condition);
-        pthread_mutex_unlock(&ctx->mutex);
-        
-        // Wait for next scan interval (for continuous scanning)
-        if (ctx->scan_interval_ms > 0 && ctx->scan_active) {
-            usleep(ctx->scan_interval_ms * 1000);
-            pthread_mutex_lock(&ctx->mutex);
-            ctx->scan_complete = 0; // Reset for next iteration
-            pthread_mutex_unlock(&ctx->mutex);
-        } else {
+        if (!continuous) {
             break; // Single scan mode
         }
     }
@@ -116,13 +132,19 @@ int wifi_scan_threaded_async_stop(wifi_scan_context_t* ctx) {
     
     pthread_mutex_lock(&ctx->mutex);
     ctx->scan_active = 0;
-    pthread_cond_signal(&ctx->condition);
     pthread_mutex_unlock(&ctx->mutex);
+    if (ctx->scan_interval_ms > 0) {
+        tick_scheduler_stop(&ctx->scheduler);
+    }
     
     if (ctx->thread_id) {
         pthread_join(ctx->thread_id, NULL);
         ctx->thread_id = 0;
     }
+    if (ctx->scan_interval_ms > 0) {
+        tick_scheduler_close(&ctx->scheduler);
+        ctx->scan_interval_ms = 0;
+    }
     
     return 0;
 }
@@ -145,14 +167,376 @@ int wifi_scan_threaded_continuous_start(wifi_scan_context_t* ctx, const char* in
     ctx->user_data = user_data;
     ctx->scan_active = 1;
     ctx->scan_complete = 0;
+    // Created before the thread so a stop can never race its setup
+    if (tick_scheduler_init(&ctx->scheduler, interval_ms / 1000.0) != 0) {
+        ctx->scan_active = 0;
+        pthread_mutex_unlock(&ctx->mutex);
+        return -1;
+    }
     ctx->scan_interval_ms = interval_ms;
     
     int result = pthread_create(&ctx->thread_id, NULL, wifi_scan_thread_worker, ctx);
+    if (result != 0) {
+        ctx->scan_active = 0;
+        ctx->scan_interval_ms = 0;
+        tick_scheduler_close(&ctx->scheduler);
+    }
     pthread_mutex_unlock(&ctx->mutex);
     
     return result;
 }
 
+// Deadline of async requests that leave deadline_ms at 0
+static int async_default_deadline_seconds = WIFI_SCAN_ASYNC_DEFAULT_DEADLINE_SECONDS;
+
+int wifi_scan_timeout_handler(int timeout_seconds) {
+    if (timeout_seconds <= 0) return __atomic_load_n(&async_default_deadline_seconds, __ATOMIC_RELAXED);
+    return __atomic_exchange_n(&async_default_deadline_seconds, timeout_seconds, __ATOMIC_RELAXED);
+}
+
+int wifi_scan_queue_init(wifi_scan_queue_t* queue) {
+    if (!queue) return -1;
+    
+    memset(queue, 0, sizeof(wifi_scan_queue_t));
+    queue->completion_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    if (queue->completion_fd < 0) return -1;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->idle, NULL);
+    return 0;
+}
+
+// One request on its own thread; nothing is locked while the scan or the callback runs
+static void* wifi_scan_async_worker(void* arg) {
+    wifi_scan_slot_t* slot = (wifi_scan_slot_t*)arg;
+    wifi_scan_queue_t* queue = slot->queue;
+    const wifi_scan_request_t* request = &slot->request;
+    wifi_scan_completion_t* completion = &slot->completion;
+    uint64_t one = 1;
+    
+    int deadline_ms = request->deadline_ms > 0 ? request->deadline_ms : wifi_scan_timeout_handler(0) * 1000;
+    completion->queued_ms = monotonic_time_ms() - slot->submitted_ms;
+    completion->results = (scan_result_t*)malloc(MAX_SCAN_RESULTS * sizeof(scan_result_t));
+    
+    if (!completion->results) {
+        completion->status = WIFI_SCAN_ASYNC_FAILED;
+    } else if (completion->queued_ms >= deadline_ms) {
+        completion->status = WIFI_SCAN_ASYNC_TIMED_OUT;
+    } else {
+        int planned[SCAN_MAX_FREQUENCIES];
+        int planned_count = wiphy_plan_scan_frequencies(request->interface, request->frequencies,
+                                                        request->frequency_count, request->band_mask,
+                                                        planned, SCAN_MAX_FREQUENCIES);
+        if (planned_count < 0) {
+            // None of the requested channels exist on this radio
+            completion->status = WIFI_SCAN_ASYNC_FAILED;
+        } else {
+            completion->result_count = perform_scan_frequencies(request->interface, planned, planned_count,
+                                                                deadline_ms - (int)completion->queued_ms,
+                                                                completion->results, MAX_SCAN_RESULTS);
+            get_last_scan_timing(&completion->timing);
+            int expired = monotonic_time_ms() - slot->submitted_ms >= deadline_ms;
+            completion->status = (completion->result_count == 0 && expired) ? WIFI_SCAN_ASYNC_TIMED_OUT : WIFI_SCAN_ASYNC_DONE;
+        }
+    }
+    completion->duration_ms = monotonic_time_ms() - slot->submitted_ms;
+    
+    if (slot->callback) {
+        slot->callback(request->interface, completion->results, completion->result_count, slot->user_data);
+        free(completion->results);
+        completion->results = NULL;
+    }
+    
+    pthread_mutex_lock(&queue->mutex);
+    if (slot->callback) {
+        slot->in_use = 0;
+    } else {
+        slot->finished_order = ++queue->finished;
+        write(queue->completion_fd, &one, sizeof(one));
+    }
+    if (--queue->running == 0) {
+        pthread_cond_broadcast(&queue->idle);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return NULL;
+}
+
+int wifi_scan_async_submit(wifi_scan_queue_t* queue, const wifi_scan_request_t* request,
+                           wifi_scan_callback_t callback, void* user_data) {
+    wifi_scan_slot_t* slot = NULL;
+    pthread_attr_t attr;
+    pthread_t thread;
+    
+    if (!queue || !request || request->interface[0] == '\0') {
+        errno = EINVAL;
+        return -1;
+    }
+    
+    pthread_mutex_lock(&queue->mutex);
+    for (int i = 0; i < WIFI_SCAN_ASYNC_MAX_REQUESTS; i++) {
+        if (!queue->slots[i].in_use) {
+            slot = &queue->slots[i];
+            break;
+        }
+    }
+    if (!slot) {
+        pthread_mutex_unlock(&queue->mutex);
+        errno = EBUSY;
+        return -1;
+    }
+    
+    memset(slot, 0, sizeof(wifi_scan_slot_t));
+    slot->in_use = 1;
+    slot->queue = queue;
+    memcpy(&slot->request, request, sizeof(wifi_scan_request_t));
+    slot->request.interface[INTERFACE_NAME_LEN - 1] = '\0';
+    if (slot->request.frequency_count > SCAN_MAX_FREQUENCIES) slot->request.frequency_count = SCAN_MAX_FREQUENCIES;
+    slot->callback = callback;
+    slot->user_data = user_data;
+    slot->submitted_ms = monotonic_time_ms();
+    if (++queue->next_handle <= 0) queue->next_handle = 1;
+    slot->completion.handle = queue->next_handle;
+    strncpy(slot->completion.interface, slot->request.interface, INTERFACE_NAME_LEN - 1);
+    
+    // Detached: wifi_scan_queue_destroy waits on the running count instead of joining
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attr, wifi_scan_async_worker, slot);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        slot->in_use = 0;
+        pthread_mutex_unlock(&queue->mutex);
+        errno = result;
+        return -1;
+    }
+    queue->running++;
+    int handle = slot->completion.handle;
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return handle;
+}
+
+int wifi_scan_async_reap(wifi_scan_queue_t* queue, wifi_scan_completion_t* completion) {
+    wifi_scan_slot_t* oldest = NULL;
+    uint64_t count;
+    
+    if (!queue || !completion) return 0;
+    
+    pthread_mutex_lock(&queue->mutex);
+    for (int i = 0; i < WIFI_SCAN_ASYNC_MAX_REQUESTS; i++) {
+        wifi_scan_slot_t* slot = &queue->slots[i];
+        if (slot->in_use && slot->finished_order != 0 &&
+            (!oldest || slot->finished_order < oldest->finished_order)) {
+            oldest = slot;
+        }
+    }
+    if (oldest) {
+        memcpy(completion, &oldest->completion, sizeof(wifi_scan_completion_t));
+        oldest->in_use = 0;
+        read(queue->completion_fd, &count, sizeof(count)); // semaphore: takes one
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return oldest ? 1 : 0;
+}
+
+void wifi_scan_completion_release(wifi_scan_completion_t* completion) {
+    if (!completion) return;
+    free(completion->results);
+    completion->results = NULL;
+    completion->result_count = 0;
+}
+
+void wifi_scan_queue_destroy(wifi_scan_queue_t* queue) {
+    if (!queue || queue->completion_fd < 0) return;
+    
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->running > 0) {
+        pthread_cond_wait(&queue->idle, &queue->mutex);
+    }
+    for (int i = 0; i < WIFI_SCAN_ASYNC_MAX_REQUESTS; i++) {
+        if (queue->slots[i].in_use) wifi_scan_completion_release(&queue->slots[i].completion);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    
+    close(queue->completion_fd);
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->idle);
+    memset(queue, 0, sizeof(wifi_scan_queue_t));
+    queue->completion_fd = -1;
+}
+
+static wifi_scan_queue_t callback_queue;
+static pthread_once_t callback_queue_once = PTHREAD_ONCE_INIT;
+
+static void init_callback_queue(void) {
+    if (wifi_scan_queue_init(&callback_queue) != 0) callback_queue.completion_fd = -1;
+}
+
+int wifi_scan_async_callback_start(const char* interface, wifi_scan_callback_t callback, void* user_data) {
+    wifi_scan_request_t request;
+    
+    if (!interface || !callback) {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_once(&callback_queue_once, init_callback_queue);
+    if (callback_queue.completion_fd < 0) return -1;
+    
+    memset(&request, 0, sizeof(request));
+    strncpy(request.interface, interface, INTERFACE_NAME_LEN - 1);
+    return wifi_scan_async_submit(&callback_queue, &request, callback, user_data);
+}
+
+// Worker process: one scan per request until the socket closes or a quit request arrives
+static void scan_worker_main(const char* interface, int sock_fd, wifi_scan_worker_shared_t* shared, pid_t parent) {
+    wifi_scan_worker_msg_t msg;
+    sigset_t empty;
+    
+    setpgid(0, 0);
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != parent) _exit(0);
+    
+    // Ctrl-C is the parent's business; it ends the worker by closing the socket
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGUSR1, SIG_DFL);
+    signal(SIGUSR2, SIG_DFL);
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, NULL);
+    
+    for (;;) {
+        ssize_t len = recv(sock_fd, &msg, sizeof(msg), 0);
+        if (len < 0 && errno == EINTR) continue;
+        if (len != (ssize_t)sizeof(msg) || msg.value != WIFI_SCAN_WORKER_OP_SCAN) break;
+        
+        shared->result_count = perform_scan(interface, shared->results, MAX_SCAN_RESULTS);
+        msg.value = shared->result_count;
+        if (send(sock_fd, &msg, sizeof(msg), MSG_NOSIGNAL) != (ssize_t)sizeof(msg)) break;
+    }
+    _exit(0);
+}
+
+static int scan_worker_spawn(wifi_scan_worker_t* worker) {
+    int fds[2];
+    pid_t parent = getpid();
+    
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) != 0) return -1;
+    
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        scan_worker_main(worker->interface, fds[1], worker->shared, parent);
+    }
+    
+    // Also here, so the group exists before the parent may have to kill it
+    setpgid(pid, pid);
+    close(fds[1]);
+    worker->pid = pid;
+    worker->sock_fd = fds[0];
+    worker->starts++;
+    return 0;
+}
+
+// Kill the worker and its scan, if any, and reap it; the next scan starts a new one
+static void scan_worker_stop(wifi_scan_worker_t* worker, int signo) {
+    if (worker->sock_fd >= 0) close(worker->sock_fd);
+    worker->sock_fd = -1;
+    if (worker->pid > 0) {
+        kill(-worker->pid, signo);
+        while (waitpid(worker->pid, NULL, 0) < 0 && errno == EINTR) {
+        }
+    }
+    worker->pid = 0;
+}
+
+int wifi_scan_worker_init(wifi_scan_worker_t* worker, const char* interface) {
+    if (!worker || !interface) return -1;
+    
+    memset(worker, 0, sizeof(wifi_scan_worker_t));
+    worker->sock_fd = -1;
+    worker->timeout_ms = FORKED_SCAN_TIMEOUT_MS;
+    strncpy(worker->interface, interface, INTERFACE_NAME_LEN - 1);
+    
+    worker->shared = mmap(NULL, sizeof(wifi_scan_worker_shared_t), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (worker->shared == MAP_FAILED) {
+        worker->shared = NULL;
+        return -1;
+    }
+    if (scan_worker_spawn(worker) != 0) {
+        munmap(worker->shared, sizeof(wifi_scan_worker_shared_t));
+        worker->shared = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int wifi_scan_worker_scan(wifi_scan_worker_t* worker, scan_result_t* results, int max_results) {
+    wifi_scan_worker_msg_t msg;
+    
+    if (!worker || !worker->shared || !results) return -1;
+    
+    // A worker that died while idle only shows up when the request cannot be sent
+    for (int attempt = 0;; attempt++) {
+        if (worker->pid <= 0 && scan_worker_spawn(worker) != 0) return -1;
+        
+        msg.sequence = ++worker->sequence;
+        msg.value = WIFI_SCAN_WORKER_OP_SCAN;
+        if (send(worker->sock_fd, &msg, sizeof(msg), MSG_NOSIGNAL) == (ssize_t)sizeof(msg)) break;
+        scan_worker_stop(worker, SIGKILL);
+        if (attempt > 0) return -1;
+    }
+    
+    long long deadline_ms = monotonic_time_ms() + worker->timeout_ms;
+    struct pollfd pfd = {.fd = worker->sock_fd, .events = POLLIN};
+    
+    for (;;) {
+        long long remaining_ms = deadline_ms - monotonic_time_ms();
+        if (remaining_ms <= 0) {
+            // Stalled: a new worker is cheaper than waiting on this one
+            scan_worker_stop(worker, SIGKILL);
+            return -1;
+        }
+        
+        int ready = poll(&pfd, 1, (int)remaining_ms);
+        if (ready < 0) {
+            // Ctrl-C: the reply that is still due will be told apart by its sequence
+            if (errno == EINTR && keep_running) continue;
+            return -1;
+        }
+        if (ready == 0) continue;
+        
+        ssize_t len = recv(worker->sock_fd, &msg, sizeof(msg), MSG_DONTWAIT);
+        if (len < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (len != (ssize_t)sizeof(msg)) {
+            // Crashed mid-scan
+            scan_worker_stop(worker, SIGKILL);
+            return -1;
+        }
+        if (msg.sequence != worker->sequence) continue; // reply to an abandoned request
+        
+        int count = msg.value;
+        if (count > max_results) count = max_results;
+        if (count > 0) memcpy(results, worker->shared->results, count * sizeof(scan_result_t));
+        return count;
+    }
+}
+
+void wifi_scan_worker_destroy(wifi_scan_worker_t* worker) {
+    if (!worker) return;
+    
+    // SIGTERM rather than a quit request: a scan in flight would otherwise run to the end
+    scan_worker_stop(worker, SIGTERM);
+    if (worker->shared) munmap(worker->shared, sizeof(wifi_scan_worker_shared_t));
+    worker->shared = NULL;
+}
+
 // Initialize pipe-based scanning
 int wifi_scan_pipe_based_init(wifi_pipe_scan_context_t* ctx, const char* interface) {
     if (!ctx || !interface) return -1;
@@ -160,6 +544,8 @@ int wifi_scan_pipe_based_init(wifi_pipe_scan_context_t* ctx, const char* interfa
     memset(ctx, 0, sizeof(wifi_pipe_scan_context_t));
     strncpy(ctx->interface, interface, INTERFACE_NAME_LEN - 1);
     ctx->interface[INTERFACE_NAME_LEN - 1] = '\0';
+    ctx->pipe_fd[0] = -1;
+    ctx->pipe_fd[1] = -1;
     
     if (pipe(ctx->pipe_fd) == -1) {
         return -1;
@@ -172,6 +558,208 @@ int wifi_scan_pipe_based_init(wifi_pipe_scan_context_t* ctx, const char* interfa
     return 0;
 }
 
+// Records travel as fixed-width numbers and length-prefixed strings instead of whole
+// scan_result_t structs, which are mostly padding
+static size_t put_record_string(unsigned char* out, const char* value, size_t field_size) {
+    size_t len = strnlen(value, field_size - 1);
+    
+    out[0] = (unsigned char)len;
+    memcpy(out + 1, value, len);
+    return len + 1;
+}
+
+static size_t encode_scan_record(const scan_result_t* result, unsigned char* out) {
+    int32_t frequency = result->frequency;
+    int16_t channel = (int16_t)result->channel;
+    int16_t signal_strength = (int16_t)result->signal_strength;
+    size_t len = 0;
+    
+    memcpy(out + len, &frequency, sizeof(frequency));
+    len += sizeof(frequency);
+    memcpy(out + len, &channel, sizeof(channel));
+    len += sizeof(channel);
+    memcpy(out + len, &signal_strength, sizeof(signal_strength));
+    len += sizeof(signal_strength);
+    out[len++] = (unsigned char)result->quality;
+    len += put_record_string(out + len, result->bssid, sizeof(result->bssid));
+    len += put_record_string(out + len, result->ssid, sizeof(result->ssid));
+    len += put_record_string(out + len, result->security, sizeof(result->security));
+    len += put_record_string(out + len, result->capabilities, sizeof(result->capabilities));
+    len += put_record_string(out + len, result->timestamp, sizeof(result->timestamp));
+    return len;
+}
+
+static int get_record_string(const unsigned char* in, size_t in_len, size_t* offset, char* value, size_t field_size) {
+    if (*offset >= in_len) return -1;
+    size_t len = in[(*offset)++];
+    if (len >= field_size || *offset + len > in_len) return -1;
+    memcpy(value, in + *offset, len);
+    value[len] = '\0';
+    *offset += len;
+    return 0;
+}
+
+static int decode_scan_record(const unsigned char* in, size_t in_len, scan_result_t* result) {
+    int32_t frequency;
+    int16_t channel;
+    int16_t signal_strength;
+    size_t offset = 0;
+    
+    if (in_len < sizeof(frequency) + sizeof(channel) + sizeof(signal_strength) + 1) return -1;
+    memset(result, 0, sizeof(scan_result_t));
+    memcpy(&frequency, in + offset, sizeof(frequency));
+    offset += sizeof(frequency);
+    memcpy(&channel, in + offset, sizeof(channel));
+    offset += sizeof(channel);
+    memcpy(&signal_strength, in + offset, sizeof(signal_strength));
+    offset += sizeof(signal_strength);
+    result->frequency = frequency;
+    result->channel = channel;
+    result->signal_strength = signal_strength;
+    result->quality = in[offset++];
+    
+    if (get_record_string(in, in_len, &offset, result->bssid, sizeof(result->bssid)) != 0 ||
+        get_record_string(in, in_len, &offset, result->ssid, sizeof(result->ssid)) != 0 ||
+        get_record_string(in, in_len, &offset, result->security, sizeof(result->security)) != 0 ||
+        get_record_string(in, in_len, &offset, result->capabilities, sizeof(result->capabilities)) != 0 ||
+        get_record_string(in, in_len, &offset, result->timestamp, sizeof(result->timestamp)) != 0) {
+        return -1;
+    }
+    return offset == in_len ? 0 : -1;
+}
+
+// writev until every byte is out; the pipe takes what fits and blocks the child for the rest
+static int writev_all(int fd, struct iovec* iov, int iov_count) {
+    while (iov_count > 0) {
+        ssize_t written = writev(fd, iov, iov_count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (iov_count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iov_count--;
+        }
+        if (iov_count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+#define PIPE_FRAMES_PER_WRITE 32
+
+static int write_scan_frames(int fd, const scan_result_t* results, int scan_count) {
+    wifi_pipe_frame_header_t headers[PIPE_FRAMES_PER_WRITE + 1];
+    unsigned char payloads[PIPE_FRAMES_PER_WRITE][WIFI_PIPE_MAX_PAYLOAD];
+    struct iovec iov[(PIPE_FRAMES_PER_WRITE + 1) * 2];
+    int32_t status = scan_count;
+    int sent = 0;
+    
+    // Batches of records per writev; the reader decodes each batch while the next is written
+    do {
+        int frames = 0;
+        int iov_count = 0;
+        
+        while (sent < scan_count && frames < PIPE_FRAMES_PER_WRITE) {
+            size_t len = encode_scan_record(&results[sent++], payloads[frames]);
+            headers[frames] = (wifi_pipe_frame_header_t){WIFI_PIPE_FRAME_MAGIC, WIFI_PIPE_FRAME_VERSION,
+                                                         WIFI_PIPE_FRAME_RECORD, (uint32_t)len};
+            iov[iov_count++] = (struct iovec){&headers[frames], sizeof(wifi_pipe_frame_header_t)};
+            iov[iov_count++] = (struct iovec){payloads[frames], len};
+            frames++;
+        }
+        if (sent >= scan_count) {
+            headers[frames] = (wifi_pipe_frame_header_t){WIFI_PIPE_FRAME_MAGIC, WIFI_PIPE_FRAME_VERSION,
+                                                         WIFI_PIPE_FRAME_END, sizeof(status)};
+            iov[iov_count++] = (struct iovec){&headers[frames], sizeof(wifi_pipe_frame_header_t)};
+            iov[iov_count++] = (struct iovec){&status, sizeof(status)};
+        }
+        if (writev_all(fd, iov, iov_count) != 0) return -1;
+    } while (sent < scan_count);
+    
+    return 0;
+}
+
+// Byte ring between the pipe and the frame decoder
+typedef struct {
+    unsigned char data[WIFI_PIPE_RING_SIZE];
+    size_t head;
+    size_t used;
+} pipe_ring_t;
+
+// One readv fills both halves of the free space when it wraps. Returns bytes read, 0 at
+// end of stream, -1 with errno (EAGAIN when the pipe is empty).
+static ssize_t pipe_ring_fill(pipe_ring_t* ring, int fd) {
+    size_t free_space = WIFI_PIPE_RING_SIZE - ring->used;
+    size_t tail = (ring->head + ring->used) % WIFI_PIPE_RING_SIZE;
+    struct iovec iov[2];
+    int iov_count = 1;
+    
+    iov[0].iov_base = ring->data + tail;
+    iov[0].iov_len = (tail + free_space <= WIFI_PIPE_RING_SIZE) ? free_space : WIFI_PIPE_RING_SIZE - tail;
+    if (iov[0].iov_len < free_space) {
+        iov[1].iov_base = ring->data;
+        iov[1].iov_len = free_space - iov[0].iov_len;
+        iov_count = 2;
+    }
+    
+    ssize_t bytes = readv(fd, iov, iov_count);
+    if (bytes > 0) ring->used += bytes;
+    return bytes;
+}
+
+static void pipe_ring_peek(const pipe_ring_t* ring, size_t offset, void* out, size_t len) {
+    size_t start = (ring->head + offset) % WIFI_PIPE_RING_SIZE;
+    size_t first = (start + len <= WIFI_PIPE_RING_SIZE) ? len : WIFI_PIPE_RING_SIZE - start;
+    
+    memcpy(out, ring->data + start, first);
+    memcpy((unsigned char*)out + first, ring->data, len - first);
+}
+
+static void pipe_ring_consume(pipe_ring_t* ring, size_t len) {
+    ring->head = (ring->head + len) % WIFI_PIPE_RING_SIZE;
+    ring->used -= len;
+}
+
+// Decode every complete frame in the ring. Returns 1 once the END frame is in, 0 when more
+// bytes are needed, -1 on a malformed stream.
+static int decode_scan_frames(pipe_ring_t* ring, scan_result_t* results, int max_results,
+                              int* decoded, int* status) {
+    wifi_pipe_frame_header_t header;
+    unsigned char payload[WIFI_PIPE_MAX_PAYLOAD];
+    
+    while (ring->used >= sizeof(header)) {
+        pipe_ring_peek(ring, 0, &header, sizeof(header));
+        if (header.magic != WIFI_PIPE_FRAME_MAGIC || header.version != WIFI_PIPE_FRAME_VERSION ||
+            header.length > WIFI_PIPE_MAX_PAYLOAD) {
+            return -1;
+        }
+        if (ring->used < sizeof(header) + header.length) return 0;
+        
+        pipe_ring_peek(ring, sizeof(header), payload, header.length);
+        pipe_ring_consume(ring, sizeof(header) + header.length);
+        
+        if (header.type == WIFI_PIPE_FRAME_RECORD) {
+            // Records past max_results are read and dropped so the stream stays in step
+            if (*decoded < max_results) {
+                if (decode_scan_record(payload, header.length, &results[*decoded]) != 0) return -1;
+                (*decoded)++;
+            }
+        } else if (header.type == WIFI_PIPE_FRAME_END && header.length == sizeof(int32_t)) {
+            int32_t end_status;
+            memcpy(&end_status, payload, sizeof(end_status));
+            *status = end_status;
+            return 1;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 // Execute pipe-based scanning
 int wifi_scan_pipe_based_execute(wifi_pipe_scan_context_t* ctx, scan_result_t* results, int max_results) {
     if (!ctx || !results) return -1;
@@ -181,60 +769,72 @@ int wifi_scan_pipe_based_execute(wifi_pipe_scan_context_t* ctx, scan_result_t* r
     if (ctx->child_pid == -1) {
         return -1; // Fork failed
     } else if (ctx->child_pid == 0) {
-        // Child process - perform scan and write to pipe
+        // Child process - perform scan and stream it into the pipe
         close(ctx->pipe_fd[0]); // Close read end
+        fcntl(ctx->pipe_fd[1], F_SETFL, 0);
         
         scan_result_t child_results[MAX_SCAN_RESULTS];
         int scan_count = perform_scan(ctx->interface, child_results, MAX_SCAN_RESULTS);
         
-        // Write scan count first
-        write(ctx->pipe_fd[1], &scan_count, sizeof(int));
-        
-        // Write results if any
-        if (scan_count > 0) {
-            size_t results_size = scan_count * sizeof(scan_result_t);
-            write(ctx->pipe_fd[1], child_results, results_size);
-        }
+        int written = write_scan_frames(ctx->pipe_fd[1], child_results, scan_count > 0 ? scan_count : 0);
         
         close(ctx->pipe_fd[1]);
-        exit(scan_count > 0 ? 0 : 1);
+        exit(written == 0 && scan_count > 0 ? 0 : 1);
     } else {
-        // Parent process - read from pipe
+        // Parent process - decode frames as they arrive
         close(ctx->pipe_fd[1]); // Close write end
+        ctx->pipe_fd[1] = -1;
         
+        pipe_ring_t* ring = malloc(sizeof(pipe_ring_t));
         struct pollfd pfd;
         pfd.fd = ctx->pipe_fd[0];
         pfd.events = POLLIN;
+        int decoded = 0;
+        int status = -1;
+        int done = ring ? 0 : -1;
+        long long deadline_ms = monotonic_time_ms() + 15000;
         
-        // Wait for data with timeout (15 seconds)
-        int poll_result = poll(&pfd, 1, 15000);
+        if (ring) {
+            ring->head = 0;
+            ring->used = 0;
+        }
         
-        if (poll_result > 0 && (pfd.revents & POLLIN)) {
-            int scan_count = 0;
-            ssize_t bytes_read = read(ctx->pipe_fd[0], &scan_count, sizeof(int));
+        // Overall timeout of 15 seconds, however the data trickles in
+        while (done == 0) {
+            long long remaining_ms = deadline_ms - monotonic_time_ms();
+            if (remaining_ms <= 0) {
+                done = -1;
+                break;
+            }
             
-            if (bytes_read == sizeof(int) && scan_count > 0) {
-                // Limit to max_results
-                int count_to_read = (scan_count > max_results) ? max_results : scan_count;
-                size_t results_size = count_to_read * sizeof(scan_result_t);
-                
-                ssize_t results_read = read(ctx->pipe_fd[0], results, results_size);
-                if (results_read == (ssize_t)results_size) {
-                    close(ctx->pipe_fd[0]);
-                    
-                    // Wait for child to complete
-                    int status;
-                    waitpid(ctx->child_pid, &status, 0);
-                    
-                    return count_to_read;
-                }
-            } else if (bytes_read == sizeof(int) && scan_count == 0) {
-                // Scan completed but no results
-                close(ctx->pipe_fd[0]);
-                int status;
-                waitpid(ctx->child_pid, &status, 0);
-                return 0;
+            int poll_result = poll(&pfd, 1, (int)remaining_ms);
+            if (poll_result < 0) {
+                if (errno == EINTR && keep_running) continue;
+                done = -1;
+                break;
             }
+            if (poll_result == 0) continue;
+            
+            ssize_t bytes = pipe_ring_fill(ring, ctx->pipe_fd[0]);
+            if (bytes < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            if (bytes <= 0) {
+                done = -1; // Child exited before the END frame
+                break;
+            }
+            done = decode_scan_frames(ring, results, max_results, &decoded, &status);
+        }
+        free(ring);
+        
+        if (done == 1) {
+            close(ctx->pipe_fd[0]);
+            ctx->pipe_fd[0] = -1;
+            
+            // Wait for child to complete
+            int child_status;
+            waitpid(ctx->child_pid, &child_status, 0);
+            ctx->child_pid = 0;
+            
+            return status < 0 ? -1 : decoded;
         }
         
         // Timeout or error - kill child and cleanup
@@ -244,7 +844,9 @@ int wifi_scan_pipe_based_execute(wifi_pipe_scan_context_t* ctx, scan_result_t* r
             kill(ctx->child_pid, SIGKILL);
             waitpid(ctx->child_pid, NULL, 0);
         }
+        ctx->child_pid = 0;
         close(ctx->pipe_fd[0]);
+        ctx->pipe_fd[0] = -1;
         
         return -1;
     }
@@ -259,102 +861,152 @@ int wifi_scan_pipe_based_cleanup(wifi_pipe_scan_context_t* ctx) {
         waitpid(ctx->child_pid, NULL, 0);
     }
     
-    if (ctx->pipe_fd[0] > 0) close(ctx->pipe_fd[0]);
-    if (ctx->pipe_fd[1] > 0) close(ctx->pipe_fd[1]);
+    if (ctx->pipe_fd[0] >= 0) close(ctx->pipe_fd[0]);
+    if (ctx->pipe_fd[1] >= 0) close(ctx->pipe_fd[1]);
     
     memset(ctx, 0, sizeof(wifi_pipe_scan_context_t));
+    ctx->pipe_fd[0] = -1;
+    ctx->pipe_fd[1] = -1;
     return 0;
 }
 
 // Initialize signal-based scanning
 int wifi_scan_signal_based_init(wifi_signal_scan_context_t* ctx, const char* interface) {
+    sigset_t completion;
+    
     if (!ctx || !interface) return -1;
     
     memset(ctx, 0, sizeof(wifi_signal_scan_context_t));
     strncpy(ctx->interface, interface, INTERFACE_NAME_LEN - 1);
     ctx->interface[INTERFACE_NAME_LEN - 1] = '\0';
+    ctx->signal_fd = -1;
     
     // Allocate shared result buffer using mmap
     ctx->result_buffer = (scan_result_t*)mmap(NULL, MAX_SCAN_RESULTS * sizeof(scan_result_t),
                                               PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-    if (ctx->result_buffer == MAP_FAILED) return -1;
+    if (ctx->result_buffer == MAP_FAILED) {
+        ctx->result_buffer = NULL;
+        return -1;
+    }
     
-    ctx->result_count_buffer = (int*)mmap(NULL, sizeof(int),
-                                          PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-    if (ctx->result_count_buffer == MAP_FAILED) {
+    sigemptyset(&completion);
+    sigaddset(&completion, WIFI_SCAN_COMPLETION_SIGNAL);
+    ctx->signal_fd = signalfd(-1, &completion, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (ctx->signal_fd < 0) {
         munmap(ctx->result_buffer, MAX_SCAN_RESULTS * sizeof(scan_result_t));
+        ctx->result_buffer = NULL;
         return -1;
     }
     
-    // Set up signal handlers
-    signal(SIGUSR1, wifi_scan_signal_handler);
-    signal(SIGUSR2, wifi_scan_signal_handler);
-    
-    g_signal_ctx = ctx;
+    return 0;
+}
+
+// Take queued completions; 1 once the one from `child` is among them
+static int read_scan_completion(int signal_fd, pid_t child, int* result_count) {
+    struct signalfd_siginfo info;
     
+    while (read(signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        if ((pid_t)info.ssi_pid == child) {
+            *result_count = info.ssi_int;
+            return 1;
+        }
+        // Otherwise a child abandoned at its timeout finished after all
+    }
     return 0;
 }
 
 // Execute signal-based scanning
 int wifi_scan_signal_based_execute(wifi_signal_scan_context_t* ctx, scan_result_t* results, int max_results) {
-    if (!ctx || !results) return -1;
+    if (!ctx || !results || !ctx->result_buffer || ctx->signal_fd < 0) return -1;
+    
+    sigset_t completion;
+    sigemptyset(&completion);
+    sigaddset(&completion, WIFI_SCAN_COMPLETION_SIGNAL);
+    // Blocked before the child exists, so the signal stays pending for the signalfd instead
+    // of taking its default action (termination)
+    pthread_sigmask(SIG_BLOCK, &completion, NULL);
     
-    ctx->scan_ready = 0;
-    ctx->scan_error = 0;
-    *ctx->result_count_buffer = 0;
+    pid_t parent_pid = getpid();
+    pid_t parent_tid = (pid_t)syscall(SYS_gettid);
     
     ctx->scanner_pid = fork();
     
     if (ctx->scanner_pid == -1) {
+        ctx->scanner_pid = 0;
         return -1;
     } else if (ctx->scanner_pid == 0) {
         // Child process - perform scan
         int scan_count = perform_scan(ctx->interface, ctx->result_buffer, MAX_SCAN_RESULTS);
-        *ctx->result_count_buffer = scan_count;
+        siginfo_t info;
         
-        // Signal parent based on result
-        if (scan_count >= 0) {
-            kill(getppid(), SIGUSR1); // Success (even if 0 results)
-        } else {
-            kill(getppid(), SIGUSR2); // Error
-        }
+        // Thread-directed: other threads of the parent neither see nor steal it
+        memset(&info, 0, sizeof(info));
+        info.si_signo = WIFI_SCAN_COMPLETION_SIGNAL;
+        info.si_code = SI_QUEUE;
+        info.si_pid = getpid();
+        info.si_uid = getuid();
+        info.si_value.sival_int = scan_count;
+        syscall(SYS_rt_tgsigqueueinfo, parent_pid, parent_tid, WIFI_SCAN_COMPLETION_SIGNAL, &info);
         
         exit(scan_count >= 0 ? 0 : 1);
     } else {
-        // Parent process - wait for signal
-        time_t start_time = time(NULL);
+        // Parent process - sleep until the completion signal or the child's exit
+        pid_t child = ctx->scanner_pid;
+        int pidfd = command_pidfd_open(child);
+        long long deadline_ms = monotonic_time_ms() + 15000;
+        int completed = 0;
+        int scan_count = -1;
         
-        while (!ctx->scan_ready && !ctx->scan_error) {
-            usleep(100000); // 100ms
+        while (!completed) {
+            long long remaining = deadline_ms - monotonic_time_ms();
+            if (remaining <= 0) break;
             
-            // Timeout after 15 seconds
-            if (time(NULL) - start_time > 15) {
-                kill(ctx->scanner_pid, SIGTERM);
-                usleep(500000); // 500ms grace period
-                if (waitpid(ctx->scanner_pid, NULL, WNOHANG) == 0) {
-                    kill(ctx->scanner_pid, SIGKILL);
-                    waitpid(ctx->scanner_pid, NULL, 0);
-                }
-                return -1;
+            struct pollfd fds[2] = {{.fd = ctx->signal_fd, .events = POLLIN}, {.fd = pidfd, .events = POLLIN}};
+            // Without a pidfd a crashed child is noticed by waitid once a second
+            int wait_ms = (pidfd < 0 && remaining > 1000) ? 1000 : (int)remaining;
+            int ready = poll(fds, pidfd >= 0 ? 2 : 1, wait_ms);
+            if (ready < 0) {
+                if (errno == EINTR && keep_running) continue;
+                break;
+            }
+            
+            completed = read_scan_completion(ctx->signal_fd, child, &scan_count);
+            if (completed) break;
+            
+            // The signal is queued before the child can exit, so an exit without one is a crash
+            siginfo_t exited;
+            exited.si_pid = 0;
+            if ((pidfd >= 0 && (fds[1].revents & POLLIN)) ||
+                (pidfd < 0 && waitid(P_PID, child, &exited, WEXITED | WNOHANG | WNOWAIT) == 0 && exited.si_pid == child)) {
+                completed = read_scan_completion(ctx->signal_fd, child, &scan_count);
+                break;
             }
         }
+        if (pidfd >= 0) close(pidfd);
         
-        // Copy results
-        int result_count = 0;
-        if (ctx->scan_ready && *ctx->result_count_buffer >= 0) {
-            result_count = *ctx->result_count_buffer;
-            if (result_count > max_results) result_count = max_results;
-            
-            if (result_count > 0) {
-                memcpy(results, ctx->result_buffer, result_count * sizeof(scan_result_t));
+        if (!completed) {
+            kill(child, SIGTERM);
+            usleep(500000); // 500ms grace period
+            if (waitpid(child, NULL, WNOHANG) == 0) {
+                kill(child, SIGKILL);
+                waitpid(child, NULL, 0);
             }
+            ctx->scanner_pid = 0;
+            return -1;
+        }
+        
+        // Copy results
+        int result_count = scan_count > max_results ? max_results : scan_count;
+        if (result_count > 0) {
+            memcpy(results, ctx->result_buffer, result_count * sizeof(scan_result_t));
         }
         
         // Wait for child to complete
         int status;
-        waitpid(ctx->scanner_pid, &status, 0);
+        waitpid(child, &status, 0);
+        ctx->scanner_pid = 0;
         
-        return ctx->scan_ready ? result_count : -1;
+        return scan_count >= 0 ? result_count : -1;
     }
 }
 
@@ -372,17 +1024,12 @@ int wifi_scan_signal_based_cleanup(wifi_signal_scan_context_t* ctx) {
         ctx->result_buffer = NULL;
     }
     
-    if (ctx->result_count_buffer && ctx->result_count_buffer != MAP_FAILED) {
-        munmap(ctx->result_count_buffer, sizeof(int));
-        ctx->result_count_buffer = NULL;
-    }
+    // The completion signal stays blocked: a late one from an abandoned child must not
+    // reach its default action
+    if (ctx->signal_fd >= 0) close(ctx->signal_fd);
     
-    // Reset signal handlers
-    signal(SIGUSR1, SIG_DFL);
-    signal(SIGUSR2, SIG_DFL);
-    
-    g_signal_ctx = NULL;
     memset(ctx, 0, sizeof(wifi_signal_scan_context_t));
+    ctx->signal_fd = -1;
     
     return 0;
 }
@@ -404,30 +1051,28 @@ void wifi_continuous_scan_loop_threaded(const char* interface_name, float delay_
     // Callback function for continuous scanning
     auto void scan_callback(const char* interface, scan_result_t* results, int count, void* user_data) {
         static int scan_number = 1;
+        json_writer_t w;
         
-        printf("{\n");
-        printf("  \"scan_number\": %d,\n", scan_number++);
-        printf("  \"interface\": \"%s\",\n", interface);
-        printf("  \"scan_time\": %ld,\n", time(NULL));
-        printf("  \"scan_method\": \"threaded\",\n");
-        printf("  \"scan_delay\": %.3f,\n", delay_seconds);
-        printf("  \"results_count\": %d,\n", count);
-        printf("  \"scan_results\": [\n");
-        
+        json_writer_init(&w);
+        json_writer_raw(&w, "{\n  \"scan_number\": ");
+        json_writer_int(&w, scan_number++);
+        json_writer_raw(&w, ",\n  \"interface\": ");
+        json_writer_string(&w, interface);
+        json_writer_raw(&w, ",\n  \"scan_time\": ");
+        json_writer_int(&w, time(NULL));
+        json_writer_raw(&w, ",\n  \"scan_method\": \"threaded\",\n  \"scan_delay\": ");
+        json_writer_double(&w, delay_seconds, 3);
+        json_writer_raw(&w, ",\n  \"schedule\": ");
+        json_write_tick_schedule(&w, &ctx.scheduler);
+        json_writer_raw(&w, ",\n  \"results_count\": ");
+        json_writer_int(&w, count);
+        json_writer_raw(&w, ",\n  \"scan_results\": [\n");
         for (int i = 0; i < count; i++) {
-            printf("    {\n");
-            printf("      \"ssid\": \"%s\",\n", results[i].ssid);
-            printf("      \"bssid\": \"%s\",\n", results[i].bssid);
-            printf("      \"frequency\": %d,\n", results[i].frequency);
-            printf("      \"signal_strength\": %d,\n", results[i].signal_strength);
-            printf("      \"quality\": %d,\n", results[i].quality);
-            printf("      \"security\": \"%s\"\n", results[i].security);
-            printf("    }%s\n", (i < count - 1) ? "," : "");
+            json_write_scan_result(&w, &results[i], (i == count - 1));
         }
-        
-        printf("  ]\n");
-        printf("}\n");
-        fflush(stdout);
+        json_writer_raw(&w, "  ]\n}\n");
+        json_writer_flush(&w, STDOUT_FILENO);
+        json_writer_free(&w);
     }
     
     wifi_scan_threaded_continuous_start(&ctx, interface_name, interval_ms, scan_callback, NULL);
@@ -442,7 +1087,8 @@ void wifi_continuous_scan_loop_threaded(const char* interface_name, float delay_
 }
 
 // Enhanced continuous scanning with pipes
-void wifi_continuous_scan_loop_pipe(const char* interface_name, float delay_seconds) {
+// Pipe- and signal-based continuous scans share one persistent worker for the whole run
+static void continuous_scan_loop_worker(const char* interface_name, float delay_seconds, const char* method_label) {
     const float minimum_scan_interval = 0.5;
     if (delay_seconds < minimum_scan_interval) {
         printf("{\"warning\": \"Scan interval too low, increasing to %.1f seconds for hardware stability\"}\n", minimum_scan_interval);
@@ -450,55 +1096,156 @@ void wifi_continuous_scan_loop_pipe(const char* interface_name, float delay_seco
     }
     
     int scan_number = 1;
+    tick_scheduler_t scheduler;
+    wifi_scan_worker_t worker;
+    scan_result_t results[MAX_SCAN_RESULTS];
+    json_writer_t w;
     
-    while (keep_running) {
-        wifi_pipe_scan_context_t ctx;
+    if (wifi_scan_worker_init(&worker, interface_name) != 0) {
+        printf("{\"error\": \"Cannot start scan worker\", \"reason\": \"%s\"}\n", strerror(errno));
+        return;
+    }
+    if (tick_scheduler_init(&scheduler, delay_seconds) != 0) {
+        printf("{\"error\": \"Cannot create scan timer\", \"reason\": \"%s\"}\n", strerror(errno));
+        wifi_scan_worker_destroy(&worker);
+        return;
+    }
+    json_writer_init(&w);
+    
+    while (keep_running && tick_scheduler_wait(&scheduler) > 0) {
+        long long start_time = monotonic_time_ms();
         
-        if (wifi_scan_pipe_based_init(&ctx, interface_name) == 0) {
-            scan_result_t results[MAX_SCAN_RESULTS];
-            clock_t start_time = clock();
-            
-            int scan_count = wifi_scan_pipe_based_execute(&ctx, results, MAX_SCAN_RESULTS);
-            
-            clock_t end_time = clock();
-            int scan_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-            
-            printf("{\n");
-            printf("  \"scan_number\": %d,\n", scan_number++);
-            printf("  \"interface\": \"%s\",\n", interface_name);
-            printf("  \"scan_time\": %ld,\n", time(NULL));
-            printf("  \"scan_method\": \"pipe-based\",\n");
-            printf("  \"scan_duration_ms\": %d,\n", scan_duration_ms);
-            printf("  \"scan_delay\": %.3f,\n", delay_seconds);
-            printf("  \"results_count\": %d,\n", scan_count);
-            printf("  \"scan_results\": [\n");
-            
-            for (int i = 0; i < scan_count; i++) {
-                printf("    {\n");
-                printf("      \"ssid\": \"%s\",\n", results[i].ssid);
-                printf("      \"bssid\": \"%s\",\n", results[i].bssid);
-                printf("      \"frequency\": %d,\n", results[i].frequency);
-                printf("      \"signal_strength\": %d,\n", results[i].signal_strength);
-                printf("      \"quality\": %d,\n", results[i].quality);
-                printf("      \"encryption\": \"%s\"\n", results[i].security);
-                printf("    }%s\n", (i < scan_count - 1) ? "," : "");
-            }
-            
-            printf("  ]\n");
-            printf("}\n");
+        int scan_count = wifi_scan_worker_scan(&worker, results, MAX_SCAN_RESULTS);
+        if (scan_count < 0) {
+            if (!keep_running) break;
+            printf("{\"warning\": \"Scan worker failed, restarting it\", \"scan_number\": %d}\n", scan_number);
             fflush(stdout);
-            
-            wifi_scan_pipe_based_cleanup(&ctx);
+            scan_count = 0;
         }
         
-        if (keep_running) {
-            precise_sleep(delay_seconds);
+        int scan_duration_ms = (int)(monotonic_time_ms() - start_time);
+        
+        json_writer_raw(&w, "{\n  \"scan_number\": ");
+        json_writer_int(&w, scan_number++);
+        json_writer_raw(&w, ",\n  \"interface\": ");
+        json_writer_string(&w, interface_name);
+        json_writer_raw(&w, ",\n  \"scan_time\": ");
+        json_writer_int(&w, time(NULL));
+        json_writer_raw(&w, ",\n  \"scan_method\": ");
+        json_writer_string(&w, method_label);
+        json_writer_raw(&w, ",\n  \"scan_duration_ms\": ");
+        json_writer_int(&w, scan_duration_ms);
+        json_writer_raw(&w, ",\n  \"scan_delay\": ");
+        json_writer_double(&w, delay_seconds, 3);
+        json_writer_raw(&w, ",\n  \"worker_restarts\": ");
+        json_writer_int(&w, worker.starts - 1);
+        json_writer_raw(&w, ",\n  \"schedule\": ");
+        json_write_tick_schedule(&w, &scheduler);
+        json_writer_raw(&w, ",\n  \"results_count\": ");
+        json_writer_int(&w, scan_count);
+        json_writer_raw(&w, ",\n  \"scan_results\": [\n");
+        for (int i = 0; i < scan_count; i++) {
+            json_write_scan_result(&w, &results[i], (i == scan_count - 1));
         }
+        json_writer_raw(&w, "  ]\n}\n");
+        json_writer_flush(&w, STDOUT_FILENO);
     }
+    json_writer_free(&w);
+    tick_scheduler_close(&scheduler);
+    wifi_scan_worker_destroy(&worker);
+}
+
+void wifi_continuous_scan_loop_pipe(const char* interface_name, float delay_seconds) {
+    continuous_scan_loop_worker(interface_name, delay_seconds, "pipe-based");
 }
 
-// Enhanced continuous scanning with signals
 void wifi_continuous_scan_loop_signal(const char* interface_name, float delay_seconds) {
+    continuous_scan_loop_worker(interface_name, delay_seconds, "signal-based");
+}
+
+// Schedule of the timer-based loop running in this thread, for its callback to report
+static __thread const tick_scheduler_t* g_timer_schedule = NULL;
+
+const tick_scheduler_t* wifi_continuous_scan_current_schedule(void) {
+    return g_timer_schedule;
+}
+
+// Continuous scanning on a worker thread while the calling thread waits for shutdown
+int wifi_continuous_scan_threaded(const char* interface, int interval_ms, 
+                                  wifi_scan_callback_t callback, void* user_data) {
+    wifi_scan_context_t ctx;
+    
+    wifi_scan_context_init(&ctx);
+    if (wifi_scan_threaded_continuous_start(&ctx, interface, interval_ms, callback, user_data) != 0) {
+        wifi_scan_context_destroy(&ctx);
+        return -1;
+    }
+    
+    while (keep_running) {
+        usleep(100000); // 100ms
+    }
+    
+    wifi_scan_threaded_async_stop(&ctx);
+    wifi_scan_context_destroy(&ctx);
+    return 0;
+}
+
+// Continuous scanning on fixed-rate timer ticks in the calling thread
+int wifi_continuous_scan_timer_based(const char* interface, int interval_ms, 
+                                     wifi_scan_callback_t callback, void* user_data) {
+    tick_scheduler_t scheduler;
+    scan_result_t results[MAX_SCAN_RESULTS];
+    int status = 0;
+    
+    if (!interface || interval_ms <= 0) return -1;
+    if (tick_scheduler_init(&scheduler, interval_ms / 1000.0) != 0) return -1;
+    
+    g_timer_schedule = &scheduler;
+    while (keep_running) {
+        int tick = tick_scheduler_wait(&scheduler);
+        if (tick <= 0) {
+            status = tick;
+            break;
+        }
+        
+        int count = perform_forked_scan(interface, results, MAX_SCAN_RESULTS);
+        if (callback) {
+            callback(interface, results, count, user_data);
+        }
+    }
+    g_timer_schedule = NULL;
+    
+    tick_scheduler_close(&scheduler);
+    return status;
+}
+
+static void print_timer_scan(const char* interface, scan_result_t* results, int count, void* user_data) {
+    int* scan_number = (int*)user_data;
+    const tick_scheduler_t* schedule = wifi_continuous_scan_current_schedule();
+    
+    printf("{\n");
+    printf("  \"scan_number\": %d,\n", (*scan_number)++);
+    printf("  \"interface\": \"%s\",\n", interface);
+    printf("  \"scan_time\": %ld,\n", time(NULL));
+    printf("  \"scan_method\": \"timer\",\n");
+    printf("  \"scan_delay\": %.3f,\n", schedule->period_ns / 1e9);
+    printf("  \"schedule\": ");
+    print_tick_schedule_json(schedule);
+    printf(",\n");
+    printf("  \"results_count\": %d,\n", count);
+    printf("  \"scan_results\": [\n");
+    
+    for (int i = 0; i < count; i++) {
+        print_scan_result_json(&results[i], (i == count - 1));
+    }
+    
+    printf("  ]\n");
+    printf("}\n");
+    fflush(stdout);
+}
+
+// Enhanced continuous scanning on timer ticks
+void wifi_continuous_scan_loop_timer(const char* interface_name, float delay_seconds) {
     const float minimum_scan_interval = 0.5;
     if (delay_seconds < minimum_scan_interval) {
         printf("{\"warning\": \"Scan interval too low, increasing to %.1f seconds for hardware stability\"}\n", minimum_scan_interval);
@@ -506,61 +1253,281 @@ void wifi_continuous_scan_loop_signal(const char* interface_name, float delay_se
     }
     
     int scan_number = 1;
+    if (wifi_continuous_scan_timer_based(interface_name, (int)(delay_seconds * 1000), print_timer_scan, &scan_number) < 0) {
+        printf("{\"error\": \"Cannot create scan timer\", \"reason\": \"%s\"}\n", strerror(errno));
+    }
+}
+
+static const char* async_status_name(wifi_scan_async_status_t status) {
+    switch (status) {
+        case WIFI_SCAN_ASYNC_DONE: return "done";
+        case WIFI_SCAN_ASYNC_TIMED_OUT: return "timed_out";
+        default: return "failed";
+    }
+}
+
+// All requests go out together; completions print in the order they finish
+void wifi_scan_async_loop(const char* const* interfaces, int interface_count,
+                          const int* frequencies, int frequency_count, uint32_t band_mask, int deadline_ms) {
+    wifi_scan_queue_t queue;
+    wifi_scan_request_t request;
+    wifi_scan_completion_t completion;
+    json_writer_t w;
+    int submitted = 0;
+    int completed = 0;
     
-    while (keep_running) {
-        wifi_signal_scan_context_t ctx;
+    if (wifi_scan_queue_init(&queue) != 0) {
+        printf("{\"error\": \"Cannot create completion queue\", \"reason\": \"%s\"}\n", strerror(errno));
+        return;
+    }
+    if (frequency_count > SCAN_MAX_FREQUENCIES) frequency_count = SCAN_MAX_FREQUENCIES;
+    
+    json_writer_init(&w);
+    long long start_ms = monotonic_time_ms();
+    for (int i = 0; i < interface_count; i++) {
+        memset(&request, 0, sizeof(request));
+        strncpy(request.interface, interfaces[i], INTERFACE_NAME_LEN - 1);
+        memcpy(request.frequencies, frequencies, frequency_count * sizeof(int));
+        request.frequency_count = frequency_count;
+        request.band_mask = band_mask;
+        request.deadline_ms = deadline_ms;
         
-        if (wifi_scan_signal_based_init(&ctx, interface_name) == 0) {
-            scan_result_t results[MAX_SCAN_RESULTS];
-            clock_t start_time = clock();
-            
-            int scan_count = wifi_scan_signal_based_execute(&ctx, results, MAX_SCAN_RESULTS);
-            
-            clock_t end_time = clock();
-            int scan_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-            
-            printf("{\n");
-            printf("  \"scan_number\": %d,\n", scan_number++);
-            printf("  \"interface\": \"%s\",\n", interface_name);
-            printf("  \"scan_time\": %ld,\n", time(NULL));
-            printf("  \"scan_method\": \"signal-based\",\n");
-            printf("  \"scan_duration_ms\": %d,\n", scan_duration_ms);
-            printf("  \"scan_delay\": %.3f,\n", delay_seconds);
-            printf("  \"results_count\": %d,\n", scan_count);
-            printf("  \"scan_results\": [\n");
-            
-            for (int i = 0; i < scan_count; i++) {
-                printf("    {\n");
-                printf("      \"ssid\": \"%s\",\n", results[i].ssid);
-                printf("      \"bssid\": \"%s\",\n", results[i].bssid);
-                printf("      \"frequency\": %d,\n", results[i].frequency);
-                printf("      \"signal_strength\": %d,\n", results[i].signal_strength);
-                printf("      \"quality\": %d,\n", results[i].quality);
-                printf("      \"encryption\": \"%s\"\n", results[i].security);
-                printf("    }%s\n", (i < scan_count - 1) ? "," : "");
+        int handle = wifi_scan_async_submit(&queue, &request, NULL, NULL);
+        if (handle < 0) {
+            json_writer_raw(&w, "{\"error\": \"Cannot submit scan\", \"interface\": ");
+            json_writer_string(&w, interfaces[i]);
+            json_writer_raw(&w, ", \"reason\": ");
+            json_writer_string(&w, strerror(errno));
+            json_writer_raw(&w, "}\n");
+            continue;
+        }
+        json_writer_raw(&w, "{\"status\": \"submitted\", \"handle\": ");
+        json_writer_int(&w, handle);
+        json_writer_raw(&w, ", \"interface\": ");
+        json_writer_string(&w, interfaces[i]);
+        json_writer_raw(&w, "}\n");
+        submitted++;
+    }
+    json_writer_flush(&w, STDOUT_FILENO);
+    
+    // This thread only sleeps in poll between completions; it could be doing other work
+    while (completed < submitted && keep_running) {
+        struct pollfd pfd = {.fd = queue.completion_fd, .events = POLLIN};
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        while (wifi_scan_async_reap(&queue, &completion)) {
+            json_writer_raw(&w, "{\n  \"scan_method\": \"async\",\n  \"handle\": ");
+            json_writer_int(&w, completion.handle);
+            json_writer_raw(&w, ",\n  \"interface\": ");
+            json_writer_string(&w, completion.interface);
+            json_writer_raw(&w, ",\n  \"status\": ");
+            json_writer_string(&w, async_status_name(completion.status));
+            json_writer_raw(&w, ",\n  \"queued_ms\": ");
+            json_writer_int(&w, completion.queued_ms);
+            json_writer_raw(&w, ",\n  \"duration_ms\": ");
+            json_writer_int(&w, completion.duration_ms);
+            json_writer_raw(&w, ",\n  \"phases\": ");
+            json_write_scan_timing(&w, &completion.timing);
+            json_writer_raw(&w, ",\n  \"results_count\": ");
+            json_writer_int(&w, completion.result_count);
+            json_writer_raw(&w, ",\n  \"scan_results\": [\n");
+            for (int i = 0; i < completion.result_count; i++) {
+                json_write_scan_result(&w, &completion.results[i], (i == completion.result_count - 1));
             }
+            json_writer_raw(&w, "  ]\n}\n");
+            json_writer_flush(&w, STDOUT_FILENO);
             
-            printf("  ]\n");
-            printf("}\n");
-            fflush(stdout);
-            
-            wifi_scan_signal_based_cleanup(&ctx);
+            wifi_scan_completion_release(&completion);
+            completed++;
+        }
+    }
+    
+    printf("{\"status\": \"async_finished\", \"submitted\": %d, \"completed\": %d, \"wall_ms\": %lld}\n",
+           submitted, completed, monotonic_time_ms() - start_ms);
+    fflush(stdout);
+    json_writer_free(&w);
+    wifi_scan_queue_destroy(&queue);
+}
+
+static const char* const scan_method_names[WIFI_SCAN_METHOD_COUNT] = {
+    "direct", "threaded", "pipe", "signal", "async", "forked"
+};
+
+const char* wifi_scan_method_name(wifi_scan_method_t method) {
+    if ((int)method < 0 || method >= WIFI_SCAN_METHOD_COUNT) return "unknown";
+    return scan_method_names[method];
+}
+
+int wifi_scan_method_from_name(const char* name) {
+    for (int i = 0; name && i < WIFI_SCAN_METHOD_COUNT; i++) {
+        if (strcmp(name, scan_method_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int scan_threaded_once(const char* interface, scan_result_t* results, int max_results) {
+    wifi_scan_context_t* ctx = malloc(sizeof(wifi_scan_context_t));
+    int count = -1;
+    
+    if (!ctx) return -1;
+    wifi_scan_context_init(ctx);
+    if (wifi_scan_threaded_async_start(ctx, interface, NULL, NULL) == 0) {
+        // Let the single scan finish; async_stop would cancel it before it starts
+        pthread_join(ctx->thread_id, NULL);
+        ctx->thread_id = 0;
+        wifi_scan_threaded_async_stop(ctx);
+        const wifi_scan_buffer_t* latest = wifi_scan_context_latest(ctx);
+        if (latest) {
+            count = latest->result_count < max_results ? latest->result_count : max_results;
+            if (count > 0) memcpy(results, latest->results, count * sizeof(scan_result_t));
         }
+    }
+    wifi_scan_context_destroy(ctx);
+    free(ctx);
+    return count;
+}
+
+static int scan_async_once(const char* interface, scan_result_t* results, int max_results) {
+    wifi_scan_queue_t* queue = malloc(sizeof(wifi_scan_queue_t));
+    wifi_scan_request_t request;
+    wifi_scan_completion_t completion;
+    int count = -1;
+    
+    if (!queue) return -1;
+    if (wifi_scan_queue_init(queue) != 0) {
+        free(queue);
+        return -1;
+    }
+    
+    memset(&request, 0, sizeof(request));
+    strncpy(request.interface, interface, INTERFACE_NAME_LEN - 1);
+    if (wifi_scan_async_submit(queue, &request, NULL, NULL) > 0) {
+        struct pollfd pfd = {.fd = queue->completion_fd, .events = POLLIN};
         
-        if (keep_running) {
-            precise_sleep(delay_seconds);
+        // The request's own deadline guarantees a completion
+        while (poll(&pfd, 1, -1) < 0 && errno == EINTR) {
         }
+        if (wifi_scan_async_reap(queue, &completion) == 1) {
+            if (completion.status != WIFI_SCAN_ASYNC_FAILED) {
+                count = completion.result_count < max_results ? completion.result_count : max_results;
+                if (count > 0) memcpy(results, completion.results, count * sizeof(scan_result_t));
+            }
+            wifi_scan_completion_release(&completion);
+        }
+    }
+    wifi_scan_queue_destroy(queue);
+    free(queue);
+    return count;
+}
+
+int wifi_scan_with_method(wifi_scan_method_t method, const char* interface,
+                          scan_result_t* results, int max_results) {
+    if (!interface || !results) return -1;
+    
+    switch (method) {
+    case WIFI_SCAN_METHOD_DIRECT:
+        return wifi_scan_direct_sync(interface, results, max_results);
+    case WIFI_SCAN_METHOD_THREADED:
+        return scan_threaded_once(interface, results, max_results);
+    case WIFI_SCAN_METHOD_PIPE: {
+        wifi_pipe_scan_context_t ctx;
+        if (wifi_scan_pipe_based_init(&ctx, interface) != 0) return -1;
+        int count = wifi_scan_pipe_based_execute(&ctx, results, max_results);
+        wifi_scan_pipe_based_cleanup(&ctx);
+        return count;
+    }
+    case WIFI_SCAN_METHOD_SIGNAL_BASED: {
+        wifi_signal_scan_context_t ctx;
+        if (wifi_scan_signal_based_init(&ctx, interface) != 0) return -1;
+        int count = wifi_scan_signal_based_execute(&ctx, results, max_results);
+        wifi_scan_signal_based_cleanup(&ctx);
+        return count;
+    }
+    case WIFI_SCAN_METHOD_ASYNC_CALLBACK:
+        return scan_async_once(interface, results, max_results);
+    case WIFI_SCAN_METHOD_FORKED_SHM:
+        return perform_forked_scan(interface, results, max_results);
+    }
+    return -1;
+}
+
+// Keyed by driver too, so a winner measured on one adapter is not applied to another
+// that later gets the same interface name. Kept with the persistent state so the choice
+// survives a reboot.
+static void build_choice_path(const char* interface, const char* driver, char* path, size_t size) {
+    snprintf(path, size, "%s/scan_method_%s_%s.choice", PERSISTENT_STATE_DIR, interface, driver);
+}
+
+int wifi_scan_method_load_choice(const char* interface, wifi_scan_method_choice_t* choice) {
+    char driver[WIFI_SCAN_METHOD_DRIVER_LEN];
+    char path[384];
+    
+    if (!interface || !choice) return -1;
+    wiphy_get_driver_name(interface, driver, sizeof(driver));
+    build_choice_path(interface, driver, path, sizeof(path));
+    
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, choice, sizeof(wifi_scan_method_choice_t));
+    close(fd);
+    
+    if (len != (ssize_t)sizeof(wifi_scan_method_choice_t) ||
+        choice->magic != WIFI_SCAN_METHOD_CHOICE_MAGIC || choice->version != WIFI_SCAN_METHOD_CHOICE_VERSION ||
+        strcmp(choice->interface, interface) != 0 || strcmp(choice->driver, driver) != 0 ||
+        (int)choice->method < 0 || choice->method >= WIFI_SCAN_METHOD_COUNT) {
+        return -1;
+    }
+    return 0;
+}
+
+// Write to a temporary file and rename so concurrent readers never see partial data
+int wifi_scan_method_store_choice(wifi_scan_method_choice_t* choice) {
+    char path[384];
+    char tmp_path[400];
+    
+    if (!choice || ensure_persistent_state_dir() != 0) return -1;
+    
+    choice->magic = WIFI_SCAN_METHOD_CHOICE_MAGIC;
+    choice->version = WIFI_SCAN_METHOD_CHOICE_VERSION;
+    wiphy_get_driver_name(choice->interface, choice->driver, sizeof(choice->driver));
+    build_choice_path(choice->interface, choice->driver, path, sizeof(path));
+    
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, getpid());
+    int fd = create_state_file(tmp_path, 0644);
+    if (fd < 0) return -1;
+    
+    ssize_t written = write(fd, choice, sizeof(wifi_scan_method_choice_t));
+    close(fd);
+    
+    if (written != (ssize_t)sizeof(wifi_scan_method_choice_t) || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return -1;
     }
+    return 0;
 }
 
-// Select optimal scan method based on system capabilities
+static int configured_method = -1;
+
+// Select the scan method measured best on this interface and driver
 wifi_scan_method_t wifi_select_optimal_scan_method(const char* interface) {
-    // For now, default to threaded method as it's most reliable
+    wifi_scan_method_choice_t choice;
+    
+    if (configured_method >= 0) return (wifi_scan_method_t)configured_method;
+    if (interface && wifi_scan_method_load_choice(interface, &choice) == 0) return choice.method;
+    
+    // Not benchmarked yet: threaded is the most reliable default
     return WIFI_SCAN_METHOD_THREADED;
 }
 
 // Configure scan method
 int wifi_configure_scan_method(wifi_scan_method_t method) {
-    // Configuration can be added here for different methods
+    if ((int)method != -1 && ((int)method < 0 || method >= WIFI_SCAN_METHOD_COUNT)) {
+        errno = EINVAL;
+        return -1;
+    }
+    configured_method = (int)method;
     return 0;
 }
\ No newline at end of file
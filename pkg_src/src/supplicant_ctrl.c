@@ -0,0 +1,480 @@
+#include "supplicant_ctrl.h"
+#include "wpa_config.h"
+#include <poll.h>
+#include <ctype.h>
+#include <sys/socket.h>
+
+static int ctrl_socket_counter = 0;
+
+static const char *describe_reason_code(int reason) {
+    switch (reason) {
+        case 1: return "unspecified";
+        case 2: return "previous authentication no longer valid";
+        case 3: return "deauthenticated because station is leaving";
+        case 4: return "disassociated due to inactivity";
+        case 6: case 7: return "class frame received from nonassociated station";
+        case 8: return "disassociated because station is leaving";
+        case 14: return "message integrity code failure";
+        case 15: return "4-way handshake timeout - pre-shared key may be incorrect";
+        case 16: return "group key handshake timeout";
+        case 23: return "IEEE 802.1X authentication failed";
+        default: return "see IEEE 802.11 reason code";
+    }
+}
+
+// Extract "key=value" from an event line (value ends at whitespace)
+static int get_event_field(const char *event, const char *key, char *value, size_t value_size) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "%s=", key);
+
+    const char *start = strstr(event, pattern);
+    if (!start || value_size == 0) return -1;
+
+    start += strlen(pattern);
+    size_t len = strcspn(start, " \t\n");
+    if (len >= value_size) len = value_size - 1;
+    memcpy(value, start, len);
+    value[len] = '\0';
+    return 0;
+}
+
+int supplicant_ctrl_open(supplicant_ctrl_t *ctrl, const char *ctrl_dir, const char *interface_name) {
+    struct sockaddr_un local;
+    struct sockaddr_un remote;
+
+    if (!ctrl || !interface_name) return -1;
+
+    memset(ctrl, 0, sizeof(supplicant_ctrl_t));
+    strncpy(ctrl->interface_name, interface_name, MAX_INTERFACE_NAME - 1);
+    ctrl->target_network_id = -1;
+
+    // The reply socket lives in the private runtime directory: a predictable name in /tmp
+    // could be pre-created or raced by another user between the unlink and the bind
+    if (ensure_runtime_state_dir() != 0) return -1;
+
+    ctrl->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (ctrl->fd < 0) return -1;
+
+    memset(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    snprintf(ctrl->local_path, sizeof(ctrl->local_path), RUNTIME_STATE_DIR "/wpa_ctrl_%d_%d",
+             getpid(), __sync_fetch_and_add(&ctrl_socket_counter, 1));
+    strncpy(local.sun_path, ctrl->local_path, sizeof(local.sun_path) - 1);
+    unlink(ctrl->local_path);
+
+    if (bind(ctrl->fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        close(ctrl->fd);
+        ctrl->fd = -1;
+        return -1;
+    }
+
+    memset(&remote, 0, sizeof(remote));
+    remote.sun_family = AF_UNIX;
+    snprintf(remote.sun_path, sizeof(remote.sun_path), "%s/%s",
+             ctrl_dir ? ctrl_dir : SUPPLICANT_CTRL_DIR, interface_name);
+
+    if (connect(ctrl->fd, (struct sockaddr *)&remote, sizeof(remote)) < 0) {
+        close(ctrl->fd);
+        unlink(ctrl->local_path);
+        ctrl->fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+// The control socket appears only once the daemon has initialized the interface
+int supplicant_ctrl_open_wait(supplicant_ctrl_t *ctrl, const char *ctrl_dir, const char *interface_name, int timeout_ms) {
+    long long deadline = monotonic_time_ms() + timeout_ms;
+    char reply[64];
+
+    while (1) {
+        if (supplicant_ctrl_open(ctrl, ctrl_dir, interface_name) == 0) {
+            if (supplicant_ctrl_request(ctrl, "PING", reply, sizeof(reply), 500) > 0 &&
+                strncmp(reply, "PONG", 4) == 0) {
+                return 0;
+            }
+            supplicant_ctrl_close(ctrl);
+        }
+
+        if (monotonic_time_ms() >= deadline) {
+            return -1;
+        }
+        precise_sleep(0.02);
+    }
+}
+
+void supplicant_ctrl_close(supplicant_ctrl_t *ctrl) {
+    if (!ctrl || ctrl->fd < 0) return;
+
+    if (ctrl->attached) {
+        char reply[16];
+        supplicant_ctrl_request(ctrl, "DETACH", reply, sizeof(reply), 500);
+    }
+    close(ctrl->fd);
+    unlink(ctrl->local_path);
+    ctrl->fd = -1;
+    ctrl->attached = 0;
+}
+
+static void queue_pending_event(supplicant_ctrl_t *ctrl, const char *event) {
+    if (ctrl->pending_count >= SUPPLICANT_CTRL_PENDING_EVENTS) {
+        // Drop the oldest event to keep the most recent state transitions
+        memmove(ctrl->pending[0], ctrl->pending[1],
+                sizeof(ctrl->pending[0]) * (SUPPLICANT_CTRL_PENDING_EVENTS - 1));
+        ctrl->pending_count--;
+    }
+    strncpy(ctrl->pending[ctrl->pending_count], event, SUPPLICANT_CTRL_EVENT_LEN - 1);
+    ctrl->pending[ctrl->pending_count][SUPPLICANT_CTRL_EVENT_LEN - 1] = '\0';
+    ctrl->pending_count++;
+}
+
+// Send a command and wait for its reply; returns reply length or -1
+int supplicant_ctrl_request(supplicant_ctrl_t *ctrl, const char *command, char *reply, size_t reply_size, int timeout_ms) {
+    char buffer[SUPPLICANT_CTRL_REPLY_LEN];
+    long long deadline = monotonic_time_ms() + timeout_ms;
+
+    if (!ctrl || ctrl->fd < 0) return -1;
+
+    if (send(ctrl->fd, command, strlen(command), 0) < 0) {
+        return -1;
+    }
+
+    while (1) {
+        struct pollfd pfd = { ctrl->fd, POLLIN, 0 };
+        int remaining = (int)(deadline - monotonic_time_ms());
+        if (remaining <= 0) return -1;
+
+        int poll_result = poll(&pfd, 1, remaining);
+        if (poll_result < 0 && errno == EINTR) continue;
+        if (poll_result <= 0) return -1;
+
+        ssize_t len = recv(ctrl->fd, buffer, sizeof(buffer) - 1, 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buffer[len] = '\0';
+
+        // Attached sockets interleave "<level>EVENT" messages with replies
+        if (ctrl->attached && len > 0 && buffer[0] == '<') {
+            queue_pending_event(ctrl, buffer);
+            continue;
+        }
+
+        if (reply && reply_size > 0) {
+            size_t copy_len = ((size_t)len < reply_size - 1) ? (size_t)len : reply_size - 1;
+            memcpy(reply, buffer, copy_len);
+            reply[copy_len] = '\0';
+        }
+        return (int)len;
+    }
+}
+
+int supplicant_ctrl_attach(supplicant_ctrl_t *ctrl) {
+    char reply[16];
+
+    if (supplicant_ctrl_request(ctrl, "ATTACH", reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) < 0 ||
+        strncmp(reply, "OK", 2) != 0) {
+        return -1;
+    }
+    ctrl->attached = 1;
+    return 0;
+}
+
+// Returns event length, 0 on timeout, -1 on error; the "<level>" prefix is stripped
+int supplicant_ctrl_receive_event(supplicant_ctrl_t *ctrl, char *event, size_t event_size, int timeout_ms) {
+    char buffer[SUPPLICANT_CTRL_REPLY_LEN];
+    const char *message = buffer;
+
+    if (ctrl->pending_count > 0) {
+        strncpy(buffer, ctrl->pending[0], sizeof(buffer) - 1);
+        buffer[sizeof(buffer) - 1] = '\0';
+        memmove(ctrl->pending[0], ctrl->pending[1],
+                sizeof(ctrl->pending[0]) * (SUPPLICANT_CTRL_PENDING_EVENTS - 1));
+        ctrl->pending_count--;
+    } else {
+        struct pollfd pfd = { ctrl->fd, POLLIN, 0 };
+        int poll_result = poll(&pfd, 1, timeout_ms);
+        if (poll_result == 0 || (poll_result < 0 && errno == EINTR)) return 0;
+        if (poll_result < 0) return -1;
+
+        ssize_t len = recv(ctrl->fd, buffer, sizeof(buffer) - 1, 0);
+        if (len < 0) return (errno == EINTR) ? 0 : -1;
+        buffer[len] = '\0';
+    }
+
+    if (message[0] == '<') {
+        const char *end = strchr(message, '>');
+        if (end) message = end + 1;
+    }
+
+    strncpy(event, message, event_size - 1);
+    event[event_size - 1] = '\0';
+    event[strcspn(event, "\n")] = '\0';
+    return (int)strlen(event) > 0 ? (int)strlen(event) : 1;
+}
+
+supplicant_event_type_t supplicant_classify_event(const char *event) {
+    if (strstr(event, "CTRL-EVENT-CONNECTED")) return SUPPLICANT_EVENT_CONNECTED;
+    if (strstr(event, "CTRL-EVENT-DISCONNECTED")) return SUPPLICANT_EVENT_DISCONNECTED;
+    if (strstr(event, "CTRL-EVENT-SSID-TEMP-DISABLED")) return SUPPLICANT_EVENT_SSID_TEMP_DISABLED;
+    if (strstr(event, "CTRL-EVENT-ASSOC-REJECT")) return SUPPLICANT_EVENT_ASSOC_REJECT;
+    if (strstr(event, "CTRL-EVENT-AUTH-REJECT")) return SUPPLICANT_EVENT_AUTH_REJECT;
+    if (strstr(event, "CTRL-EVENT-NETWORK-NOT-FOUND")) return SUPPLICANT_EVENT_NETWORK_NOT_FOUND;
+    if (strstr(event, "CTRL-EVENT-TERMINATING")) return SUPPLICANT_EVENT_TERMINATING;
+    if (strstr(event, "Trying to associate") || strstr(event, "SME: Trying to authenticate")) return SUPPLICANT_EVENT_ASSOCIATING;
+    if (strstr(event, "Associated with")) return SUPPLICANT_EVENT_ASSOCIATED;
+    if (strstr(event, "WPA: Key negotiation completed")) return SUPPLICANT_EVENT_KEY_NEGOTIATED;
+    return SUPPLICANT_EVENT_OTHER;
+}
+
+// Find one "field=value" line in a STATUS-style reply
+int supplicant_reply_get_field(const char *reply, const char *field, char *value, size_t value_size) {
+    size_t field_len = strlen(field);
+    const char *line = reply;
+
+    while (line && *line) {
+        const char *next = strchr(line, '\n');
+        if (strncmp(line, field, field_len) == 0 && line[field_len] == '=') {
+            const char *start = line + field_len + 1;
+            size_t len = next ? (size_t)(next - start) : strlen(start);
+            if (len >= value_size) len = value_size - 1;
+            memcpy(value, start, len);
+            value[len] = '\0';
+            return 0;
+        }
+        line = next ? next + 1 : NULL;
+    }
+    return -1;
+}
+
+// Read one "field=value" line of the STATUS reply
+int supplicant_ctrl_get_status_field(supplicant_ctrl_t *ctrl, const char *field, char *value, size_t value_size) {
+    char reply[SUPPLICANT_CTRL_REPLY_LEN];
+
+    if (supplicant_ctrl_request(ctrl, "STATUS", reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) <= 0) {
+        return -1;
+    }
+    return supplicant_reply_get_field(reply, field, value, value_size);
+}
+
+static int request_expect_ok(supplicant_ctrl_t *ctrl, const char *command) {
+    char reply[64];
+
+    if (supplicant_ctrl_request(ctrl, command, reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) <= 0) {
+        return -1;
+    }
+    return (strncmp(reply, "OK", 2) == 0) ? 0 : -1;
+}
+
+// Returns the new network id, or -1 (a half-configured network is removed again)
+int supplicant_ctrl_add_network(supplicant_ctrl_t *ctrl, const char *ssid, const char *psk_hex) {
+    char reply[64];
+    char command[256];
+    char ssid_hex[MAX_SSID_LEN * 2 + 1];
+
+    if (supplicant_ctrl_request(ctrl, "ADD_NETWORK", reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) <= 0 ||
+        !isdigit((unsigned char)reply[0])) {
+        return -1;
+    }
+    int network_id = atoi(reply);
+
+    wpa_config_hex_ssid(ssid, ssid_hex, sizeof(ssid_hex));
+    snprintf(command, sizeof(command), "SET_NETWORK %d ssid %s", network_id, ssid_hex);
+    int result = request_expect_ok(ctrl, command);
+
+    if (result == 0 && psk_hex) {
+        snprintf(command, sizeof(command), "SET_NETWORK %d key_mgmt WPA-PSK", network_id);
+        result = request_expect_ok(ctrl, command);
+        if (result == 0) {
+            snprintf(command, sizeof(command), "SET_NETWORK %d psk %s", network_id, psk_hex);
+            result = request_expect_ok(ctrl, command);
+        }
+    } else if (result == 0) {
+        snprintf(command, sizeof(command), "SET_NETWORK %d key_mgmt NONE", network_id);
+        result = request_expect_ok(ctrl, command);
+    }
+
+    if (result != 0) {
+        supplicant_ctrl_remove_network(ctrl, network_id);
+        return -1;
+    }
+    return network_id;
+}
+
+int supplicant_ctrl_select_network(supplicant_ctrl_t *ctrl, int network_id) {
+    char command[64];
+
+    snprintf(command, sizeof(command), "SELECT_NETWORK %d", network_id);
+    if (request_expect_ok(ctrl, command) != 0) return -1;
+    ctrl->target_network_id = network_id;
+    return 0;
+}
+
+int supplicant_ctrl_select_network_pinned(supplicant_ctrl_t *ctrl, int network_id, const char *bssid, int frequency) {
+    char command[96];
+
+    if (bssid && bssid[0]) {
+        snprintf(command, sizeof(command), "BSSID %d %s", network_id, bssid);
+        if (request_expect_ok(ctrl, command) != 0) return -1;
+    }
+    if (frequency > 0) {
+        snprintf(command, sizeof(command), "SELECT_NETWORK %d freq=%d", network_id, frequency);
+        if (request_expect_ok(ctrl, command) == 0) {
+            ctrl->target_network_id = network_id;
+            return 0;
+        }
+    }
+    return supplicant_ctrl_select_network(ctrl, network_id);
+}
+
+int supplicant_ctrl_remove_network(supplicant_ctrl_t *ctrl, int network_id) {
+    char command[64];
+
+    snprintf(command, sizeof(command), "REMOVE_NETWORK %d", network_id);
+    if (ctrl->target_network_id == network_id) ctrl->target_network_id = -1;
+    return request_expect_ok(ctrl, command);
+}
+
+int supplicant_ctrl_list_enabled_networks(supplicant_ctrl_t *ctrl, int *network_ids, int max_ids) {
+    char reply[SUPPLICANT_CTRL_REPLY_LEN];
+    char *saveptr = NULL;
+    int count = 0;
+
+    if (supplicant_ctrl_request(ctrl, "LIST_NETWORKS", reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) <= 0 ||
+        strncmp(reply, "FAIL", 4) == 0) {
+        return -1;
+    }
+
+    // "network id / ssid / bssid / flags" header, then one tab-separated line per network
+    char *line = strtok_r(reply, "\n", &saveptr);
+    for (line = strtok_r(NULL, "\n", &saveptr); line && count < max_ids; line = strtok_r(NULL, "\n", &saveptr)) {
+        char *end;
+        long id = strtol(line, &end, 10);
+        if (end == line || *end != '\t') continue;
+        const char *flags = strrchr(line, '\t');
+        if (strstr(flags, "[DISABLED]")) continue;
+        network_ids[count++] = (int)id;
+    }
+    return count;
+}
+
+int supplicant_ctrl_enable_networks(supplicant_ctrl_t *ctrl, const int *network_ids, int count) {
+    char command[64];
+    int result = 0;
+
+    for (int i = 0; i < count; i++) {
+        snprintf(command, sizeof(command), "ENABLE_NETWORK %d", network_ids[i]);
+        if (request_expect_ok(ctrl, command) != 0) result = -1;
+    }
+    return result;
+}
+
+// True when the event (or STATUS id) belongs to the network we are waiting for
+static int matches_target_network(supplicant_ctrl_t *ctrl, const char *event) {
+    char value[16];
+
+    if (ctrl->target_network_id < 0) return 1;
+    if (get_event_field(event, "id", value, sizeof(value)) != 0) return 1;
+    return atoi(value) == ctrl->target_network_id;
+}
+
+int supplicant_wait_for_connection(supplicant_ctrl_t *ctrl, int timeout_ms, supplicant_wait_result_t *result) {
+    char event[SUPPLICANT_CTRL_EVENT_LEN];
+    char value[64];
+    int attempt_seen = 0;
+    long long deadline = monotonic_time_ms() + timeout_ms;
+
+    memset(result, 0, sizeof(supplicant_wait_result_t));
+    result->outcome = -2;
+
+    // Events emitted before ATTACH are lost, so check whether we are already done
+    if (supplicant_ctrl_get_status_field(ctrl, "wpa_state", value, sizeof(value)) == 0 &&
+        strcmp(value, "COMPLETED") == 0 &&
+        (ctrl->target_network_id < 0 ||
+         (supplicant_ctrl_get_status_field(ctrl, "id", value, sizeof(value)) == 0 && atoi(value) == ctrl->target_network_id))) {
+        result->connected_ms = monotonic_time_ms();
+        result->outcome = 0;
+        return 0;
+    }
+
+    while (1) {
+        int remaining = (int)(deadline - monotonic_time_ms());
+        if (remaining <= 0) break;
+
+        int len = supplicant_ctrl_receive_event(ctrl, event, sizeof(event), remaining);
+        if (len < 0) {
+            strncpy(result->reason, "Lost connection to wpa_supplicant control interface", sizeof(result->reason) - 1);
+            result->outcome = -1;
+            return -1;
+        }
+        if (len == 0) continue;
+
+        long long now = monotonic_time_ms();
+        switch (supplicant_classify_event(event)) {
+            case SUPPLICANT_EVENT_ASSOCIATING:
+                attempt_seen = 1;
+                if (!result->associating_ms) result->associating_ms = now;
+                break;
+            case SUPPLICANT_EVENT_ASSOCIATED:
+                attempt_seen = 1;
+                result->associated_ms = now;
+                break;
+            case SUPPLICANT_EVENT_KEY_NEGOTIATED:
+                result->key_negotiated_ms = now;
+                break;
+            case SUPPLICANT_EVENT_CONNECTED:
+                // With a running supplicant, the previously selected network may still report in
+                if (!matches_target_network(ctrl, event)) break;
+                result->connected_ms = now;
+                result->outcome = 0;
+                return 0;
+            case SUPPLICANT_EVENT_SSID_TEMP_DISABLED:
+                if (get_event_field(event, "reason", value, sizeof(value)) == 0 && strcmp(value, "WRONG_KEY") == 0) {
+                    strncpy(result->reason, "Wrong key - network temporarily disabled by wpa_supplicant", sizeof(result->reason) - 1);
+                } else {
+                    snprintf(result->reason, sizeof(result->reason), "Network temporarily disabled by wpa_supplicant (reason=%s)",
+                             get_event_field(event, "reason", value, sizeof(value)) == 0 ? value : "unknown");
+                }
+                result->outcome = -1;
+                return -1;
+            case SUPPLICANT_EVENT_DISCONNECTED:
+                // A stale disconnect from before our attempt is not a failure
+                if (!attempt_seen) break;
+                {
+                    int reason = (get_event_field(event, "reason", value, sizeof(value)) == 0) ? atoi(value) : 0;
+                    snprintf(result->reason, sizeof(result->reason), "Disconnected during connection attempt (reason=%d: %s)",
+                             reason, describe_reason_code(reason));
+                }
+                result->outcome = -1;
+                return -1;
+            case SUPPLICANT_EVENT_ASSOC_REJECT:
+                snprintf(result->reason, sizeof(result->reason), "Association rejected by AP (status_code=%s)",
+                         get_event_field(event, "status_code", value, sizeof(value)) == 0 ? value : "unknown");
+                result->outcome = -1;
+                return -1;
+            case SUPPLICANT_EVENT_AUTH_REJECT:
+                snprintf(result->reason, sizeof(result->reason), "Authentication rejected by AP (status_code=%s)",
+                         get_event_field(event, "status_code", value, sizeof(value)) == 0 ? value : "unknown");
+                result->outcome = -1;
+                return -1;
+            case SUPPLICANT_EVENT_TERMINATING:
+                strncpy(result->reason, "wpa_supplicant terminated during connection attempt", sizeof(result->reason) - 1);
+                result->outcome = -1;
+                return -1;
+            case SUPPLICANT_EVENT_NETWORK_NOT_FOUND:
+                // Keep waiting (the supplicant rescans) but remember why for the timeout message
+                strncpy(result->reason, "Network not found in scan results", sizeof(result->reason) - 1);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (strlen(result->reason) == 0) {
+        strncpy(result->reason, "No connection event before timeout", sizeof(result->reason) - 1);
+    }
+    result->outcome = -2;
+    return -2;
+}
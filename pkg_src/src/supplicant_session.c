@@ -0,0 +1,201 @@
+#include "supplicant_session.h"
+#include "supplicant_ctrl.h"
+#include "command_runner.h"
+#include <pthread.h>
+
+static supplicant_session_t sessions[MAX_INTERFACES];
+static pthread_mutex_t sessions_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static supplicant_session_t *find_session(const char *interface_name) {
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (sessions[i].in_use && strcmp(sessions[i].interface_name, interface_name) == 0) {
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static supplicant_session_t *allocate_session(const char *interface_name) {
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (!sessions[i].in_use) {
+            memset(&sessions[i], 0, sizeof(supplicant_session_t));
+            sessions[i].in_use = 1;
+            strncpy(sessions[i].interface_name, interface_name, MAX_INTERFACE_NAME - 1);
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static pid_t read_pidfile(const char *path) {
+    char pid_str[32];
+    pid_t pid = 0;
+
+    int fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) return 0;
+    FILE *pidfile = fdopen(fd, "r");
+    if (!pidfile) {
+        close(fd);
+        return 0;
+    }
+    if (fgets(pid_str, sizeof(pid_str), pidfile)) {
+        pid = (pid_t)atoi(pid_str);
+    }
+    fclose(pidfile);
+    return pid;
+}
+
+// Launch "wpa_supplicant -B" directly (no shell) and wait for it to daemonize
+static int launch_daemon(supplicant_session_t *session) {
+    int config_fd = create_state_file(session->config_path, 0600);
+    if (config_fd < 0) return -1;
+
+    // wpa_supplicant writes the pid file itself; never let it reuse a stale or planted entry
+    if (unlink(session->pidfile_path) != 0 && errno != ENOENT) {
+        close(config_fd);
+        unlink(session->config_path);
+        return -1;
+    }
+
+    // No networks: tests add them at runtime over the control socket
+    const char config[] = "ctrl_interface=" SUPPLICANT_CTRL_DIR "\nupdate_config=0\n";
+    ssize_t written = write(config_fd, config, sizeof(config) - 1);
+    close(config_fd);
+    if (written != (ssize_t)(sizeof(config) - 1)) return -1;
+
+    const char *const argv[] = {"wpa_supplicant", "-B", "-i", session->interface_name,
+                                "-c", session->config_path, "-P", session->pidfile_path, NULL};
+    if (command_run(argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int supplicant_session_start(const char *interface_name) {
+    supplicant_ctrl_t ctrl;
+    int result = 0;
+
+    pthread_mutex_lock(&sessions_mutex);
+    if (find_session(interface_name)) {
+        pthread_mutex_unlock(&sessions_mutex);
+        return 0;
+    }
+    supplicant_session_t *session = allocate_session(interface_name);
+    pthread_mutex_unlock(&sessions_mutex);
+    if (!session) return -1;
+
+    session->started_ms = monotonic_time_ms();
+
+    // Reuse an instance that already serves this interface rather than replacing it. Every
+    // test's SELECT_NETWORK disables its networks, so remember which ones to hand back.
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) == 0) {
+        int count = supplicant_ctrl_list_enabled_networks(&ctrl, session->enabled_networks,
+                                                          SUPPLICANT_SESSION_MAX_NETWORKS);
+        session->enabled_network_count = (count > 0) ? count : 0;
+        supplicant_ctrl_close(&ctrl);
+        printf("[SESSION] Reusing running wpa_supplicant on %s\n", interface_name);
+        fflush(stdout);
+        return 0;
+    }
+
+    if (ensure_runtime_state_dir() != 0) {
+        result = -1;
+    } else {
+        snprintf(session->config_path, sizeof(session->config_path),
+                 RUNTIME_STATE_DIR "/session_%s.conf", interface_name);
+        snprintf(session->pidfile_path, sizeof(session->pidfile_path),
+                 RUNTIME_STATE_DIR "/session_%s.pid", interface_name);
+
+        printf("[SESSION] Starting persistent wpa_supplicant on %s\n", interface_name);
+        fflush(stdout);
+        if (launch_daemon(session) != 0 ||
+            supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, SUPPLICANT_SESSION_START_TIMEOUT_MS) != 0) {
+            result = -1;
+        } else {
+            supplicant_ctrl_close(&ctrl);
+            session->owned = 1;
+            session->daemon_pid = read_pidfile(session->pidfile_path);
+        }
+    }
+
+    if (result != 0) {
+        printf("[SESSION] Failed to start wpa_supplicant on %s\n", interface_name);
+        unlink(session->config_path);
+        pid_t stray_pid = read_pidfile(session->pidfile_path);
+        if (stray_pid > 0) kill(stray_pid, SIGTERM);
+        unlink(session->pidfile_path);
+        pthread_mutex_lock(&sessions_mutex);
+        session->in_use = 0;
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+
+    session->start_duration_ms = (int)(monotonic_time_ms() - session->started_ms);
+    printf("[SESSION] wpa_supplicant ready on %s after %d ms (PID: %d)\n",
+           interface_name, session->start_duration_ms, session->daemon_pid);
+    fflush(stdout);
+    return 0;
+}
+
+void supplicant_session_stop(const char *interface_name) {
+    supplicant_session_t copy;
+    supplicant_ctrl_t ctrl;
+    char reply[16];
+
+    pthread_mutex_lock(&sessions_mutex);
+    supplicant_session_t *session = find_session(interface_name);
+    if (!session) {
+        pthread_mutex_unlock(&sessions_mutex);
+        return;
+    }
+    memcpy(&copy, session, sizeof(copy));
+    session->in_use = 0;
+    pthread_mutex_unlock(&sessions_mutex);
+
+    if (!copy.owned) {
+        if (copy.enabled_network_count > 0 &&
+            supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) == 0) {
+            printf("[SESSION] Re-enabling %d network(s) on the adopted wpa_supplicant on %s\n",
+                   copy.enabled_network_count, interface_name);
+            supplicant_ctrl_enable_networks(&ctrl, copy.enabled_networks, copy.enabled_network_count);
+            supplicant_ctrl_close(&ctrl);
+        }
+        return;
+    }
+
+    printf("[SESSION] Stopping persistent wpa_supplicant on %s\n", interface_name);
+
+    // TERMINATE lets the daemon deauthenticate and remove its control socket cleanly
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) == 0) {
+        supplicant_ctrl_request(&ctrl, "TERMINATE", reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS);
+        supplicant_ctrl_close(&ctrl);
+    }
+
+    // Only the recorded PID is signalled, never other supplicant instances
+    if (copy.daemon_pid > 0) {
+        if (!wait_for_process_exit(copy.daemon_pid, 1000)) {
+            kill(copy.daemon_pid, SIGTERM);
+            if (!wait_for_process_exit(copy.daemon_pid, 500)) {
+                kill(copy.daemon_pid, SIGKILL);
+            }
+        }
+    }
+
+    unlink(copy.config_path);
+    unlink(copy.pidfile_path);
+}
+
+int supplicant_session_active(const char *interface_name) {
+    pthread_mutex_lock(&sessions_mutex);
+    int active = (find_session(interface_name) != NULL);
+    pthread_mutex_unlock(&sessions_mutex);
+    return active;
+}
+
+int supplicant_session_get(const char *interface_name, supplicant_session_t *session) {
+    pthread_mutex_lock(&sessions_mutex);
+    supplicant_session_t *found = find_session(interface_name);
+    if (found) memcpy(session, found, sizeof(supplicant_session_t));
+    pthread_mutex_unlock(&sessions_mutex);
+    return found ? 0 : -1;
+}
@@ -0,0 +1,214 @@
+#include "test_history.h"
+#include <math.h>
+#include <sys/file.h>
+
+#define INDEX_SLOT_OFFSET(slot) \
+    ((off_t)sizeof(test_history_index_header_t) + (off_t)(slot) * (off_t)sizeof(test_history_entry_t))
+
+static double sketch_gamma(void) {
+    return (1.0 + SKETCH_RELATIVE_ACCURACY) / (1.0 - SKETCH_RELATIVE_ACCURACY);
+}
+
+void sketch_add(quantile_sketch_t *sketch, double value_ms) {
+    int bucket = 0;
+
+    if (value_ms >= 1.0) {
+        bucket = 1 + (int)floor(log(value_ms) / log(sketch_gamma()));
+        if (bucket >= SKETCH_BUCKETS) bucket = SKETCH_BUCKETS - 1;
+    }
+    sketch->buckets[bucket]++;
+    sketch->count++;
+}
+
+// Smallest bucket whose cumulative count passes the rank, reported at the bucket's
+// relative midpoint so the error stays within SKETCH_RELATIVE_ACCURACY
+double sketch_quantile(const quantile_sketch_t *sketch, double quantile) {
+    double gamma = sketch_gamma();
+    double rank;
+    uint64_t cumulative = 0;
+
+    if (sketch->count == 0) return -1;
+    rank = quantile * (double)(sketch->count - 1);
+
+    for (int bucket = 0; bucket < SKETCH_BUCKETS; bucket++) {
+        cumulative += sketch->buckets[bucket];
+        if ((double)cumulative > rank) {
+            if (bucket == 0) return 0;
+            return 2.0 * pow(gamma, bucket) / (gamma + 1.0);
+        }
+    }
+    return 2.0 * pow(gamma, SKETCH_BUCKETS - 1) / (gamma + 1.0);
+}
+
+const char *test_history_metric_name(int metric) {
+    if (metric == TEST_HISTORY_METRIC_TOTAL) return "total";
+    return test_phase_name((test_phase_t)metric);
+}
+
+static int ensure_history_dir(void) {
+    char path[] = TEST_HISTORY_DIR;
+
+    // mkdir -p: the default location is two levels below /var
+    for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+        *slash = '/';
+    }
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+// Open the index with an exclusive lock held until close; a missing or foreign file starts empty
+static int open_index(test_history_index_header_t *header) {
+    int fd = open(TEST_HISTORY_INDEX, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    if (pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header) ||
+        header->magic != TEST_HISTORY_MAGIC || header->version != TEST_HISTORY_VERSION) {
+        memset(header, 0, sizeof(*header));
+        header->magic = TEST_HISTORY_MAGIC;
+        header->version = TEST_HISTORY_VERSION;
+        if (ftruncate(fd, 0) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static int find_slot(int fd, const test_history_index_header_t *header, const char *ssid) {
+    char slot_ssid[MAX_SSID_LEN];
+
+    for (uint32_t slot = 0; slot < header->slot_count; slot++) {
+        if (pread(fd, slot_ssid, sizeof(slot_ssid), INDEX_SLOT_OFFSET(slot)) != (ssize_t)sizeof(slot_ssid)) {
+            return -1;
+        }
+        slot_ssid[MAX_SSID_LEN - 1] = '\0';
+        if (strcmp(slot_ssid, ssid) == 0) return (int)slot;
+    }
+    return -1;
+}
+
+static int fold_result(int fd, test_history_index_header_t *header, const connection_test_result_t *result) {
+    test_history_entry_t entry;
+    int slot = find_slot(fd, header, result->ssid);
+
+    if (slot >= 0) {
+        if (pread(fd, &entry, sizeof(entry), INDEX_SLOT_OFFSET(slot)) != (ssize_t)sizeof(entry)) return -1;
+    } else {
+        if (header->slot_count >= TEST_HISTORY_MAX_SSIDS) return 0; // index full: the log still has it
+        slot = (int)header->slot_count++;
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.ssid, result->ssid, MAX_SSID_LEN - 1);
+        entry.first_test = result->test_time;
+    }
+
+    entry.tests++;
+    if (result->success) entry.successes++;
+    if (result->test_time > entry.last_test) entry.last_test = result->test_time;
+    for (int phase = 0; phase < TEST_PHASE_COUNT; phase++) {
+        if (result->phase_ms[phase] >= 0) {
+            sketch_add(&entry.metrics[phase], result->phase_ms[phase]);
+        }
+    }
+    sketch_add(&entry.metrics[TEST_HISTORY_METRIC_TOTAL], result->test_duration_ms);
+
+    if (pwrite(fd, &entry, sizeof(entry), INDEX_SLOT_OFFSET(slot)) != (ssize_t)sizeof(entry)) return -1;
+    return 0;
+}
+
+// Fold log records the index has not seen yet (all of them after a rebuild, normally one)
+static int catch_up_index(int fd, test_history_index_header_t *header) {
+    test_history_record_t record;
+    struct stat st;
+    int result = 0;
+
+    int log_fd = open(TEST_HISTORY_LOG, O_RDONLY | O_CLOEXEC);
+    if (log_fd < 0) return (errno == ENOENT) ? 0 : -1;
+
+    if (fstat(log_fd, &st) != 0) {
+        close(log_fd);
+        return -1;
+    }
+    uint32_t available = (uint32_t)(st.st_size / (off_t)sizeof(record));
+
+    while (header->record_count < available) {
+        off_t offset = (off_t)header->record_count * (off_t)sizeof(record);
+        if (pread(log_fd, &record, sizeof(record), offset) != (ssize_t)sizeof(record)) {
+            result = -1;
+            break;
+        }
+        if (record.magic == TEST_HISTORY_MAGIC && record.version == TEST_HISTORY_VERSION &&
+            fold_result(fd, header, &record.result) != 0) {
+            result = -1;
+            break;
+        }
+        header->record_count++;
+    }
+    close(log_fd);
+
+    if (pwrite(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)) return -1;
+    return result;
+}
+
+int test_history_append(const connection_test_result_t *result) {
+    test_history_index_header_t header;
+    test_history_record_t record;
+
+    if (ensure_history_dir() != 0) return -1;
+
+    // The index lock also serializes log appends between processes
+    int fd = open_index(&header);
+    if (fd < 0) return -1;
+
+    memset(&record, 0, sizeof(record));
+    record.magic = TEST_HISTORY_MAGIC;
+    record.version = TEST_HISTORY_VERSION;
+    memcpy(&record.result, result, sizeof(record.result));
+
+    int log_fd = open(TEST_HISTORY_LOG, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (log_fd < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Write at the end of the last whole record: a torn append (ENOSPC, power loss) is cut
+    // off by the next one rather than shifting every later record off the record grid
+    struct stat st;
+    ssize_t written = -1;
+    if (fstat(log_fd, &st) == 0) {
+        off_t offset = (st.st_size / (off_t)sizeof(record)) * (off_t)sizeof(record);
+        if (offset == st.st_size || ftruncate(log_fd, offset) == 0) {
+            written = pwrite(log_fd, &record, sizeof(record), offset);
+        }
+    }
+    close(log_fd);
+
+    int status = (written == (ssize_t)sizeof(record)) ? catch_up_index(fd, &header) : -1;
+    close(fd);
+    return status;
+}
+
+int test_history_lookup(const char *ssid, test_history_entry_t *entry) {
+    test_history_index_header_t header;
+
+    int fd = open_index(&header);
+    if (fd < 0) return (errno == ENOENT) ? 1 : -1;
+
+    if (catch_up_index(fd, &header) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    int slot = find_slot(fd, &header, ssid);
+    int result = 1;
+    if (slot >= 0) {
+        result = (pread(fd, entry, sizeof(*entry), INDEX_SLOT_OFFSET(slot)) == (ssize_t)sizeof(*entry)) ? 0 : -1;
+    }
+    close(fd);
+    return result;
+}
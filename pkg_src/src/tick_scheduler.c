@@ -0,0 +1,119 @@
+#include "tick_scheduler.h"
+#include <math.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+static double alignment_seconds = 0;
+
+void tick_scheduler_set_alignment(double align_seconds) {
+    alignment_seconds = align_seconds > 0 ? align_seconds : 0;
+}
+
+double tick_scheduler_get_alignment(void) {
+    return alignment_seconds;
+}
+
+static long long clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static struct timespec ns_to_timespec(long long ns) {
+    struct timespec ts = {.tv_sec = ns / NSEC_PER_SEC, .tv_nsec = ns % NSEC_PER_SEC};
+    return ts;
+}
+
+int tick_scheduler_init(tick_scheduler_t *sched, double period_seconds) {
+    struct itimerspec spec;
+
+    memset(sched, 0, sizeof(tick_scheduler_t));
+    sched->timer_fd = -1;
+    sched->stop_fd = -1;
+    sched->period_ns = llround(period_seconds * NSEC_PER_SEC);
+    sched->align_seconds = alignment_seconds;
+    if (sched->period_ns <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    sched->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    sched->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (sched->timer_fd < 0 || sched->stop_fd < 0) {
+        tick_scheduler_close(sched);
+        return -1;
+    }
+
+    // The monotonic clock has no wall-clock phase: translate the next aligned wall-clock
+    // boundary into a monotonic deadline once, then let the period carry it
+    long long now_ns = clock_ns(CLOCK_MONOTONIC);
+    sched->first_deadline_ns = now_ns;
+    if (sched->align_seconds > 0) {
+        long long align_ns = llround(sched->align_seconds * NSEC_PER_SEC);
+        long long wall_ns = clock_ns(CLOCK_REALTIME);
+        sched->first_deadline_ns = now_ns + (wall_ns / align_ns + 1) * align_ns - wall_ns;
+    }
+
+    spec.it_value = ns_to_timespec(sched->first_deadline_ns);
+    spec.it_interval = ns_to_timespec(sched->period_ns);
+    if (timerfd_settime(sched->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) != 0) {
+        tick_scheduler_close(sched);
+        return -1;
+    }
+    return 0;
+}
+
+int tick_scheduler_consume(tick_scheduler_t *sched) {
+    uint64_t elapsed;
+    ssize_t bytes;
+
+    do {
+        bytes = read(sched->timer_fd, &elapsed, sizeof(elapsed));
+    } while (bytes < 0 && errno == EINTR);
+    if (bytes != (ssize_t)sizeof(elapsed)) {
+        return (bytes < 0 && errno == EAGAIN) ? 0 : -1;
+    }
+
+    // Deliver the latest period; the ones before it were overrun
+    sched->expirations += elapsed;
+    sched->skipped_ticks += elapsed - 1;
+    sched->ticks++;
+    long long deadline_ns = sched->first_deadline_ns + (long long)(sched->expirations - 1) * sched->period_ns;
+    sched->lateness_us = (clock_ns(CLOCK_MONOTONIC) - deadline_ns) / 1000;
+    return 1;
+}
+
+int tick_scheduler_wait(tick_scheduler_t *sched) {
+    struct pollfd fds[2] = {{.fd = sched->timer_fd, .events = POLLIN}, {.fd = sched->stop_fd, .events = POLLIN}};
+
+    for (;;) {
+        // poll is never restarted after a signal handler, so Ctrl-C ends the wait at once
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR && keep_running) continue;
+            return errno == EINTR ? 0 : -1;
+        }
+        if (fds[1].revents & POLLIN) return 0;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int result = tick_scheduler_consume(sched);
+        if (result != 0) return result;
+    }
+}
+
+void tick_scheduler_stop(tick_scheduler_t *sched) {
+    uint64_t one = 1;
+
+    if (sched->stop_fd >= 0) {
+        write(sched->stop_fd, &one, sizeof(one));
+    }
+}
+
+void tick_scheduler_close(tick_scheduler_t *sched) {
+    if (sched->timer_fd >= 0) close(sched->timer_fd);
+    if (sched->stop_fd >= 0) close(sched->stop_fd);
+    sched->timer_fd = -1;
+    sched->stop_fd = -1;
+}
@@ -1,116 +1,164 @@
 #include "wifi_scanner.h"
 #include "json_formatter.h"
+#include "interface_cache.h"
+#include "supplicant_ctrl.h"
+#include "netlink_helper.h"
+#include "wpa_config.h"
+#include "supplicant_session.h"
+#include "dhcp_probe.h"
+#include "connectivity_probe.h"
+#include "link_state.h"
+#include "command_runner.h"
+#include "monitor.h"
+#include "wiphy_capabilities.h"
+#include <arpa/inet.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+
+// Failure reason of the last supplicant start in this thread, as reported by wpa_supplicant
+static __thread char wpa_failure_reason[256];
+static __thread scan_timing_t last_scan_timing;
+// Timestamps of the last supplicant event wait, for the connection test phase breakdown
+static __thread supplicant_wait_result_t last_wait_result;
+static __thread long long last_wait_start_ms;
+static __thread int last_restore_duration_ms = -1;
 
 int get_interface_info(const char *interface_name, wifi_interface_t *interface) {
+    // Served from the per-interface snapshot cache; only stale field groups are refetched
+    return interface_cache_get(interface_name, interface);
+}
+
+long long monotonic_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int fetch_interface_fields(const char *interface_name, wifi_interface_t *interface, unsigned int field_mask) {
     FILE *fp;
     char command[MAX_COMMAND_LEN];
     char line[MAX_LINE_LEN];
+    int want_static = (field_mask & IFACE_FIELD_MASK(IFACE_FIELDS_STATIC)) != 0;
+    int want_status = (field_mask & IFACE_FIELD_MASK(IFACE_FIELDS_STATUS)) != 0;
+    int want_link = (field_mask & IFACE_FIELD_MASK(IFACE_FIELDS_LINK)) != 0;
+    int want_signal = (field_mask & IFACE_FIELD_MASK(IFACE_FIELDS_SIGNAL)) != 0;
     
-    // Initialize interface structure
-    memset(interface, 0, sizeof(wifi_interface_t));
+    // Reset only the fields being refreshed
     strncpy(interface->name, interface_name, MAX_INTERFACE_NAME - 1);
+    interface->name[MAX_INTERFACE_NAME - 1] = '\0';
+    if (want_static) {
+        memset(interface->mac, 0, sizeof(interface->mac));
+        memset(interface->type, 0, sizeof(interface->type));
+        memset(interface->mode, 0, sizeof(interface->mode));
+    }
+    if (want_status) {
+        memset(interface->status, 0, sizeof(interface->status));
+    }
+    if (want_link) {
+        memset(interface->ssid, 0, sizeof(interface->ssid));
+        interface->frequency = 0;
+        interface->channel = 0;
+        interface->tx_power = 0;
+    }
+    if (want_signal) {
+        interface->signal_strength = 0;
+    }
     
-    // Get interface status using ip command
-    snprintf(command, sizeof(command), "ip link show %s | grep -oE '(UP|DOWN)'", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        if (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            strncpy(interface->status, line, sizeof(interface->status) - 1);
-        } else {
-            strcpy(interface->status, "DOWN");
+    // Get administrative status from the sysfs flags word (IFF_UP)
+    if (want_status) {
+        snprintf(command, sizeof(command), "/sys/class/net/%s/flags", interface_name);
+        fp = fopen(command, "r");
+        strcpy(interface->status, "DOWN");
+        if (fp) {
+            unsigned int flags = 0;
+            if (fscanf(fp, "%x", &flags) == 1 && (flags & 0x1)) {
+                strcpy(interface->status, "UP");
+            }
+            fclose(fp);
         }
-        pclose(fp);
     }
     
     // Get MAC address
-    snprintf(command, sizeof(command), "cat /sys/class/net/%s/address 2>/dev/null", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        if (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            strncpy(interface->mac, line, MAX_MAC_LEN - 1);
+    if (want_static) {
+        snprintf(command, sizeof(command), "/sys/class/net/%s/address", interface_name);
+        fp = fopen(command, "r");
+        if (fp) {
+            if (fgets(line, sizeof(line), fp)) {
+                line[strcspn(line, "\n")] = 0;
+                strncpy(interface->mac, line, MAX_MAC_LEN - 1);
+            }
+            fclose(fp);
         }
-        pclose(fp);
     }
     
     // Get wireless information using iw
-    snprintf(command, sizeof(command), "iw dev %s info 2>/dev/null", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        while (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            
-            if (strstr(line, "\ttype ")) {
-                char *type_start = strstr(line, "\ttype ") + 6;
-                char *end = strchr(type_start, '\n');
-                if (end) *end = '\0';
-                strncpy(interface->type, type_start, sizeof(interface->type) - 1);
-                interface->type[sizeof(interface->type) - 1] = '\0';
-            }
-            else if (strstr(line, "\tchannel ")) {
-                sscanf(line, "\tchannel %d (%d MHz)", &interface->channel, &interface->frequency);
-            }
-            else if (strstr(line, "\ttxpower ")) {
-                float power;
-                if (sscanf(line, "\ttxpower %f dBm", &power) == 1) {
-                    interface->tx_power = (int)power;
+    if (want_static || want_link) {
+        const char *const iw_info[] = {"iw", "dev", interface_name, "info", NULL};
+        fp = command_run_stream(iw_info, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL);
+        if (fp) {
+            while (fgets(line, sizeof(line), fp)) {
+                line[strcspn(line, "\n")] = 0;
+                
+                if (want_static && strstr(line, "\ttype ")) {
+                    char *type_start = strstr(line, "\ttype ") + 6;
+                    char *end = strchr(type_start, '\n');
+                    if (end) *end = '\0';
+                    strncpy(interface->type, type_start, sizeof(interface->type) - 1);
+                    interface->type[sizeof(interface->type) - 1] = '\0';
+                }
+                else if (want_link && strstr(line, "\tchannel ")) {
+                    sscanf(line, "\tchannel %d (%d MHz)", &interface->channel, &interface->frequency);
+                }
+                else if (want_link && strstr(line, "\ttxpower ")) {
+                    float power;
+                    if (sscanf(line, "\ttxpower %f dBm", &power) == 1) {
+                        interface->tx_power = (int)power;
+                    }
                 }
             }
+            fclose(fp);
         }
-        pclose(fp);
     }
     
-    // Get connection information using iw link
-    snprintf(command, sizeof(command), "iw dev %s link 2>/dev/null", interface_name);
-    fp = popen(command, "r");
-    if (fp) {
-        while (fgets(line, sizeof(line), fp)) {
-            line[strcspn(line, "\n")] = 0;
-            
-            if (strstr(line, "Connected to ")) {
-                // Extract BSSID from "Connected to XX:XX:XX:XX:XX:XX"
-                char *bssid_start = strstr(line, "Connected to ") + 13;
-                char bssid[MAX_MAC_LEN];
-                if (sscanf(bssid_start, "%17s", bssid) == 1) {
-                    // Store BSSID if needed
-                }
-            }
-            else if (strstr(line, "\tSSID: ")) {
-                char *ssid_start = strstr(line, "\tSSID: ") + 7;
-                strncpy(interface->ssid, ssid_start, MAX_SSID_LEN - 1);
-                interface->ssid[MAX_SSID_LEN - 1] = '\0';
-            }
-            else if (strstr(line, "\tfreq: ")) {
-                int freq;
-                if (sscanf(line, "\tfreq: %d", &freq) == 1) {
-                    interface->frequency = freq;
-                    // Convert frequency to channel
-                    if (freq >= 2412 && freq <= 2484) {
-                        interface->channel = (freq - 2412) / 5 + 1;
-                    } else if (freq >= 5170 && freq <= 5825) {
-                        interface->channel = (freq - 5000) / 5;
-                    }
-                }
+    // Get connection information from one link-state sample
+    if (want_link || want_signal) {
+        wifi_interface_t link_info;
+        link_state_t link;
+        memset(&link_info, 0, sizeof(link_info));
+        
+        if (link_state_sample(interface_name, &link) == 0 && link.connected) {
+            strncpy(link_info.ssid, link.ssid, MAX_SSID_LEN - 1);
+            link_info.frequency = link.frequency;
+            // Convert frequency to channel
+            if (link.frequency >= 2412 && link.frequency <= 2484) {
+                link_info.channel = (link.frequency - 2412) / 5 + 1;
+            } else if (link.frequency >= 5170 && link.frequency <= 5825) {
+                link_info.channel = (link.frequency - 5000) / 5;
             }
-            else if (strstr(line, "\tsignal: ")) {
-                int signal;
-                if (sscanf(line, "\tsignal: %d dBm", &signal) == 1) {
-                    interface->signal_strength = signal;
-                }
+            link_info.signal_strength = link.has_signal ? link.signal_dbm : 0;
+        }
+        
+        // The link sample is authoritative for the link group and refreshes signal too
+        if (want_link) {
+            if (strlen(link_info.ssid) > 0) {
+                strncpy(interface->ssid, link_info.ssid, MAX_SSID_LEN - 1);
             }
-            else if (strstr(line, "\ttx bitrate: ")) {
-                // Could extract bitrate info if needed
+            if (link_info.frequency > 0) {
+                interface->frequency = link_info.frequency;
+                interface->channel = link_info.channel;
             }
         }
-        pclose(fp);
+        interface->signal_strength = link_info.signal_strength;
     }
     
-    // Fallback: try getting connection info from iwconfig if iw link fails
-    if (interface->frequency == 0 || strlen(interface->ssid) == 0) {
-        snprintf(command, sizeof(command), "iwconfig %s 2>/dev/null", interface_name);
-        fp = popen(command, "r");
+    // Fallback: try getting connection info from iwconfig if the link sample has nothing
+    if (want_link && (interface->frequency == 0 || strlen(interface->ssid) == 0)) {
+        const char *const iwconfig[] = {"iwconfig", interface_name, NULL};
+        fp = command_run_stream(iwconfig, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL);
         if (fp) {
             while (fgets(line, sizeof(line), fp)) {
                 line[strcspn(line, "\n")] = 0;
@@ -145,45 +193,93 @@ int get_interface_info(const char *interface_name, wifi_interface_t *interface)
                     }
                 }
             }
-            pclose(fp);
+            fclose(fp);
         }
     }
     
     // Set default values if not detected
-    if (strlen(interface->type) == 0) {
-        strcpy(interface->type, "managed");
-    }
-    if (strlen(interface->mode) == 0) {
-        strcpy(interface->mode, "station");
+    if (want_static) {
+        if (strlen(interface->type) == 0) {
+            strcpy(interface->type, "managed");
+        }
+        if (strlen(interface->mode) == 0) {
+            strcpy(interface->mode, "station");
+        }
     }
     
     return 0;
 }
 
 int perform_scan(const char *interface_name, scan_result_t *results, int max_results) {
+    return perform_scan_frequencies(interface_name, NULL, 0, 0, results, max_results);
+}
+
+int perform_scan_frequencies(const char *interface_name, const int *frequencies, int frequency_count,
+                             int timeout_ms, scan_result_t *results, int max_results) {
     FILE *fp;
-    char command[MAX_COMMAND_LEN];
+    const char *scan_argv[7 + SCAN_MAX_FREQUENCIES] = {"iw", "dev", interface_name, "scan", "flush"};
+    char frequency_args[SCAN_MAX_FREQUENCIES][8];
+    int planned[SCAN_MAX_FREQUENCIES];
+    int scan_argc = 5;
+    command_status_t scan_status;
     char line[MAX_LINE_LEN];
     int count = 0;
     int retry_count = 0;
     const int max_retries = 3;
+    long long phase_start;
+    long long deadline = (timeout_ms > 0) ? monotonic_time_ms() + timeout_ms : 0;
+    
+    memset(&last_scan_timing, 0, sizeof(last_scan_timing));
+    last_scan_timing.handoff_us = -1;
+    
+    // "freq" limits the scan to the listed channels, which is much shorter than a full sweep.
+    // Channels the radio lacks or the regulatory domain disables would only make iw fail.
+    if (frequencies && frequency_count > 0) {
+        frequency_count = wiphy_plan_scan_frequencies(interface_name, frequencies, frequency_count, 0,
+                                                      planned, SCAN_MAX_FREQUENCIES);
+        if (frequency_count < 0) return 0;
+        frequencies = planned;
+    }
+    if (frequencies && frequency_count > 0) {
+        scan_argv[scan_argc++] = "freq";
+        for (int i = 0; i < frequency_count && i < SCAN_MAX_FREQUENCIES; i++) {
+            snprintf(frequency_args[i], sizeof(frequency_args[i]), "%d", frequencies[i]);
+            scan_argv[scan_argc++] = frequency_args[i];
+        }
+    }
+    scan_argv[scan_argc] = NULL;
     
     // Retry scanning up to max_retries times if no results found
     while (retry_count < max_retries) {
+        int attempt_timeout_ms = COMMAND_SCAN_TIMEOUT_MS;
+        
         // Add slight delay between retries to allow hardware to settle
         if (retry_count > 0) {
+            if (deadline && deadline - monotonic_time_ms() <= 500) break;
+            phase_start = monotonic_time_ms();
             precise_sleep(0.5); // 500ms delay between retries
+            last_scan_timing.retry_wait_ms += (int)(monotonic_time_ms() - phase_start);
         }
+        if (deadline) {
+            long long remaining = deadline - monotonic_time_ms();
+            if (remaining <= 0) break;
+            if (remaining < attempt_timeout_ms) attempt_timeout_ms = (int)remaining;
+        }
+        last_scan_timing.attempts++;
         
-        // Use iw dev scan with flush and timeout
-        snprintf(command, sizeof(command), "iw dev %s scan flush 2>/dev/null", interface_name);
-        fp = popen(command, "r");
+        // Use iw dev scan with flush; a wedged scan is killed at the deadline
+        fp = command_run_stream(scan_argv, 0, attempt_timeout_ms, &scan_status);
         
         if (!fp) {
             retry_count++;
             continue;
         }
         
+        // iw prints nothing until the kernel scan completes; time to the first byte is the scan itself
+        long long output_start = monotonic_time_ms();
+        last_scan_timing.scan_command_ms += (int)(scan_status.first_output_ms >= 0 ?
+                                                  scan_status.first_output_ms : scan_status.duration_ms);
+        
         scan_result_t current_result;
         memset(&current_result, 0, sizeof(current_result));
         int has_bss = 0;
@@ -408,7 +504,8 @@ int perform_scan(const char *interface_name, scan_result_t *results, int max_res
             count++;
         }
         
-        pclose(fp);
+        fclose(fp);
+        last_scan_timing.parse_ms += (int)(monotonic_time_ms() - output_start);
         
         // If we got results, break out of retry loop
         if (count > 0) {
@@ -446,234 +543,464 @@ void precise_sleep(float seconds) {
     }
 }
 
-// Shared memory structure for scan results
+// An existing entry is only trusted if it is a real directory owned by us that nobody
+// else can write
+static int ensure_private_dir(const char *path) {
+    struct stat st;
+
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+    if (lstat(path, &st) != 0) return -1;
+    if (!S_ISDIR(st.st_mode) || st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        fprintf(stderr, "Refusing to use %s: not a private directory owned by uid %d\n",
+                path, (int)geteuid());
+        errno = EPERM;
+        return -1;
+    }
+    return 0;
+}
+
+// Create the directory holding caches and state shared between invocations (cleared at boot)
+int ensure_runtime_state_dir(void) {
+    return ensure_private_dir(RUNTIME_STATE_DIR);
+}
+
+// Create the directory holding state that must survive a reboot
+int ensure_persistent_state_dir(void) {
+    return ensure_private_dir(PERSISTENT_STATE_DIR);
+}
+
+// Create a state file that did not exist before; a stale entry of the same name (including
+// a symlink) is removed rather than followed
+int create_state_file(const char *path, mode_t mode) {
+    if (unlink(path) != 0 && errno != ENOENT) return -1;
+    return open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, mode);
+}
+
+// Handoff area between a forked scan child and its parent; mapped anonymously per call
 typedef struct {
     int result_count;
     scan_result_t results[MAX_SCAN_RESULTS];
-    int scan_complete;
+    int scan_complete;              // published with release order after everything above
     int scan_success;
+    scan_timing_t timing;
+    long long completed_ns;         // CLOCK_MONOTONIC when the child signalled
 } shared_scan_data_t;
 
-// Forked scan worker function with shared memory
-int perform_forked_scan(const char *interface_name, scan_result_t *results, int max_results) {
-    // Create shared memory for scan results
-    int shm_fd = shm_open("/wifi_scan_shm", O_CREAT | O_RDWR, 0666);
-    if (shm_fd == -1) {
-        // Fall back to direct scanning if shared memory fails
-        return perform_scan(interface_name, results, max_results);
-    }
-    
-    // Set the size of shared memory
-    if (ftruncate(shm_fd, sizeof(shared_scan_data_t)) == -1) {
-        close(shm_fd);
-        shm_unlink("/wifi_scan_shm");
-        return perform_scan(interface_name, results, max_results);
+#define FORKED_SCAN_KILL_GRACE_MS 500
+
+void get_last_scan_timing(scan_timing_t *timing) {
+    memcpy(timing, &last_scan_timing, sizeof(scan_timing_t));
+}
+
+static long long monotonic_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// The result area is an anonymous MAP_SHARED mapping private to this scan, so concurrent
+// scans (other processes, threads or interfaces) never share or unlink it; the child
+// signals completion through an eventfd instead of the parent polling a flag.
+int forked_scan_start(const char *interface_name, forked_scan_t *scan) {
+    memset(scan, 0, sizeof(forked_scan_t));
+    scan->pidfd = -1;
+    scan->shared = mmap(NULL, sizeof(shared_scan_data_t), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (scan->shared == MAP_FAILED) {
+        scan->shared = NULL;
+        return -1;
     }
     
-    // Map shared memory
-    shared_scan_data_t *shared_data = mmap(NULL, sizeof(shared_scan_data_t),
-                                          PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (shared_data == MAP_FAILED) {
-        close(shm_fd);
-        shm_unlink("/wifi_scan_shm");
-        return perform_scan(interface_name, results, max_results);
+    scan->done_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (scan->done_fd < 0) {
+        munmap(scan->shared, sizeof(shared_scan_data_t));
+        scan->shared = NULL;
+        return -1;
     }
     
-    // Initialize shared data
-    memset(shared_data, 0, sizeof(shared_scan_data_t));
-    
-    pid_t pid = fork();
+    scan->started_ms = monotonic_time_ms();
+    scan->pid = fork();
     
-    if (pid == -1) {
-        // Fork failed, cleanup and fall back
-        munmap(shared_data, sizeof(shared_scan_data_t));
-        close(shm_fd);
-        shm_unlink("/wifi_scan_shm");
-        return perform_scan(interface_name, results, max_results);
-    } else if (pid == 0) {
-        // Child process - perform the scan
+    if (scan->pid == -1) {
+        munmap(scan->shared, sizeof(shared_scan_data_t));
+        close(scan->done_fd);
+        memset(scan, 0, sizeof(forked_scan_t));
+        return -1;
+    } else if (scan->pid == 0) {
+        // Child process - perform the scan, publish, then wake the parent. Ctrl-C is the
+        // parent's to handle (it may hold SIGINT/SIGTERM for a signalfd); SIGTERM ends the child.
+        // Its own process group lets the parent take down the iw it runs as well.
+        shared_scan_data_t *shared_data = (shared_scan_data_t *)scan->shared;
+        sigset_t no_signals;
+        uint64_t one = 1;
+        setpgid(0, 0);
+        signal(SIGINT, SIG_IGN);
+        signal(SIGTERM, SIG_DFL);
+        sigemptyset(&no_signals);
+        sigprocmask(SIG_SETMASK, &no_signals, NULL);
+        
         int count = perform_scan(interface_name, shared_data->results, MAX_SCAN_RESULTS);
+        get_last_scan_timing(&shared_data->timing);
         shared_data->result_count = count;
         shared_data->scan_success = (count > 0) ? 1 : 0;
-        shared_data->scan_complete = 1;
-        
-        // Cleanup child process
-        munmap(shared_data, sizeof(shared_scan_data_t));
-        close(shm_fd);
-        exit(0);
-    } else {
-        // Parent process - wait for child with timeout
-        int status;
-        int timeout_seconds = 12; // 12 second timeout for scan operation
-        int final_count = 0;
-        
-        for (int i = 0; i < timeout_seconds * 10; i++) { // Check every 100ms
-            if (waitpid(pid, &status, WNOHANG) == pid) {
-                // Child process completed
-                break;
-            }
-            
-            // Check if scan is complete via shared memory
-            if (shared_data->scan_complete) {
-                break;
+        shared_data->completed_ns = monotonic_time_ns();
+        __atomic_store_n(&shared_data->scan_complete, 1, __ATOMIC_RELEASE);
+        write(scan->done_fd, &one, sizeof(one));
+        // _exit: the parent's stdio buffers were copied by fork and must not be flushed twice
+        _exit(0);
+    }
+    
+    // Also here, so the group exists before the parent may have to kill it
+    setpgid(scan->pid, scan->pid);
+    scan->pidfd = command_pidfd_open(scan->pid);
+    return 0;
+}
+
+int forked_scan_finish(forked_scan_t *scan, scan_result_t *results, int max_results) {
+    shared_scan_data_t *shared_data = (shared_scan_data_t *)scan->shared;
+    long long woke_ns = monotonic_time_ns();
+    int status;
+    int final_count = 0;
+    
+    if (!shared_data) return 0;
+    
+    // Reap the child: after signalling it is already exiting; one that overran or was
+    // interrupted gets a SIGTERM grace period, then SIGKILL, along with its iw
+    int signalled = __atomic_load_n(&shared_data->scan_complete, __ATOMIC_ACQUIRE);
+    if (signalled) {
+        waitpid(scan->pid, &status, 0);
+    } else if (waitpid(scan->pid, &status, WNOHANG) != scan->pid) {
+        long long grace_deadline = monotonic_time_ms() + FORKED_SCAN_KILL_GRACE_MS;
+        int reaped = 0;
+        kill(-scan->pid, SIGTERM);
+        while (!(reaped = (waitpid(scan->pid, &status, WNOHANG) == scan->pid))) {
+            long long remaining = grace_deadline - monotonic_time_ms();
+            if (remaining <= 0) break;
+            if (scan->pidfd >= 0) {
+                struct pollfd pfd = {.fd = scan->pidfd, .events = POLLIN};
+                poll(&pfd, 1, (int)remaining);
+            } else {
+                precise_sleep(0.01);
             }
-            
-            usleep(100000); // 100ms delay
         }
-        
-        // Check if child is still running and kill if necessary
-        if (waitpid(pid, &status, WNOHANG) == 0) {
-            kill(pid, SIGTERM);
-            usleep(500000); // 500ms grace period
-            if (waitpid(pid, &status, WNOHANG) == 0) {
-                kill(pid, SIGKILL);
+        if (!reaped) {
+            kill(-scan->pid, SIGKILL);
+            while (waitpid(scan->pid, &status, 0) < 0 && errno == EINTR) {
             }
-            waitpid(pid, &status, 0);
         }
-        
-        // Copy results from shared memory if scan was successful
-        if (shared_data->scan_complete && shared_data->scan_success && shared_data->result_count > 0) {
-            int copy_count = (shared_data->result_count < max_results) ? shared_data->result_count : max_results;
-            memcpy(results, shared_data->results, copy_count * sizeof(scan_result_t));
-            final_count = copy_count;
-        }
-        
-        // Cleanup shared memory
-        munmap(shared_data, sizeof(shared_scan_data_t));
-        close(shm_fd);
-        shm_unlink("/wifi_scan_shm");
-        
-        return final_count;
     }
+    if (scan->pidfd >= 0) close(scan->pidfd);
+    close(scan->done_fd);
+    
+    // Copy results from shared memory if scan was successful
+    int complete = __atomic_load_n(&shared_data->scan_complete, __ATOMIC_ACQUIRE);
+    if (complete && shared_data->scan_success && shared_data->result_count > 0) {
+        int copy_count = (shared_data->result_count < max_results) ? shared_data->result_count : max_results;
+        memcpy(results, shared_data->results, copy_count * sizeof(scan_result_t));
+        final_count = copy_count;
+    }
+    memset(&last_scan_timing, 0, sizeof(last_scan_timing));
+    last_scan_timing.handoff_us = -1;
+    if (complete) {
+        memcpy(&last_scan_timing, &shared_data->timing, sizeof(scan_timing_t));
+        last_scan_timing.handoff_us = signalled ? (int)((woke_ns - shared_data->completed_ns) / 1000) : -1;
+    }
+    
+    munmap(shared_data, sizeof(shared_scan_data_t));
+    memset(scan, 0, sizeof(forked_scan_t));
+    scan->done_fd = -1;
+    scan->pidfd = -1;
+    return final_count;
 }
 
-void continuous_scan_loop(const char *interface_name, float delay_seconds) {
-    scan_session_t session;
-    int scan_number = 1;
+// Forked scan worker: sleep until the completion signal, the child dying, the deadline or Ctrl-C
+int perform_forked_scan(const char *interface_name, scan_result_t *results, int max_results) {
+    forked_scan_t scan;
     
-    // Enforce minimum scan interval for stability
-    const float minimum_scan_interval = 0.5; // Minimum 0.5 seconds between scans
-    if (delay_seconds < minimum_scan_interval) {
-        printf("{\"warning\": \"Scan interval too low, increasing to %.1f seconds for hardware stability\"}\n", minimum_scan_interval);
-        delay_seconds = minimum_scan_interval;
+    if (forked_scan_start(interface_name, &scan) != 0) {
+        // Fall back to direct scanning if the mapping or the fork fails
+        return perform_scan(interface_name, results, max_results);
     }
     
+    long long deadline = scan.started_ms + FORKED_SCAN_TIMEOUT_MS;
     while (keep_running) {
-        memset(&session, 0, sizeof(session));
-        
-        // Get current interface info
-        get_interface_info(interface_name, &session.interface);
-        
-        // Perform scan using forked approach for better reliability
-        clock_t start_time = clock();
-        session.result_count = perform_forked_scan(interface_name, session.results, MAX_SCAN_RESULTS);
-        clock_t end_time = clock();
-        
-        session.scan_time = time(NULL);
-        session.scan_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        
-        // Print scan results in JSON format
-        printf("{\n");
-        printf("  \"scan_number\": %d,\n", scan_number);
-        printf("  \"interface\": \"%s\",\n", interface_name);
-        printf("  \"scan_time\": %ld,\n", session.scan_time);
-        printf("  \"scan_duration_ms\": %d,\n", session.scan_duration_ms);
-        printf("  \"scan_delay\": %.3f,\n", delay_seconds);
-        printf("  \"results_count\": %d,\n", session.result_count);
-        printf("  \"interface_info\": ");
-        print_interface_json(&session.interface);
-        printf(",\n");
-        printf("  \"scan_results\": [\n");
-        
-        for (int i = 0; i < session.result_count; i++) {
-            print_scan_result_json(&session.results[i], (i == session.result_count - 1));
-        }
-        
-        printf("  ]\n");
-        printf("}\n");
-        fflush(stdout);
-        
-        scan_number++;
-        
-        if (keep_running) {
-            precise_sleep(delay_seconds);
-        }
+        struct pollfd fds[2] = {{.fd = scan.done_fd, .events = POLLIN}, {.fd = scan.pidfd, .events = POLLIN}};
+        siginfo_t info;
+        long long remaining = deadline - monotonic_time_ms();
+        if (remaining <= 0) break;
+        // Without a pidfd a crashed child is noticed by waitid once a second
+        int wait_ms = (scan.pidfd < 0 && remaining > 1000) ? 1000 : (int)remaining;
+        int ready = poll(fds, scan.pidfd >= 0 ? 2 : 1, wait_ms);
+        // Ctrl-C: forked_scan_finish kills the unfinished child group instead of waiting it out
+        if (ready < 0 && (errno != EINTR || !keep_running)) break;
+        if ((fds[0].revents & POLLIN) || (fds[1].revents & POLLIN)) break;
+        // Exited without signalling; WNOWAIT leaves the reaping to forked_scan_finish
+        info.si_pid = 0;
+        if (waitid(P_PID, scan.pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == scan.pid) break;
     }
+    
+    return forked_scan_finish(&scan, results, max_results);
+}
+
+void complete_timed_scan(scan_session_t *session, long long info_start_ms, long long scan_start_ms) {
+    long long end_ms = monotonic_time_ms();
+    
+    get_last_scan_timing(&session->timing);
+    session->timing.interface_info_ms = (int)(scan_start_ms - info_start_ms);
+    session->timing.process_overhead_ms = (int)(end_ms - scan_start_ms) - session->timing.scan_command_ms -
+                                          session->timing.parse_ms - session->timing.retry_wait_ms;
+    if (session->timing.process_overhead_ms < 0) session->timing.process_overhead_ms = 0;
+    session->scan_time = time(NULL);
+    session->scan_duration_ms = (int)(end_ms - scan_start_ms);
+}
+
+// Interface query plus forked scan with a wall-clock breakdown. clock() would only
+// count this process's CPU time, which excludes the scan child and the kernel scan.
+int run_timed_scan(const char *interface_name, scan_session_t *session) {
+    long long start_ms = monotonic_time_ms();
+    
+    get_interface_info(interface_name, &session->interface);
+    long long scan_start_ms = monotonic_time_ms();
+    session->result_count = perform_forked_scan(interface_name, session->results, MAX_SCAN_RESULTS);
+    complete_timed_scan(session, start_ms, scan_start_ms);
+    return session->result_count;
+}
+
+// Scans run on a fixed-rate schedule: delay_seconds is the period between scan starts.
+// The scan child is watched by the monitor's event loop rather than waited for.
+void continuous_scan_loop(const char *interface_name, float delay_seconds) {
+    monitor_config_t config;
+    
+    memset(&config, 0, sizeof(config));
+    config.interfaces[0] = interface_name;
+    config.interface_count = 1;
+    config.scan_period = delay_seconds;
+    monitor_run(&config, NULL);
 }
 
 void continuous_info_loop(const char *interface_name, float delay_seconds) {
-    wifi_interface_t interface_info;
-    int info_number = 1;
+    monitor_config_t config;
     
-    while (keep_running) {
-        memset(&interface_info, 0, sizeof(interface_info));
-        
-        // Get current interface info with timing
-        clock_t start_time = clock();
-        int result = get_interface_info(interface_name, &interface_info);
-        clock_t end_time = clock();
-        
-        time_t current_time = time(NULL);
-        int info_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        
-        // Print interface info in JSON format
-        printf("{\n");
-        printf("  \"info_number\": %d,\n", info_number);
-        printf("  \"interface\": \"%s\",\n", interface_name);
-        printf("  \"info_time\": %ld,\n", current_time);
-        printf("  \"info_duration_ms\": %d,\n", info_duration_ms);
-        printf("  \"info_delay\": %.3f,\n", delay_seconds);
-        printf("  \"status\": \"%s\",\n", (result == 0) ? "success" : "error");
-        printf("  \"interface_info\": ");
-        print_interface_json(&interface_info);
-        printf("\n");
-        printf("}\n");
-        fflush(stdout);
+    memset(&config, 0, sizeof(config));
+    config.interfaces[0] = interface_name;
+    config.interface_count = 1;
+    config.info_period = delay_seconds;
+    monitor_run(&config, NULL);
+}
+
+static int fixed_link_waits = 0;
+
+void set_fixed_link_waits(int fixed) {
+    fixed_link_waits = fixed;
+}
+
+// Bounded wait for IFF_* link flags via rtnetlink. When netlink is unavailable the
+// full bound is slept, which matches the old fixed delays. Returns 1 if reached.
+int wait_for_link_state(const char *interface_name, unsigned int flags_set, unsigned int flags_clear, int timeout_ms) {
+    if (fixed_link_waits) {
+        precise_sleep(timeout_ms / 1000.0f);
+        return 0;
+    }
+    int result = rtnl_wait_for_link_flags(interface_name, flags_set, flags_clear, timeout_ms, NULL);
+    if (result < 0) {
+        precise_sleep(timeout_ms / 1000.0f);
+        return 0;
+    }
+    return result;
+}
+
+// Poll for process exit in short steps instead of sleeping the whole grace period
+int wait_for_process_exit(pid_t pid, int timeout_ms) {
+    long long deadline = monotonic_time_ms() + timeout_ms;
+    
+    while (kill(pid, 0) == 0 || errno == EPERM) {
+        if (monotonic_time_ms() >= deadline) return 0;
+        precise_sleep(0.01);
+    }
+    return 1;
+}
+
+// Bring the link down and up again, waiting on IFF_UP transitions rather than fixed delays
+int reset_interface_link(const char *interface_name) {
+    const char *const link_down[] = {"ip", "link", "set", interface_name, "down", NULL};
+    const char *const link_up[] = {"ip", "link", "set", interface_name, "up", NULL};
+    
+    execute_command_with_logging(link_down, "Bringing interface down");
+    wait_for_link_state(interface_name, 0, IFF_UP, 500);
+    
+    int result = execute_command_with_logging(link_up, "Bringing interface up");
+    // Wireless links only gain IFF_RUNNING once associated, so IFF_UP is the readiness condition
+    if (!wait_for_link_state(interface_name, IFF_UP, 0, 1000)) {
+        printf("[WARNING] %s did not report IFF_UP within 1000 ms\n", interface_name);
+    }
+    return result;
+}
+
+static void run_iw_disconnect(const char *interface_name) {
+    const char *const argv[] = {"iw", "dev", interface_name, "disconnect", NULL};
+    command_run(argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL);
+}
+
+// Record where the link is (BSSID, channel) and, when a supplicant owns it, which of its
+// networks is selected plus any exportable PMKSA entries
+static void capture_network_profile(const char *interface_name, network_profile_t *profile) {
+    supplicant_ctrl_t ctrl;
+    link_state_t link;
+    char reply[SUPPLICANT_CTRL_REPLY_LEN];
+    char value[64];
+    char command[64];
+    
+    memset(profile, 0, sizeof(network_profile_t));
+    profile->network_id = -1;
+    
+    if (link_state_sample(interface_name, &link) == 0 && link.connected) {
+        strncpy(profile->bssid, link.bssid, MAX_MAC_LEN - 1);
+        profile->frequency = link.frequency;
+    }
+    
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) != 0) return;
+    
+    if (supplicant_ctrl_request(&ctrl, "STATUS", reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) > 0 &&
+        supplicant_reply_get_field(reply, "wpa_state", value, sizeof(value)) == 0 && strcmp(value, "COMPLETED") == 0 &&
+        supplicant_reply_get_field(reply, "id", value, sizeof(value)) == 0) {
+        profile->supplicant_managed = 1;
+        profile->network_id = atoi(value);
+        supplicant_reply_get_field(reply, "bssid", profile->bssid, sizeof(profile->bssid));
+        if (supplicant_reply_get_field(reply, "freq", value, sizeof(value)) == 0) {
+            profile->frequency = atoi(value);
+        }
         
-        info_number++;
+        // FAIL means the network has no bssid of its own; all zeros clears a pin again
+        snprintf(command, sizeof(command), "GET_NETWORK %d bssid", profile->network_id);
+        if (supplicant_ctrl_request(&ctrl, command, value, sizeof(value), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS) <= 0 ||
+            strncmp(value, "FAIL", 4) == 0) {
+            strcpy(value, "00:00:00:00:00:00");
+        }
+        value[strcspn(value, "\n")] = '\0';
+        strncpy(profile->configured_bssid, value, MAX_MAC_LEN - 1);
         
-        if (keep_running) {
-            precise_sleep(delay_seconds);
+        // Only builds with an external PMKSA cache answer this; others reply FAIL or UNKNOWN COMMAND
+        snprintf(command, sizeof(command), "PMKSA_GET %d", profile->network_id);
+        int len = supplicant_ctrl_request(&ctrl, command, reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS);
+        if (len > 0 && len < MAX_PMKSA_LEN && strncmp(reply, "FAIL", 4) != 0 && strncmp(reply, "UNKNOWN", 7) != 0) {
+            strncpy(profile->pmksa, reply, MAX_PMKSA_LEN - 1);
         }
     }
+    supplicant_ctrl_close(&ctrl);
 }
 
 int save_interface_state(const char *interface_name, wifi_interface_t *saved_state) {
+    // The saved state must reflect the interface right now, not a cached snapshot
+    interface_cache_invalidate(interface_name);
     int result = get_interface_info(interface_name, saved_state);
     if (result == 0) {
         saved_state->was_connected = (strlen(saved_state->ssid) > 0) ? 1 : 0;
+        if (saved_state->was_connected) {
+            capture_network_profile(interface_name, &saved_state->profile);
+        }
     }
     return result;
 }
 
+// Reselect the saved network on its BSSID and channel, so the supplicant skips the full scan.
+// Returns 0 once it reports CONNECTED.
+static int reattach_supplicant_network(const char *interface_name, const network_profile_t *profile) {
+    supplicant_ctrl_t ctrl;
+    supplicant_wait_result_t wait_result;
+    char command[MAX_PMKSA_LEN + 32];
+    char reply[64];
+    int enabled_networks[SUPPLICANT_SESSION_MAX_NETWORKS];
+    int result = -1;
+    
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) != 0 ||
+        supplicant_ctrl_attach(&ctrl) != 0) {
+        supplicant_ctrl_close(&ctrl);
+        return -1;
+    }
+    
+    // Cached PMKSAs let 802.1X and SAE networks skip the full authentication
+    char pmksa[MAX_PMKSA_LEN];
+    char *saveptr = NULL;
+    strncpy(pmksa, profile->pmksa, sizeof(pmksa) - 1);
+    pmksa[sizeof(pmksa) - 1] = '\0';
+    for (char *entry = strtok_r(pmksa, "\n", &saveptr); entry; entry = strtok_r(NULL, "\n", &saveptr)) {
+        snprintf(command, sizeof(command), "PMKSA_ADD %d %s", profile->network_id, entry);
+        supplicant_ctrl_request(&ctrl, command, reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS);
+    }
+    
+    // SELECT_NETWORK disables every other network; only the ones enabled now are handed back
+    int enabled_count = supplicant_ctrl_list_enabled_networks(&ctrl, enabled_networks, SUPPLICANT_SESSION_MAX_NETWORKS);
+    
+    if (supplicant_ctrl_select_network_pinned(&ctrl, profile->network_id, profile->bssid, profile->frequency) == 0 &&
+        supplicant_wait_for_connection(&ctrl, RESTORE_TIMEOUT_MS, &wait_result) == 0) {
+        result = 0;
+    }
+    
+    // Unpin and hand the supplicant its other networks back
+    snprintf(command, sizeof(command), "BSSID %d %s", profile->network_id,
+             profile->configured_bssid[0] ? profile->configured_bssid : "00:00:00:00:00:00");
+    supplicant_ctrl_request(&ctrl, command, reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS);
+    if (enabled_count > 0) supplicant_ctrl_enable_networks(&ctrl, enabled_networks, enabled_count);
+    supplicant_ctrl_close(&ctrl);
+    return result;
+}
+
+int get_last_restore_duration_ms(void) {
+    return last_restore_duration_ms;
+}
+
 int restore_interface_state(const char *interface_name, const wifi_interface_t *saved_state) {
-    char command[MAX_COMMAND_LEN];
+    const network_profile_t *profile = &saved_state->profile;
+    long long start_ms = monotonic_time_ms();
     int result = 0;
     
+    last_restore_duration_ms = -1;
+    
+    // A supplicant that owned the link reattaches itself, without a disconnect first
+    if (saved_state->was_connected && profile->supplicant_managed) {
+        if (reattach_supplicant_network(interface_name, profile) == 0) {
+            last_restore_duration_ms = (int)(monotonic_time_ms() - start_ms);
+            printf("[RESTORE] Reattached %s to %s (%s, %d MHz) in %d ms\n", interface_name, saved_state->ssid,
+                   profile->bssid, profile->frequency, last_restore_duration_ms);
+            return 0;
+        }
+        printf("[RESTORE] Pinned reconnect to %s failed, falling back to iw connect\n", saved_state->ssid);
+    }
+    
     // Disconnect from any current network
-    snprintf(command, sizeof(command), "iw dev %s disconnect 2>/dev/null", interface_name);
-    system(command);
+    run_iw_disconnect(interface_name);
     
-    // Wait a moment for disconnection
-    precise_sleep(0.5);
+    // Wait for the carrier to drop instead of a fixed delay
+    wait_for_link_state(interface_name, 0, IFF_RUNNING, 500);
     
-    // If there was an original connection, attempt to restore it
+    // If there was an original connection, attempt to restore it on the same channel and BSS
     if (saved_state->was_connected && strlen(saved_state->ssid) > 0) {
-        snprintf(command, sizeof(command), "iw dev %s connect \"%s\" 2>/dev/null", 
-                 interface_name, saved_state->ssid);
-        result = system(command);
+        // The SSID is its own argument, so quotes or spaces in it need no escaping
+        char frequency[16];
+        const char *connect_argv[] = {"iw", "dev", interface_name, "connect", saved_state->ssid, NULL, NULL, NULL};
+        if (profile->frequency > 0 && profile->bssid[0]) {
+            snprintf(frequency, sizeof(frequency), "%d", profile->frequency);
+            connect_argv[5] = frequency;
+            connect_argv[6] = profile->bssid;
+        }
+        result = command_run(connect_argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL);
         
-        // Wait for connection attempt
-        precise_sleep(2.0);
+        // Wait for the association to bring the carrier up
+        if (result == 0 && wait_for_link_state(interface_name, IFF_RUNNING, 0, RESTORE_TIMEOUT_MS)) {
+            last_restore_duration_ms = (int)(monotonic_time_ms() - start_ms);
+        }
     }
     
     return (result == 0) ? 0 : -1;
 }
 
 char* generate_random_filename(void) {
-    static char filename[32];
-    srand((unsigned int)time(NULL) + (unsigned int)getpid());
-    snprintf(filename, sizeof(filename), "wpa_test_%08x", rand());
+    // Per-thread buffer and sequence so parallel batch tests never share a config file
+    static __thread char filename[48];
+    static unsigned int filename_sequence = 0;
+    unsigned int seed = (unsigned int)time(NULL) ^ ((unsigned int)getpid() << 16) ^ (unsigned int)pthread_self();
+    snprintf(filename, sizeof(filename), "wpa_test_%08x_%u", rand_r(&seed),
+             __sync_fetch_and_add(&filename_sequence, 1));
     return filename;
 }
 
@@ -683,272 +1010,372 @@ void log_command_execution(const char *command, const char *description) {
     fflush(stdout);
 }
 
-int execute_command_with_logging(const char *command, const char *description) {
+int execute_command_with_logging(const char *const argv[], const char *description) {
+    char command[MAX_COMMAND_LEN];
+    command_status_t status;
+    
+    command_format(argv, command, sizeof(command));
     log_command_execution(command, description);
-    int result = system(command);
-    printf("[RESULT] Exit code: %d %s\n", result, (result == 0) ? "(SUCCESS)" : "(FAILED)");
+    int result = command_run(argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, &status);
+    printf("[RESULT] Exit code: %d %s\n", status.exit_code,
+           (result == 0) ? "(SUCCESS)" : status.timed_out ? "(TIMED OUT)" : "(FAILED)");
     printf("----------------------------------------\n");
     fflush(stdout);
     return result;
 }
 
-FILE* execute_command_with_output_logging(const char *command, const char *description) {
+int execute_command_with_output_logging(const char *const argv[], const char *description) {
+    char command[MAX_COMMAND_LEN];
+    command_output_t *output = command_shared_output();
+    command_status_t status;
+    
+    command_format(argv, command, sizeof(command));
     log_command_execution(command, description);
-    FILE *fp = popen(command, "r");
-    if (fp) {
+    int result = command_run(argv, COMMAND_CAPTURE_STDERR, COMMAND_DEFAULT_TIMEOUT_MS, output, &status);
+    if (status.pid != 0) {
         printf("[OUTPUT]\n");
-        char line[MAX_LINE_LEN];
-        while (fgets(line, sizeof(line), fp)) {
-            printf("  %s", line);
+        // Indent every line the way the output block has always been shown
+        for (char *line = (output && output->data) ? output->data : ""; *line; ) {
+            char *end = strchr(line, '\n');
+            int length = end ? (int)(end - line) : (int)strlen(line);
+            printf("  %.*s\n", length, line);
+            line += length + (end ? 1 : 0);
         }
         printf("[END OUTPUT]\n");
-        printf("----------------------------------------\n");
-        fflush(stdout);
-        pclose(fp);
-        
-        // Re-open for actual use
-        fp = popen(command, "r");
     } else {
         printf("[ERROR] Failed to execute command\n");
-        printf("----------------------------------------\n");
-        fflush(stdout);
     }
-    return fp;
+    printf("----------------------------------------\n");
+    fflush(stdout);
+    return result;
 }
 
-int cleanup_interface_connections(const char *interface_name) {
-    char command[MAX_COMMAND_LEN];
+// pgrep/pkill -f pattern for a command line that starts with "<program> -i <interface>" and
+// nothing longer, so tests running on other interfaces (wlan1 vs wlan10) keep theirs. The
+// interface name is escaped: "wlan.0" must not match wlanX0, nor "wl+" every wlan.
+static void format_interface_process_pattern(const char *program, const char *interface_name,
+                                             char *pattern, size_t size) {
+    size_t len = (size_t)snprintf(pattern, size, "^([^ ]*/)?%s -i ", program);
+    
+    for (const char *p = interface_name; *p && len + 3 < size; p++) {
+        if (strchr(".[]{}()\\*+?^$|", *p)) pattern[len++] = '\\';
+        pattern[len++] = *p;
+    }
+    snprintf(pattern + len, size - len, "( |$)");
+}
+
+void kill_interface_process(const char *program, const char *interface_name) {
+    char pattern[MAX_COMMAND_LEN];
     
+    format_interface_process_pattern(program, interface_name, pattern, sizeof(pattern));
+    const char *const argv[] = {"pkill", "-f", pattern, NULL};
+    command_run(argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL);
+}
+
+void flush_interface_addresses(const char *interface_name) {
+    const char *const argv[] = {"ip", "addr", "flush", "dev", interface_name, NULL};
+    command_run(argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, NULL);
+}
+
+// Kill udhcpc and wpa_supplicant instances bound to this interface only, so
+// tests running on other interfaces keep their processes
+void terminate_interface_processes(const char *interface_name) {
+    kill_interface_process("udhcpc", interface_name);
+    kill_interface_process("wpa_supplicant", interface_name);
+}
+
+int cleanup_interface_connections(const char *interface_name) {
     printf("[CLEANUP] Cleaning up existing connections on %s...\n", interface_name);
     
-    // Kill existing udhcpc processes for this interface
-    snprintf(command, sizeof(command), "killall udhcpc 2>/dev/null || true");
-    system(command);
-    
-    // Kill existing wpa_supplicant processes
-    system("killall wpa_supplicant 2>/dev/null || true");
+    // Kill existing udhcpc and wpa_supplicant processes for this interface
+    terminate_interface_processes(interface_name);
     
     // Flush IP addresses from interface
-    snprintf(command, sizeof(command), "ip addr flush dev %s 2>/dev/null", interface_name);
-    system(command);
+    flush_interface_addresses(interface_name);
     
     // Disconnect from any current network
-    snprintf(command, sizeof(command), "iw dev %s disconnect 2>/dev/null", interface_name);
-    system(command);
+    run_iw_disconnect(interface_name);
     
-    precise_sleep(1.0); // Allow cleanup to complete
+    // Cleanup is complete once the link has no carrier
+    wait_for_link_state(interface_name, 0, IFF_RUNNING, 1000);
     
     printf("[CLEANUP] Interface cleanup completed\n");
     return 0;
 }
 
+// Kept in the private runtime directory so nobody else can plant or swap the pid we later signal
 int create_wpa_supplicant_pidfile(const char *interface_name, char *pidfile_path, size_t pidfile_size) {
-    snprintf(pidfile_path, pidfile_size, "/tmp/wpa_supplicant_%s_%d.pid", interface_name, getpid());
+    if (ensure_runtime_state_dir() != 0) return -1;
+    snprintf(pidfile_path, pidfile_size, RUNTIME_STATE_DIR "/wpa_supplicant_%s_%d.pid", interface_name, getpid());
+    unlink(pidfile_path);
     return 0;
 }
 
 int verify_ip_assignment(const char *interface_name, int max_wait_seconds) {
-    char command[MAX_COMMAND_LEN];
-    FILE *fp;
-    char line[MAX_LINE_LEN];
-    time_t start_time = time(NULL);
-    int ip_count = 0;
+    char address[INET6_ADDRSTRLEN + 8];
     
     printf("[DHCP] Waiting up to %d seconds for IP assignment...\n", max_wait_seconds);
+    fflush(stdout);
     
-    while ((time(NULL) - start_time) < max_wait_seconds) {
-        snprintf(command, sizeof(command), "ip addr show %s | grep 'inet ' | grep -v '127.0.0.1' | wc -l", interface_name);
-        fp = popen(command, "r");
-        
-        if (fp) {
-            if (fgets(line, sizeof(line), fp)) {
-                ip_count = atoi(line);
-                if (ip_count > 0) {
-                    pclose(fp);
-                    printf("[DHCP] IP address assigned successfully\n");
-                    
-                    // Display the assigned IP
-                    snprintf(command, sizeof(command), "ip addr show %s | grep 'inet ' | grep -v '127.0.0.1'", interface_name);
-                    fp = popen(command, "r");
-                    if (fp) {
-                        printf("[DHCP] Assigned IP: ");
-                        while (fgets(line, sizeof(line), fp)) {
-                            printf("%s", line);
-                        }
-                        pclose(fp);
-                    }
-                    return 1; // Success
-                }
-            }
-            pclose(fp);
-        }
-        
-        precise_sleep(0.5); // Check every 500ms
+    // Block on rtnetlink address notifications instead of polling 'ip addr'
+    int wait_result = rtnl_wait_for_address(interface_name, max_wait_seconds * 1000, address, sizeof(address));
+    if (wait_result < 0) {
+        printf("[ERROR] Unable to monitor address changes on %s\n", interface_name);
+        return 0;
+    }
+    
+    if (wait_result > 0) {
+        printf("[DHCP] IP address assigned successfully\n");
+        printf("[DHCP] Assigned IP: %s\n", address);
+        return 1; // Success
     }
     
     printf("[DHCP] No IP address assigned within timeout period\n");
     return 0; // Timeout
 }
 
+const char* get_wpa_failure_reason(void) {
+    return wpa_failure_reason;
+}
+
+// Terminate the daemon recorded in the PID file, escalating to SIGKILL after the grace period
+static void terminate_wpa_supplicant_from_pidfile(const char *pidfile_path, float grace_seconds, const char *label) {
+    FILE *pidfile = fopen(pidfile_path, "r");
+    if (pidfile) {
+        char pid_str[32];
+        if (fgets(pid_str, sizeof(pid_str), pidfile)) {
+            pid_t wpa_daemon_pid = atoi(pid_str);
+            printf("[CLEANUP] Terminating %s process (PID: %d)\n", label, wpa_daemon_pid);
+            
+            // Graceful termination
+            kill(wpa_daemon_pid, SIGTERM);
+            wait_for_process_exit(wpa_daemon_pid, (int)(grace_seconds * 1000));
+            
+            // Force termination if needed
+            if (kill(wpa_daemon_pid, 0) == 0) {
+                printf("[CLEANUP] Force terminating %s\n", label);
+                kill(wpa_daemon_pid, SIGKILL);
+            }
+        }
+        fclose(pidfile);
+    }
+}
+
+// Wait on an attached control socket and record the supplicant's failure reason.
+// Returns 0 connected, -1 failed, -2 timed out.
+static int wait_on_supplicant_events(supplicant_ctrl_t *ctrl, long long start_ms, int timeout_ms) {
+    supplicant_wait_result_t wait_result;
+    
+    last_wait_start_ms = monotonic_time_ms();
+    int remaining_ms = timeout_ms - (int)(last_wait_start_ms - start_ms);
+    supplicant_wait_for_connection(ctrl, remaining_ms > 0 ? remaining_ms : 0, &wait_result);
+    memcpy(&last_wait_result, &wait_result, sizeof(wait_result));
+    
+    strncpy(wpa_failure_reason, wait_result.reason, sizeof(wpa_failure_reason) - 1);
+    wpa_failure_reason[sizeof(wpa_failure_reason) - 1] = '\0';
+    
+    if (wait_result.outcome == 0) {
+        printf("[SUCCESS] CTRL-EVENT-CONNECTED received after %lld ms\n", wait_result.connected_ms - start_ms);
+    } else if (wait_result.outcome == -1) {
+        printf("[ERROR] Connection failed after %lld ms: %s\n", monotonic_time_ms() - start_ms, wait_result.reason);
+    }
+    return wait_result.outcome;
+}
+
+// Wait for the connection outcome on the supplicant control socket.
+// Returns 0 connected, -1 failed, -2 timed out, -3 control interface unavailable.
+static int wait_for_supplicant_connection(const char *interface_name, int timeout_ms) {
+    supplicant_ctrl_t ctrl;
+    long long start_ms = monotonic_time_ms();
+    int open_timeout_ms = (timeout_ms < 2000) ? timeout_ms : 2000;
+    
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, open_timeout_ms) != 0) {
+        return -3;
+    }
+    if (supplicant_ctrl_attach(&ctrl) != 0) {
+        supplicant_ctrl_close(&ctrl);
+        return -3;
+    }
+    
+    printf("[WPA] Attached to control interface %s/%s, waiting for connection events\n", 
+           SUPPLICANT_CTRL_DIR, interface_name);
+    fflush(stdout);
+    
+    int outcome = wait_on_supplicant_events(&ctrl, start_ms, timeout_ms);
+    supplicant_ctrl_close(&ctrl);
+    return outcome;
+}
+
+// True when a wpa_supplicant already answers on this interface's control socket
+static int supplicant_is_running(const char *interface_name) {
+    supplicant_ctrl_t ctrl;
+    
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) != 0) {
+        return 0;
+    }
+    supplicant_ctrl_close(&ctrl);
+    return 1;
+}
+
+// Add and select the test network on the running supplicant (ADD_NETWORK/SET_NETWORK),
+// so no config file or daemon start is needed. Returns 0 connected, -1 failed, -2 timed out.
+static int connect_via_running_supplicant(const char *interface_name, const char *ssid, const char *psk_hex,
+                                          int timeout_seconds, int *network_id) {
+    supplicant_ctrl_t ctrl;
+    long long start_ms = monotonic_time_ms();
+    
+    *network_id = -1;
+    wpa_failure_reason[0] = '\0';
+    
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) != 0 ||
+        supplicant_ctrl_attach(&ctrl) != 0) {
+        supplicant_ctrl_close(&ctrl);
+        strncpy(wpa_failure_reason, "wpa_supplicant control interface not available", sizeof(wpa_failure_reason) - 1);
+        return -1;
+    }
+    
+    *network_id = supplicant_ctrl_add_network(&ctrl, ssid, psk_hex);
+    if (*network_id < 0 || supplicant_ctrl_select_network(&ctrl, *network_id) != 0) {
+        strncpy(wpa_failure_reason, "wpa_supplicant rejected the network configuration", sizeof(wpa_failure_reason) - 1);
+        supplicant_ctrl_close(&ctrl);
+        return -1;
+    }
+    
+    printf("[WPA] Provisioned network id %d on running wpa_supplicant, waiting for connection events\n", *network_id);
+    fflush(stdout);
+    
+    int outcome = wait_on_supplicant_events(&ctrl, start_ms, timeout_seconds * 1000);
+    supplicant_ctrl_close(&ctrl);
+    return outcome;
+}
+
+// Remove a provisioned test network and let the supplicant return to its own networks
+static void release_provisioned_network(const char *interface_name, int network_id) {
+    supplicant_ctrl_t ctrl;
+    char command[64];
+    char reply[64];
+    
+    if (network_id < 0) return;
+    if (supplicant_ctrl_open_wait(&ctrl, SUPPLICANT_CTRL_DIR, interface_name, 0) != 0) return;
+    
+    printf("[CLEANUP] Removing provisioned network id %d\n", network_id);
+    // Disable first so a failing network stops retrying before it is removed
+    snprintf(command, sizeof(command), "DISABLE_NETWORK %d", network_id);
+    supplicant_ctrl_request(&ctrl, command, reply, sizeof(reply), SUPPLICANT_CTRL_REQUEST_TIMEOUT_MS);
+    supplicant_ctrl_remove_network(&ctrl, network_id);
+    
+    // The networks SELECT_NETWORK disabled stay disabled until the session ends
+    // (supplicant_session_stop), so they do not reconnect between tests
+    supplicant_ctrl_close(&ctrl);
+}
+
 int start_wpa_supplicant_with_timeout(const char *interface_name, const char *config_file, int timeout_seconds, pid_t *wpa_pid) {
-    pid_t pid;
-    int status;
-    char command[MAX_COMMAND_LEN];
     char pidfile_path[256];
     time_t start_time = time(NULL);
     time_t last_check = start_time;
     int connection_checks = 0;
     int max_connection_checks = timeout_seconds * 10; // Check every 100ms
     
-    printf("[WPA] Starting enhanced WPA supplicant with time-based monitoring...\n");
-    printf("[WPA] Timeout: %d seconds, Check interval: 100ms\n", timeout_seconds);
+    printf("[WPA] Starting WPA supplicant with control interface event monitoring...\n");
+    printf("[WPA] Timeout: %d seconds\n", timeout_seconds);
+    wpa_failure_reason[0] = '\0';
     
     // Cleanup existing connections first
     cleanup_interface_connections(interface_name);
     
     // Create PID file path for better process tracking
-    create_wpa_supplicant_pidfile(interface_name, pidfile_path, sizeof(pidfile_path));
+    if (create_wpa_supplicant_pidfile(interface_name, pidfile_path, sizeof(pidfile_path)) != 0) {
+        printf("[ERROR] Cannot prepare %s for the wpa_supplicant PID file\n", RUNTIME_STATE_DIR);
+        strncpy(wpa_failure_reason, "runtime state directory unavailable", sizeof(wpa_failure_reason) - 1);
+        return -1;
+    }
     
-    // Fork a child process to start wpa_supplicant
-    pid = fork();
+    // Start wpa_supplicant with PID file, no shell; -B returns once it has daemonized
+    const char *const wpa_argv[] = {"wpa_supplicant", "-i", interface_name, "-c", config_file,
+                                    "-P", pidfile_path, "-B", NULL};
+    command_status_t spawn_status;
     
-    if (pid == -1) {
-        printf("[ERROR] Failed to fork process for wpa_supplicant\n");
+    if (command_run(wpa_argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, &spawn_status) != 0) {
+        printf("[ERROR] wpa_supplicant startup failed%s\n", spawn_status.timed_out ? " (timed out)" : "");
+        strncpy(wpa_failure_reason, "wpa_supplicant failed to start", sizeof(wpa_failure_reason) - 1);
+        unlink(pidfile_path);
         return -1;
-    } else if (pid == 0) {
-        // Child process - start wpa_supplicant with PID file
-        snprintf(command, sizeof(command), 
-                 "wpa_supplicant -i %s -c %s -P %s -B 2>/dev/null", 
-                 interface_name, config_file, pidfile_path);
+    } else {
+        // Wait for connection events from the supplicant
+        *wpa_pid = spawn_status.pid;
         
-        // Redirect output to /dev/null and exec
-        int dev_null = open("/dev/null", O_WRONLY);
-        if (dev_null != -1) {
-            dup2(dev_null, STDOUT_FILENO);
-            dup2(dev_null, STDERR_FILENO);
-            close(dev_null);
-        }
+        printf("[WPA] wpa_supplicant startup completed, waiting for connection events...\n");
         
-        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
-        _exit(1); // If exec fails
-    } else {
-        // Parent process - implement time-based monitoring
-        *wpa_pid = pid;
+        int remaining_ms = timeout_seconds * 1000 - (int)(time(NULL) - start_time) * 1000;
+        int event_result = wait_for_supplicant_connection(interface_name, remaining_ms);
         
-        // Wait for child to complete wpa_supplicant startup
-        int wait_result = waitpid(pid, &status, 0);
-        if (wait_result == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
-            printf("[ERROR] wpa_supplicant startup failed\n");
+        if (event_result == 0) {
+            return 0; // Connection established
+        } else if (event_result == -1) {
+            terminate_wpa_supplicant_from_pidfile(pidfile_path, 0.5, "wpa_supplicant");
             unlink(pidfile_path);
             return -1;
-        }
-        
-        printf("[WPA] wpa_supplicant startup completed, monitoring connection...\n");
-        
-        // Monitor connection with proper time-based checks
-        while ((time(NULL) - start_time) < timeout_seconds && connection_checks < max_connection_checks) {
-            time_t current_time = time(NULL);
+        } else if (event_result == -3) {
+            printf("[WARNING] Control interface unavailable, falling back to link polling\n");
             
-            // Only check every 100ms to avoid excessive system calls
-            if ((current_time - last_check) >= 0.1 || connection_checks == 0) {
-                last_check = current_time;
-                connection_checks++;
+            // Monitor connection with proper time-based checks
+            while ((time(NULL) - start_time) < timeout_seconds && connection_checks < max_connection_checks) {
+                time_t current_time = time(NULL);
                 
-                // Check if wpa_supplicant process is still running via PID file
-                FILE *pidfile = fopen(pidfile_path, "r");
-                if (pidfile) {
-                    char pid_str[32];
-                    if (fgets(pid_str, sizeof(pid_str), pidfile)) {
-                        pid_t wpa_daemon_pid = atoi(pid_str);
-                        if (kill(wpa_daemon_pid, 0) != 0) {
-                            // Process no longer exists
-                            fclose(pidfile);
-                            printf("[ERROR] wpa_supplicant process terminated unexpectedly\n");
-                            unlink(pidfile_path);
-                            return -1;
-                        }
-                    }
-                    fclose(pidfile);
-                } else {
-                    printf("[WARNING] PID file not found, checking via process list\n");
-                }
-                
-                // Enhanced connection verification
-                char check_command[MAX_COMMAND_LEN];
-                
-                // Enhanced connection verification using iw dev link and process checks
-                snprintf(check_command, sizeof(check_command), 
-                         "iw dev %s link | grep -q 'Connected to' && echo 'connected' || echo 'not_connected'",
-                         interface_name);
-                
-                FILE *fp = popen(check_command, "r");
-                if (fp) {
-                    char result[32];
-                    if (fgets(result, sizeof(result), fp)) {
-                        result[strcspn(result, "\n")] = 0;
-                        if (strcmp(result, "connected") == 0) {
-                            pclose(fp);
-                            
-                            // Verify corresponding wpa_supplicant process
-                            snprintf(check_command, sizeof(check_command), 
-                                     "pgrep -f 'wpa_supplicant.*%s' >/dev/null 2>&1 && echo 'process_ok' || echo 'no_process'",
-                                     interface_name);
-                            
-                            fp = popen(check_command, "r");
-                            if (fp) {
-                                if (fgets(result, sizeof(result), fp)) {
-                                    result[strcspn(result, "\n")] = 0;
-                                    pclose(fp);
-                                    printf("[SUCCESS] Connection established after %ld seconds\n", 
-                                           current_time - start_time);
-                                    if (strcmp(result, "process_ok") == 0) {
-                                        printf("[INFO] Active wpa_supplicant process confirmed\n");
-                                    }
-                                    return 0; // Connection established
-                                }
-                                pclose(fp);
+                // Only check every 100ms to avoid excessive system calls
+                if ((current_time - last_check) >= 0.1 || connection_checks == 0) {
+                    last_check = current_time;
+                    connection_checks++;
+                    
+                    // Check if wpa_supplicant process is still running via PID file
+                    FILE *pidfile = fopen(pidfile_path, "r");
+                    if (pidfile) {
+                        char pid_str[32];
+                        if (fgets(pid_str, sizeof(pid_str), pidfile)) {
+                            pid_t wpa_daemon_pid = atoi(pid_str);
+                            if (kill(wpa_daemon_pid, 0) != 0) {
+                                // Process no longer exists
+                                fclose(pidfile);
+                                printf("[ERROR] wpa_supplicant process terminated unexpectedly\n");
+                                strncpy(wpa_failure_reason, "wpa_supplicant terminated unexpectedly", sizeof(wpa_failure_reason) - 1);
+                                unlink(pidfile_path);
+                                return -1;
                             }
                         }
+                        fclose(pidfile);
+                    } else {
+                        printf("[WARNING] PID file not found, checking via process list\n");
+                    }
+                    
+                    // One link sample per tick instead of an iw | grep pipeline
+                    link_state_t link;
+                    if (link_state_sample(interface_name, &link) == 0 && link.connected) {
+                        printf("[SUCCESS] Connection established after %ld seconds\n", 
+                               current_time - start_time);
+                        return 0; // Connection established
+                    }
+                    
+                    // Progress indicator every 2 seconds
+                    if ((current_time - start_time) % 2 == 0 && connection_checks % 20 == 0) {
+                        printf("[WPA] Connection attempt in progress... (%ld/%d seconds)\n", 
+                               current_time - start_time, timeout_seconds);
                     }
-                    if (fp) pclose(fp);
                 }
                 
-                // Progress indicator every 2 seconds
-                if ((current_time - start_time) % 2 == 0 && connection_checks % 20 == 0) {
-                    printf("[WPA] Connection attempt in progress... (%ld/%d seconds)\n", 
-                           current_time - start_time, timeout_seconds);
-                }
+                precise_sleep(0.1); // 100ms interval
             }
-            
-            precise_sleep(0.1); // 100ms interval
         }
         
         // Timeout reached - perform graceful cleanup
         printf("[TIMEOUT] Connection timeout after %d seconds\n", timeout_seconds);
-        
-        // Read PID from file and terminate gracefully
-        FILE *pidfile = fopen(pidfile_path, "r");
-        if (pidfile) {
-            char pid_str[32];
-            if (fgets(pid_str, sizeof(pid_str), pidfile)) {
-                pid_t wpa_daemon_pid = atoi(pid_str);
-                printf("[CLEANUP] Terminating wpa_supplicant process (PID: %d)\n", wpa_daemon_pid);
-                
-                // Graceful termination
-                kill(wpa_daemon_pid, SIGTERM);
-                precise_sleep(0.5);
-                
-                // Force termination if needed
-                if (kill(wpa_daemon_pid, 0) == 0) {
-                    printf("[CLEANUP] Force terminating wpa_supplicant\n");
-                    kill(wpa_daemon_pid, SIGKILL);
-                }
-            }
-            fclose(pidfile);
+        if (strlen(wpa_failure_reason) > 0) {
+            printf("[TIMEOUT] Last supplicant state: %s\n", wpa_failure_reason);
         }
         
-        // Global cleanup for any remaining processes
-        system("killall wpa_supplicant 2>/dev/null || true");
+        terminate_wpa_supplicant_from_pidfile(pidfile_path, 0.5, "wpa_supplicant");
+        
+        // Cleanup for any remaining processes on this interface
+        terminate_interface_processes(interface_name);
         unlink(pidfile_path);
         
         return -2; // Timeout
@@ -956,206 +1383,137 @@ int start_wpa_supplicant_with_timeout(const char *interface_name, const char *co
 }
 
 int start_wpa_supplicant_secured_with_timeout(const char *interface_name, const char *config_file, const char *ssid, int timeout_seconds, pid_t *wpa_pid) {
-    pid_t pid;
-    int status;
-    char command[MAX_COMMAND_LEN];
     char pidfile_path[256];
     time_t start_time = time(NULL);
     time_t last_check = start_time;
     int auth_checks = 0;
     int max_auth_checks = timeout_seconds * 2; // Check every 500ms for authentication
     
-    printf("[AUTH] Starting enhanced WPA/WPA2 authentication with time-based monitoring...\n");
-    printf("[AUTH] Timeout: %d seconds, Authentication check interval: 500ms\n", timeout_seconds);
+    printf("[AUTH] Starting WPA/WPA2 authentication with control interface event monitoring...\n");
+    printf("[AUTH] Timeout: %d seconds\n", timeout_seconds);
     fflush(stdout);
+    wpa_failure_reason[0] = '\0';
     
     // Cleanup existing connections first - enhanced for secured networks
     cleanup_interface_connections(interface_name);
     
     // Create PID file path for better process tracking
-    create_wpa_supplicant_pidfile(interface_name, pidfile_path, sizeof(pidfile_path));
+    if (create_wpa_supplicant_pidfile(interface_name, pidfile_path, sizeof(pidfile_path)) != 0) {
+        printf("[ERROR] Cannot prepare %s for the wpa_supplicant PID file\n", RUNTIME_STATE_DIR);
+        strncpy(wpa_failure_reason, "runtime state directory unavailable", sizeof(wpa_failure_reason) - 1);
+        return -1;
+    }
     
-    // Fork a child process to start wpa_supplicant
-    pid = fork();
+    // Start wpa_supplicant with PID file and debug for secured networks, no shell
+    const char *const wpa_argv[] = {"wpa_supplicant", "-i", interface_name, "-c", config_file,
+                                    "-P", pidfile_path, "-B", "-d", NULL};
+    command_status_t spawn_status;
     
-    if (pid == -1) {
-        printf("[ERROR] Failed to fork process for secured wpa_supplicant\n");
+    if (command_run(wpa_argv, 0, COMMAND_DEFAULT_TIMEOUT_MS, NULL, &spawn_status) != 0) {
+        printf("[ERROR] secured wpa_supplicant startup failed%s\n", spawn_status.timed_out ? " (timed out)" : "");
+        strncpy(wpa_failure_reason, "wpa_supplicant failed to start", sizeof(wpa_failure_reason) - 1);
+        unlink(pidfile_path);
         return -1;
-    } else if (pid == 0) {
-        // Child process - start wpa_supplicant with PID file and debug for secured networks
-        snprintf(command, sizeof(command), 
-                 "wpa_supplicant -i %s -c %s -P %s -B -d 2>/dev/null", 
-                 interface_name, config_file, pidfile_path);
+    } else {
+        // Wait for authentication events from the supplicant
+        *wpa_pid = spawn_status.pid;
         
-        // Redirect output to /dev/null and exec
-        int dev_null = open("/dev/null", O_WRONLY);
-        if (dev_null != -1) {
-            dup2(dev_null, STDOUT_FILENO);
-            dup2(dev_null, STDERR_FILENO);
-            close(dev_null);
-        }
+        printf("[AUTH] Secured wpa_supplicant startup completed, waiting for authentication events...\n");
         
-        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
-        _exit(1); // If exec fails
-    } else {
-        // Parent process - implement enhanced time-based authentication monitoring
-        *wpa_pid = pid;
+        int remaining_ms = timeout_seconds * 1000 - (int)(time(NULL) - start_time) * 1000;
+        int event_result = wait_for_supplicant_connection(interface_name, remaining_ms);
         
-        // Wait for child to complete wpa_supplicant startup
-        int wait_result = waitpid(pid, &status, 0);
-        if (wait_result == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
-            printf("[ERROR] secured wpa_supplicant startup failed\n");
+        if (event_result == 0) {
+            return 0; // Complete authentication success
+        } else if (event_result == -1) {
+            terminate_wpa_supplicant_from_pidfile(pidfile_path, 1.0, "secured wpa_supplicant");
+            run_iw_disconnect(interface_name);
             unlink(pidfile_path);
             return -1;
-        }
-        
-        printf("[AUTH] Secured wpa_supplicant startup completed, monitoring authentication...\n");
-        
-        // Monitor authentication with enhanced time-based checks
-        while ((time(NULL) - start_time) < timeout_seconds && auth_checks < max_auth_checks) {
-            time_t current_time = time(NULL);
+        } else if (event_result == -3) {
+            printf("[WARNING] Control interface unavailable, falling back to link polling\n");
             
-            // Check every 500ms for authentication progress
-            if ((current_time - last_check) >= 0.5 || auth_checks == 0) {
-                last_check = current_time;
-                auth_checks++;
+            // Monitor authentication with enhanced time-based checks
+            while ((time(NULL) - start_time) < timeout_seconds && auth_checks < max_auth_checks) {
+                time_t current_time = time(NULL);
                 
-                // Verify wpa_supplicant process is still running via PID file
-                FILE *pidfile = fopen(pidfile_path, "r");
-                if (pidfile) {
-                    char pid_str[32];
-                    if (fgets(pid_str, sizeof(pid_str), pidfile)) {
-                        pid_t wpa_daemon_pid = atoi(pid_str);
-                        if (kill(wpa_daemon_pid, 0) != 0) {
-                            // Process terminated - check if authentication succeeded
-                            fclose(pidfile);
-                            
-                            // Allow time for interface state to settle
-                            precise_sleep(1.0);
-                            
-                            // Comprehensive authentication verification using iw dev link
-                            char verify_command[MAX_COMMAND_LEN];
-                            snprintf(verify_command, sizeof(verify_command), 
-                                     "iw dev %s link | grep -q 'Connected to' && iw dev %s link | grep -q 'SSID: %s'", 
-                                     interface_name, interface_name, ssid);
-                            
-                            if (system(verify_command) == 0) {
-                                printf("[SUCCESS] Authentication completed successfully after %ld seconds\n", 
-                                       current_time - start_time);
-                                unlink(pidfile_path);
-                                return 0; // Success
-                            } else {
-                                printf("[ERROR] Process terminated but authentication failed\n");
-                                unlink(pidfile_path);
-                                return -1; // Failed
+                // Check every 500ms for authentication progress
+                if ((current_time - last_check) >= 0.5 || auth_checks == 0) {
+                    last_check = current_time;
+                    auth_checks++;
+                    
+                    // Verify wpa_supplicant process is still running via PID file
+                    FILE *pidfile = fopen(pidfile_path, "r");
+                    if (pidfile) {
+                        char pid_str[32];
+                        if (fgets(pid_str, sizeof(pid_str), pidfile)) {
+                            pid_t wpa_daemon_pid = atoi(pid_str);
+                            if (kill(wpa_daemon_pid, 0) != 0) {
+                                // Process terminated - check if authentication succeeded
+                                fclose(pidfile);
+                                
+                                // Allow the interface state to settle (carrier up when associated)
+                                wait_for_link_state(interface_name, IFF_RUNNING, 0, 1000);
+                                
+                                // Authentication succeeded only if the link is up on the target SSID
+                                link_state_t link;
+                                if (link_state_sample(interface_name, &link) == 0 && link_state_matches_ssid(&link, ssid)) {
+                                    printf("[SUCCESS] Authentication completed successfully after %ld seconds\n", 
+                                           current_time - start_time);
+                                    unlink(pidfile_path);
+                                    return 0; // Success
+                                } else {
+                                    printf("[ERROR] Process terminated but authentication failed\n");
+                                    strncpy(wpa_failure_reason, "wpa_supplicant terminated before authentication completed", 
+                                            sizeof(wpa_failure_reason) - 1);
+                                    unlink(pidfile_path);
+                                    return -1; // Failed
+                                }
                             }
                         }
+                        fclose(pidfile);
+                    } else {
+                        printf("[WARNING] PID file not accessible during authentication\n");
                     }
-                    fclose(pidfile);
-                } else {
-                    printf("[WARNING] PID file not accessible during authentication\n");
-                }
-                
-                // Enhanced multi-stage authentication verification
-                char check_command[MAX_COMMAND_LEN];
-                
-                // Stage 1: Check for active link connection
-                snprintf(check_command, sizeof(check_command), 
-                         "iw dev %s link | grep -q 'Connected to' && echo 'connected' || echo 'not_connected'", 
-                         interface_name);
-                
-                FILE *fp = popen(check_command, "r");
-                if (fp) {
-                    char result[32];
-                    if (fgets(result, sizeof(result), fp)) {
-                        result[strcspn(result, "\n")] = 0;
-                        if (strcmp(result, "connected") == 0) {
-                            pclose(fp);
-                            
-                            // Stage 2: Verify SSID matches target
-                            snprintf(check_command, sizeof(check_command), 
-                                     "iw dev %s link | grep -q 'SSID: %s' && echo 'ssid_match' || echo 'ssid_mismatch'",
-                                     interface_name, ssid);
-                            
-                            fp = popen(check_command, "r");
-                            if (fp) {
-                                if (fgets(result, sizeof(result), fp)) {
-                                    result[strcspn(result, "\n")] = 0;
-                                    if (strcmp(result, "ssid_match") == 0) {
-                                        pclose(fp);
-                                        
-                                        // Stage 3: Verify corresponding wpa_supplicant process
-                                        snprintf(check_command, sizeof(check_command), 
-                                                 "pgrep -f 'wpa_supplicant.*%s' >/dev/null 2>&1 && echo 'process_ok' || echo 'no_process'",
-                                                 interface_name);
-                                        
-                                        fp = popen(check_command, "r");
-                                        if (fp) {
-                                            if (fgets(result, sizeof(result), fp)) {
-                                                result[strcspn(result, "\n")] = 0;
-                                                pclose(fp);
-                                                printf("[SUCCESS] Full authentication verified after %ld seconds\n", 
-                                                       current_time - start_time);
-                                                if (strcmp(result, "process_ok") == 0) {
-                                                    printf("[INFO] Active wpa_supplicant process confirmed\n");
-                                                }
-                                                return 0; // Complete authentication success
-                                            }
-                                            pclose(fp);
-                                        }
-                                    }
-                                }
-                                if (fp) pclose(fp);
-                            }
+                    
+                    // Check for an active link to the target SSID; the same sample feeds the progress line
+                    link_state_t link;
+                    int sampled = (link_state_sample(interface_name, &link) == 0);
+                    if (sampled && link_state_matches_ssid(&link, ssid)) {
+                        printf("[SUCCESS] Full authentication verified after %ld seconds\n", 
+                               current_time - start_time);
+                        return 0; // Complete authentication success
+                    }
+                    
+                    // Progress indicator for authentication every 3 seconds
+                    if ((current_time - start_time) % 3 == 0 && auth_checks % 6 == 0) {
+                        printf("[AUTH] Authentication in progress... (%ld/%d seconds)\n", 
+                               current_time - start_time, timeout_seconds);
+                        
+                        // Show current authentication state
+                        if (sampled) {
+                            print_link_state(interface_name, &link);
                         }
                     }
-                    if (fp) pclose(fp);
                 }
                 
-                // Progress indicator for authentication every 3 seconds
-                if ((current_time - start_time) % 3 == 0 && auth_checks % 6 == 0) {
-                    printf("[AUTH] Authentication in progress... (%ld/%d seconds)\n", 
-                           current_time - start_time, timeout_seconds);
-                    
-                    // Show current authentication state
-                    snprintf(check_command, sizeof(check_command), "iw dev %s link | head -5", interface_name);
-                    system(check_command);
-                }
+                precise_sleep(0.5); // 500ms interval for authentication checks
             }
-            
-            precise_sleep(0.5); // 500ms interval for authentication checks
         }
         
         // Timeout reached - perform enhanced cleanup for secured connections
         printf("[TIMEOUT] Authentication timeout after %d seconds\n", timeout_seconds);
-        
-        // Read PID from file and terminate gracefully
-        FILE *pidfile = fopen(pidfile_path, "r");
-        if (pidfile) {
-            char pid_str[32];
-            if (fgets(pid_str, sizeof(pid_str), pidfile)) {
-                pid_t wpa_daemon_pid = atoi(pid_str);
-                printf("[CLEANUP] Terminating secured wpa_supplicant process (PID: %d)\n", wpa_daemon_pid);
-                
-                // Graceful termination for secured connections
-                kill(wpa_daemon_pid, SIGTERM);
-                precise_sleep(1.0); // Longer wait for secured connections
-                
-                // Force termination if needed
-                if (kill(wpa_daemon_pid, 0) == 0) {
-                    printf("[CLEANUP] Force terminating secured wpa_supplicant\n");
-                    kill(wpa_daemon_pid, SIGKILL);
-                }
-            }
-            fclose(pidfile);
+        if (strlen(wpa_failure_reason) > 0) {
+            printf("[TIMEOUT] Last supplicant state: %s\n", wpa_failure_reason);
         }
         
-        // Enhanced global cleanup for secured networks
-        system("killall wpa_supplicant 2>/dev/null || true");
+        terminate_wpa_supplicant_from_pidfile(pidfile_path, 1.0, "secured wpa_supplicant");
+        
+        // Enhanced cleanup of remaining processes on this interface
+        terminate_interface_processes(interface_name);
         
         // Clear any partial authentication state
-        snprintf(command, sizeof(command), "iw dev %s disconnect 2>/dev/null", interface_name);
-        system(command);
+        run_iw_disconnect(interface_name);
         
         unlink(pidfile_path);
         
@@ -1163,14 +1521,129 @@ int start_wpa_supplicant_secured_with_timeout(const char *interface_name, const
     }
 }
 
-int test_open_ap_connection(const char *interface_name, const char *ssid, connection_test_result_t *result) {
-    FILE *fp;
+const char* test_phase_name(test_phase_t phase) {
+    static const char *names[TEST_PHASE_COUNT] = {
+        "state_save", "config_write", "link_reset", "supplicant_start", "auth_assoc",
+        "handshake", "dhcp", "connectivity_probe", "restore"
+    };
+    return (phase >= 0 && phase < TEST_PHASE_COUNT) ? names[phase] : "unknown";
+}
+
+static void record_phase(connection_test_result_t *result, test_phase_t phase, long long phase_start_ms) {
+    result->phase_ms[phase] = (int)(monotonic_time_ms() - phase_start_ms);
+}
+
+// Split step 4 into supplicant start, association and handshake using the event timestamps
+static void record_supplicant_phases(connection_test_result_t *result, long long step_start_ms, int secured) {
+    long long now = monotonic_time_ms();
+    
+    if (last_wait_start_ms < step_start_ms) {
+        // No event wait (control interface unavailable): the whole step is unattributed start-up
+        result->phase_ms[TEST_PHASE_SUPPLICANT_START] = (int)(now - step_start_ms);
+        return;
+    }
+    result->phase_ms[TEST_PHASE_SUPPLICANT_START] = (int)(last_wait_start_ms - step_start_ms);
+    
+    long long end_ms = last_wait_result.connected_ms ? last_wait_result.connected_ms : now;
+    long long associated_ms = last_wait_result.associated_ms;
+    if (!secured || associated_ms < last_wait_start_ms || associated_ms > end_ms) {
+        result->phase_ms[TEST_PHASE_AUTH_ASSOC] = (int)(end_ms - last_wait_start_ms);
+    } else {
+        result->phase_ms[TEST_PHASE_AUTH_ASSOC] = (int)(associated_ms - last_wait_start_ms);
+        result->phase_ms[TEST_PHASE_HANDSHAKE] = (int)(end_ms - associated_ms);
+    }
+}
+
+// Restore the saved state when the test owns it and close the restore phase. A supplicant
+// the test adopted gets its networks back first; one this process started stays running.
+static void finish_test_restore(const char *interface_name, const wifi_interface_t *saved_state,
+                                connection_test_result_t *result, int manage_state, long long phase_start_ms) {
+    supplicant_session_t session;
+    
+    if (manage_state) {
+        if (supplicant_session_get(interface_name, &session) == 0 && !session.owned) {
+            supplicant_session_stop(interface_name);
+        }
+        restore_interface_state(interface_name, saved_state);
+        result->restore_duration_ms = get_last_restore_duration_ms();
+    }
+    record_phase(result, TEST_PHASE_RESTORE, phase_start_ms);
+}
+
+// Lease an address with the in-process DHCP exchange (no client process to spawn and
+// kill). udhcpc is used only when no packet socket can be opened. Returns 1 when assigned;
+// the probe records what was installed so the cleanup can hand it back with dhcp_probe_release().
+static int acquire_test_address(const char *interface_name, int timeout_seconds, connection_test_result_t *result,
+                                dhcp_probe_result_t *probe) {
+    char command[MAX_COMMAND_LEN];
+    long long start_ms = monotonic_time_ms();
+    
+    dhcp_probe_run(interface_name, DHCP_PROBE_BIND, timeout_seconds * 1000, probe);
+    if (probe->discover_count > 0) {
+        if (probe->outcome != 0) {
+            printf("[DHCP] No lease after %d DISCOVER(s): %s\n", probe->discover_count, probe->error);
+            return 0;
+        }
+        printf("[DHCP] Leased %s from %s (OFFER %.1f ms, ACK %.1f ms, lease %u s)\n", probe->offered_ip,
+               probe->server_ip, probe->offer_ms, probe->ack_ms, probe->lease_time_s);
+        result->dhcp_duration_ms = (int)(probe->ack_ms + 0.5);
+        return 1;
+    }
+    
+    printf("[DHCP] In-process DHCP unavailable (%s), falling back to udhcpc\n", probe->error);
+    // udhcpc backgrounds itself once it holds a lease (and exits on failure with -n),
+    // so it runs in the foreground under the same deadline as the in-process client
+    const char *const udhcpc[] = {"udhcpc", "-i", interface_name, "-n", NULL};
+    command_format(udhcpc, command, sizeof(command));
+    log_command_execution(command, "Starting DHCP client");
+    command_run(udhcpc, 0, timeout_seconds * 1000, NULL, NULL);
+    if (!verify_ip_assignment(interface_name, timeout_seconds)) return 0;
+    
+    result->dhcp_duration_ms = (int)(monotonic_time_ms() - start_ms);
+    printf("[DHCP] Address obtained %d ms after starting the DHCP client\n", result->dhcp_duration_ms);
+    return 1;
+}
+
+// Hand a bound lease back and remove its address and default route while the link is
+// still associated, so no test address outlives the test
+static void release_test_address(const char *interface_name, dhcp_probe_result_t *lease) {
+    if (!lease->bound) return;
+    if (dhcp_probe_release(interface_name, lease) == 0) {
+        printf("[DHCP] Released %s and removed its address and route\n", lease->offered_ip);
+    } else {
+        printf("[DHCP] Could not fully release %s\n", lease->offered_ip);
+    }
+}
+
+// Gateway, DNS and internet reachability in one concurrent round. Returns 1 when the internet layer answered.
+static int probe_test_connectivity(const char *interface_name, int timeout_ms, connection_test_result_t *result) {
+    connectivity_probe_config_t config;
+    connectivity_probe_result_t probe;
+    
+    connectivity_probe_default_config(&config);
+    connectivity_probe_run(interface_name, &config, timeout_ms, &probe);
+    
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) {
+        const probe_layer_result_t *layer_result = &probe.layers[layer];
+        result->layer_rtt_ms[layer] = (layer_result->status == PROBE_STATUS_REACHABLE) ? layer_result->rtt_ms : -1;
+        if (layer_result->status == PROBE_STATUS_REACHABLE) {
+            printf("[PROBE] %s: reachable via %s %s in %.1f ms\n", probe_layer_name(layer),
+                   layer_result->method, layer_result->target, layer_result->rtt_ms);
+        } else {
+            printf("[PROBE] %s: %s\n", probe_layer_name(layer), probe_status_name(layer_result->status));
+        }
+    }
+    printf("[PROBE] Connectivity probe finished in %.1f ms\n", probe.total_ms);
+    return probe.layers[PROBE_LAYER_INTERNET].status == PROBE_STATUS_REACHABLE;
+}
+
+static int run_open_ap_test(const char *interface_name, const char *ssid, connection_test_result_t *result, int manage_state) {
     char command[MAX_COMMAND_LEN];
-    char line[MAX_LINE_LEN];
     char config_file[256];
     char *random_filename;
     wifi_interface_t saved_state;
-    clock_t start_time, end_time;
+    dhcp_probe_result_t lease;
+    long long start_time, end_time;
     
     printf("========================================\n");
     printf("STARTING OPEN AP CONNECTION TEST\n");
@@ -1188,58 +1661,71 @@ int test_open_ap_connection(const char *interface_name, const char *ssid, connec
     strncpy(result->interface_name, interface_name, MAX_INTERFACE_NAME - 1);
     strncpy(result->connection_type, "open", sizeof(result->connection_type) - 1);
     result->test_time = time(NULL);
+    for (int phase = 0; phase < TEST_PHASE_COUNT; phase++) result->phase_ms[phase] = -1;
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) result->layer_rtt_ms[layer] = -1;
+    result->restore_duration_ms = -1;
+    memset(&lease, 0, sizeof(lease));
     
-    // Save current interface state
+    // Save current interface state (batch sessions save once per interface)
     printf("[STEP 1] Saving current interface state...\n");
-    if (save_interface_state(interface_name, &saved_state) == 0) {
+    long long phase_start = monotonic_time_ms();
+    if (!manage_state) {
+        printf("[INFO] Interface state is managed by the batch session\n");
+    } else if (save_interface_state(interface_name, &saved_state) == 0) {
         strncpy(result->original_ssid, saved_state.ssid, MAX_SSID_LEN - 1);
+        strncpy(result->original_bssid, saved_state.profile.bssid, MAX_MAC_LEN - 1);
         result->was_connected = (strlen(saved_state.ssid) > 0) ? 1 : 0;
         printf("[INFO] Original SSID: %s\n", strlen(saved_state.ssid) > 0 ? saved_state.ssid : "(none)");
         printf("[INFO] Was connected: %s\n", result->was_connected ? "Yes" : "No");
     } else {
         printf("[WARNING] Failed to save interface state\n");
     }
+    if (manage_state) record_phase(result, TEST_PHASE_STATE_SAVE, phase_start);
     printf("----------------------------------------\n");
     fflush(stdout);
     
-    start_time = clock();
+    start_time = monotonic_time_ms();
     
     // Generate random config file name
-    printf("[STEP 2] Generating configuration file...\n");
-    random_filename = generate_random_filename();
-    snprintf(config_file, sizeof(config_file), "/tmp/%s.conf", random_filename);
-    printf("[INFO] Config file: %s\n", config_file);
-    
-    // Create wpa_supplicant config for open network
-    snprintf(command, sizeof(command), 
-             "echo \"%s none\" | awk '{printf \"network={\\n    ssid=\\\"%s\\\"\\n    key_mgmt=NONE\\n}\\n\", $1}' | tee %s > /dev/null",
-             ssid, ssid, config_file);
-    
-    if (execute_command_with_logging(command, "Creating wpa_supplicant configuration for open network") != 0) {
-        strncpy(result->error_message, "Failed to create wpa_supplicant configuration", sizeof(result->error_message) - 1);
-        end_time = clock();
-        result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        restore_interface_state(interface_name, &saved_state);
-        return -1;
+    // A supplicant already managing the interface gets the network over its control socket
+    printf("[STEP 2] Preparing network configuration...\n");
+    phase_start = monotonic_time_ms();
+    config_file[0] = '\0';
+    int use_running_supplicant = supplicant_is_running(interface_name);
+    int network_id = -1;
+    
+    if (use_running_supplicant) {
+        printf("[INFO] wpa_supplicant already running on %s - provisioning via control interface\n", interface_name);
+        // A single test is its own session: record the networks its SELECT_NETWORK will disable
+        if (manage_state) supplicant_session_start(interface_name);
+    } else {
+        random_filename = generate_random_filename();
+        snprintf(config_file, sizeof(config_file), RUNTIME_STATE_DIR "/%s.conf", random_filename);
+        printf("[INFO] Config file: %s\n", config_file);
+        
+        // Written in-process (0600, single write) rather than through a shell pipeline
+        if (ensure_runtime_state_dir() != 0 || wpa_config_write(config_file, ssid, NULL) != 0) {
+            strncpy(result->error_message, "Failed to create wpa_supplicant configuration", sizeof(result->error_message) - 1);
+            end_time = monotonic_time_ms();
+            result->test_duration_ms = (int)(end_time - start_time);
+            finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
+            return -1;
+        }
+        printf("[INFO] Configuration: ssid=\"%s\" key_mgmt=NONE\n", ssid);
+    }
+    record_phase(result, TEST_PHASE_CONFIG_WRITE, phase_start);
+    
+    // Bring interface down and up (batch sessions reset once per interface)
+    if (manage_state && !use_running_supplicant) {
+        printf("[STEP 3] Resetting network interface...\n");
+        phase_start = monotonic_time_ms();
+        reset_interface_link(interface_name);
+        record_phase(result, TEST_PHASE_LINK_RESET, phase_start);
+        
+        // Check interface status after reset
+        const char *const link_show[] = {"ip", "link", "show", interface_name, NULL};
+        execute_command_with_output_logging(link_show, "Checking interface status after reset");
     }
-    
-    // Display the created configuration
-    snprintf(command, sizeof(command), "cat %s", config_file);
-    execute_command_with_output_logging(command, "Displaying created configuration file");
-    
-    // Bring interface down and up
-    printf("[STEP 3] Resetting network interface...\n");
-    snprintf(command, sizeof(command), "ip link set %s down", interface_name);
-    execute_command_with_logging(command, "Bringing interface down");
-    precise_sleep(0.5);
-    
-    snprintf(command, sizeof(command), "ip link set %s up", interface_name);
-    execute_command_with_logging(command, "Bringing interface up");
-    precise_sleep(1.0);
-    
-    // Check interface status after reset
-    snprintf(command, sizeof(command), "ip link show %s", interface_name);
-    execute_command_with_output_logging(command, "Checking interface status after reset");
     
     // Start wpa_supplicant with failsafe timeout mechanism
     printf("[STEP 4] Starting wpa_supplicant with failsafe timeout mechanism...\n");
@@ -1247,48 +1733,66 @@ int test_open_ap_connection(const char *interface_name, const char *ssid, connec
     printf("[INFO] Process will be automatically terminated if connection fails\n");
     fflush(stdout);
     
-    pid_t wpa_pid;
-    int wpa_result = start_wpa_supplicant_with_timeout(interface_name, config_file, CONNECTION_TIMEOUT_SECONDS, &wpa_pid);
+    pid_t wpa_pid = 0;
+    int wpa_result;
+    phase_start = monotonic_time_ms();
+    if (use_running_supplicant) {
+        wpa_result = connect_via_running_supplicant(interface_name, ssid, NULL, CONNECTION_TIMEOUT_SECONDS, &network_id);
+    } else {
+        wpa_result = start_wpa_supplicant_with_timeout(interface_name, config_file, CONNECTION_TIMEOUT_SECONDS, &wpa_pid);
+    }
+    record_supplicant_phases(result, phase_start, 0);
     
     if (wpa_result == -1) {
-        printf("[ERROR] Failed to start wpa_supplicant process\n");
-        strncpy(result->error_message, "Failed to start wpa_supplicant", sizeof(result->error_message) - 1);
-        unlink(config_file);
-        end_time = clock();
-        result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        restore_interface_state(interface_name, &saved_state);
+        printf("[ERROR] wpa_supplicant failed to connect\n");
+        if (strlen(get_wpa_failure_reason()) > 0) {
+            snprintf(result->error_message, sizeof(result->error_message), "Connection failed: %.200s", get_wpa_failure_reason());
+        } else {
+            strncpy(result->error_message, "Failed to start wpa_supplicant", sizeof(result->error_message) - 1);
+        }
+        if (config_file[0]) unlink(config_file);
+        release_provisioned_network(interface_name, network_id);
+        end_time = monotonic_time_ms();
+        result->test_duration_ms = (int)(end_time - start_time);
+        finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
         return -1;
     } else if (wpa_result == -2) {
         printf("[TIMEOUT] Connection attempt timed out - wpa_supplicant automatically terminated\n");
-        strncpy(result->error_message, "Connection attempt timed out after 5 seconds - wpa_supplicant process automatically terminated", sizeof(result->error_message) - 1);
-        unlink(config_file);
-        end_time = clock();
-        result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        restore_interface_state(interface_name, &saved_state);
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Connection attempt timed out after %d seconds - wpa_supplicant process automatically terminated (%.100s)",
+                 CONNECTION_TIMEOUT_SECONDS, strlen(get_wpa_failure_reason()) > 0 ? get_wpa_failure_reason() : "no supplicant events");
+        if (config_file[0]) unlink(config_file);
+        release_provisioned_network(interface_name, network_id);
+        end_time = monotonic_time_ms();
+        result->test_duration_ms = (int)(end_time - start_time);
+        finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
         return -1;
     } else {
-        printf("[SUCCESS] wpa_supplicant started successfully (PID: %d)\n", wpa_pid);
+        if (use_running_supplicant) {
+            printf("[SUCCESS] Connected through running wpa_supplicant (network id %d)\n", network_id);
+        } else {
+            printf("[SUCCESS] wpa_supplicant started successfully (PID: %d)\n", wpa_pid);
+        }
     }
     printf("----------------------------------------\n");
     fflush(stdout);
     
     // Enhanced DHCP with proper timeout handling and IP verification
-    printf("[STEP 5] Starting enhanced DHCP client with timeout monitoring...\n");
-    snprintf(command, sizeof(command), 
-             "udhcpc -i %s -n 2>/dev/null &", interface_name);
-    int dhcp_result = execute_command_with_logging(command, "Starting DHCP client with 8-second timeout");
-    
-    // Use enhanced IP assignment verification
-    printf("[STEP 6] Enhanced IP address assignment verification...\n");
-    int ip_assigned = verify_ip_assignment(interface_name, 10); // Wait up to 10 seconds for IP
+    printf("[STEP 5] Requesting a DHCP lease...\n");
+    long long dhcp_start_ms = monotonic_time_ms();
+    int ip_assigned = acquire_test_address(interface_name, 10, result, &lease); // Wait up to 10 seconds for IP
+    record_phase(result, TEST_PHASE_DHCP, dhcp_start_ms);
     
+    printf("[STEP 6] IP address assignment: %s\n", ip_assigned ? "assigned" : "none");
     if (ip_assigned) {
         result->success = 1;
         printf("[SUCCESS] Enhanced DHCP verification successful - IP address obtained\n");
         
         // Additional connectivity verification
-        snprintf(command, sizeof(command), "ping -c 1 -W 2 8.8.8.8 >/dev/null 2>&1");
-        if (execute_command_with_logging(command, "Testing internet connectivity") == 0) {
+        phase_start = monotonic_time_ms();
+        int internet_reachable = probe_test_connectivity(interface_name, CONNECTIVITY_PROBE_DEFAULT_TIMEOUT_MS, result);
+        record_phase(result, TEST_PHASE_CONNECTIVITY_PROBE, phase_start);
+        if (internet_reachable) {
             printf("[SUCCESS] Internet connectivity verified\n");
         } else {
             printf("[INFO] Local network connection established (internet connectivity test failed)\n");
@@ -1301,30 +1805,30 @@ int test_open_ap_connection(const char *interface_name, const char *ssid, connec
     printf("----------------------------------------\n");
     fflush(stdout);
     
-    // Additional check - verify association with iw dev link and corresponding processes
+    // Additional check - verify association and the supplicant from one link sample
     if (!result->success) {
-        printf("[STEP 7] Performing enhanced association verification with iw dev link...\n");
+        link_state_t link;
+        printf("[STEP 7] Performing enhanced association verification from the link state...\n");
         
-        // Check for active connection using iw dev link
-        snprintf(command, sizeof(command), "iw dev %s link | grep -q 'Connected to'", interface_name);
-        int link_connected = (execute_command_with_logging(command, "Checking link connection status with iw dev") == 0);
+        int sampled = (link_state_sample(interface_name, &link) == 0);
+        int link_connected = sampled && link.connected;
         
         if (link_connected) {
             // Verify SSID matches the target
-            snprintf(command, sizeof(command), "iw dev %s link | grep -q 'SSID: %s'", interface_name, ssid);
-            int ssid_matches = (execute_command_with_logging(command, "Verifying SSID match in link status") == 0);
+            int ssid_matches = link_state_matches_ssid(&link, ssid);
             
             if (ssid_matches) {
-                // Check for corresponding wpa_supplicant process
-                snprintf(command, sizeof(command), "pgrep -f 'wpa_supplicant.*%s' >/dev/null 2>&1", interface_name);
-                int wpa_process_active = (execute_command_with_logging(command, "Checking for active wpa_supplicant process") == 0);
+                // A supplicant answering on the control socket for this interface
+                int wpa_process_active = (link.supplicant_state[0] != '\0');
+                
                 
                 // Check for corresponding udhcpc process
-                snprintf(command, sizeof(command), "pgrep -f 'udhcpc.*%s' >/dev/null 2>&1", interface_name);
-                int dhcp_process_active = (execute_command_with_logging(command, "Checking for active udhcpc process") == 0);
+                format_interface_process_pattern("udhcpc", interface_name, command, sizeof(command));
+                const char *const pgrep[] = {"pgrep", "-f", command, NULL};
+                int dhcp_process_active = (execute_command_with_logging(pgrep, "Checking for active udhcpc process") == 0);
                 
                 result->success = 1;
-                printf("[SUCCESS] Association verified via iw dev link - interface connected to %s\n", ssid);
+                printf("[SUCCESS] Association verified from link state - interface connected to %s\n", ssid);
                 if (wpa_process_active) {
                     printf("[INFO] Active wpa_supplicant process detected for interface\n");
                 }
@@ -1345,26 +1849,45 @@ int test_open_ap_connection(const char *interface_name, const char *ssid, connec
         }
         
         // Show current link status instead of iwconfig
-        snprintf(command, sizeof(command), "iw dev %s link", interface_name);
-        execute_command_with_output_logging(command, "Current link status");
+        if (sampled) {
+            print_link_state(interface_name, &link);
+        }
     }
     
-    end_time = clock();
-    result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
+    end_time = monotonic_time_ms();
+    result->test_duration_ms = (int)(end_time - start_time);
     
     // Cleanup: kill udhcpc and wpa_supplicant, remove config file
     printf("[STEP 8] Performing cleanup operations...\n");
-    snprintf(command, sizeof(command), "killall udhcpc 2>/dev/null || true");
-    execute_command_with_logging(command, "Terminating udhcpc processes");
+    phase_start = monotonic_time_ms();
+    release_test_address(interface_name, &lease);
+    format_interface_process_pattern("udhcpc", interface_name, command, sizeof(command));
+    const char *const pkill_udhcpc[] = {"pkill", "-f", command, NULL};
+    execute_command_with_logging(pkill_udhcpc, "Terminating udhcpc processes");
+    
+    if (use_running_supplicant) {
+        // The supplicant is not ours; only take our network back out of it
+        release_provisioned_network(interface_name, network_id);
+    } else {
+        format_interface_process_pattern("wpa_supplicant", interface_name, command, sizeof(command));
+        const char *const pkill_supplicant[] = {"pkill", "-f", command, NULL};
+        execute_command_with_logging(pkill_supplicant, "Terminating wpa_supplicant processes");
+    }
     
-    execute_command_with_logging("killall wpa_supplicant 2>/dev/null || true", "Terminating wpa_supplicant processes");
+    if (!manage_state) {
+        // Leave no stale address behind for the next test in the session
+        const char *const flush[] = {"ip", "addr", "flush", "dev", interface_name, NULL};
+        execute_command_with_logging(flush, "Flushing addresses for next test");
+    }
     
-    printf("[INFO] Removing configuration file: %s\n", config_file);
-    unlink(config_file);
-    precise_sleep(0.5);
+    if (config_file[0]) {
+        printf("[INFO] Removing configuration file: %s\n", config_file);
+        unlink(config_file);
+    }
+    wait_for_link_state(interface_name, 0, IFF_RUNNING, 500);
     
     printf("[STEP 9] Restoring original interface state...\n");
-    restore_interface_state(interface_name, &saved_state);
+    finish_test_restore(interface_name, &saved_state, result, manage_state, phase_start);
     
     printf("========================================\n");
     printf("OPEN AP CONNECTION TEST COMPLETED\n");
@@ -1380,14 +1903,21 @@ int test_open_ap_connection(const char *interface_name, const char *ssid, connec
     return result->success ? 0 : -1;
 }
 
-int test_secured_ap_connection(const char *interface_name, const char *ssid, const char *password, connection_test_result_t *result) {
-    FILE *fp;
+int test_open_ap_connection(const char *interface_name, const char *ssid, connection_test_result_t *result) {
+    return run_open_ap_test(interface_name, ssid, result, 1);
+}
+
+int test_open_ap_connection_in_session(const char *interface_name, const char *ssid, connection_test_result_t *result) {
+    return run_open_ap_test(interface_name, ssid, result, 0);
+}
+
+static int run_secured_ap_test(const char *interface_name, const char *ssid, const char *password, connection_test_result_t *result, int manage_state) {
     char command[MAX_COMMAND_LEN];
-    char line[MAX_LINE_LEN];
     char config_file[256];
     char *random_filename;
     wifi_interface_t saved_state;
-    clock_t start_time, end_time;
+    dhcp_probe_result_t lease;
+    long long start_time, end_time;
     
     printf("========================================\n");
     printf("STARTING SECURED AP CONNECTION TEST\n");
@@ -1406,58 +1936,82 @@ int test_secured_ap_connection(const char *interface_name, const char *ssid, con
     strncpy(result->interface_name, interface_name, MAX_INTERFACE_NAME - 1);
     strncpy(result->connection_type, "secured", sizeof(result->connection_type) - 1);
     result->test_time = time(NULL);
+    for (int phase = 0; phase < TEST_PHASE_COUNT; phase++) result->phase_ms[phase] = -1;
+    for (int layer = 0; layer < PROBE_LAYER_COUNT; layer++) result->layer_rtt_ms[layer] = -1;
+    result->restore_duration_ms = -1;
+    memset(&lease, 0, sizeof(lease));
     
-    // Save current interface state
+    // Save current interface state (batch sessions save once per interface)
     printf("[STEP 1] Saving current interface state...\n");
-    if (save_interface_state(interface_name, &saved_state) == 0) {
+    long long phase_start = monotonic_time_ms();
+    if (!manage_state) {
+        printf("[INFO] Interface state is managed by the batch session\n");
+    } else if (save_interface_state(interface_name, &saved_state) == 0) {
         strncpy(result->original_ssid, saved_state.ssid, MAX_SSID_LEN - 1);
+        strncpy(result->original_bssid, saved_state.profile.bssid, MAX_MAC_LEN - 1);
         result->was_connected = (strlen(saved_state.ssid) > 0) ? 1 : 0;
         printf("[INFO] Original SSID: %s\n", strlen(saved_state.ssid) > 0 ? saved_state.ssid : "(none)");
         printf("[INFO] Was connected: %s\n", result->was_connected ? "Yes" : "No");
     } else {
         printf("[WARNING] Failed to save interface state\n");
     }
+    if (manage_state) record_phase(result, TEST_PHASE_STATE_SAVE, phase_start);
     printf("----------------------------------------\n");
     fflush(stdout);
     
-    start_time = clock();
+    start_time = monotonic_time_ms();
     
     // Generate random config file name
-    printf("[STEP 2] Generating configuration file for secured network...\n");
-    random_filename = generate_random_filename();
-    snprintf(config_file, sizeof(config_file), "/tmp/%s.conf", random_filename);
-    printf("[INFO] Config file: %s\n", config_file);
-    
-    // Create wpa_supplicant config for secured network
-    snprintf(command, sizeof(command), 
-             "echo \"%s %s\" | awk '{printf \"network={\\n    ssid=\\\"%s\\\"\\n    psk=\\\"%s\\\"\\n}\\n\", $1, $2}' | tee %s > /dev/null",
-             ssid, password, ssid, password, config_file);
-    
-    if (execute_command_with_logging(command, "Creating wpa_supplicant configuration for secured network") != 0) {
-        strncpy(result->error_message, "Failed to create wpa_supplicant configuration", sizeof(result->error_message) - 1);
-        end_time = clock();
-        result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        restore_interface_state(interface_name, &saved_state);
+    // The PSK is derived once per SSID/passphrase and never placed on a command line
+    printf("[STEP 2] Preparing configuration for secured network...\n");
+    phase_start = monotonic_time_ms();
+    config_file[0] = '\0';
+    char psk_hex[WPA_PSK_HEX_LEN + 1];
+    int network_id = -1;
+    
+    if (wpa_config_derive_psk(ssid, password, psk_hex, sizeof(psk_hex)) != 0) {
+        strncpy(result->error_message, "Invalid passphrase - WPA-PSK requires 8-63 printable characters or 64 hex digits",
+                sizeof(result->error_message) - 1);
+        end_time = monotonic_time_ms();
+        result->test_duration_ms = (int)(end_time - start_time);
+        finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
         return -1;
     }
     
-    // Display the created configuration (hiding password)
-    snprintf(command, sizeof(command), "cat %s | sed 's/psk=.*/psk=\"***HIDDEN***\"/'", config_file);
-    execute_command_with_output_logging(command, "Displaying created configuration file (password hidden)");
-    
-    // Bring interface down and up
-    printf("[STEP 3] Resetting network interface...\n");
-    snprintf(command, sizeof(command), "ip link set %s down", interface_name);
-    execute_command_with_logging(command, "Bringing interface down");
-    precise_sleep(0.5);
-    
-    snprintf(command, sizeof(command), "ip link set %s up", interface_name);
-    execute_command_with_logging(command, "Bringing interface up");
-    precise_sleep(1.0);
-    
-    // Check interface status after reset
-    snprintf(command, sizeof(command), "ip link show %s", interface_name);
-    execute_command_with_output_logging(command, "Checking interface status after reset");
+    // A supplicant already managing the interface gets the network over its control socket
+    int use_running_supplicant = supplicant_is_running(interface_name);
+    if (use_running_supplicant) {
+        printf("[INFO] wpa_supplicant already running on %s - provisioning via control interface\n", interface_name);
+        // A single test is its own session: record the networks its SELECT_NETWORK will disable
+        if (manage_state) supplicant_session_start(interface_name);
+    } else {
+        random_filename = generate_random_filename();
+        snprintf(config_file, sizeof(config_file), RUNTIME_STATE_DIR "/%s.conf", random_filename);
+        printf("[INFO] Config file: %s\n", config_file);
+        
+        // Written in-process (0600, single write) rather than through a shell pipeline
+        if (ensure_runtime_state_dir() != 0 || wpa_config_write(config_file, ssid, psk_hex) != 0) {
+            strncpy(result->error_message, "Failed to create wpa_supplicant configuration", sizeof(result->error_message) - 1);
+            end_time = monotonic_time_ms();
+            result->test_duration_ms = (int)(end_time - start_time);
+            finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
+            return -1;
+        }
+        printf("[INFO] Configuration: ssid=\"%s\" key_mgmt=WPA-PSK psk=***HIDDEN***\n", ssid);
+    }
+    record_phase(result, TEST_PHASE_CONFIG_WRITE, phase_start);
+    
+    // Bring interface down and up (batch sessions reset once per interface)
+    if (manage_state && !use_running_supplicant) {
+        printf("[STEP 3] Resetting network interface...\n");
+        phase_start = monotonic_time_ms();
+        reset_interface_link(interface_name);
+        record_phase(result, TEST_PHASE_LINK_RESET, phase_start);
+        
+        // Check interface status after reset
+        const char *const link_show[] = {"ip", "link", "show", interface_name, NULL};
+        execute_command_with_output_logging(link_show, "Checking interface status after reset");
+    }
     
     // Start wpa_supplicant with enhanced secured authentication mechanism
     printf("[STEP 4] Starting enhanced WPA/WPA2 authentication...\n");
@@ -1465,27 +2019,41 @@ int test_secured_ap_connection(const char *interface_name, const char *ssid, con
     printf("[INFO] Enhanced monitoring for WPA handshake completion\n");
     fflush(stdout);
     
-    pid_t wpa_pid;
-    int wpa_result = start_wpa_supplicant_secured_with_timeout(interface_name, config_file, ssid, SECURED_CONNECTION_TIMEOUT_SECONDS, &wpa_pid);
+    pid_t wpa_pid = 0;
+    int wpa_result;
+    phase_start = monotonic_time_ms();
+    if (use_running_supplicant) {
+        wpa_result = connect_via_running_supplicant(interface_name, ssid, psk_hex, SECURED_CONNECTION_TIMEOUT_SECONDS, &network_id);
+    } else {
+        wpa_result = start_wpa_supplicant_secured_with_timeout(interface_name, config_file, ssid, SECURED_CONNECTION_TIMEOUT_SECONDS, &wpa_pid);
+    }
+    record_supplicant_phases(result, phase_start, 1);
     
     if (wpa_result == -1) {
         printf("[ERROR] Failed to start or authenticate with wpa_supplicant\n");
-        strncpy(result->error_message, "Failed to start wpa_supplicant or authentication failed", sizeof(result->error_message) - 1);
-        unlink(config_file);
-        end_time = clock();
-        result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        restore_interface_state(interface_name, &saved_state);
+        if (strlen(get_wpa_failure_reason()) > 0) {
+            snprintf(result->error_message, sizeof(result->error_message), "Authentication failed: %.200s", get_wpa_failure_reason());
+        } else {
+            strncpy(result->error_message, "Failed to start wpa_supplicant or authentication failed", sizeof(result->error_message) - 1);
+        }
+        if (config_file[0]) unlink(config_file);
+        release_provisioned_network(interface_name, network_id);
+        end_time = monotonic_time_ms();
+        result->test_duration_ms = (int)(end_time - start_time);
+        finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
         return -1;
     } else if (wpa_result == -2) {
         printf("[TIMEOUT] Authentication timeout after %d seconds - process terminated\n", SECURED_CONNECTION_TIMEOUT_SECONDS);
         snprintf(command, sizeof(command), 
-                 "Authentication timed out after %d seconds - may indicate wrong password or network issues", 
-                 SECURED_CONNECTION_TIMEOUT_SECONDS);
+                 "Authentication timed out after %d seconds - may indicate wrong password or network issues (%.100s)", 
+                 SECURED_CONNECTION_TIMEOUT_SECONDS,
+                 strlen(get_wpa_failure_reason()) > 0 ? get_wpa_failure_reason() : "no supplicant events");
         strncpy(result->error_message, command, sizeof(result->error_message) - 1);
-        unlink(config_file);
-        end_time = clock();
-        result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
-        restore_interface_state(interface_name, &saved_state);
+        if (config_file[0]) unlink(config_file);
+        release_provisioned_network(interface_name, network_id);
+        end_time = monotonic_time_ms();
+        result->test_duration_ms = (int)(end_time - start_time);
+        finish_test_restore(interface_name, &saved_state, result, manage_state, monotonic_time_ms());
         return -1;
     } else {
         printf("[SUCCESS] WPA/WPA2 authentication completed successfully\n");
@@ -1496,17 +2064,12 @@ int test_secured_ap_connection(const char *interface_name, const char *ssid, con
     // Enhanced verification - since authentication already succeeded, verify and proceed with DHCP
     printf("[STEP 5] Verifying authentication and attempting DHCP...\n");
     
-    // Verify association status using iw dev link and corresponding processes
-    snprintf(command, sizeof(command), "iw dev %s link | grep -q 'Connected to'", interface_name);
-    int link_connected = (execute_command_with_logging(command, "Verifying link connection status") == 0);
-    
-    // Additional verification: check SSID matches
-    snprintf(command, sizeof(command), "iw dev %s link | grep -q 'SSID: %s'", interface_name, ssid);
-    int ssid_matches = (execute_command_with_logging(command, "Verifying SSID match") == 0);
-    
-    // Check for corresponding wpa_supplicant process
-    snprintf(command, sizeof(command), "pgrep -f 'wpa_supplicant.*%s' >/dev/null 2>&1", interface_name);
-    int wpa_process_active = (execute_command_with_logging(command, "Verifying wpa_supplicant process") == 0);
+    // Verify association, SSID and supplicant from one link sample
+    link_state_t link;
+    int sampled = (link_state_sample(interface_name, &link) == 0);
+    int link_connected = sampled && link.connected;
+    int ssid_matches = sampled && link_state_matches_ssid(&link, ssid);
+    int wpa_process_active = sampled && link.supplicant_state[0] != '\0';
     
     int associated = link_connected && ssid_matches;
     
@@ -1523,39 +2086,38 @@ int test_secured_ap_connection(const char *interface_name, const char *ssid, con
         }
         
         // Check current link status for debugging
-        snprintf(command, sizeof(command), "iw dev %s link", interface_name);
-        execute_command_with_output_logging(command, "Current link status check");
+        if (sampled) {
+            print_link_state(interface_name, &link);
+        }
         
         strncpy(result->error_message, "Authentication process completed but link association unclear", 
                 sizeof(result->error_message) - 1);
         result->success = 0;
     } else {
-        printf("[SUCCESS] Link association confirmed via iw dev link\n");
+        printf("[SUCCESS] Link association confirmed from link state\n");
         if (wpa_process_active) {
             printf("[INFO] Active wpa_supplicant process verified for interface\n");
         }
         
         // Show current connection details
-        snprintf(command, sizeof(command), "iw dev %s link", interface_name);
-        execute_command_with_output_logging(command, "Displaying current connection details");
+        print_link_state(interface_name, &link);
         
         // Enhanced DHCP with proper timeout handling for secured networks
-        printf("[STEP 6] Starting enhanced DHCP client with extended timeout for secured networks...\n");
-        snprintf(command, sizeof(command), 
-                 "udhcpc -i %s -n 2>/dev/null &", interface_name);
-        int dhcp_result = execute_command_with_logging(command, "Starting DHCP client with 10-second timeout for secured networks");
-        
-        // Use enhanced IP assignment verification with longer timeout for secured networks
-        printf("[STEP 7] Enhanced IP address assignment verification for secured connection...\n");
-        int ip_assigned = verify_ip_assignment(interface_name, 12); // Wait up to 12 seconds for secured networks
+        printf("[STEP 6] Requesting a DHCP lease with extended timeout for secured networks...\n");
+        long long dhcp_start_ms = monotonic_time_ms();
+        int ip_assigned = acquire_test_address(interface_name, 12, result, &lease); // Wait up to 12 seconds for secured networks
+        record_phase(result, TEST_PHASE_DHCP, dhcp_start_ms);
         
+        printf("[STEP 7] IP address assignment for secured connection: %s\n", ip_assigned ? "assigned" : "none");
         if (ip_assigned) {
             result->success = 1;
             printf("[SUCCESS] Complete secured connection established - authentication and enhanced DHCP successful\n");
             
             // Enhanced connectivity verification for secured networks
-            snprintf(command, sizeof(command), "ping -c 2 -W 3 8.8.8.8 >/dev/null 2>&1");
-            if (execute_command_with_logging(command, "Testing internet connectivity for secured connection") == 0) {
+            phase_start = monotonic_time_ms();
+            int internet_reachable = probe_test_connectivity(interface_name, 3000, result);
+            record_phase(result, TEST_PHASE_CONNECTIVITY_PROBE, phase_start);
+            if (internet_reachable) {
                 printf("[SUCCESS] Internet connectivity verified for secured connection\n");
             } else {
                 printf("[INFO] Secured local network connection established (internet connectivity test failed)\n");
@@ -1570,17 +2132,34 @@ int test_secured_ap_connection(const char *interface_name, const char *ssid, con
     printf("----------------------------------------\n");
     fflush(stdout);
     
-    end_time = clock();
-    result->test_duration_ms = (int)((end_time - start_time) * 1000 / CLOCKS_PER_SEC);
+    end_time = monotonic_time_ms();
+    result->test_duration_ms = (int)(end_time - start_time);
     
-    // Cleanup: kill udhcpc and wpa_supplicant, remove config file
-    snprintf(command, sizeof(command), "killall udhcpc 2>/dev/null || true");
-    system(command);
-    system("killall wpa_supplicant 2>/dev/null || true");
-    unlink(config_file);
-    precise_sleep(0.5);
+    // Cleanup: kill udhcpc and wpa_supplicant (or release our network), remove config file
+    phase_start = monotonic_time_ms();
+    release_test_address(interface_name, &lease);
+    if (use_running_supplicant) {
+        kill_interface_process("udhcpc", interface_name);
+        release_provisioned_network(interface_name, network_id);
+    } else {
+        terminate_interface_processes(interface_name);
+    }
+    if (!manage_state) {
+        // Leave no stale address behind for the next test in the session
+        flush_interface_addresses(interface_name);
+    }
+    if (config_file[0]) unlink(config_file);
+    wait_for_link_state(interface_name, 0, IFF_RUNNING, 500);
     
-    restore_interface_state(interface_name, &saved_state);
+    finish_test_restore(interface_name, &saved_state, result, manage_state, phase_start);
     
     return result->success ? 0 : -1;
-}
\ No newline at end of file
+}
+
+int test_secured_ap_connection(const char *interface_name, const char *ssid, const char *password, connection_test_result_t *result) {
+    return run_secured_ap_test(interface_name, ssid, password, result, 1);
+}
+
+int test_secured_ap_connection_in_session(const char *interface_name, const char *ssid, const char *password, connection_test_result_t *result) {
+    return run_secured_ap_test(interface_name, ssid, password, result, 0);
+}
@@ -0,0 +1,563 @@
+#include "wiphy_capabilities.h"
+#include "netlink_helper.h"
+#include <linux/nl80211.h>
+#include <libgen.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#define WIPHY_MEMORY_CACHE_SLOTS 4
+
+// Process-wide copy so repeated lookups never touch the disk or netlink. Batch sessions
+// look capabilities up from several threads, so the table is only used under the mutex.
+static wiphy_capabilities_t memory_cache[WIPHY_MEMORY_CACHE_SLOTS];
+static int memory_cache_used = 0;
+static pthread_mutex_t memory_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Regulatory domain per wiphy, read once per process and dropped on an nl80211
+// "regulatory" event (country change) rather than queried on every lookup
+typedef struct {
+    int phy_index;
+    char alpha2[WIPHY_REG_ALPHA2_LEN];
+} reg_domain_entry_t;
+
+static reg_domain_entry_t reg_domains[WIPHY_MEMORY_CACHE_SLOTS];
+static int reg_domains_used = 0;
+static nl_socket_t reg_events = { -1, 0, 0 };
+static int reg_events_state = 0; // 0 = not tried, 1 = active, -1 = unavailable
+
+static int frequency_to_channel(int freq) {
+    if (freq == 2484) return 14;
+    if (freq >= 2412 && freq < 2484) return (freq - 2407) / 5;
+    if (freq == 5935) return 2;
+    if (freq >= 5955 && freq <= 7115) return (freq - 5950) / 5;
+    if (freq >= 4910 && freq <= 4995) return (freq - 4000) / 5;     // 4.9 GHz public safety band
+    if (freq >= 5000 && freq <= 5885) return (freq - 5000) / 5;
+    if (freq >= 58320 && freq <= 70200) return (freq - 56160) / 2160;
+    return 0;
+}
+
+static int read_sysfs_string(const char *path, char *buffer, size_t size) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    if (!fgets(buffer, size, fp)) {
+        fclose(fp);
+        return -1;
+    }
+    buffer[strcspn(buffer, "\n")] = 0;
+    fclose(fp);
+    return 0;
+}
+
+// Resolve phy name, index and kernel driver of an interface through sysfs (no forks)
+int wiphy_get_phy_identity(const char *interface_name, char *phy_name, size_t phy_size,
+                           int *phy_index, char *driver, size_t driver_size) {
+    char path[256];
+    char value[64];
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/phy80211/name", interface_name);
+    if (read_sysfs_string(path, phy_name, phy_size) != 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/phy80211/index", interface_name);
+    if (read_sysfs_string(path, value, sizeof(value)) != 0) {
+        return -1;
+    }
+    *phy_index = atoi(value);
+
+    wiphy_get_driver_name(interface_name, driver, driver_size);
+    return 0;
+}
+
+void wiphy_get_driver_name(const char *interface_name, char *driver, size_t driver_size) {
+    char path[256];
+    char link_target[256];
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/device/driver", interface_name);
+    ssize_t len = readlink(path, link_target, sizeof(link_target) - 1);
+    if (len > 0) {
+        link_target[len] = '\0';
+        strncpy(driver, basename(link_target), driver_size - 1);
+        driver[driver_size - 1] = '\0';
+    } else {
+        strncpy(driver, "unknown", driver_size - 1);
+        driver[driver_size - 1] = '\0';
+    }
+}
+
+static void build_cache_path(const char *phy_name, const char *driver, char *path, size_t size) {
+    snprintf(path, size, "%s/wiphy_%s_%s.cache", RUNTIME_STATE_DIR, phy_name, driver);
+}
+
+static void add_channel(wiphy_capabilities_t *caps, int band, struct nlattr *freq_attr) {
+    struct nlattr *tb[NL80211_FREQUENCY_ATTR_MAX + 1];
+
+    nl_parse_nested(tb, NL80211_FREQUENCY_ATTR_MAX, freq_attr);
+    if (!tb[NL80211_FREQUENCY_ATTR_FREQ]) return;
+
+    int freq = (int)nl_attr_get_u32(tb[NL80211_FREQUENCY_ATTR_FREQ]);
+
+    // Split dumps may repeat a band; keep each frequency once
+    for (int i = 0; i < caps->channel_count; i++) {
+        if (caps->channels[i].frequency == freq) return;
+    }
+    if (caps->channel_count >= WIPHY_MAX_CHANNELS) return;
+
+    wiphy_channel_t *channel = &caps->channels[caps->channel_count++];
+    channel->frequency = freq;
+    channel->channel = frequency_to_channel(freq);
+    channel->band = (unsigned char)band;
+    channel->disabled = tb[NL80211_FREQUENCY_ATTR_DISABLED] ? 1 : 0;
+    channel->no_ir = tb[NL80211_FREQUENCY_ATTR_NO_IR] ? 1 : 0;
+    channel->radar = tb[NL80211_FREQUENCY_ATTR_RADAR] ? 1 : 0;
+}
+
+static void parse_bands(wiphy_capabilities_t *caps, struct nlattr *bands_attr) {
+    struct nlattr *band;
+    int rem_band;
+
+    nl_attr_for_each_nested(band, bands_attr, rem_band) {
+        struct nlattr *tb_band[NL80211_BAND_ATTR_MAX + 1];
+        int band_index = band->nla_type & NLA_TYPE_MASK;
+
+        if (band_index < 32) {
+            caps->band_mask |= (1u << band_index);
+        }
+
+        nl_parse_nested(tb_band, NL80211_BAND_ATTR_MAX, band);
+        if (!tb_band[NL80211_BAND_ATTR_FREQS]) continue;
+
+        struct nlattr *freq;
+        int rem_freq;
+        nl_attr_for_each_nested(freq, tb_band[NL80211_BAND_ATTR_FREQS], rem_freq) {
+            add_channel(caps, band_index, freq);
+        }
+    }
+}
+
+static void parse_combinations(wiphy_capabilities_t *caps, struct nlattr *combinations_attr) {
+    struct nlattr *comb;
+    int rem_comb;
+
+    nl_attr_for_each_nested(comb, combinations_attr, rem_comb) {
+        struct nlattr *tb_comb[NUM_NL80211_IFACE_COMB];
+
+        if (caps->combination_count >= WIPHY_MAX_COMBINATIONS) break;
+        nl_parse_nested(tb_comb, MAX_NL80211_IFACE_COMB, comb);
+
+        wiphy_combination_t *combination = &caps->combinations[caps->combination_count++];
+        memset(combination, 0, sizeof(wiphy_combination_t));
+
+        if (tb_comb[NL80211_IFACE_COMB_MAXNUM]) {
+            combination->max_interfaces = (int)nl_attr_get_u32(tb_comb[NL80211_IFACE_COMB_MAXNUM]);
+        }
+        if (tb_comb[NL80211_IFACE_COMB_NUM_CHANNELS]) {
+            combination->num_channels = (int)nl_attr_get_u32(tb_comb[NL80211_IFACE_COMB_NUM_CHANNELS]);
+        }
+        if (!tb_comb[NL80211_IFACE_COMB_LIMITS]) continue;
+
+        struct nlattr *limit;
+        int rem_limit;
+        nl_attr_for_each_nested(limit, tb_comb[NL80211_IFACE_COMB_LIMITS], rem_limit) {
+            struct nlattr *tb_limit[NUM_NL80211_IFACE_LIMIT];
+
+            if (combination->limit_count >= WIPHY_MAX_COMB_LIMITS) break;
+            nl_parse_nested(tb_limit, MAX_NL80211_IFACE_LIMIT, limit);
+
+            wiphy_comb_limit_t *entry = &combination->limits[combination->limit_count++];
+            entry->max_interfaces = tb_limit[NL80211_IFACE_LIMIT_MAX] ?
+                                    (int)nl_attr_get_u32(tb_limit[NL80211_IFACE_LIMIT_MAX]) : 0;
+            entry->iftype_mask = 0;
+
+            if (tb_limit[NL80211_IFACE_LIMIT_TYPES]) {
+                struct nlattr *iftype;
+                int rem_type;
+                nl_attr_for_each_nested(iftype, tb_limit[NL80211_IFACE_LIMIT_TYPES], rem_type) {
+                    int type = iftype->nla_type & NLA_TYPE_MASK;
+                    if (type < 32) entry->iftype_mask |= (1u << type);
+                }
+            }
+        }
+    }
+}
+
+static int wiphy_dump_handler(struct nlmsghdr *nlh, void *user_data) {
+    wiphy_capabilities_t *caps = (wiphy_capabilities_t *)user_data;
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+
+    genl_parse_attrs(tb, NL80211_ATTR_MAX, nlh);
+
+    // A dump without a filter would include other radios
+    if (tb[NL80211_ATTR_WIPHY] && (int)nl_attr_get_u32(tb[NL80211_ATTR_WIPHY]) != caps->phy_index) {
+        return 0;
+    }
+
+    if (tb[NL80211_ATTR_WIPHY_NAME]) {
+        strncpy(caps->phy_name, (const char *)nl_attr_data(tb[NL80211_ATTR_WIPHY_NAME]), sizeof(caps->phy_name) - 1);
+    }
+    if (tb[NL80211_ATTR_MAX_NUM_SCAN_SSIDS]) {
+        caps->max_scan_ssids = nl_attr_get_u8(tb[NL80211_ATTR_MAX_NUM_SCAN_SSIDS]);
+    }
+    if (tb[NL80211_ATTR_MAX_NUM_SCHED_SCAN_SSIDS]) {
+        caps->max_sched_scan_ssids = nl_attr_get_u8(tb[NL80211_ATTR_MAX_NUM_SCHED_SCAN_SSIDS]);
+    }
+    if (tb[NL80211_ATTR_MAX_MATCH_SETS]) {
+        caps->max_match_sets = nl_attr_get_u8(tb[NL80211_ATTR_MAX_MATCH_SETS]);
+    }
+
+    if (tb[NL80211_ATTR_SUPPORTED_IFTYPES]) {
+        struct nlattr *iftype;
+        int rem;
+        nl_attr_for_each_nested(iftype, tb[NL80211_ATTR_SUPPORTED_IFTYPES], rem) {
+            int type = iftype->nla_type & NLA_TYPE_MASK;
+            if (type < 32) caps->iftype_mask |= (1u << type);
+        }
+    }
+
+    if (tb[NL80211_ATTR_SUPPORTED_COMMANDS]) {
+        struct nlattr *cmd;
+        int rem;
+        nl_attr_for_each_nested(cmd, tb[NL80211_ATTR_SUPPORTED_COMMANDS], rem) {
+            if (nl_attr_get_u32(cmd) == NL80211_CMD_START_SCHED_SCAN) {
+                caps->sched_scan_supported = 1;
+            }
+        }
+    }
+
+    if (tb[NL80211_ATTR_WIPHY_BANDS]) {
+        parse_bands(caps, tb[NL80211_ATTR_WIPHY_BANDS]);
+    }
+
+    if (tb[NL80211_ATTR_INTERFACE_COMBINATIONS]) {
+        parse_combinations(caps, tb[NL80211_ATTR_INTERFACE_COMBINATIONS]);
+    }
+
+    return 0;
+}
+
+// Build the capability model of one wiphy from a split NL80211_CMD_GET_WIPHY dump
+int wiphy_query_nl80211(int phy_index, wiphy_capabilities_t *caps) {
+    nl_socket_t sock;
+    nl_msg_t msg;
+
+    if (nl_socket_open(&sock, NETLINK_GENERIC, 0) != 0) {
+        return -1;
+    }
+
+    int family_id = genl_resolve_family(&sock, "nl80211");
+    if (family_id < 0) {
+        nl_socket_close(&sock);
+        return -1;
+    }
+
+    caps->phy_index = phy_index;
+
+    genl_msg_init(&msg, (uint16_t)family_id, NL80211_CMD_GET_WIPHY, NLM_F_DUMP);
+    nl_msg_put_u32(&msg, NL80211_ATTR_WIPHY, (uint32_t)phy_index);
+    nl_msg_put_flag(&msg, NL80211_ATTR_SPLIT_WIPHY_DUMP);
+
+    int result = nl_transact(&sock, &msg, wiphy_dump_handler, caps);
+    nl_socket_close(&sock);
+
+    if (result != 0) {
+        return -1;
+    }
+
+    caps->supports_ap = (caps->iftype_mask & (1u << NL80211_IFTYPE_AP)) ? 1 : 0;
+    caps->supports_monitor = (caps->iftype_mask & (1u << NL80211_IFTYPE_MONITOR)) ? 1 : 0;
+    caps->supports_station = (caps->iftype_mask & (1u << NL80211_IFTYPE_STATION)) ? 1 : 0;
+    return 0;
+}
+
+static int reg_alpha2_handler(struct nlmsghdr *nlh, void *user_data) {
+    char *alpha2 = (char *)user_data;
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+
+    genl_parse_attrs(tb, NL80211_ATTR_MAX, nlh);
+    if (tb[NL80211_ATTR_REG_ALPHA2] && nl_attr_len(tb[NL80211_ATTR_REG_ALPHA2]) >= 2) {
+        memcpy(alpha2, nl_attr_data(tb[NL80211_ATTR_REG_ALPHA2]), 2);
+        alpha2[2] = '\0';
+    }
+    return 0;
+}
+
+// A self-managed wiphy reports its own domain; every other one gets the global domain
+int wiphy_query_reg_alpha2(int phy_index, char *alpha2, size_t alpha2_size) {
+    nl_socket_t sock;
+    nl_msg_t msg;
+    char found[WIPHY_REG_ALPHA2_LEN] = "";
+
+    if (alpha2_size < 3 || nl_socket_open(&sock, NETLINK_GENERIC, 0) != 0) return -1;
+
+    int family_id = genl_resolve_family(&sock, "nl80211");
+    if (family_id < 0) {
+        nl_socket_close(&sock);
+        return -1;
+    }
+
+    genl_msg_init(&msg, (uint16_t)family_id, NL80211_CMD_GET_REG, 0);
+    nl_msg_put_u32(&msg, NL80211_ATTR_WIPHY, (uint32_t)phy_index);
+    int result = nl_transact(&sock, &msg, reg_alpha2_handler, found);
+    nl_socket_close(&sock);
+
+    if (result != 0 || !isalnum((unsigned char)found[0]) || !isalnum((unsigned char)found[1])) return -1;
+    strncpy(alpha2, found, alpha2_size - 1);
+    alpha2[alpha2_size - 1] = '\0';
+    return 0;
+}
+
+static void open_reg_events(void) {
+    if (reg_events_state != 0) return;
+
+    reg_events_state = -1;
+    if (nl_socket_open(&reg_events, NETLINK_GENERIC, 0) != 0) return;
+
+    int group = genl_resolve_multicast_group(&reg_events, "nl80211", "regulatory");
+    if (group < 0 || nl_socket_add_membership(&reg_events, (uint32_t)group) != 0) {
+        nl_socket_close(&reg_events);
+        reg_events.fd = -1;
+        return;
+    }
+    fcntl(reg_events.fd, F_SETFL, O_NONBLOCK);
+    reg_events_state = 1;
+}
+
+// Any pending regulatory notification (or a dropped one) forgets every known domain.
+// Called with memory_cache_mutex held.
+static void drain_reg_events(void) {
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    if (reg_events_state != 1) return;
+
+    while (1) {
+        ssize_t len = recv(reg_events.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == ENOBUFS) {
+                reg_domains_used = 0;
+                continue;
+            }
+            break;
+        }
+
+        struct nlmsghdr *nlh;
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) continue;
+            const struct genlmsghdr *genl = (const struct genlmsghdr *)NLMSG_DATA(nlh);
+            if (genl->cmd == NL80211_CMD_REG_CHANGE || genl->cmd == NL80211_CMD_WIPHY_REG_CHANGE) {
+                reg_domains_used = 0;
+            }
+        }
+    }
+}
+
+// Current domain of the wiphy, "" when nl80211 cannot tell
+static void lookup_reg_domain(int phy_index, char *alpha2, size_t alpha2_size) {
+    pthread_mutex_lock(&memory_cache_mutex);
+    open_reg_events();
+    drain_reg_events();
+    for (int i = 0; i < reg_domains_used; i++) {
+        if (reg_domains[i].phy_index == phy_index) {
+            strncpy(alpha2, reg_domains[i].alpha2, alpha2_size - 1);
+            alpha2[alpha2_size - 1] = '\0';
+            pthread_mutex_unlock(&memory_cache_mutex);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&memory_cache_mutex);
+
+    if (wiphy_query_reg_alpha2(phy_index, alpha2, alpha2_size) != 0) {
+        alpha2[0] = '\0';
+        return;
+    }
+
+    pthread_mutex_lock(&memory_cache_mutex);
+    reg_domain_entry_t *slot = &reg_domains[reg_domains_used < WIPHY_MEMORY_CACHE_SLOTS ? reg_domains_used++ : 0];
+    slot->phy_index = phy_index;
+    strncpy(slot->alpha2, alpha2, sizeof(slot->alpha2) - 1);
+    slot->alpha2[sizeof(slot->alpha2) - 1] = '\0';
+    pthread_mutex_unlock(&memory_cache_mutex);
+}
+
+// An unknown current domain ("") accepts whatever domain the entry was read under
+static int reg_domain_matches(const wiphy_capabilities_t *caps, const char *alpha2) {
+    return alpha2[0] == '\0' || strcmp(caps->reg_alpha2, alpha2) == 0;
+}
+
+static int load_cache_file(const char *path, wiphy_capabilities_t *caps) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t len = read(fd, caps, sizeof(wiphy_capabilities_t));
+    close(fd);
+
+    if (len != (ssize_t)sizeof(wiphy_capabilities_t) ||
+        caps->magic != WIPHY_CACHE_MAGIC || caps->version != WIPHY_CACHE_VERSION) {
+        return -1;
+    }
+    return 0;
+}
+
+// Write to a temporary file and rename so concurrent readers never see partial data
+static int store_cache_file(const char *path, const wiphy_capabilities_t *caps) {
+    char tmp_path[300];
+
+    if (ensure_runtime_state_dir() != 0) return -1;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, getpid());
+    int fd = create_state_file(tmp_path, 0644);
+    if (fd < 0) return -1;
+
+    ssize_t written = write(fd, caps, sizeof(wiphy_capabilities_t));
+    close(fd);
+
+    if (written != (ssize_t)sizeof(wiphy_capabilities_t) || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static wiphy_capabilities_t *find_memory_cache(const char *phy_name, const char *driver, const char *alpha2) {
+    for (int i = 0; i < memory_cache_used; i++) {
+        if (strcmp(memory_cache[i].phy_name, phy_name) == 0 &&
+            strcmp(memory_cache[i].driver, driver) == 0 &&
+            reg_domain_matches(&memory_cache[i], alpha2)) {
+            return &memory_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static void store_memory_cache(const wiphy_capabilities_t *caps) {
+    pthread_mutex_lock(&memory_cache_mutex);
+    wiphy_capabilities_t *slot = find_memory_cache(caps->phy_name, caps->driver, "");
+
+    if (!slot) {
+        slot = &memory_cache[memory_cache_used < WIPHY_MEMORY_CACHE_SLOTS ? memory_cache_used++ : 0];
+    }
+    memcpy(slot, caps, sizeof(wiphy_capabilities_t));
+    pthread_mutex_unlock(&memory_cache_mutex);
+}
+
+static int load_capabilities(const char *interface_name, wiphy_capabilities_t *caps, int force_refresh) {
+    char phy_name[MAX_INTERFACE_NAME];
+    char driver[WIPHY_MAX_DRIVER_LEN];
+    char alpha2[WIPHY_REG_ALPHA2_LEN];
+    char cache_path[256];
+    int phy_index;
+
+    if (!interface_name || !caps) return -1;
+
+    if (wiphy_get_phy_identity(interface_name, phy_name, sizeof(phy_name),
+                               &phy_index, driver, sizeof(driver)) != 0) {
+        return -1;
+    }
+
+    // Channel permissions depend on the regulatory domain; an entry read under another one is stale
+    lookup_reg_domain(phy_index, alpha2, sizeof(alpha2));
+    build_cache_path(phy_name, driver, cache_path, sizeof(cache_path));
+
+    if (!force_refresh) {
+        pthread_mutex_lock(&memory_cache_mutex);
+        wiphy_capabilities_t *cached = find_memory_cache(phy_name, driver, alpha2);
+        if (cached) memcpy(caps, cached, sizeof(wiphy_capabilities_t));
+        pthread_mutex_unlock(&memory_cache_mutex);
+        if (cached) return 0;
+
+        if (load_cache_file(cache_path, caps) == 0 &&
+            strcmp(caps->phy_name, phy_name) == 0 && strcmp(caps->driver, driver) == 0 &&
+            reg_domain_matches(caps, alpha2)) {
+            store_memory_cache(caps);
+            return 0;
+        }
+    }
+
+    memset(caps, 0, sizeof(wiphy_capabilities_t));
+    if (wiphy_query_nl80211(phy_index, caps) != 0) {
+        return -1;
+    }
+
+    caps->magic = WIPHY_CACHE_MAGIC;
+    caps->version = WIPHY_CACHE_VERSION;
+    caps->created = time(NULL);
+    strncpy(caps->phy_name, phy_name, sizeof(caps->phy_name) - 1);
+    strncpy(caps->driver, driver, sizeof(caps->driver) - 1);
+    strncpy(caps->reg_alpha2, alpha2, sizeof(caps->reg_alpha2) - 1);
+
+    store_cache_file(cache_path, caps);
+    store_memory_cache(caps);
+    return 0;
+}
+
+int wiphy_get_capabilities(const char *interface_name, wiphy_capabilities_t *caps) {
+    return load_capabilities(interface_name, caps, 0);
+}
+
+int wiphy_refresh_capabilities(const char *interface_name, wiphy_capabilities_t *caps) {
+    return load_capabilities(interface_name, caps, 1);
+}
+
+int wiphy_can_scan(const wiphy_capabilities_t *caps) {
+    return (caps->supports_station && caps->max_scan_ssids > 0) ? 1 : 0;
+}
+
+static const wiphy_channel_t *find_channel(const wiphy_capabilities_t *caps, int frequency) {
+    for (int i = 0; i < caps->channel_count; i++) {
+        if (caps->channels[i].frequency == frequency) {
+            return &caps->channels[i];
+        }
+    }
+    return NULL;
+}
+
+int wiphy_supports_frequency(const wiphy_capabilities_t *caps, int frequency) {
+    const wiphy_channel_t *channel = find_channel(caps, frequency);
+    return (channel && !channel->disabled) ? 1 : 0;
+}
+
+// Enabled frequencies of the selected bands (band_mask 0 selects all bands)
+int wiphy_get_scan_frequencies(const wiphy_capabilities_t *caps, uint32_t band_mask, int *frequencies, int max_frequencies) {
+    int count = 0;
+
+    for (int i = 0; i < caps->channel_count && count < max_frequencies; i++) {
+        const wiphy_channel_t *channel = &caps->channels[i];
+        if (channel->disabled) continue;
+        if (band_mask && !(band_mask & (1u << channel->band))) continue;
+        frequencies[count++] = channel->frequency;
+    }
+    return count;
+}
+
+int wiphy_plan_scan_frequencies(const char *interface_name, const int *requested, int requested_count,
+                                uint32_t band_mask, int *planned, int max_planned) {
+    wiphy_capabilities_t caps;
+    int band_frequencies[WIPHY_MAX_CHANNELS];
+    int count = 0;
+
+    if (requested_count > max_planned) requested_count = max_planned;
+
+    if (wiphy_get_capabilities(interface_name, &caps) != 0 || caps.channel_count == 0) {
+        memcpy(planned, requested, requested_count * sizeof(int));
+        return requested_count;
+    }
+
+    if (requested_count > 0) {
+        for (int i = 0; i < requested_count; i++) {
+            if (!wiphy_supports_frequency(&caps, requested[i])) continue;
+            if (band_mask && !(band_mask & (1u << find_channel(&caps, requested[i])->band))) continue;
+            planned[count++] = requested[i];
+        }
+        return count > 0 ? count : -1;
+    }
+
+    if (!band_mask) return 0;
+
+    count = wiphy_get_scan_frequencies(&caps, band_mask, band_frequencies, WIPHY_MAX_CHANNELS);
+    if (count == 0) return -1;
+    // A band wider than one scan request (6 GHz) is swept in full rather than cut short
+    if (count > max_planned) return 0;
+    memcpy(planned, band_frequencies, count * sizeof(int));
+    return count;
+}
@@ -0,0 +1,308 @@
+#include "wpa_config.h"
+#include "supplicant_ctrl.h"
+#include <stdint.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#define SHA1_DIGEST_LEN 20
+#define SHA1_BLOCK_LEN 64
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;
+    unsigned char block[SHA1_BLOCK_LEN];
+    size_t block_used;
+} sha1_ctx_t;
+
+// Derived PSKs keyed by SSID and a digest of the passphrase (the plaintext is not kept)
+typedef struct {
+    int in_use;
+    char ssid[MAX_SSID_LEN];
+    unsigned char passphrase_digest[SHA1_DIGEST_LEN];
+    char psk_hex[WPA_PSK_HEX_LEN + 1];
+} psk_cache_entry_t;
+
+static psk_cache_entry_t psk_cache[WPA_PSK_CACHE_SIZE];
+static int psk_cache_next = 0;
+static pthread_mutex_t psk_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define ROTL32(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
+
+static void sha1_transform(sha1_ctx_t *ctx, const unsigned char *data) {
+    uint32_t w[80];
+    uint32_t a, b, c, d, e;
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)data[i * 4] << 24) | ((uint32_t)data[i * 4 + 1] << 16) |
+               ((uint32_t)data[i * 4 + 2] << 8) | (uint32_t)data[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = ROTL32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    a = ctx->state[0];
+    b = ctx->state[1];
+    c = ctx->state[2];
+    d = ctx->state[3];
+    e = ctx->state[4];
+
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = ROTL32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROTL32(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+}
+
+static void sha1_init(sha1_ctx_t *ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xEFCDAB89;
+    ctx->state[2] = 0x98BADCFE;
+    ctx->state[3] = 0x10325476;
+    ctx->state[4] = 0xC3D2E1F0;
+    ctx->length = 0;
+    ctx->block_used = 0;
+}
+
+static void sha1_update(sha1_ctx_t *ctx, const unsigned char *data, size_t len) {
+    ctx->length += len;
+    while (len > 0) {
+        size_t take = SHA1_BLOCK_LEN - ctx->block_used;
+        if (take > len) take = len;
+        memcpy(ctx->block + ctx->block_used, data, take);
+        ctx->block_used += take;
+        data += take;
+        len -= take;
+        if (ctx->block_used == SHA1_BLOCK_LEN) {
+            sha1_transform(ctx, ctx->block);
+            ctx->block_used = 0;
+        }
+    }
+}
+
+static void sha1_final(sha1_ctx_t *ctx, unsigned char digest[SHA1_DIGEST_LEN]) {
+    uint64_t bit_length = ctx->length * 8;
+    unsigned char pad = 0x80;
+    unsigned char zero = 0;
+    unsigned char length_bytes[8];
+
+    sha1_update(ctx, &pad, 1);
+    while (ctx->block_used != SHA1_BLOCK_LEN - 8) {
+        sha1_update(ctx, &zero, 1);
+    }
+    for (int i = 0; i < 8; i++) {
+        length_bytes[i] = (unsigned char)(bit_length >> (56 - i * 8));
+    }
+    sha1_update(ctx, length_bytes, 8);
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (unsigned char)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (unsigned char)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (unsigned char)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (unsigned char)ctx->state[i];
+    }
+}
+
+// HMAC pads are hashed once per key so each PBKDF2 round costs two compressions
+typedef struct {
+    sha1_ctx_t inner;
+    sha1_ctx_t outer;
+} hmac_sha1_key_t;
+
+static void hmac_sha1_prepare(hmac_sha1_key_t *key, const unsigned char *secret, size_t secret_len) {
+    unsigned char block[SHA1_BLOCK_LEN];
+    unsigned char pad[SHA1_BLOCK_LEN];
+
+    memset(block, 0, sizeof(block));
+    if (secret_len > SHA1_BLOCK_LEN) {
+        sha1_ctx_t ctx;
+        sha1_init(&ctx);
+        sha1_update(&ctx, secret, secret_len);
+        sha1_final(&ctx, block);
+    } else {
+        memcpy(block, secret, secret_len);
+    }
+
+    for (int i = 0; i < SHA1_BLOCK_LEN; i++) pad[i] = block[i] ^ 0x36;
+    sha1_init(&key->inner);
+    sha1_update(&key->inner, pad, SHA1_BLOCK_LEN);
+
+    for (int i = 0; i < SHA1_BLOCK_LEN; i++) pad[i] = block[i] ^ 0x5c;
+    sha1_init(&key->outer);
+    sha1_update(&key->outer, pad, SHA1_BLOCK_LEN);
+}
+
+static void hmac_sha1(const hmac_sha1_key_t *key, const unsigned char *data, size_t len, unsigned char digest[SHA1_DIGEST_LEN]) {
+    sha1_ctx_t ctx = key->inner;
+    unsigned char inner_digest[SHA1_DIGEST_LEN];
+
+    sha1_update(&ctx, data, len);
+    sha1_final(&ctx, inner_digest);
+
+    ctx = key->outer;
+    sha1_update(&ctx, inner_digest, SHA1_DIGEST_LEN);
+    sha1_final(&ctx, digest);
+}
+
+// PBKDF2-HMAC-SHA1 as used by IEEE 802.11i for passphrase-to-PSK mapping
+static void pbkdf2_sha1(const char *passphrase, const unsigned char *salt, size_t salt_len,
+                        int iterations, unsigned char *output, size_t output_len) {
+    hmac_sha1_key_t key;
+    unsigned char block_salt[MAX_SSID_LEN + 4];
+    unsigned int block_index = 1;
+
+    hmac_sha1_prepare(&key, (const unsigned char *)passphrase, strlen(passphrase));
+    memcpy(block_salt, salt, salt_len);
+
+    while (output_len > 0) {
+        unsigned char u[SHA1_DIGEST_LEN];
+        unsigned char t[SHA1_DIGEST_LEN];
+
+        block_salt[salt_len] = (unsigned char)(block_index >> 24);
+        block_salt[salt_len + 1] = (unsigned char)(block_index >> 16);
+        block_salt[salt_len + 2] = (unsigned char)(block_index >> 8);
+        block_salt[salt_len + 3] = (unsigned char)block_index;
+
+        hmac_sha1(&key, block_salt, salt_len + 4, u);
+        memcpy(t, u, SHA1_DIGEST_LEN);
+        for (int i = 1; i < iterations; i++) {
+            hmac_sha1(&key, u, SHA1_DIGEST_LEN, u);
+            for (int j = 0; j < SHA1_DIGEST_LEN; j++) t[j] ^= u[j];
+        }
+
+        size_t take = (output_len < SHA1_DIGEST_LEN) ? output_len : SHA1_DIGEST_LEN;
+        memcpy(output, t, take);
+        output += take;
+        output_len -= take;
+        block_index++;
+    }
+}
+
+static void hex_encode(const unsigned char *data, size_t len, char *hex, size_t hex_size) {
+    static const char digits[] = "0123456789abcdef";
+    size_t i;
+
+    for (i = 0; i < len && (i * 2 + 2) < hex_size; i++) {
+        hex[i * 2] = digits[data[i] >> 4];
+        hex[i * 2 + 1] = digits[data[i] & 0x0f];
+    }
+    hex[i * 2] = '\0';
+}
+
+int wpa_config_derive_psk(const char *ssid, const char *passphrase, char *psk_hex, size_t psk_hex_size) {
+    unsigned char digest[SHA1_DIGEST_LEN];
+    unsigned char psk[WPA_PSK_LEN];
+    size_t passphrase_len = strlen(passphrase);
+    size_t ssid_len = strlen(ssid);
+    sha1_ctx_t ctx;
+
+    if (psk_hex_size < WPA_PSK_HEX_LEN + 1 || ssid_len == 0 || ssid_len > 32) return -1;
+
+    // 64 hex digits are already a PSK
+    if (passphrase_len == WPA_PSK_HEX_LEN) {
+        for (size_t i = 0; i < passphrase_len; i++) {
+            if (!isxdigit((unsigned char)passphrase[i])) return -1;
+            psk_hex[i] = (char)tolower((unsigned char)passphrase[i]);
+        }
+        psk_hex[WPA_PSK_HEX_LEN] = '\0';
+        return 0;
+    }
+
+    if (passphrase_len < 8 || passphrase_len > 63) return -1;
+    for (size_t i = 0; i < passphrase_len; i++) {
+        if ((unsigned char)passphrase[i] < 32 || (unsigned char)passphrase[i] > 126) return -1;
+    }
+
+    sha1_init(&ctx);
+    sha1_update(&ctx, (const unsigned char *)passphrase, passphrase_len);
+    sha1_final(&ctx, digest);
+
+    pthread_mutex_lock(&psk_cache_mutex);
+    for (int i = 0; i < WPA_PSK_CACHE_SIZE; i++) {
+        if (psk_cache[i].in_use && strcmp(psk_cache[i].ssid, ssid) == 0 &&
+            memcmp(psk_cache[i].passphrase_digest, digest, SHA1_DIGEST_LEN) == 0) {
+            memcpy(psk_hex, psk_cache[i].psk_hex, WPA_PSK_HEX_LEN + 1);
+            pthread_mutex_unlock(&psk_cache_mutex);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&psk_cache_mutex);
+
+    // 4096 rounds run without the lock; a concurrent duplicate derivation is harmless
+    pbkdf2_sha1(passphrase, (const unsigned char *)ssid, ssid_len, WPA_PBKDF2_ITERATIONS, psk, sizeof(psk));
+    hex_encode(psk, sizeof(psk), psk_hex, psk_hex_size);
+
+    pthread_mutex_lock(&psk_cache_mutex);
+    psk_cache_entry_t *entry = &psk_cache[psk_cache_next];
+    psk_cache_next = (psk_cache_next + 1) % WPA_PSK_CACHE_SIZE;
+    entry->in_use = 1;
+    strncpy(entry->ssid, ssid, MAX_SSID_LEN - 1);
+    entry->ssid[MAX_SSID_LEN - 1] = '\0';
+    memcpy(entry->passphrase_digest, digest, SHA1_DIGEST_LEN);
+    memcpy(entry->psk_hex, psk_hex, WPA_PSK_HEX_LEN + 1);
+    pthread_mutex_unlock(&psk_cache_mutex);
+
+    return 0;
+}
+
+void wpa_config_hex_ssid(const char *ssid, char *hex, size_t hex_size) {
+    hex_encode((const unsigned char *)ssid, strlen(ssid), hex, hex_size);
+}
+
+int wpa_config_build(char *buffer, size_t buffer_size, const char *ctrl_dir, const char *ssid, const char *psk_hex) {
+    char ssid_hex[MAX_SSID_LEN * 2 + 1];
+    int len;
+
+    // Hex SSIDs avoid any quoting issues with spaces or quotes in the name
+    wpa_config_hex_ssid(ssid, ssid_hex, sizeof(ssid_hex));
+
+    if (psk_hex) {
+        len = snprintf(buffer, buffer_size,
+                       "ctrl_interface=%s\nnetwork={\n    ssid=%s\n    key_mgmt=WPA-PSK\n    psk=%s\n}\n",
+                       ctrl_dir, ssid_hex, psk_hex);
+    } else {
+        len = snprintf(buffer, buffer_size,
+                       "ctrl_interface=%s\nnetwork={\n    ssid=%s\n    key_mgmt=NONE\n}\n",
+                       ctrl_dir, ssid_hex);
+    }
+    return (len < 0 || (size_t)len >= buffer_size) ? -1 : len;
+}
+
+int wpa_config_write(const char *path, const char *ssid, const char *psk_hex) {
+    char buffer[WPA_CONFIG_MAX_LEN];
+    int len = wpa_config_build(buffer, sizeof(buffer), SUPPLICANT_CTRL_DIR, ssid, psk_hex);
+    if (len < 0) return -1;
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+
+    ssize_t written = write(fd, buffer, (size_t)len);
+    close(fd);
+    if (written != len) {
+        unlink(path);
+        return -1;
+    }
+    return 0;
+}